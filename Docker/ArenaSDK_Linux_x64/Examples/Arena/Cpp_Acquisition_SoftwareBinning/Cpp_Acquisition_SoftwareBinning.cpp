@@ -0,0 +1,510 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Acquisition: Software Binning
+//    This example bins pushbroom frames in software instead of on the sensor
+//    (see Cpp_Acquisition_SensorBinning). Sensor binning only supports a few
+//    factors and bins the whole frame the same way. Here frames are captured
+//    at full resolution and every binning product is computed on the host:
+//    any spatial factor, and spectral bins with arbitrary edges, for example
+//    narrow bins across the red edge and wide bins elsewhere. A pushbroom
+//    frame holds one line: rows run across track and columns along the
+//    spectrum. All products are produced in a single pass over each frame.
+//    Every sensor row is read once and added into the row accumulator of
+//    each product; when a product's spatial group of rows is complete, the
+//    columns of its accumulator are summed into the spectral bins and
+//    written as one sample of that product's band-interleaved-by-line cube.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) in each cube
+#define NUM_LINES 200
+
+// wavelength range covered by the sensor columns, from the left edge of the
+//    first column to the right edge of the last (in nanometers); the spectral
+//    axis of a pushbroom frame runs along the image width
+#define WAVELENGTH_FIRST_NM 400.0
+#define WAVELENGTH_LAST_NM 1000.0
+
+// number of times the last frame is reprocessed to compare a single pass
+//    against one pass per product
+#define BENCHMARK_REPEATS 50
+
+// spectral bins from firstNm to lastNm, widthNm wide
+struct SpectralSegment
+{
+	double firstNm;
+	double lastNm;
+	double widthNm;
+};
+
+// binning product; Sum saturates at 65535, Average rounds to nearest
+struct BinningProductSetting
+{
+	const char* name;
+	size_t spatialFactor;
+	bool average;
+	const SpectralSegment* segments;
+	size_t numSegments;
+};
+
+static const SpectralSegment UNIFORM_SEGMENTS[] = {
+	{ 400.0, 1000.0, 10.0 },
+};
+
+static const SpectralSegment RED_EDGE_SEGMENTS[] = {
+	{ 400.0, 680.0, 20.0 },
+	{ 680.0, 760.0, 2.5 },
+	{ 760.0, 1000.0, 20.0 },
+};
+
+static const SpectralSegment BROAD_SEGMENTS[] = {
+	{ 450.0, 900.0, 50.0 },
+};
+
+// products computed from every frame
+static const BinningProductSetting PRODUCTS[] = {
+	{ "Uniform10nm_Spatial2", 2, false, UNIFORM_SEGMENTS, sizeof(UNIFORM_SEGMENTS) / sizeof(UNIFORM_SEGMENTS[0]) },
+	{ "RedEdge_Spatial1", 1, false, RED_EDGE_SEGMENTS, sizeof(RED_EDGE_SEGMENTS) / sizeof(RED_EDGE_SEGMENTS[0]) },
+	{ "Broad50nm_Spatial3", 3, true, BROAD_SEGMENTS, sizeof(BROAD_SEGMENTS) / sizeof(BROAD_SEGMENTS[0]) },
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// cube stored band-interleaved by line: each line is numBands rows of
+//    numSamples pixels
+struct Cube
+{
+	size_t numLines;
+	size_t numBands;
+	size_t numSamples;
+	std::vector<uint16_t> data;
+
+	uint16_t* Band(size_t line, size_t band)
+	{
+		return &data[(line * numBands + band) * numSamples];
+	}
+};
+
+// binning product prepared for a frame size
+struct BinningProduct
+{
+	std::string name;
+	size_t spatialFactor;
+	bool average;
+
+	// spectral bins as [binFirst, binEnd) sensor columns, and the scale of
+	//    each bin (1 for Sum, 1 / pixels per bin for Average)
+	std::vector<size_t> binFirst;
+	std::vector<size_t> binEnd;
+	std::vector<float> binScale;
+
+	// running column sums of the current spatial group of rows
+	std::vector<uint32_t> accumulator;
+
+	Cube cube;
+};
+
+// wavelength at the edge of a column boundary (0 to numColumns)
+inline double ColumnBoundaryToWavelength(size_t boundary, size_t numColumns)
+{
+	return WAVELENGTH_FIRST_NM + (WAVELENGTH_LAST_NM - WAVELENGTH_FIRST_NM) * static_cast<double>(boundary) / static_cast<double>(numColumns);
+}
+
+// column boundary nearest to a wavelength, clamped to the frame
+inline size_t WavelengthToColumnBoundary(double nm, size_t numColumns)
+{
+	double boundary = (nm - WAVELENGTH_FIRST_NM) / (WAVELENGTH_LAST_NM - WAVELENGTH_FIRST_NM) * static_cast<double>(numColumns);
+	if (boundary <= 0.0)
+		return 0;
+	if (boundary >= static_cast<double>(numColumns))
+		return numColumns;
+	return static_cast<size_t>(boundary + 0.5);
+}
+
+// converts the wavelength segments of a product setting to column bins for
+//    a frame size; bins never overlap and are at least one column wide
+BinningProduct PrepareProduct(const BinningProductSetting& setting, size_t numRows, size_t numColumns, size_t numLines)
+{
+	if (setting.spatialFactor == 0 || setting.spatialFactor > numRows)
+		throw GenICam::GenericException("Spatial binning factor out of range", __FILE__, __LINE__);
+
+	BinningProduct product;
+	product.name = setting.name;
+	product.spatialFactor = setting.spatialFactor;
+	product.average = setting.average;
+
+	size_t previousEnd = 0;
+	for (size_t s = 0; s < setting.numSegments; s++)
+	{
+		const SpectralSegment& segment = setting.segments[s];
+		if (segment.widthNm <= 0.0 || segment.lastNm <= segment.firstNm)
+			throw GenICam::GenericException("Invalid spectral segment", __FILE__, __LINE__);
+
+		size_t steps = static_cast<size_t>(std::ceil((segment.lastNm - segment.firstNm) / segment.widthNm - 1e-9));
+		for (size_t i = 0; i < steps; i++)
+		{
+			size_t first = WavelengthToColumnBoundary(segment.firstNm + segment.widthNm * i, numColumns);
+			size_t end = WavelengthToColumnBoundary(std::min(segment.lastNm, segment.firstNm + segment.widthNm * (i + 1)), numColumns);
+			first = std::max(first, previousEnd);
+			if (end <= first)
+				continue;
+			product.binFirst.push_back(first);
+			product.binEnd.push_back(end);
+			previousEnd = end;
+		}
+	}
+	if (product.binFirst.empty())
+		throw GenICam::GenericException("Binning product has no spectral bins", __FILE__, __LINE__);
+
+	for (size_t b = 0; b < product.binFirst.size(); b++)
+		product.binScale.push_back(setting.average ? 1.0f / static_cast<float>((product.binEnd[b] - product.binFirst[b]) * setting.spatialFactor) : 1.0f);
+
+	product.accumulator.resize(numColumns);
+
+	product.cube.numLines = numLines;
+	product.cube.numBands = product.binFirst.size();
+	product.cube.numSamples = numRows / setting.spatialFactor;
+	product.cube.data.resize(product.cube.numLines * product.cube.numBands * product.cube.numSamples);
+	return product;
+}
+
+// widens a row into the accumulator (first row of a spatial group)
+inline void LoadRow(const uint16_t* pSrc, size_t count, uint32_t* pAcc)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pAcc + i), _mm_unpacklo_epi16(v, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pAcc + i + 4), _mm_unpackhi_epi16(v, zero));
+	}
+#endif
+	for (; i < count; i++)
+		pAcc[i] = pSrc[i];
+}
+
+// adds a row into the accumulator
+inline void AccumulateRow(const uint16_t* pSrc, size_t count, uint32_t* pAcc)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+		__m128i* pLo = reinterpret_cast<__m128i*>(pAcc + i);
+		__m128i* pHi = reinterpret_cast<__m128i*>(pAcc + i + 4);
+		_mm_storeu_si128(pLo, _mm_add_epi32(_mm_loadu_si128(pLo), _mm_unpacklo_epi16(v, zero)));
+		_mm_storeu_si128(pHi, _mm_add_epi32(_mm_loadu_si128(pHi), _mm_unpackhi_epi16(v, zero)));
+	}
+#endif
+	for (; i < count; i++)
+		pAcc[i] += pSrc[i];
+}
+
+// sums the accumulator columns [first, end) of one spectral bin
+inline uint32_t SumColumns(const uint32_t* pAcc, size_t first, size_t end)
+{
+	size_t i = first;
+	uint32_t sum = 0;
+#if defined(__SSE2__)
+	__m128i vSum = _mm_setzero_si128();
+	for (; i + 4 <= end; i += 4)
+		vSum = _mm_add_epi32(vSum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pAcc + i)));
+	vSum = _mm_add_epi32(vSum, _mm_shuffle_epi32(vSum, _MM_SHUFFLE(1, 0, 3, 2)));
+	vSum = _mm_add_epi32(vSum, _mm_shuffle_epi32(vSum, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = static_cast<uint32_t>(_mm_cvtsi128_si32(vSum));
+#endif
+	for (; i < end; i++)
+		sum += pAcc[i];
+	return sum;
+}
+
+// scales a bin sum, rounds Average products and saturates to 16 bits
+inline uint16_t StoreBinnedValue(uint32_t sum, float scale, bool average)
+{
+	return static_cast<uint16_t>(std::min(static_cast<float>(sum) * scale + (average ? 0.5f : 0.0f), 65535.0f));
+}
+
+// bins one frame into line 'line' of every product, reading each sensor row
+//    once; rows past the last complete spatial group are dropped
+void BinFrame(const uint16_t* pFrame, size_t numRows, size_t numColumns, size_t line, std::vector<BinningProduct*>& products)
+{
+	for (size_t row = 0; row < numRows; row++)
+	{
+		const uint16_t* pRow = pFrame + row * numColumns;
+
+		for (size_t p = 0; p < products.size(); p++)
+		{
+			BinningProduct& product = *products[p];
+			size_t sample = row / product.spatialFactor;
+			if (sample >= product.cube.numSamples)
+				continue;
+
+			size_t position = row % product.spatialFactor;
+			if (position == 0)
+				LoadRow(pRow, numColumns, product.accumulator.data());
+			else
+				AccumulateRow(pRow, numColumns, product.accumulator.data());
+
+			if (position + 1 == product.spatialFactor)
+			{
+				const uint32_t* pAcc = product.accumulator.data();
+				for (size_t b = 0; b < product.cube.numBands; b++)
+					product.cube.Band(line, b)[sample] = StoreBinnedValue(SumColumns(pAcc, product.binFirst[b], product.binEnd[b]), product.binScale[b], product.average);
+			}
+		}
+	}
+}
+
+// bins one line of a product pixel by pixel, as a check
+void BinLineReference(const uint16_t* pFrame, size_t numColumns, const BinningProduct& product, std::vector<uint16_t>& out)
+{
+	out.resize(product.cube.numBands * product.cube.numSamples);
+	for (size_t b = 0; b < product.cube.numBands; b++)
+	{
+		size_t pixels = (product.binEnd[b] - product.binFirst[b]) * product.spatialFactor;
+		for (size_t x = 0; x < product.cube.numSamples; x++)
+		{
+			uint32_t sum = 0;
+			for (size_t k = 0; k < product.spatialFactor; k++)
+				for (size_t column = product.binFirst[b]; column < product.binEnd[b]; column++)
+					sum += pFrame[(x * product.spatialFactor + k) * numColumns + column];
+
+			float scale = product.average ? 1.0f / static_cast<float>(pixels) : 1.0f;
+			float offset = product.average ? 0.5f : 0.0f;
+			out[b * product.cube.numSamples + x] = static_cast<uint16_t>(std::min(static_cast<float>(sum) * scale + offset, 65535.0f));
+		}
+	}
+}
+
+// demonstrates software binning into several products
+// (1) selects an unpacked 12 or 16-bit mono format
+// (2) prepares the spectral bins of every product for the frame size
+// (3) bins every frame into all products in a single pass
+// (4) checks the first line against a pixel-by-pixel reference
+// (5) compares a single pass with one pass per product
+// (6) restores the pixel format
+void AcquireWithSoftwareBinning(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat");
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// select pixel format
+	//    Mono12 is unpacked into 16-bit containers, so both formats are binned
+	//    straight from the image buffer without conversion.
+	GenApi::CEnumerationPtr pPixelFormat = pNodeMap->GetNode("PixelFormat");
+	GenApi::CEnumEntryPtr pMono12 = pPixelFormat->GetEntryByName("Mono12");
+	const char* pixelFormat = (pMono12 != 0 && GenApi::IsAvailable(pMono12)) ? "Mono12" : "Mono16";
+	std::cout << TAB1 << "Set pixel format to " << pixelFormat << "\n";
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormat);
+
+	size_t numRows = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	size_t numColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+
+	// prepare products
+	std::cout << TAB1 << "Prepare binning products for " << numColumns << " x " << numRows << " frames\n";
+
+	std::vector<BinningProduct> products;
+	for (size_t i = 0; i < sizeof(PRODUCTS) / sizeof(PRODUCTS[0]); i++)
+		products.push_back(PrepareProduct(PRODUCTS[i], numRows, numColumns, NUM_LINES));
+
+	std::vector<BinningProduct*> allProducts;
+	for (size_t i = 0; i < products.size(); i++)
+	{
+		allProducts.push_back(&products[i]);
+
+		const BinningProduct& product = products[i];
+		size_t narrowest = numColumns;
+		size_t widest = 0;
+		for (size_t b = 0; b < product.binFirst.size(); b++)
+		{
+			narrowest = std::min(narrowest, product.binEnd[b] - product.binFirst[b]);
+			widest = std::max(widest, product.binEnd[b] - product.binFirst[b]);
+		}
+		std::cout << TAB2 << product.name << ": " << product.cube.numSamples << " samples x " << product.cube.numBands << " bands (" << narrowest << " to " << widest << " columns, " << ColumnBoundaryToWavelength(product.binFirst.front(), numColumns) << " to " << ColumnBoundaryToWavelength(product.binEnd.back(), numColumns) << " nm, " << (product.average ? "Average" : "Sum") << ")\n";
+	}
+
+	// acquire and bin
+	std::cout << TAB1 << "Acquire and bin " << NUM_LINES << " lines\n";
+
+	std::vector<uint16_t> firstFrame;
+	std::vector<uint16_t> lastFrame;
+	double binningSeconds = 0.0;
+
+	pDevice->StartStream();
+	for (size_t line = 0; line < NUM_LINES; line++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->GetWidth() != numColumns || pImage->GetHeight() != numRows || pImage->GetBitsPerPixel() != 16)
+		{
+			pDevice->RequeueBuffer(pImage);
+			pDevice->StopStream();
+			throw GenICam::GenericException("Unexpected image size or format", __FILE__, __LINE__);
+		}
+
+		const uint16_t* pFrame = reinterpret_cast<const uint16_t*>(pImage->GetData());
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BinFrame(pFrame, numRows, numColumns, line, allProducts);
+		binningSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (line == 0)
+			firstFrame.assign(pFrame, pFrame + numRows * numColumns);
+		if (line == NUM_LINES - 1)
+			lastFrame.assign(pFrame, pFrame + numRows * numColumns);
+
+		pDevice->RequeueBuffer(pImage);
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << binningSeconds * 1e6 / NUM_LINES << " us per frame for " << products.size() << " products (" << NUM_LINES / binningSeconds << " lines/s)\n";
+
+	// check
+	std::cout << TAB1 << "Check first line against pixel-by-pixel reference\n";
+
+	for (size_t p = 0; p < products.size(); p++)
+	{
+		std::vector<uint16_t> expected;
+		BinLineReference(firstFrame.data(), numColumns, products[p], expected);
+		size_t mismatches = 0;
+		for (size_t i = 0; i < expected.size(); i++)
+			if (expected[i] != products[p].cube.data[i])
+				mismatches++;
+
+		std::cout << TAB2 << products[p].name << ": " << mismatches << " mismatches\n";
+		if (mismatches != 0)
+			throw GenICam::GenericException("Binned line does not match reference", __FILE__, __LINE__);
+	}
+
+	// compare single pass with one pass per product
+	std::cout << TAB1 << "Compare single pass with one pass per product (" << BENCHMARK_REPEATS << " repeats)\n";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < BENCHMARK_REPEATS; r++)
+		BinFrame(lastFrame.data(), numRows, numColumns, NUM_LINES - 1, allProducts);
+	double singlePass = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < BENCHMARK_REPEATS; r++)
+	{
+		for (size_t p = 0; p < allProducts.size(); p++)
+		{
+			std::vector<BinningProduct*> one(1, allProducts[p]);
+			BinFrame(lastFrame.data(), numRows, numColumns, NUM_LINES - 1, one);
+		}
+	}
+	double perProduct = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << TAB2 << "single pass: " << singlePass * 1e6 / BENCHMARK_REPEATS << " us per frame\n";
+	std::cout << TAB2 << "pass per product: " << perProduct * 1e6 / BENCHMARK_REPEATS << " us per frame\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Acquisition_SoftwareBinning\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		AcquireWithSoftwareBinning(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,880 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "GenTL.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// Acquisition: User Buffers
+//    This example receives images into memory that the application
+//    allocates, instead of buffers that Arena::IDevice::StartStream allocates
+//    internally. The GenTL interface that Arena is built on lets a consumer
+//    announce its own memory to a stream with DSAnnounceBuffer. The example
+//    uses this to place all stream buffers in one region of 2 MiB huge pages.
+//    The region is bound to the NUMA node of the acquiring CPU, and every
+//    buffer starts on a 4 KiB boundary. SIMD kernels then read frames with
+//    fewer TLB misses and no remote memory traffic. A writer opened with
+//    O_DIRECT can take a frame straight from its buffer, without a copy. The
+//    IBufferProvider interface is the extension point: a provider that maps
+//    a cube file lands frames directly in the cube. Arena streams cannot
+//    take user memory, so the user buffer stream opens the camera through
+//    the GenTL producer (libgentl) and the GenApi node map of the device
+//    port. The example first acquires with the default allocation, then
+//    with user buffers, and compares the two.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images to grab with each allocation
+#define NUM_IMAGES 500
+
+// number of stream buffers
+#define NUM_BUFFERS 32
+
+// alignment of each user buffer; also the O_DIRECT block size
+#define BUFFER_ALIGNMENT 4096
+
+// huge page size
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// NUMA node for the user buffers; -1 uses the node of the acquiring CPU
+#define NUMA_NODE -1
+
+// file written with O_DIRECT from each frame; empty to skip writing. O_DIRECT
+// needs a file system that supports it (not tmpfs).
+#define DIRECT_WRITE_FILE "Cpp_Acquisition_UserBuffers.raw"
+
+// timeout for detecting camera devices (in milliseconds)
+#define SYSTEM_TIMEOUT 100
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPERS =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// throws the producer's last error if a GenTL call failed
+void CheckGC(GenTL::GC_ERROR err, const char* call)
+{
+	if (err == GenTL::GC_ERR_SUCCESS)
+		return;
+
+	GenTL::GC_ERROR lastErr = err;
+	char text[512] = "";
+	size_t size = sizeof(text);
+	GenTL::GCGetLastError(&lastErr, text, &size);
+
+	std::string msg = std::string(call) + " failed (" + std::to_string(err) + "): " + text;
+	throw GenICam::GenericException(msg.c_str(), __FILE__, __LINE__);
+}
+
+// rounds up to a multiple of an alignment
+size_t RoundUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// stand-in for a processing kernel: reads every word of a frame. Its speed
+// is bound by memory bandwidth and TLB reach, which is what buffer
+// placement changes.
+uint64_t ConsumeFrame(const void* pData, size_t size)
+{
+	const uint64_t* pWords = static_cast<const uint64_t*>(pData);
+	size_t numWords = size / sizeof(uint64_t);
+	uint64_t sum0 = 0;
+	uint64_t sum1 = 0;
+	uint64_t sum2 = 0;
+	uint64_t sum3 = 0;
+	size_t i = 0;
+
+	for (; i + 4 <= numWords; i += 4)
+	{
+		sum0 += pWords[i];
+		sum1 += pWords[i + 1];
+		sum2 += pWords[i + 2];
+		sum3 += pWords[i + 3];
+	}
+	for (; i < numWords; i++)
+		sum0 += pWords[i];
+
+	return sum0 + sum1 + sum2 + sum3;
+}
+
+// opens the direct write file, or returns -1 if writing is disabled or the
+// file system does not support O_DIRECT
+int OpenDirectWriter()
+{
+	if (std::strlen(DIRECT_WRITE_FILE) == 0)
+		return -1;
+
+	int fd = open(DIRECT_WRITE_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+	if (fd < 0)
+		std::cout << TAB2 << "O_DIRECT unavailable for " << DIRECT_WRITE_FILE << " (" << std::strerror(errno) << "); not writing\n";
+	return fd;
+}
+
+// results of one acquisition run
+struct BenchmarkResult
+{
+	size_t frames = 0;
+	size_t incomplete = 0;
+	size_t alignedBuffers = 0;
+	size_t bytes = 0;
+	double seconds = 0.0;
+	double cpuSeconds = 0.0;
+	double kernelSeconds = 0.0;
+	double writeSeconds = 0.0;
+	size_t bytesWritten = 0;
+	uint64_t checksum = 0;
+};
+
+// stream channel settings carried from the Arena run to the user buffer run
+//    so that both runs stream with the same packets
+struct StreamChannelSettings
+{
+	int64_t packetSize = 0;
+	int64_t packetDelay = 0;
+};
+
+// prints one acquisition run
+void PrintResult(const char* name, const BenchmarkResult& result)
+{
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << TAB2 << name << "\n";
+	std::cout << TAB3 << result.frames << " frames at " << result.frames / result.seconds << " fps, " << result.incomplete << " incomplete\n";
+	std::cout << TAB3 << result.alignedBuffers << " of " << result.frames << " frames " << BUFFER_ALIGNMENT << "-byte aligned\n";
+	std::cout << TAB3 << "process CPU " << 1000.0 * result.cpuSeconds / result.frames << " ms per frame\n";
+	std::cout << TAB3 << "kernel " << result.bytes / result.kernelSeconds / 1e9 << " GB/s\n";
+	if (result.bytesWritten > 0)
+		std::cout << TAB3 << "direct write " << result.bytesWritten / result.writeSeconds / 1e6 << " MB/s\n";
+}
+
+// seconds since an arbitrary point
+double NowSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// process CPU seconds, including the producer's receive threads
+double CpuSeconds()
+{
+	return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- USER BUFFERS -=
+// =-=-=-=-=-=-=-=-=-
+
+// Buffer provider
+//    Supplies the memory a stream receives into. The stream announces every
+//    buffer when it starts and revokes them when it stops; the provider must
+//    outlive the stream.
+class IBufferProvider
+{
+public:
+	virtual ~IBufferProvider()
+	{
+	}
+
+	virtual size_t GetNumBuffers() const = 0;
+	virtual size_t GetBufferSize() const = 0;
+	virtual void* GetBuffer(size_t index) = 0;
+	virtual std::string Describe() const = 0;
+};
+
+// Huge page buffer provider
+//    Places all buffers in one region of 2 MiB pages. Each buffer takes a
+//    stride of the payload size rounded up to BUFFER_ALIGNMENT, so that every
+//    buffer starts aligned and can be written with O_DIRECT in whole blocks.
+//    Reserved huge pages (vm.nr_hugepages) are used when available; otherwise
+//    the region is aligned to 2 MiB and transparent huge pages are
+//    requested. The region is bound to a NUMA node before it is touched, then
+//    touched so that no page faults happen while streaming.
+class HugePageBufferProvider : public IBufferProvider
+{
+public:
+	HugePageBufferProvider(size_t payloadSize, size_t numBuffers, int numaNode) :
+		m_numBuffers(numBuffers),
+		m_stride(RoundUp(payloadSize, BUFFER_ALIGNMENT)),
+		m_length(RoundUp(m_stride * numBuffers, HUGE_PAGE_SIZE)),
+		m_pBase(nullptr),
+		m_reservedPages(false),
+		m_numaNode(numaNode)
+	{
+		// reserved huge pages
+		void* pBase = mmap(nullptr, m_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+		if (pBase != MAP_FAILED)
+		{
+			m_reservedPages = true;
+		}
+		else
+		{
+			// transparent huge pages: over-allocate, trim to a 2 MiB boundary
+			size_t mapped = m_length + HUGE_PAGE_SIZE;
+			uint8_t* pMapped = static_cast<uint8_t*>(mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (pMapped == MAP_FAILED)
+				throw GenICam::GenericException("could not map stream buffers", __FILE__, __LINE__);
+
+			uint8_t* pAligned = reinterpret_cast<uint8_t*>(RoundUp(reinterpret_cast<uintptr_t>(pMapped), HUGE_PAGE_SIZE));
+			size_t head = pAligned - pMapped;
+			if (head > 0)
+				munmap(pMapped, head);
+			munmap(pAligned + m_length, mapped - head - m_length);
+			madvise(pAligned, m_length, MADV_HUGEPAGE);
+			pBase = pAligned;
+		}
+		m_pBase = static_cast<uint8_t*>(pBase);
+
+		// bind to a NUMA node
+		if (m_numaNode < 0)
+		{
+			unsigned cpu = 0;
+			unsigned node = 0;
+			if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+				m_numaNode = static_cast<int>(node);
+		}
+		if (m_numaNode >= 0 && m_numaNode < 64)
+		{
+			unsigned long nodeMask = 1ul << m_numaNode;
+			if (syscall(SYS_mbind, m_pBase, m_length, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0) != 0)
+				m_numaNode = -1;
+		}
+
+		// fault every page in now
+		std::memset(m_pBase, 0, m_length);
+	}
+
+	~HugePageBufferProvider()
+	{
+		munmap(m_pBase, m_length);
+	}
+
+	HugePageBufferProvider(const HugePageBufferProvider&) = delete;
+	HugePageBufferProvider& operator=(const HugePageBufferProvider&) = delete;
+
+	size_t GetNumBuffers() const
+	{
+		return m_numBuffers;
+	}
+
+	size_t GetBufferSize() const
+	{
+		return m_stride;
+	}
+
+	void* GetBuffer(size_t index)
+	{
+		return m_pBase + index * m_stride;
+	}
+
+	std::string Describe() const
+	{
+		return std::to_string(m_numBuffers) + " buffers of " + std::to_string(m_stride) + " bytes in " + std::to_string(m_length / HUGE_PAGE_SIZE) + (m_reservedPages ? " reserved" : " transparent") + " huge pages, NUMA node " + (m_numaNode >= 0 ? std::to_string(m_numaNode) : std::string("unbound"));
+	}
+
+private:
+	size_t m_numBuffers;
+	size_t m_stride;
+	size_t m_length;
+	uint8_t* m_pBase;
+	bool m_reservedPages;
+	int m_numaNode;
+};
+
+// Remote device port
+//    Lets GenApi read and write the camera's registers through the GenTL
+//    device port, so that the device node map works without Arena.
+class RemoteDevicePort : public GenApi::IPort
+{
+public:
+	explicit RemoteDevicePort(GenTL::PORT_HANDLE hPort) :
+		m_hPort(hPort)
+	{
+	}
+
+	GenApi::EAccessMode GetAccessMode() const
+	{
+		return GenApi::RW;
+	}
+
+	void Read(void* pBuffer, int64_t address, int64_t length)
+	{
+		size_t size = static_cast<size_t>(length);
+		CheckGC(GenTL::GCReadPort(m_hPort, static_cast<uint64_t>(address), pBuffer, &size), "GCReadPort");
+	}
+
+	void Write(const void* pBuffer, int64_t address, int64_t length)
+	{
+		size_t size = static_cast<size_t>(length);
+		CheckGC(GenTL::GCWritePort(m_hPort, static_cast<uint64_t>(address), pBuffer, &size), "GCWritePort");
+	}
+
+private:
+	GenTL::PORT_HANDLE m_hPort;
+};
+
+// a frame received into a user buffer
+struct UserFrame
+{
+	GenTL::BUFFER_HANDLE hBuffer = nullptr;
+	size_t index = 0;
+	const uint8_t* pData = nullptr;
+	size_t sizeFilled = 0;
+	uint64_t frameId = 0;
+	bool incomplete = false;
+};
+
+// User buffer stream
+//    Opens a device through the GenTL producer by serial number and streams
+//    into the buffers of a provider: the user buffer counterpart of
+//    Arena::IDevice::StartStream, GetImage, RequeueBuffer and StopStream.
+//    Arena must not have the device open at the same time.
+class UserBufferStream
+{
+public:
+	explicit UserBufferStream(const std::string& serialNumber) :
+		m_closeLib(false),
+		m_hTL(nullptr),
+		m_hIF(nullptr),
+		m_hDev(nullptr),
+		m_hDS(nullptr),
+		m_hEvent(nullptr),
+		m_pProvider(nullptr)
+	{
+		try
+		{
+			Open(serialNumber);
+		}
+		catch (...)
+		{
+			Close();
+			throw;
+		}
+	}
+
+	~UserBufferStream()
+	{
+		Close();
+	}
+
+	UserBufferStream(const UserBufferStream&) = delete;
+	UserBufferStream& operator=(const UserBufferStream&) = delete;
+
+	GenApi::INodeMap* GetNodeMap()
+	{
+		return m_nodeMap._Ptr;
+	}
+
+	// announces and queues the provider's buffers, then starts acquisition
+	void StartStream(IBufferProvider& provider)
+	{
+		int64_t payloadSize = Arena::GetNodeValue<int64_t>(GetNodeMap(), "PayloadSize");
+		if (static_cast<size_t>(payloadSize) > provider.GetBufferSize())
+			throw GenICam::GenericException("user buffers are smaller than the payload", __FILE__, __LINE__);
+
+		char streamId[256] = "";
+		size_t size = sizeof(streamId);
+		CheckGC(GenTL::DevGetDataStreamID(m_hDev, 0, streamId, &size), "DevGetDataStreamID");
+		CheckGC(GenTL::DevOpenDataStream(m_hDev, streamId, &m_hDS), "DevOpenDataStream");
+
+		m_pProvider = &provider;
+		for (size_t i = 0; i < provider.GetNumBuffers(); i++)
+		{
+			GenTL::BUFFER_HANDLE hBuffer = nullptr;
+			CheckGC(GenTL::DSAnnounceBuffer(m_hDS, provider.GetBuffer(i), provider.GetBufferSize(), reinterpret_cast<void*>(i), &hBuffer), "DSAnnounceBuffer");
+			m_buffers.push_back(hBuffer);
+			CheckGC(GenTL::DSQueueBuffer(m_hDS, hBuffer), "DSQueueBuffer");
+		}
+
+		CheckGC(GenTL::GCRegisterEvent(m_hDS, GenTL::EVENT_NEW_BUFFER, &m_hEvent), "GCRegisterEvent");
+		SetParamsLocked(true);
+		CheckGC(GenTL::DSStartAcquisition(m_hDS, GenTL::ACQ_START_FLAGS_DEFAULT, GENTL_INFINITE), "DSStartAcquisition");
+		Arena::ExecuteNode(GetNodeMap(), "AcquisitionStart");
+	}
+
+	// waits for the next filled buffer
+	UserFrame GetImage(uint64_t timeout)
+	{
+		GenTL::EVENT_NEW_BUFFER_DATA data;
+		size_t size = sizeof(data);
+		CheckGC(GenTL::EventGetData(m_hEvent, &data, &size, timeout), "EventGetData");
+
+		UserFrame frame;
+		frame.hBuffer = data.BufferHandle;
+		frame.index = reinterpret_cast<size_t>(data.pUserPointer);
+		frame.pData = static_cast<const uint8_t*>(m_pProvider->GetBuffer(frame.index));
+
+		GenTL::INFO_DATATYPE type = 0;
+		size = sizeof(frame.sizeFilled);
+		CheckGC(GenTL::DSGetBufferInfo(m_hDS, frame.hBuffer, GenTL::BUFFER_INFO_SIZE_FILLED, &type, &frame.sizeFilled, &size), "DSGetBufferInfo");
+		size = sizeof(frame.frameId);
+		CheckGC(GenTL::DSGetBufferInfo(m_hDS, frame.hBuffer, GenTL::BUFFER_INFO_FRAMEID, &type, &frame.frameId, &size), "DSGetBufferInfo");
+		bool8_t incomplete = 0;
+		size = sizeof(incomplete);
+		CheckGC(GenTL::DSGetBufferInfo(m_hDS, frame.hBuffer, GenTL::BUFFER_INFO_IS_INCOMPLETE, &type, &incomplete, &size), "DSGetBufferInfo");
+		frame.incomplete = incomplete != 0;
+		return frame;
+	}
+
+	void RequeueBuffer(const UserFrame& frame)
+	{
+		CheckGC(GenTL::DSQueueBuffer(m_hDS, frame.hBuffer), "DSQueueBuffer");
+	}
+
+	// stops acquisition and revokes the provider's buffers
+	void StopStream()
+	{
+		if (!m_hDS)
+			return;
+
+		Arena::ExecuteNode(GetNodeMap(), "AcquisitionStop");
+		SetParamsLocked(false);
+		GenTL::DSStopAcquisition(m_hDS, GenTL::ACQ_STOP_FLAGS_DEFAULT);
+		GenTL::DSFlushQueue(m_hDS, GenTL::ACQ_QUEUE_ALL_DISCARD);
+		ReleaseStream();
+	}
+
+private:
+	void Open(const std::string& serialNumber)
+	{
+		// Arena may have left the library initialized in this process
+		GenTL::GC_ERROR err = GenTL::GCInitLib();
+		if (err != GenTL::GC_ERR_RESOURCE_IN_USE)
+		{
+			CheckGC(err, "GCInitLib");
+			m_closeLib = true;
+		}
+
+		CheckGC(GenTL::TLOpen(&m_hTL), "TLOpen");
+		CheckGC(GenTL::TLUpdateInterfaceList(m_hTL, nullptr, SYSTEM_TIMEOUT), "TLUpdateInterfaceList");
+
+		uint32_t numInterfaces = 0;
+		CheckGC(GenTL::TLGetNumInterfaces(m_hTL, &numInterfaces), "TLGetNumInterfaces");
+		for (uint32_t i = 0; i < numInterfaces && !m_hDev; i++)
+		{
+			char interfaceId[256] = "";
+			size_t size = sizeof(interfaceId);
+			CheckGC(GenTL::TLGetInterfaceID(m_hTL, i, interfaceId, &size), "TLGetInterfaceID");
+			CheckGC(GenTL::TLOpenInterface(m_hTL, interfaceId, &m_hIF), "TLOpenInterface");
+			CheckGC(GenTL::IFUpdateDeviceList(m_hIF, nullptr, SYSTEM_TIMEOUT), "IFUpdateDeviceList");
+
+			uint32_t numDevices = 0;
+			CheckGC(GenTL::IFGetNumDevices(m_hIF, &numDevices), "IFGetNumDevices");
+			for (uint32_t j = 0; j < numDevices && !m_hDev; j++)
+			{
+				char deviceId[256] = "";
+				size = sizeof(deviceId);
+				CheckGC(GenTL::IFGetDeviceID(m_hIF, j, deviceId, &size), "IFGetDeviceID");
+
+				char serial[256] = "";
+				GenTL::INFO_DATATYPE type = 0;
+				size = sizeof(serial);
+				if (GenTL::IFGetDeviceInfo(m_hIF, deviceId, GenTL::DEVICE_INFO_SERIAL_NUMBER, &type, serial, &size) != GenTL::GC_ERR_SUCCESS || serialNumber != serial)
+					continue;
+
+				CheckGC(GenTL::IFOpenDevice(m_hIF, deviceId, GenTL::DEVICE_ACCESS_EXCLUSIVE, &m_hDev), "IFOpenDevice");
+			}
+
+			if (!m_hDev)
+			{
+				GenTL::IFClose(m_hIF);
+				m_hIF = nullptr;
+			}
+		}
+		if (!m_hDev)
+			throw GenICam::GenericException(("device " + serialNumber + " not found by the GenTL producer").c_str(), __FILE__, __LINE__);
+
+		GenTL::PORT_HANDLE hPort = nullptr;
+		CheckGC(GenTL::DevGetPort(m_hDev, &hPort), "DevGetPort");
+		m_pPort.reset(new RemoteDevicePort(hPort));
+		LoadNodeMap(hPort);
+	}
+
+	// loads the device description from the URL of the device port, which
+	// has the form "Local:<file>;<hex address>;<hex length>"
+	void LoadNodeMap(GenTL::PORT_HANDLE hPort)
+	{
+		char url[1024] = "";
+		GenTL::INFO_DATATYPE type = 0;
+		size_t size = sizeof(url);
+		CheckGC(GenTL::GCGetPortURLInfo(hPort, 0, GenTL::URL_INFO_URL, &type, url, &size), "GCGetPortURLInfo");
+
+		std::string location(url);
+		size_t colon = location.find(':');
+		size_t first = location.find(';');
+		size_t second = location.find(';', first + 1);
+		if (colon == std::string::npos || first == std::string::npos || second == std::string::npos || strncasecmp(url, "local", colon) != 0)
+			throw GenICam::GenericException(("unsupported device description URL " + location).c_str(), __FILE__, __LINE__);
+
+		std::string fileName = location.substr(colon + 1, first - colon - 1);
+		uint64_t address = std::strtoull(location.substr(first + 1, second - first - 1).c_str(), nullptr, 16);
+		uint64_t length = std::strtoull(location.substr(second + 1).c_str(), nullptr, 16);
+
+		std::vector<char> file(static_cast<size_t>(length));
+		m_pPort->Read(file.data(), static_cast<int64_t>(address), static_cast<int64_t>(length));
+
+		bool zipped = fileName.size() > 4 && strcasecmp(fileName.c_str() + fileName.size() - 4, ".zip") == 0;
+		if (zipped)
+			m_nodeMap._LoadXMLFromZIPData(file.data(), file.size());
+		else
+			m_nodeMap._LoadXMLFromString(std::string(file.begin(), file.end()).c_str());
+
+		if (!m_nodeMap._Connect(m_pPort.get(), "Device"))
+			throw GenICam::GenericException("could not connect the device node map", __FILE__, __LINE__);
+	}
+
+	// locks transport layer parameters such as PayloadSize while streaming
+	void SetParamsLocked(bool locked)
+	{
+		GenApi::CIntegerPtr pParamsLocked = GetNodeMap()->GetNode("TLParamsLocked");
+		if (pParamsLocked && GenApi::IsWritable(pParamsLocked))
+			pParamsLocked->SetValue(locked ? 1 : 0);
+	}
+
+	void ReleaseStream()
+	{
+		if (m_hEvent)
+			GenTL::GCUnregisterEvent(m_hDS, GenTL::EVENT_NEW_BUFFER);
+		m_hEvent = nullptr;
+		for (size_t i = 0; i < m_buffers.size(); i++)
+			GenTL::DSRevokeBuffer(m_hDS, m_buffers[i], nullptr, nullptr);
+		m_buffers.clear();
+		GenTL::DSClose(m_hDS);
+		m_hDS = nullptr;
+		m_pProvider = nullptr;
+	}
+
+	void Close()
+	{
+		if (m_hDS)
+		{
+			try
+			{
+				StopStream();
+			}
+			catch (...)
+			{
+				if (m_hDS)
+					ReleaseStream();
+			}
+		}
+
+		m_nodeMap._Destroy();
+		m_pPort.reset();
+		if (m_hDev)
+			GenTL::DevClose(m_hDev);
+		if (m_hIF)
+			GenTL::IFClose(m_hIF);
+		if (m_hTL)
+			GenTL::TLClose(m_hTL);
+		if (m_closeLib)
+			GenTL::GCCloseLib();
+		m_hDev = nullptr;
+		m_hIF = nullptr;
+		m_hTL = nullptr;
+		m_closeLib = false;
+	}
+
+	bool m_closeLib;
+	GenTL::TL_HANDLE m_hTL;
+	GenTL::IF_HANDLE m_hIF;
+	GenTL::DEV_HANDLE m_hDev;
+	GenTL::DS_HANDLE m_hDS;
+	GenTL::EVENT_HANDLE m_hEvent;
+	std::vector<GenTL::BUFFER_HANDLE> m_buffers;
+	IBufferProvider* m_pProvider;
+	std::unique_ptr<RemoteDevicePort> m_pPort;
+	GenApi::CNodeMapRef m_nodeMap;
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// demonstrates acquisition into buffers allocated by Arena
+// (1) sets acquisition mode and stream settings
+// (2) starts the stream with Arena's default allocation
+// (3) runs the kernel on each image and writes it with O_DIRECT, through an
+//     aligned copy unless the buffer is aligned and a whole number of blocks
+// (4) records the negotiated packet size and delay
+// (5) stops the stream and restores settings
+BenchmarkResult AcquireIntoArenaBuffers(Arena::IDevice* pDevice, StreamChannelSettings& negotiated)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+	GenApi::INodeMap* pTLStreamNodeMap = pDevice->GetTLStreamNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring acquisitionModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode");
+	GenICam::gcstring bufferHandlingModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pTLStreamNodeMap, "StreamBufferHandlingMode");
+
+	// Set acquisition mode and stream settings
+	//    'OldestFirst' hands over every frame in order, as the user buffer
+	//    stream does.
+	std::cout << TAB1 << "Acquire into Arena buffers\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", "Continuous");
+	Arena::SetNodeValue<GenICam::gcstring>(pTLStreamNodeMap, "StreamBufferHandlingMode", "OldestFirst");
+	Arena::SetNodeValue<bool>(pTLStreamNodeMap, "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pTLStreamNodeMap, "StreamPacketResendEnable", true);
+
+	size_t stride = RoundUp(static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "PayloadSize")), BUFFER_ALIGNMENT);
+	void* pBounce = nullptr;
+	if (posix_memalign(&pBounce, BUFFER_ALIGNMENT, stride) != 0)
+		throw GenICam::GenericException("could not allocate the O_DIRECT bounce buffer", __FILE__, __LINE__);
+	std::unique_ptr<void, void (*)(void*)> bounce(pBounce, std::free);
+	int fd = OpenDirectWriter();
+
+	// Start stream and acquire
+	BenchmarkResult result;
+	pDevice->StartStream(NUM_BUFFERS);
+
+	double start = NowSeconds();
+	double cpuStart = CpuSeconds();
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		const uint8_t* pData = pImage->GetData();
+		size_t size = pImage->GetSizeFilled();
+
+		result.frames++;
+		if (pImage->IsIncomplete())
+			result.incomplete++;
+		bool aligned = reinterpret_cast<uintptr_t>(pData) % BUFFER_ALIGNMENT == 0;
+		if (aligned)
+			result.alignedBuffers++;
+
+		double kernelStart = NowSeconds();
+		result.checksum += ConsumeFrame(pData, size);
+		result.kernelSeconds += NowSeconds() - kernelStart;
+		result.bytes += size;
+
+		if (fd >= 0)
+		{
+			double writeStart = NowSeconds();
+			const void* pBlock = pData;
+			if (!aligned || size % BUFFER_ALIGNMENT != 0)
+			{
+				std::memcpy(bounce.get(), pData, size);
+				pBlock = bounce.get();
+			}
+			if (write(fd, pBlock, RoundUp(size, BUFFER_ALIGNMENT)) > 0)
+				result.bytesWritten += RoundUp(size, BUFFER_ALIGNMENT);
+			result.writeSeconds += NowSeconds() - writeStart;
+		}
+
+		pDevice->RequeueBuffer(pImage);
+	}
+	result.seconds = NowSeconds() - start;
+	result.cpuSeconds = CpuSeconds() - cpuStart;
+
+	// Record negotiated packet size and delay
+	//    The packet size is negotiated when the stream starts; the user buffer
+	//    run applies both values so that the comparison only differs in the
+	//    buffers.
+	negotiated.packetSize = Arena::GetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize");
+	negotiated.packetDelay = Arena::GetNodeValue<int64_t>(pNodeMap, "GevSCPD");
+	std::cout << TAB2 << "Negotiated packet size " << negotiated.packetSize << ", packet delay " << negotiated.packetDelay << "\n";
+
+	pDevice->StopStream();
+	if (fd >= 0)
+		close(fd);
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pTLStreamNodeMap, "StreamBufferHandlingMode", bufferHandlingModeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", acquisitionModeInitial);
+	return result;
+}
+
+// demonstrates acquisition into user buffers
+// (1) opens the device through the GenTL producer
+// (2) applies the packet size and delay negotiated by the Arena run
+// (3) allocates huge page, NUMA-local, aligned buffers
+// (4) announces the buffers and starts the stream
+// (5) runs the kernel on each image and writes it with O_DIRECT, straight
+//     from the buffer
+// (6) stops the stream and restores settings
+BenchmarkResult AcquireIntoUserBuffers(const std::string& serialNumber, const StreamChannelSettings& negotiated)
+{
+	// Open device through the GenTL producer
+	std::cout << TAB1 << "Acquire into user buffers\n";
+
+	// the provider is declared first so that it outlives the stream, even
+	// when an exception unwinds both
+	std::unique_ptr<HugePageBufferProvider> pProvider;
+	UserBufferStream stream(serialNumber);
+	GenApi::INodeMap* pNodeMap = stream.GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring acquisitionModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode");
+	int64_t packetSizeInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize");
+	int64_t packetDelayInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "GevSCPD");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", "Continuous");
+
+	// Apply negotiated packet size and delay
+	//    The producer does not negotiate the packet size itself; without this
+	//    the user buffer run would stream with the camera's default packets.
+	Arena::SetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize", negotiated.packetSize);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "GevSCPD", negotiated.packetDelay);
+
+	// Allocate buffers
+	size_t payloadSize = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "PayloadSize"));
+	pProvider.reset(new HugePageBufferProvider(payloadSize, NUM_BUFFERS, NUMA_NODE));
+
+	std::cout << TAB2 << pProvider->Describe() << "\n";
+
+	int fd = OpenDirectWriter();
+
+	// Start stream and acquire
+	BenchmarkResult result;
+	stream.StartStream(*pProvider);
+
+	double start = NowSeconds();
+	double cpuStart = CpuSeconds();
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		UserFrame frame = stream.GetImage(TIMEOUT);
+
+		result.frames++;
+		if (frame.incomplete)
+			result.incomplete++;
+		if (reinterpret_cast<uintptr_t>(frame.pData) % BUFFER_ALIGNMENT == 0)
+			result.alignedBuffers++;
+
+		double kernelStart = NowSeconds();
+		result.checksum += ConsumeFrame(frame.pData, frame.sizeFilled);
+		result.kernelSeconds += NowSeconds() - kernelStart;
+		result.bytes += frame.sizeFilled;
+
+		// every buffer is aligned and a whole number of blocks long
+		if (fd >= 0)
+		{
+			double writeStart = NowSeconds();
+			if (write(fd, frame.pData, pProvider->GetBufferSize()) > 0)
+				result.bytesWritten += pProvider->GetBufferSize();
+			result.writeSeconds += NowSeconds() - writeStart;
+		}
+
+		stream.RequeueBuffer(frame);
+	}
+	result.seconds = NowSeconds() - start;
+	result.cpuSeconds = CpuSeconds() - cpuStart;
+
+	stream.StopStream();
+	if (fd >= 0)
+		close(fd);
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<int64_t>(pNodeMap, "GevSCPD", packetDelayInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize", packetSizeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", acquisitionModeInitial);
+	return result;
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Acquisition_UserBuffers\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(SYSTEM_TIMEOUT);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		std::string serialNumber = deviceInfos[0].SerialNumber().c_str();
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		StreamChannelSettings negotiated;
+		BenchmarkResult arenaResult = AcquireIntoArenaBuffers(pDevice, negotiated);
+
+		// the user buffer stream opens the device itself, so Arena releases it
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+
+		BenchmarkResult userResult = AcquireIntoUserBuffers(serialNumber, negotiated);
+
+		std::cout << TAB1 << "Compare\n";
+		PrintResult("Arena buffers", arenaResult);
+		PrintResult("user buffers", userResult);
+		std::cout << "\nExample complete\n";
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,1162 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "Log/CLog.h"
+#include "Log/ILogger.h"
+#include "Log/ILoggerFactory.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Asynchronous Logger
+//    This example implements an asynchronous binary logger and installs it as
+//    the GenICam logging backend (GenICam::CLog::SetLoggerFactory), replacing
+//    the synchronous log4cpp appenders. A logging thread only checks the
+//    logger's priority, copies the format and the raw argument values into a
+//    lock-free ring buffer owned by that thread, and returns. Formatting and
+//    file output happen later on a background drain thread. Acquisition code
+//    can use the typed Log() template, which needs no format parsing at all;
+//    GenApi and other ILogger users go through LogVA(), which walks the
+//    format once to pull the arguments off the va_list. When a ring is full
+//    the message is dropped and counted instead of blocking the caller. The
+//    example measures the per-message cost on the calling thread for both
+//    paths against a synchronous fprintf, then logs every frame of an
+//    acquisition at debug priority.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images to grab
+#define NUM_IMAGES 100
+
+// log file written by the drain thread
+#define LOG_FILE "Cpp_AsyncLogger.log"
+
+// per-thread ring size in bytes; a power of two
+#define RING_SIZE (1 << 22)
+
+// drain thread sleep when all rings are empty (in microseconds)
+#define DRAIN_IDLE_US 500
+
+// number of messages per benchmark
+#define NUM_MESSAGES 200000
+
+// messages per timed burst; the rings are drained between bursts so the
+//    benchmark measures accepted messages rather than drops
+#define BURST_SIZE 10000
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// cheap timestamp; converted to nanoseconds on the drain thread
+inline uint64_t Timestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// single-producer single-consumer byte ring with variable-size records
+class LogRing
+{
+public:
+	LogRing()
+		: m_buffer(RING_SIZE), m_head(0), m_tail(0), m_cachedTail(0), m_dropped(0)
+	{
+	}
+
+	// producer: space for n bytes (a multiple of 8), or NULL when full
+	uint8_t* Reserve(size_t n)
+	{
+		uint64_t head = m_head.load(std::memory_order_relaxed);
+		size_t offset = static_cast<size_t>(head & (RING_SIZE - 1));
+		size_t padding = offset + n > RING_SIZE ? RING_SIZE - offset : 0;
+		if (head + padding + n - m_cachedTail > RING_SIZE)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if (head + padding + n - m_cachedTail > RING_SIZE)
+			{
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return NULL;
+			}
+		}
+		if (padding)
+		{
+			// records never wrap; the rest of the ring is skipped
+			uint32_t marker = static_cast<uint32_t>(padding) | PADDING;
+			memcpy(&m_buffer[offset], &marker, sizeof(marker));
+			m_head.store(head + padding, std::memory_order_release);
+			offset = 0;
+		}
+		return &m_buffer[offset];
+	}
+
+	void Commit(size_t n)
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+	}
+
+	// consumer: next record, or NULL when empty
+	const uint8_t* Peek(uint32_t* pSize)
+	{
+		for (;;)
+		{
+			uint64_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail == m_head.load(std::memory_order_acquire))
+				return NULL;
+			const uint8_t* pRecord = &m_buffer[static_cast<size_t>(tail & (RING_SIZE - 1))];
+			uint32_t size;
+			memcpy(&size, pRecord, sizeof(size));
+			if (size & PADDING)
+			{
+				m_tail.store(tail + (size & ~PADDING), std::memory_order_release);
+				continue;
+			}
+			*pSize = size;
+			return pRecord;
+		}
+	}
+
+	void Release(uint32_t size)
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+	uint64_t Dropped() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+	// producer and consumer positions; read-only, so safe from any thread
+	uint64_t Committed() const
+	{
+		return m_head.load(std::memory_order_acquire);
+	}
+
+	uint64_t Consumed() const
+	{
+		return m_tail.load(std::memory_order_acquire);
+	}
+
+private:
+	static const uint32_t PADDING = 0x80000000u;
+
+	std::vector<uint8_t> m_buffer;
+	char m_padding0[64];
+	std::atomic<uint64_t> m_head;
+	char m_padding1[64];
+	std::atomic<uint64_t> m_tail;
+	char m_padding2[64];
+	uint64_t m_cachedTail; // producer only
+	std::atomic<uint64_t> m_dropped;
+};
+
+enum LogArgTag
+{
+	ARG_INT,
+	ARG_UINT,
+	ARG_DOUBLE,
+	ARG_STRING,
+	ARG_POINTER
+};
+
+// record header; arguments follow as 16-byte slots (tag, value), strings
+//    continue in the following bytes padded to 8
+struct LogRecord
+{
+	uint32_t size;
+	uint16_t priority;
+	uint8_t numArgs;
+	uint8_t flags; // FORMAT_INLINE: format copied after the arguments
+	uint32_t indent;
+	uint32_t formatLength;
+	uint64_t timestamp;
+	const char* format;
+	const char* loggerName; // interned in the backend, which outlives every record
+};
+
+struct LogArg
+{
+	uint64_t tag;
+	union
+	{
+		int64_t i;
+		uint64_t u;
+		double d;
+		const void* p;
+		uint64_t length;
+	};
+};
+
+enum
+{
+	FORMAT_INLINE = 1
+};
+
+inline size_t Align8(size_t n)
+{
+	return (n + 7) & ~static_cast<size_t>(7);
+}
+
+// encoding of typed arguments
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, size_t>::type
+ArgSize(const T&)
+{
+	return sizeof(LogArg);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, size_t>::type
+ArgSize(const T&)
+{
+	return sizeof(LogArg);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+ArgSize(const T&)
+{
+	return sizeof(LogArg);
+}
+
+template <typename T>
+inline size_t ArgSize(T* const&)
+{
+	return sizeof(LogArg);
+}
+
+inline size_t ArgSize(const char* const& s)
+{
+	return sizeof(LogArg) + Align8(strlen(s ? s : "(null)"));
+}
+
+inline size_t ArgSize(char* const& s)
+{
+	return ArgSize(static_cast<const char* const&>(s));
+}
+
+inline size_t ArgSize(const std::string& s)
+{
+	return sizeof(LogArg) + Align8(s.size());
+}
+
+inline uint8_t* EncodeString(uint8_t* p, const char* s, size_t length)
+{
+	LogArg* pArg = reinterpret_cast<LogArg*>(p);
+	pArg->tag = ARG_STRING;
+	pArg->length = length;
+	memcpy(p + sizeof(LogArg), s, length);
+	return p + sizeof(LogArg) + Align8(length);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, uint8_t*>::type
+EncodeArg(uint8_t* p, const T& value)
+{
+	LogArg* pArg = reinterpret_cast<LogArg*>(p);
+	pArg->tag = ARG_INT;
+	pArg->i = value;
+	return p + sizeof(LogArg);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, uint8_t*>::type
+EncodeArg(uint8_t* p, const T& value)
+{
+	LogArg* pArg = reinterpret_cast<LogArg*>(p);
+	pArg->tag = ARG_UINT;
+	pArg->u = value;
+	return p + sizeof(LogArg);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, uint8_t*>::type
+EncodeArg(uint8_t* p, const T& value)
+{
+	LogArg* pArg = reinterpret_cast<LogArg*>(p);
+	pArg->tag = ARG_DOUBLE;
+	pArg->d = static_cast<double>(value);
+	return p + sizeof(LogArg);
+}
+
+template <typename T>
+inline uint8_t* EncodeArg(uint8_t* p, T* const& value)
+{
+	LogArg* pArg = reinterpret_cast<LogArg*>(p);
+	pArg->tag = ARG_POINTER;
+	pArg->p = value;
+	return p + sizeof(LogArg);
+}
+
+inline uint8_t* EncodeArg(uint8_t* p, const char* const& s)
+{
+	const char* text = s ? s : "(null)";
+	return EncodeString(p, text, strlen(text));
+}
+
+inline uint8_t* EncodeArg(uint8_t* p, char* const& s)
+{
+	return EncodeArg(p, static_cast<const char* const&>(s));
+}
+
+inline uint8_t* EncodeArg(uint8_t* p, const std::string& s)
+{
+	return EncodeString(p, s.c_str(), s.size());
+}
+
+inline size_t ArgsSize()
+{
+	return 0;
+}
+
+template <typename T, typename... Rest>
+inline size_t ArgsSize(const T& first, const Rest&... rest)
+{
+	return ArgSize(first) + ArgsSize(rest...);
+}
+
+inline uint8_t* EncodeArgs(uint8_t* p)
+{
+	return p;
+}
+
+template <typename T, typename... Rest>
+inline uint8_t* EncodeArgs(uint8_t* p, const T& first, const Rest&... rest)
+{
+	return EncodeArgs(EncodeArg(p, first), rest...);
+}
+
+// walks a printf format; calls f(conversion, hasLengthL, numStars) for each
+//    conversion and returns the position after it
+template <typename F>
+void WalkFormat(const char* format, F f)
+{
+	for (const char* p = format; *p; p++)
+	{
+		if (*p != '%')
+			continue;
+		p++;
+		if (*p == '%')
+			continue;
+		int stars = 0;
+		while (*p && strchr("-+ #0123456789.*", *p))
+		{
+			if (*p == '*')
+				stars++;
+			p++;
+		}
+		int longs = 0;
+		bool wide = false;
+		while (*p && strchr("hlLqjzt", *p))
+		{
+			if (*p == 'l')
+				longs++;
+			if (*p == 'L' || *p == 'q' || *p == 'j' || *p == 'z' || *p == 't')
+				wide = true;
+			p++;
+		}
+		if (!*p)
+			return;
+		f(*p, longs, wide, stars);
+	}
+}
+
+class AsyncLogBackend;
+
+// ILogger backed by the asynchronous ring buffers
+class AsyncLogger : public GenICam::ILogger
+{
+public:
+	AsyncLogger(const std::string& name, AsyncLogBackend& backend, int priority);
+
+	const std::string& Name() const
+	{
+		return m_name;
+	}
+
+	void SetPriority(int priority)
+	{
+		m_priority.store(priority, std::memory_order_relaxed);
+	}
+
+	bool IsEnabled(Priority priority) const
+	{
+		return static_cast<int>(priority) <= m_priority.load(std::memory_order_relaxed);
+	}
+
+	// typed fast path; the format must be a string literal
+	template <size_t N, typename... Args>
+	void Log(Priority priority, const char (&format)[N], const Args&... args);
+
+	virtual void Log(Priority priority, const char* stringFormat, ...)
+	{
+		va_list args;
+		va_start(args, stringFormat);
+		LogVA(priority, stringFormat, args);
+		va_end(args);
+	}
+
+	virtual void LogVA(Priority priority, const char* stringFormat, va_list args);
+
+private:
+	std::string m_name;
+	const char* m_pInternedName;
+	AsyncLogBackend& m_backend;
+	std::atomic<int> m_priority;
+};
+
+// owns the per-thread rings and the drain thread
+class AsyncLogBackend
+{
+public:
+	explicit AsyncLogBackend(const char* fileName)
+		: m_pFile(fopen(fileName, "w")), m_running(true), m_written(0), m_cycles(0), m_nsPerTick(1.0)
+	{
+		if (!m_pFile)
+			throw GenICam::GenericException("Could not open log file", __FILE__, __LINE__);
+		Calibrate();
+		m_drain = std::thread(&AsyncLogBackend::Drain, this);
+	}
+
+	~AsyncLogBackend()
+	{
+		Stop();
+		fclose(m_pFile);
+		for (size_t i = 0; i < m_rings.size(); i++)
+			delete m_rings[i];
+	}
+
+	// writes out everything committed and stops the drain thread; records
+	//    committed afterwards are not written
+	void Stop()
+	{
+		if (!m_drain.joinable())
+			return;
+		m_running = false;
+		m_drain.join();
+		fflush(m_pFile);
+	}
+
+	// copy of a logger name that stays valid until the backend is destroyed,
+	//    so records never refer to the logger itself
+	const char* InternName(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(m_namesLock);
+		m_names.push_back(name);
+		return m_names.back().c_str();
+	}
+
+	// ring of the calling thread, registered on first use
+	LogRing& ThreadRing()
+	{
+		static thread_local LogRing* t_pRing = NULL;
+		static thread_local AsyncLogBackend* t_pOwner = NULL;
+		if (t_pOwner != this)
+		{
+			t_pRing = new LogRing();
+			t_pOwner = this;
+			std::lock_guard<std::mutex> lock(m_ringsLock);
+			m_rings.push_back(t_pRing);
+		}
+		return *t_pRing;
+	}
+
+	static uint32_t& ThreadIndent()
+	{
+		static thread_local uint32_t t_indent = 0;
+		return t_indent;
+	}
+
+	uint64_t Dropped()
+	{
+		std::lock_guard<std::mutex> lock(m_ringsLock);
+		uint64_t dropped = 0;
+		for (size_t i = 0; i < m_rings.size(); i++)
+			dropped += m_rings[i]->Dropped();
+		return dropped;
+	}
+
+	uint64_t Written() const
+	{
+		return m_written.load();
+	}
+
+	// waits until everything committed before the call is written out; the
+	//    drain thread stays the only consumer, Flush only compares each ring's
+	//    committed position with the position the drain thread has consumed
+	void Flush()
+	{
+		std::vector<std::pair<const LogRing*, uint64_t>> targets;
+		{
+			std::lock_guard<std::mutex> lock(m_ringsLock);
+			for (size_t i = 0; i < m_rings.size(); i++)
+				targets.push_back(std::make_pair(m_rings[i], m_rings[i]->Committed()));
+		}
+
+		std::unique_lock<std::mutex> lock(m_flushLock);
+		m_drainCycle.wait(lock, [&]() {
+			for (size_t i = 0; i < targets.size(); i++)
+			{
+				if (targets[i].first->Consumed() < targets[i].second)
+					return false;
+			}
+			return true;
+		});
+
+		// consumed records are written at the end of the drain cycle that
+		// consumed them, which is at the latest the one now running
+		uint64_t cycle = m_cycles.load();
+		m_drainCycle.wait(lock, [&]() { return m_cycles.load() > cycle; });
+		lock.unlock();
+
+		std::lock_guard<std::mutex> fileLock(m_fileLock);
+		fflush(m_pFile);
+	}
+
+private:
+	void Calibrate()
+	{
+		uint64_t ticks0 = Timestamp();
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		uint64_t ticks1 = Timestamp();
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+		m_nsPerTick = ticks1 > ticks0 ? ns / static_cast<double>(ticks1 - ticks0) : 1.0;
+		m_tickBase = ticks0;
+	}
+
+	void Drain()
+	{
+		std::string line;
+		std::vector<LogRing*> rings;
+		for (;;)
+		{
+			bool stopping = !m_running.load();
+			{
+				std::lock_guard<std::mutex> lock(m_ringsLock);
+				rings = m_rings;
+			}
+
+			size_t drained = 0;
+			for (size_t r = 0; r < rings.size(); r++)
+			{
+				uint32_t size;
+				const uint8_t* pRecord;
+				while ((pRecord = rings[r]->Peek(&size)) != NULL)
+				{
+					Format(reinterpret_cast<const LogRecord*>(pRecord), line);
+					rings[r]->Release(size);
+					drained++;
+				}
+			}
+
+			if (drained)
+			{
+				std::lock_guard<std::mutex> lock(m_fileLock);
+				fwrite(line.data(), 1, line.size(), m_pFile);
+				line.clear();
+				m_written += drained;
+			}
+			{
+				std::lock_guard<std::mutex> lock(m_flushLock);
+				m_cycles++;
+			}
+			m_drainCycle.notify_all();
+
+			if (drained)
+				continue;
+			if (stopping)
+				break;
+			std::this_thread::sleep_for(std::chrono::microseconds(DRAIN_IDLE_US));
+		}
+	}
+
+	static const char* PriorityName(int priority)
+	{
+		if (priority <= GenICam::ILogger::ERR)
+			return "ERROR";
+		if (priority <= GenICam::ILogger::WARN)
+			return "WARN ";
+		if (priority <= GenICam::ILogger::INFO)
+			return "INFO ";
+		return "DEBUG";
+	}
+
+	// formats one record into line, one conversion at a time
+	void Format(const LogRecord* pRecord, std::string& line);
+
+	FILE* m_pFile;
+	std::mutex m_fileLock;
+	std::mutex m_ringsLock;
+	std::vector<LogRing*> m_rings;
+	std::mutex m_namesLock;
+	std::list<std::string> m_names;
+	std::atomic<bool> m_running;
+	std::atomic<uint64_t> m_written;
+	std::atomic<uint64_t> m_cycles;
+	std::mutex m_flushLock;
+	std::condition_variable m_drainCycle;
+	double m_nsPerTick;
+	uint64_t m_tickBase;
+	std::thread m_drain;
+
+	friend class AsyncLogger;
+};
+
+AsyncLogger::AsyncLogger(const std::string& name, AsyncLogBackend& backend, int priority)
+	: m_name(name), m_pInternedName(backend.InternName(name)), m_backend(backend), m_priority(priority)
+{
+}
+
+template <size_t N, typename... Args>
+void AsyncLogger::Log(Priority priority, const char (&format)[N], const Args&... args)
+{
+	if (!IsEnabled(priority))
+		return;
+
+	size_t size = sizeof(LogRecord) + ArgsSize(args...);
+	LogRing& ring = m_backend.ThreadRing();
+	uint8_t* p = ring.Reserve(size);
+	if (!p)
+		return;
+
+	LogRecord* pRecord = reinterpret_cast<LogRecord*>(p);
+	pRecord->size = static_cast<uint32_t>(size);
+	pRecord->priority = static_cast<uint16_t>(priority);
+	pRecord->numArgs = static_cast<uint8_t>(sizeof...(Args));
+	pRecord->flags = 0;
+	pRecord->indent = AsyncLogBackend::ThreadIndent();
+	pRecord->formatLength = static_cast<uint32_t>(N - 1);
+	pRecord->timestamp = Timestamp();
+	pRecord->format = format;
+	pRecord->loggerName = m_pInternedName;
+	EncodeArgs(p + sizeof(LogRecord), args...);
+	ring.Commit(size);
+}
+
+void AsyncLogger::LogVA(Priority priority, const char* stringFormat, va_list args)
+{
+	if (!IsEnabled(priority) || !stringFormat)
+		return;
+
+	// first walk: size; the va_list is copied because it is consumed twice
+	size_t formatLength = strlen(stringFormat);
+	size_t size = sizeof(LogRecord) + Align8(formatLength);
+	size_t numArgs = 0;
+	va_list sizing;
+	va_copy(sizing, args);
+	WalkFormat(stringFormat, [&](char conversion, int longs, bool wide, int stars) {
+		for (int s = 0; s < stars; s++)
+		{
+			va_arg(sizing, int);
+			size += sizeof(LogArg);
+			numArgs++;
+		}
+		numArgs++;
+		switch (conversion)
+		{
+		case 's':
+		{
+			const char* s = va_arg(sizing, const char*);
+			size += sizeof(LogArg) + Align8(strlen(s ? s : "(null)"));
+			return;
+		}
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			if (wide)
+				va_arg(sizing, long double);
+			else
+				va_arg(sizing, double);
+			break;
+		case 'p':
+			va_arg(sizing, void*);
+			break;
+		default:
+			if (longs >= 2 || wide)
+				va_arg(sizing, long long);
+			else if (longs == 1)
+				va_arg(sizing, long);
+			else
+				va_arg(sizing, int);
+			break;
+		}
+		size += sizeof(LogArg);
+	});
+	va_end(sizing);
+
+	LogRing& ring = m_backend.ThreadRing();
+	uint8_t* p = ring.Reserve(size);
+	if (!p)
+		return;
+
+	LogRecord* pRecord = reinterpret_cast<LogRecord*>(p);
+	pRecord->size = static_cast<uint32_t>(size);
+	pRecord->priority = static_cast<uint16_t>(priority);
+	pRecord->numArgs = static_cast<uint8_t>(std::min<size_t>(numArgs, 255));
+	pRecord->flags = FORMAT_INLINE;
+	pRecord->indent = AsyncLogBackend::ThreadIndent();
+	pRecord->formatLength = static_cast<uint32_t>(formatLength);
+	pRecord->timestamp = Timestamp();
+	pRecord->format = NULL;
+	pRecord->loggerName = m_pInternedName;
+
+	// second walk: encode
+	uint8_t* pArgs = p + sizeof(LogRecord);
+	WalkFormat(stringFormat, [&](char conversion, int longs, bool wide, int stars) {
+		for (int s = 0; s < stars; s++)
+			pArgs = EncodeArg(pArgs, va_arg(args, int));
+		switch (conversion)
+		{
+		case 's':
+			pArgs = EncodeArg(pArgs, va_arg(args, const char*));
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			if (wide)
+				pArgs = EncodeArg(pArgs, static_cast<double>(va_arg(args, long double)));
+			else
+				pArgs = EncodeArg(pArgs, va_arg(args, double));
+			break;
+		case 'p':
+			pArgs = EncodeArg(pArgs, va_arg(args, void*));
+			break;
+		case 'u': case 'o': case 'x': case 'X':
+			if (longs >= 2 || wide)
+				pArgs = EncodeArg(pArgs, va_arg(args, unsigned long long));
+			else if (longs == 1)
+				pArgs = EncodeArg(pArgs, va_arg(args, unsigned long));
+			else
+				pArgs = EncodeArg(pArgs, va_arg(args, unsigned int));
+			break;
+		default:
+			if (longs >= 2 || wide)
+				pArgs = EncodeArg(pArgs, va_arg(args, long long));
+			else if (longs == 1)
+				pArgs = EncodeArg(pArgs, va_arg(args, long));
+			else
+				pArgs = EncodeArg(pArgs, va_arg(args, int));
+			break;
+		}
+	});
+	memcpy(pArgs, stringFormat, formatLength);
+	ring.Commit(size);
+}
+
+void AsyncLogBackend::Format(const LogRecord* pRecord, std::string& line)
+{
+	// collect arguments
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(pRecord) + sizeof(LogRecord);
+	std::vector<const LogArg*> args;
+	for (size_t i = 0; i < pRecord->numArgs; i++)
+	{
+		const LogArg* pArg = reinterpret_cast<const LogArg*>(p);
+		args.push_back(pArg);
+		p += sizeof(LogArg);
+		if (pArg->tag == ARG_STRING)
+			p += Align8(pArg->length);
+	}
+	std::string format = (pRecord->flags & FORMAT_INLINE) ? std::string(reinterpret_cast<const char*>(p), pRecord->formatLength) : std::string(pRecord->format, pRecord->formatLength);
+
+	char prefix[128];
+	double ns = static_cast<double>(pRecord->timestamp - m_tickBase) * m_nsPerTick;
+	snprintf(prefix, sizeof(prefix), "%12.6f %s %s: ", ns * 1e-9, PriorityName(pRecord->priority), pRecord->loggerName);
+	line += prefix;
+	line.append(pRecord->indent * 2, ' ');
+
+	size_t next = 0;
+	char buffer[512];
+	for (size_t i = 0; i < format.size(); i++)
+	{
+		if (format[i] != '%')
+		{
+			line += format[i];
+			continue;
+		}
+		if (i + 1 < format.size() && format[i + 1] == '%')
+		{
+			line += '%';
+			i++;
+			continue;
+		}
+
+		// rebuild the conversion for the stored argument type
+		size_t start = i++;
+		std::string spec = "%";
+		while (i < format.size() && strchr("-+ #0123456789.*", format[i]))
+		{
+			if (format[i] == '*' && next < args.size())
+			{
+				std::stringstream ss;
+				ss << args[next++]->i;
+				spec += ss.str();
+			}
+			else
+				spec += format[i];
+			i++;
+		}
+		while (i < format.size() && strchr("hlLqjzt", format[i]))
+			i++;
+		if (i >= format.size() || next >= args.size())
+		{
+			line.append(format, start, std::string::npos);
+			break;
+		}
+
+		char conversion = format[i];
+		const LogArg* pArg = args[next++];
+		switch (pArg->tag)
+		{
+		case ARG_STRING:
+			spec += 's';
+			snprintf(buffer, sizeof(buffer), spec.c_str(), std::string(reinterpret_cast<const char*>(pArg + 1), pArg->length).c_str());
+			break;
+		case ARG_DOUBLE:
+			spec += conversion;
+			snprintf(buffer, sizeof(buffer), spec.c_str(), pArg->d);
+			break;
+		case ARG_POINTER:
+			spec += 'p';
+			snprintf(buffer, sizeof(buffer), spec.c_str(), pArg->p);
+			break;
+		case ARG_UINT:
+			spec += conversion == 'c' ? "c" : (std::string("ll") + (strchr("uoxX", conversion) ? conversion : 'u'));
+			if (conversion == 'c')
+				snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(pArg->u));
+			else
+				snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned long long>(pArg->u));
+			break;
+		default:
+			spec += conversion == 'c' ? "c" : (std::string("ll") + (strchr("uoxX", conversion) ? conversion : 'd'));
+			if (conversion == 'c')
+				snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(pArg->i));
+			else
+				snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long long>(pArg->i));
+			break;
+		}
+		line += buffer;
+	}
+	line += '\n';
+}
+
+// ILoggerFactory handing out asynchronous loggers
+class AsyncLoggerFactory : public GenICam::ILoggerFactory
+{
+public:
+	explicit AsyncLoggerFactory(AsyncLogBackend& backend)
+		: m_backend(backend), m_defaultPriority(GenICam::ILogger::WARN)
+	{
+	}
+
+	~AsyncLoggerFactory()
+	{
+		for (std::map<std::string, AsyncLogger*>::iterator it = m_loggers.begin(); it != m_loggers.end(); ++it)
+			delete it->second;
+	}
+
+	virtual GenICam::gcstring GetLoggerFactoryName()
+	{
+		return "AsyncLogger";
+	}
+
+	// accepts log4cpp style lines (log4j.category.<name>=<PRIORITY>, ...)
+	//    or plain <name>=<PRIORITY>; rootCategory sets the default
+	virtual void ConfigureFromString(GenICam::gcstring configString)
+	{
+		std::stringstream ss(configString.c_str());
+		std::string entry;
+		while (std::getline(ss, entry))
+		{
+			size_t equals = entry.find('=');
+			if (equals == std::string::npos || entry[0] == '#')
+				continue;
+			std::string name = entry.substr(0, equals);
+			std::string value = entry.substr(equals + 1);
+			size_t dot = name.rfind("category.");
+			if (dot != std::string::npos)
+				name = name.substr(dot + 9);
+			value = value.substr(0, value.find(','));
+			value.erase(0, value.find_first_not_of(' '));
+			value.erase(value.find_last_not_of(' ') + 1);
+
+			int priority = ParsePriority(value);
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (name == "rootCategory" || name.find("rootCategory") != std::string::npos)
+			{
+				m_defaultPriority = priority;
+				for (std::map<std::string, AsyncLogger*>::iterator it = m_loggers.begin(); it != m_loggers.end(); ++it)
+					it->second->SetPriority(priority);
+			}
+			else
+				FindOrCreate(name)->SetPriority(priority);
+		}
+	}
+
+	virtual void ConfigureDefault()
+	{
+		ConfigureFromString("rootCategory=WARN");
+	}
+
+	virtual GenICam::ILogger* GetLogger(GenICam::gcstring name)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return FindOrCreate(name.c_str());
+	}
+
+	AsyncLogger* GetAsyncLogger(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return FindOrCreate(name);
+	}
+
+	virtual bool Exist(GenICam::gcstring name)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_loggers.find(name.c_str()) != m_loggers.end();
+	}
+
+	virtual void PushIndent()
+	{
+		AsyncLogBackend::ThreadIndent()++;
+	}
+
+	virtual void PopIndent()
+	{
+		if (AsyncLogBackend::ThreadIndent() > 0)
+			AsyncLogBackend::ThreadIndent()--;
+	}
+
+private:
+	static int ParsePriority(const std::string& value)
+	{
+		if (value == "ERROR" || value == "ERR" || value == "FATAL")
+			return GenICam::ILogger::ERR;
+		if (value == "WARN")
+			return GenICam::ILogger::WARN;
+		if (value == "INFO")
+			return GenICam::ILogger::INFO;
+		if (value == "DEBUG")
+			return GenICam::ILogger::DEBUG;
+		return GenICam::ILogger::NOTSET;
+	}
+
+	// called with m_lock held; logger pointers never change once created
+	AsyncLogger* FindOrCreate(const std::string& name)
+	{
+		std::map<std::string, AsyncLogger*>::iterator it = m_loggers.find(name);
+		if (it != m_loggers.end())
+			return it->second;
+		AsyncLogger* pLogger = new AsyncLogger(name, m_backend, m_defaultPriority);
+		m_loggers[name] = pLogger;
+		return pLogger;
+	}
+
+	AsyncLogBackend& m_backend;
+	std::mutex m_lock;
+	std::map<std::string, AsyncLogger*> m_loggers;
+	int m_defaultPriority;
+};
+
+// times NUM_MESSAGES calls of f on the calling thread in bursts, flushing
+//    the backend untimed between bursts
+template <typename F>
+double MeasureNsPerMessage(AsyncLogBackend& backend, F f)
+{
+	double ns = 0.0;
+	for (int burst = 0; burst < NUM_MESSAGES; burst += BURST_SIZE)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int i = burst; i < burst + BURST_SIZE; i++)
+			f(i);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		ns += std::chrono::duration<double, std::nano>(end - start).count();
+		backend.Flush();
+	}
+	return ns / NUM_MESSAGES;
+}
+
+// compares the cost per debug message on the calling thread
+// (1) typed asynchronous path
+// (2) ILogger::Log (va_list) asynchronous path
+// (3) synchronous fprintf and fflush, as a file appender does
+void BenchmarkLogging(AsyncLogBackend& backend, AsyncLoggerFactory& factory)
+{
+	std::cout << TAB1 << "Per-message cost on the calling thread (" << NUM_MESSAGES << " debug messages)\n";
+
+	AsyncLogger* pLogger = factory.GetAsyncLogger("Benchmark");
+	pLogger->SetPriority(GenICam::ILogger::DEBUG);
+	GenICam::ILogger* pInterface = factory.GetLogger("Benchmark");
+
+	uint64_t droppedBefore = backend.Dropped();
+	double typedNs = MeasureNsPerMessage(backend, [&](int i) {
+		pLogger->Log(GenICam::ILogger::DEBUG, "frame %d exposure %.1f us status %s", i, 1234.5, "ok");
+	});
+
+	double interfaceNs = MeasureNsPerMessage(backend, [&](int i) {
+		pInterface->Log(GenICam::ILogger::DEBUG, "frame %d exposure %.1f us status %s", i, 1234.5, "ok");
+	});
+	uint64_t dropped = backend.Dropped() - droppedBefore;
+
+	FILE* pFile = fopen(LOG_FILE ".sync", "w");
+	if (!pFile)
+		throw GenICam::GenericException("Could not open log file", __FILE__, __LINE__);
+	double syncNs = MeasureNsPerMessage(backend, [&](int i) {
+		fprintf(pFile, "DEBUG Benchmark: frame %d exposure %.1f us status %s\n", i, 1234.5, "ok");
+		fflush(pFile);
+	});
+	fclose(pFile);
+	remove(LOG_FILE ".sync");
+
+	double disabledNs = MeasureNsPerMessage(backend, [&](int i) {
+		pLogger->Log(GenICam::ILogger::NOTSET, "frame %d exposure %.1f us status %s", i, 1234.5, "ok");
+	});
+
+	std::cout << TAB2 << "async typed:      " << typedNs << " ns\n";
+	std::cout << TAB2 << "async ILogger:    " << interfaceNs << " ns\n";
+	std::cout << TAB2 << "sync fprintf:     " << syncNs << " ns\n";
+	std::cout << TAB2 << "filtered out:     " << disabledNs << " ns\n";
+	std::cout << TAB2 << "dropped (ring full): " << dropped << "\n";
+}
+
+// logs every frame of an acquisition at debug priority; GenICam's own
+//    loggers write through the same backend
+void AcquireWithLogging(Arena::IDevice* pDevice, AsyncLoggerFactory& factory)
+{
+	std::cout << TAB1 << "Acquire " << NUM_IMAGES << " images with debug logging\n";
+
+	AsyncLogger* pLogger = factory.GetAsyncLogger("Acquisition");
+	pLogger->SetPriority(GenICam::ILogger::DEBUG);
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	pDevice->StartStream();
+
+	double loggingNs = 0.0;
+	for (int i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		pLogger->Log(GenICam::ILogger::DEBUG, "frame %llu size %llu timestamp %llu incomplete %d",
+			static_cast<unsigned long long>(pImage->GetFrameId()),
+			static_cast<unsigned long long>(pImage->GetSizeFilled()),
+			static_cast<unsigned long long>(pImage->GetTimestampNs()),
+			pImage->IsIncomplete() ? 1 : 0);
+		loggingNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		pDevice->RequeueBuffer(pImage);
+	}
+
+	pDevice->StopStream();
+
+	std::cout << TAB2 << "average logging cost per frame: " << loggingNs / NUM_IMAGES << " ns\n";
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_AsyncLogger\n";
+
+	try
+	{
+		// prepare example
+		//    CLog takes ownership of the factory and deletes it in ShutDown.
+		AsyncLogBackend backend(LOG_FILE);
+		AsyncLoggerFactory* pFactory = new AsyncLoggerFactory(backend);
+		pFactory->ConfigureDefault();
+		GenICam::CLog::SetLoggerFactory(*pFactory);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		BenchmarkLogging(backend, *pFactory);
+
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+			std::cout << "\n" << TAB1 << "No camera connected, skipping acquisition\n";
+		else
+		{
+			Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+			AcquireWithLogging(pDevice, *pFactory);
+			pSystem->DestroyDevice(pDevice);
+		}
+		Arena::CloseSystem(pSystem);
+
+		backend.Flush();
+		std::cout << TAB1 << backend.Written() << " messages written to " << LOG_FILE << ", " << backend.Dropped() << " dropped\n";
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		//    The backend is drained and stopped before ShutDown deletes the
+		//    factory and its loggers.
+		backend.Stop();
+		GenICam::CLog::ShutDown();
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,858 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "GenApi/impl/MathParser/MathParser.h"
+
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <sstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Band Math: Fused Spectral Indices
+//    This example computes spectral indices (NDVI, water indices, custom band
+//    ratios) over a pushbroom cube in C++ instead of per pixel in Python.
+//    Each expression is written in terms of bands, either by wavelength
+//    (b[820nm]) or by sensor column (b[42]). The expression is validated with
+//    the GenApi math parser that evaluates SwissKnife formulas, then compiled
+//    to a small stack bytecode with constant folding. Every instruction of
+//    the bytecode operates on a block of pixels at once using SIMD. All
+//    expressions are evaluated together in a single fused pass over the cube:
+//    each band is converted to float once per block and shared by every
+//    expression, and the cube lines are split across worker threads.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) in the cube
+#define NUM_LINES 200
+
+// wavelength of the first and last sensor column (in nanometers); the
+//    spectral axis of a pushbroom frame runs along the image width and the
+//    rows run across track
+#define WAVELENGTH_FIRST_COLUMN_NM 400.0
+#define WAVELENGTH_LAST_COLUMN_NM 1000.0
+
+// number of pixels evaluated by one bytecode instruction; must be a multiple
+//    of 4 for the SSE path
+#define BLOCK_PIXELS 64
+
+// number of worker threads (0 uses std::thread::hardware_concurrency)
+#define NUM_THREADS 0
+
+// number of pixels re-evaluated with the GenApi math parser as a check
+#define NUM_REFERENCE_PIXELS 16
+
+// expressions evaluated in a single fused pass
+static const char* const EXPRESSIONS[][2] = {
+	{ "NDVI", "(b[820nm]-b[670nm])/(b[820nm]+b[670nm])" },
+	{ "NDWI", "(b[560nm]-b[860nm])/(b[560nm]+b[860nm])" },
+	{ "RedEdge", "b[750nm]/b[705nm] - 1" },
+	{ "Brightness", "(b[480nm]+b[560nm]+b[670nm])/3" },
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// cube stored band-interleaved by line: each line is one pushbroom frame,
+//    transposed to numBands rows of numSamples pixels
+struct Cube
+{
+	size_t numLines;
+	size_t numBands;
+	size_t numSamples;
+	std::vector<uint16_t> data;
+
+	const uint16_t* Band(size_t line, size_t band) const
+	{
+		return &data[(line * numBands + band) * numSamples];
+	}
+};
+
+enum BandMathOp
+{
+	BM_LOAD,
+	BM_CONST,
+	BM_ADD,
+	BM_SUB,
+	BM_MUL,
+	BM_DIV,
+	BM_NEG,
+	BM_ABS,
+	BM_SQRT,
+	BM_MIN,
+	BM_MAX
+};
+
+struct BandMathInstruction
+{
+	BandMathOp op;
+	size_t slot; // BM_LOAD: index into the shared band slots
+	float value; // BM_CONST
+};
+
+// compiled expression
+struct BandMathProgram
+{
+	std::string name;
+	std::string expression;
+	std::string parserFormula; // expression rewritten for CMathParser
+	std::vector<BandMathInstruction> code;
+	size_t maxDepth;
+};
+
+// set of expressions sharing band slots
+struct BandMathPlan
+{
+	std::vector<size_t> bands; // sensor column of each slot
+	std::vector<BandMathProgram> programs;
+};
+
+// maps a wavelength to the nearest sensor column
+size_t WavelengthToBand(double wavelengthNm, size_t numBands)
+{
+	double step = (WAVELENGTH_LAST_COLUMN_NM - WAVELENGTH_FIRST_COLUMN_NM) / static_cast<double>(numBands - 1);
+	double column = std::floor((wavelengthNm - WAVELENGTH_FIRST_COLUMN_NM) / step + 0.5);
+	if (column < 0 || column > static_cast<double>(numBands - 1))
+	{
+		std::stringstream ss;
+		ss << "Wavelength " << wavelengthNm << "nm is outside the sensor range";
+		throw GenICam::GenericException(ss.str().c_str(), __FILE__, __LINE__);
+	}
+	return static_cast<size_t>(column);
+}
+
+// recursive descent compiler
+//    expr  := term (('+'|'-') term)*
+//    term  := unary (('*'|'/') unary)*
+//    unary := '-' unary | primary
+//    primary := number | band | func '(' expr [',' expr] ')' | '(' expr ')'
+class BandMathCompiler
+{
+public:
+	BandMathCompiler(BandMathPlan& plan, size_t numBands)
+		: m_plan(plan), m_numBands(numBands), m_pos(0), m_depth(0), m_maxDepth(0)
+	{
+	}
+
+	BandMathProgram Compile(const std::string& name, const std::string& expression)
+	{
+		m_text = expression;
+		m_pos = 0;
+		m_depth = 0;
+		m_maxDepth = 0;
+		m_code.clear();
+		m_formula.clear();
+
+		ParseExpr();
+		SkipSpace();
+		if (m_pos != m_text.size())
+			Fail("unexpected character");
+
+		BandMathProgram program;
+		program.name = name;
+		program.expression = expression;
+		program.parserFormula = m_formula;
+		program.code = m_code;
+		program.maxDepth = m_maxDepth;
+		return program;
+	}
+
+private:
+	void Fail(const char* reason)
+	{
+		std::stringstream ss;
+		ss << "Band math: " << reason << " at position " << m_pos << " in '" << m_text << "'";
+		throw GenICam::GenericException(ss.str().c_str(), __FILE__, __LINE__);
+	}
+
+	void SkipSpace()
+	{
+		while (m_pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_pos])))
+			m_pos++;
+	}
+
+	bool Accept(char c)
+	{
+		SkipSpace();
+		if (m_pos < m_text.size() && m_text[m_pos] == c)
+		{
+			m_pos++;
+			return true;
+		}
+		return false;
+	}
+
+	void Expect(char c)
+	{
+		if (!Accept(c))
+		{
+			std::string reason = std::string("expected '") + c + "'";
+			Fail(reason.c_str());
+		}
+	}
+
+	void Push()
+	{
+		m_depth++;
+		if (m_depth > m_maxDepth)
+			m_maxDepth = m_depth;
+	}
+
+	void EmitConst(float value)
+	{
+		BandMathInstruction inst = { BM_CONST, 0, value };
+		m_code.push_back(inst);
+		Push();
+	}
+
+	void EmitLoad(size_t band)
+	{
+		size_t slot = 0;
+		while (slot < m_plan.bands.size() && m_plan.bands[slot] != band)
+			slot++;
+		if (slot == m_plan.bands.size())
+			m_plan.bands.push_back(band);
+
+		BandMathInstruction inst = { BM_LOAD, slot, 0.0f };
+		m_code.push_back(inst);
+		Push();
+	}
+
+	// folds unary operations on constants
+	void EmitUnary(BandMathOp op)
+	{
+		BandMathInstruction& top = m_code.back();
+		if (top.op == BM_CONST)
+		{
+			if (op == BM_NEG)
+				top.value = -top.value;
+			else if (op == BM_ABS)
+				top.value = std::fabs(top.value);
+			else if (op == BM_SQRT)
+				top.value = std::sqrt(top.value);
+			return;
+		}
+		BandMathInstruction inst = { op, 0, 0.0f };
+		m_code.push_back(inst);
+	}
+
+	// folds binary operations on two constants
+	void EmitBinary(BandMathOp op)
+	{
+		size_t n = m_code.size();
+		if (n >= 2 && m_code[n - 1].op == BM_CONST && m_code[n - 2].op == BM_CONST)
+		{
+			float a = m_code[n - 2].value;
+			float b = m_code[n - 1].value;
+			float r = 0.0f;
+			switch (op)
+			{
+			case BM_ADD: r = a + b; break;
+			case BM_SUB: r = a - b; break;
+			case BM_MUL: r = a * b; break;
+			case BM_DIV: r = a / b; break;
+			case BM_MIN: r = std::min(a, b); break;
+			case BM_MAX: r = std::max(a, b); break;
+			default: break;
+			}
+			m_code.pop_back();
+			m_code.back().value = r;
+			m_depth--;
+			return;
+		}
+		BandMathInstruction inst = { op, 0, 0.0f };
+		m_code.push_back(inst);
+		m_depth--;
+	}
+
+	void ParseExpr()
+	{
+		ParseTerm();
+		for (;;)
+		{
+			if (Accept('+'))
+			{
+				m_formula += "+";
+				ParseTerm();
+				EmitBinary(BM_ADD);
+			}
+			else if (Accept('-'))
+			{
+				m_formula += "-";
+				ParseTerm();
+				EmitBinary(BM_SUB);
+			}
+			else
+				return;
+		}
+	}
+
+	void ParseTerm()
+	{
+		ParseUnary();
+		for (;;)
+		{
+			if (Accept('*'))
+			{
+				m_formula += "*";
+				ParseUnary();
+				EmitBinary(BM_MUL);
+			}
+			else if (Accept('/'))
+			{
+				m_formula += "/";
+				ParseUnary();
+				EmitBinary(BM_DIV);
+			}
+			else
+				return;
+		}
+	}
+
+	void ParseUnary()
+	{
+		if (Accept('-'))
+		{
+			m_formula += "(0-";
+			ParseUnary();
+			m_formula += ")";
+			EmitUnary(BM_NEG);
+			return;
+		}
+		ParsePrimary();
+	}
+
+	void ParsePrimary()
+	{
+		SkipSpace();
+		if (m_pos >= m_text.size())
+			Fail("unexpected end of expression");
+
+		char c = m_text[m_pos];
+		if (Accept('('))
+		{
+			m_formula += "(";
+			ParseExpr();
+			Expect(')');
+			m_formula += ")";
+			return;
+		}
+
+		if (isdigit(static_cast<unsigned char>(c)) || c == '.')
+		{
+			const char* begin = m_text.c_str() + m_pos;
+			char* end = NULL;
+			double value = strtod(begin, &end);
+			m_formula.append(begin, end - begin);
+			m_pos += end - begin;
+			EmitConst(static_cast<float>(value));
+			return;
+		}
+
+		if (!isalpha(static_cast<unsigned char>(c)))
+			Fail("unexpected character");
+
+		size_t start = m_pos;
+		while (m_pos < m_text.size() && isalnum(static_cast<unsigned char>(m_text[m_pos])))
+			m_pos++;
+		std::string ident = m_text.substr(start, m_pos - start);
+		for (size_t i = 0; i < ident.size(); i++)
+			ident[i] = static_cast<char>(tolower(static_cast<unsigned char>(ident[i])));
+
+		if (ident == "b")
+		{
+			ParseBand();
+			return;
+		}
+
+		BandMathOp op;
+		bool binary = false;
+		if (ident == "abs")
+			op = BM_ABS;
+		else if (ident == "sqrt")
+			op = BM_SQRT;
+		else if (ident == "min")
+			op = BM_MIN, binary = true;
+		else if (ident == "max")
+			op = BM_MAX, binary = true;
+		else
+			Fail("unknown function");
+
+		Expect('(');
+		if (binary)
+		{
+			// CMathParser has no min/max, so the check formula spells them
+			//    out with the ternary operator
+			size_t formulaStart = m_formula.size();
+			ParseExpr();
+			std::string a = m_formula.substr(formulaStart);
+			Expect(',');
+			m_formula.resize(formulaStart);
+			ParseExpr();
+			std::string b = m_formula.substr(formulaStart);
+			m_formula.resize(formulaStart);
+			m_formula += "((" + a + ")" + (op == BM_MIN ? "<" : ">") + "(" + b + ")?(" + a + "):(" + b + "))";
+			Expect(')');
+			EmitBinary(op);
+		}
+		else
+		{
+			m_formula += (op == BM_ABS ? "ABS(" : "SQRT(");
+			ParseExpr();
+			Expect(')');
+			m_formula += ")";
+			EmitUnary(op);
+		}
+	}
+
+	// b[820nm] selects the nearest column to a wavelength, b[42] selects a
+	//    column
+	void ParseBand()
+	{
+		Expect('[');
+		SkipSpace();
+		const char* begin = m_text.c_str() + m_pos;
+		char* end = NULL;
+		double value = strtod(begin, &end);
+		if (end == begin)
+			Fail("expected band number or wavelength");
+		m_pos += end - begin;
+
+		size_t band = 0;
+		SkipSpace();
+		if (m_text.compare(m_pos, 2, "nm") == 0)
+		{
+			m_pos += 2;
+			band = WavelengthToBand(value, m_numBands);
+		}
+		else
+		{
+			if (value < 0 || value >= static_cast<double>(m_numBands))
+				Fail("band index out of range");
+			band = static_cast<size_t>(value);
+		}
+		Expect(']');
+
+		std::stringstream ss;
+		ss << "B" << band;
+		m_formula += ss.str();
+		EmitLoad(band);
+	}
+
+	BandMathPlan& m_plan;
+	size_t m_numBands;
+	std::string m_text;
+	size_t m_pos;
+	size_t m_depth;
+	size_t m_maxDepth;
+	std::vector<BandMathInstruction> m_code;
+	std::string m_formula;
+};
+
+// validates the rewritten formula with the GenApi math parser
+void ValidateWithMathParser(const BandMathProgram& program, const BandMathPlan& plan)
+{
+	GenApi::CStrMap parameters(sizeof(double), 1);
+	double zero = 0.0;
+	for (size_t i = 0; i < plan.bands.size(); i++)
+	{
+		std::stringstream ss;
+		ss << "B" << plan.bands[i];
+		parameters.AddString(ss.str().c_str(), &zero);
+	}
+
+	GenApi::CMathParser parser;
+	parser.Parameters = &parameters;
+	const char* error = parser.Parse(program.parserFormula.c_str(), true);
+	parser.Parameters = NULL;
+	if (error)
+	{
+		std::string msg = "Math parser rejected '" + program.expression + "': " + error;
+		throw GenICam::GenericException(msg.c_str(), __FILE__, __LINE__);
+	}
+}
+
+// evaluates a program for one pixel with the GenApi math parser
+double EvaluateWithMathParser(const BandMathProgram& program, const BandMathPlan& plan, const Cube& cube, size_t line, size_t sample)
+{
+	GenApi::CStrMap parameters(sizeof(double), 1);
+	for (size_t i = 0; i < plan.bands.size(); i++)
+	{
+		std::stringstream ss;
+		ss << "B" << plan.bands[i];
+		double value = cube.Band(line, plan.bands[i])[sample];
+		parameters.AddString(ss.str().c_str(), &value);
+	}
+
+	GenApi::CMathParser parser;
+	parser.Parameters = &parameters;
+	double result = 0.0;
+	const char* error = parser.Parse(program.parserFormula.c_str(), true);
+	if (!error)
+		error = parser.Eval(&result);
+	parser.Parameters = NULL;
+	if (error)
+		throw GenICam::GenericException(error, __FILE__, __LINE__);
+	return result;
+}
+
+// converts a block of unsigned 16-bit pixels to float
+inline void LoadBlock(const uint16_t* pSrc, size_t count, float* pDst)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	if (count == BLOCK_PIXELS)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		for (; i < BLOCK_PIXELS; i += 8)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+			_mm_store_ps(pDst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+			_mm_store_ps(pDst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+		}
+		return;
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = static_cast<float>(pSrc[i]);
+	for (; i < BLOCK_PIXELS; i++)
+		pDst[i] = 0.0f;
+}
+
+// applies a binary operation to two blocks, result in a
+template <BandMathOp OP>
+inline void BinaryBlock(float* a, const float* b)
+{
+#if defined(__SSE2__)
+	for (size_t i = 0; i < BLOCK_PIXELS; i += 4)
+	{
+		__m128 x = _mm_load_ps(a + i);
+		__m128 y = _mm_load_ps(b + i);
+		__m128 r;
+		switch (OP)
+		{
+		case BM_ADD: r = _mm_add_ps(x, y); break;
+		case BM_SUB: r = _mm_sub_ps(x, y); break;
+		case BM_MUL: r = _mm_mul_ps(x, y); break;
+		case BM_DIV: r = _mm_div_ps(x, y); break;
+		case BM_MIN: r = _mm_min_ps(x, y); break;
+		default: r = _mm_max_ps(x, y); break;
+		}
+		_mm_store_ps(a + i, r);
+	}
+#else
+	for (size_t i = 0; i < BLOCK_PIXELS; i++)
+	{
+		switch (OP)
+		{
+		case BM_ADD: a[i] = a[i] + b[i]; break;
+		case BM_SUB: a[i] = a[i] - b[i]; break;
+		case BM_MUL: a[i] = a[i] * b[i]; break;
+		case BM_DIV: a[i] = a[i] / b[i]; break;
+		case BM_MIN: a[i] = std::min(a[i], b[i]); break;
+		default: a[i] = std::max(a[i], b[i]); break;
+		}
+	}
+#endif
+}
+
+inline void UnaryBlock(BandMathOp op, float* a)
+{
+#if defined(__SSE2__)
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (size_t i = 0; i < BLOCK_PIXELS; i += 4)
+	{
+		__m128 x = _mm_load_ps(a + i);
+		if (op == BM_NEG)
+			x = _mm_xor_ps(x, signMask);
+		else if (op == BM_ABS)
+			x = _mm_andnot_ps(signMask, x);
+		else
+			x = _mm_sqrt_ps(x);
+		_mm_store_ps(a + i, x);
+	}
+#else
+	for (size_t i = 0; i < BLOCK_PIXELS; i++)
+	{
+		if (op == BM_NEG)
+			a[i] = -a[i];
+		else if (op == BM_ABS)
+			a[i] = std::fabs(a[i]);
+		else
+			a[i] = std::sqrt(a[i]);
+	}
+#endif
+}
+
+// evaluates every program of the plan over a range of lines; results are
+//    written to one float plane (numLines x numSamples) per program
+void EvaluateLines(const BandMathPlan& plan, const Cube& cube, size_t firstLine, size_t lastLine, std::vector<std::vector<float> >* pOutputs)
+{
+	size_t maxDepth = 1;
+	for (size_t p = 0; p < plan.programs.size(); p++)
+		maxDepth = std::max(maxDepth, plan.programs[p].maxDepth);
+
+	// band slots and evaluation stack, aligned for SSE loads
+	std::vector<float> storage((plan.bands.size() + maxDepth) * BLOCK_PIXELS + 4);
+	float* pAligned = reinterpret_cast<float*>((reinterpret_cast<uintptr_t>(&storage[0]) + 15) & ~static_cast<uintptr_t>(15));
+	float* pSlots = pAligned;
+	float* pStack = pAligned + plan.bands.size() * BLOCK_PIXELS;
+
+	for (size_t line = firstLine; line < lastLine; line++)
+	{
+		for (size_t x = 0; x < cube.numSamples; x += BLOCK_PIXELS)
+		{
+			size_t count = std::min(static_cast<size_t>(BLOCK_PIXELS), cube.numSamples - x);
+
+			// each band is converted once per block and shared by all programs
+			for (size_t s = 0; s < plan.bands.size(); s++)
+				LoadBlock(cube.Band(line, plan.bands[s]) + x, count, pSlots + s * BLOCK_PIXELS);
+
+			for (size_t p = 0; p < plan.programs.size(); p++)
+			{
+				const std::vector<BandMathInstruction>& code = plan.programs[p].code;
+				size_t top = 0;
+				for (size_t k = 0; k < code.size(); k++)
+				{
+					const BandMathInstruction& inst = code[k];
+					float* pTop = pStack + top * BLOCK_PIXELS;
+					switch (inst.op)
+					{
+					case BM_LOAD:
+						memcpy(pTop, pSlots + inst.slot * BLOCK_PIXELS, BLOCK_PIXELS * sizeof(float));
+						top++;
+						break;
+					case BM_CONST:
+						for (size_t i = 0; i < BLOCK_PIXELS; i++)
+							pTop[i] = inst.value;
+						top++;
+						break;
+					case BM_ADD: BinaryBlock<BM_ADD>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					case BM_SUB: BinaryBlock<BM_SUB>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					case BM_MUL: BinaryBlock<BM_MUL>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					case BM_DIV: BinaryBlock<BM_DIV>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					case BM_MIN: BinaryBlock<BM_MIN>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					case BM_MAX: BinaryBlock<BM_MAX>(pTop - 2 * BLOCK_PIXELS, pTop - BLOCK_PIXELS); top--; break;
+					default: UnaryBlock(inst.op, pTop - BLOCK_PIXELS); break;
+					}
+				}
+				memcpy(&(*pOutputs)[p][line * cube.numSamples + x], pStack, count * sizeof(float));
+			}
+		}
+	}
+}
+
+// evaluates all programs in one fused pass, splitting lines across threads
+void EvaluatePlan(const BandMathPlan& plan, const Cube& cube, std::vector<std::vector<float> >* pOutputs)
+{
+	pOutputs->assign(plan.programs.size(), std::vector<float>(cube.numLines * cube.numSamples));
+
+	size_t numThreads = NUM_THREADS ? NUM_THREADS : std::thread::hardware_concurrency();
+	numThreads = std::max(static_cast<size_t>(1), std::min(numThreads, cube.numLines));
+
+	std::vector<std::thread> workers;
+	size_t linesPerThread = (cube.numLines + numThreads - 1) / numThreads;
+	for (size_t t = 0; t < numThreads; t++)
+	{
+		size_t first = t * linesPerThread;
+		size_t last = std::min(cube.numLines, first + linesPerThread);
+		if (first >= last)
+			break;
+		workers.push_back(std::thread(EvaluateLines, std::cref(plan), std::cref(cube), first, last, pOutputs));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
+
+// transposes a frame of numRows x numColumns pixels into one cube line of
+//    numColumns bands x numRows samples, in tiles that stay in cache
+void TransposeFrame(const uint16_t* pFrame, size_t numRows, size_t numColumns, uint16_t* pLine)
+{
+	const size_t tile = 32;
+	for (size_t r0 = 0; r0 < numRows; r0 += tile)
+	{
+		size_t r1 = std::min(numRows, r0 + tile);
+		for (size_t c0 = 0; c0 < numColumns; c0 += tile)
+		{
+			size_t c1 = std::min(numColumns, c0 + tile);
+			for (size_t r = r0; r < r1; r++)
+				for (size_t c = c0; c < c1; c++)
+					pLine[c * numRows + r] = pFrame[r * numColumns + c];
+		}
+	}
+}
+
+// demonstrates fused band math over an acquired cube
+// (1) acquires a cube of pushbroom lines as Mono16, one band per column
+// (2) compiles and validates all expressions
+// (3) evaluates them in one fused multi-threaded pass
+// (4) compares sample pixels against the GenApi math parser
+void ComputeBandMath(Arena::IDevice* pDevice)
+{
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// acquire cube
+	std::cout << TAB1 << "Acquire " << NUM_LINES << " lines\n";
+
+	Cube cube;
+	cube.numLines = NUM_LINES;
+	cube.numBands = 0;
+	cube.numSamples = 0;
+
+	pDevice->StartStream();
+	for (size_t line = 0; line < NUM_LINES; line++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		Arena::IImage* pMono16 = Arena::ImageFactory::Convert(pImage, Mono16);
+
+		if (line == 0)
+		{
+			cube.numBands = pMono16->GetWidth();
+			cube.numSamples = pMono16->GetHeight();
+			cube.data.resize(cube.numLines * cube.numBands * cube.numSamples);
+		}
+		TransposeFrame(reinterpret_cast<const uint16_t*>(pMono16->GetData()), cube.numSamples, cube.numBands, &cube.data[line * cube.numBands * cube.numSamples]);
+
+		Arena::ImageFactory::Destroy(pMono16);
+		pDevice->RequeueBuffer(pImage);
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << cube.numSamples << " samples x " << cube.numBands << " bands x " << cube.numLines << " lines\n";
+
+	// compile expressions
+	std::cout << TAB1 << "Compile expressions\n";
+
+	BandMathPlan plan;
+	BandMathCompiler compiler(plan, cube.numBands);
+	for (size_t i = 0; i < sizeof(EXPRESSIONS) / sizeof(EXPRESSIONS[0]); i++)
+		plan.programs.push_back(compiler.Compile(EXPRESSIONS[i][0], EXPRESSIONS[i][1]));
+
+	for (size_t i = 0; i < plan.programs.size(); i++)
+	{
+		ValidateWithMathParser(plan.programs[i], plan);
+		std::cout << TAB2 << plan.programs[i].name << ": " << plan.programs[i].parserFormula << " (" << plan.programs[i].code.size() << " instructions, stack " << plan.programs[i].maxDepth << ")\n";
+	}
+	std::cout << TAB2 << plan.bands.size() << " distinct bands shared by " << plan.programs.size() << " expressions\n";
+
+	// evaluate
+	std::cout << TAB1 << "Evaluate in a fused pass\n";
+
+	std::vector<std::vector<float> > outputs;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	EvaluatePlan(plan, cube, &outputs);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double pixels = static_cast<double>(cube.numLines * cube.numSamples);
+	std::cout << TAB2 << seconds * 1000.0 << " ms (" << pixels / seconds / 1e6 << " Mpixel/s for all expressions)\n";
+
+	// check against the math parser
+	std::cout << TAB1 << "Check against GenApi math parser\n";
+
+	for (size_t p = 0; p < plan.programs.size(); p++)
+	{
+		double maxError = 0.0;
+		for (size_t i = 0; i < NUM_REFERENCE_PIXELS; i++)
+		{
+			size_t line = (i * 7919) % cube.numLines;
+			size_t sample = (i * 104729) % cube.numSamples;
+			double expected = EvaluateWithMathParser(plan.programs[p], plan, cube, line, sample);
+			double actual = outputs[p][line * cube.numSamples + sample];
+			if (std::isfinite(expected) && std::isfinite(actual))
+				maxError = std::max(maxError, std::fabs(expected - actual) / std::max(1.0, std::fabs(expected)));
+		}
+		std::cout << TAB2 << plan.programs[p].name << ": max relative error " << maxError << "\n";
+	}
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_BandMath\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		ComputeBandMath(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
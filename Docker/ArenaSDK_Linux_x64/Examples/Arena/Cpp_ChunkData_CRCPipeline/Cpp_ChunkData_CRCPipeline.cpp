@@ -0,0 +1,701 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CRC_PCLMUL
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Chunk Data: CRC Pipeline
+//    This example verifies the CRC chunk of every frame without slowing
+//    acquisition. IChunkData::VerifyCRC (see Cpp_ChunkData_CRCValidation)
+//    runs a byte-wise CRC on the acquisition thread, so on large frames it
+//    competes with receiving. Here the CRC runs on a small pool of worker
+//    threads. The acquisition thread reads the CRC chunk, hands the buffer to
+//    the pool and goes back to GetImage. Buffers are requeued as their
+//    checks complete. The CRC uses carry-less multiplication (PCLMULQDQ) on
+//    x86 when the processor has it, or the ARMv8 CRC32 instructions when
+//    built for them. Otherwise it uses a slicing-by-8 table. Each frame's
+//    result is kept in a per-frame record. The example first times VerifyCRC
+//    on the acquisition thread, then runs the pipeline, and compares the
+//    share of a core each uses.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images in each run
+#define NUM_IMAGES 500
+
+// number of stream buffers
+#define NUM_BUFFERS 32
+
+// buffers the pool may hold before acquisition waits for one to complete;
+// the rest stay with the stream
+#define MAX_IN_FLIGHT 24
+
+// number of verification threads; 0 picks from the number of cores
+#define NUM_WORKERS 0
+
+// number of passes over one frame for the throughput comparison
+#define NUM_THROUGHPUT_PASSES 20
+
+// target share of a core for verification
+#define TARGET_CORE_PERCENT 5.0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- CRC -=-=-=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// CRC-32 (reflected polynomial 0xEDB88320); the functions below work on the
+//    running register, which starts at 0xFFFFFFFF and is inverted at the end
+
+// slicing-by-8 tables; built once, on first use from any thread
+struct CrcTables
+{
+	uint32_t t[8][256];
+
+	CrcTables()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+			t[0][i] = c;
+		}
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			for (int k = 1; k < 8; k++)
+				t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+		}
+	}
+};
+
+const uint32_t* GetCrcTables()
+{
+	static const CrcTables tables;
+	return &tables.t[0][0];
+}
+
+uint32_t Crc32Table(uint32_t crc, const uint8_t* p, size_t n)
+{
+	const uint32_t* t = GetCrcTables();
+	for (; n >= 8; n -= 8, p += 8)
+	{
+		uint32_t lo;
+		uint32_t hi;
+		std::memcpy(&lo, p, 4);
+		std::memcpy(&hi, p + 4, 4);
+		lo ^= crc;
+		crc = t[7 * 256 + (lo & 0xFF)] ^ t[6 * 256 + ((lo >> 8) & 0xFF)] ^ t[5 * 256 + ((lo >> 16) & 0xFF)] ^ t[4 * 256 + (lo >> 24)] ^
+			  t[3 * 256 + (hi & 0xFF)] ^ t[2 * 256 + ((hi >> 8) & 0xFF)] ^ t[1 * 256 + ((hi >> 16) & 0xFF)] ^ t[0 * 256 + (hi >> 24)];
+	}
+	for (; n > 0; n--, p++)
+		crc = t[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#if defined(CRC_PCLMUL)
+
+// Carry-less multiplication
+//    Folds four 128-bit lanes 64 bytes at a time, then folds them into one
+//    lane and reduces it to 32 bits (Barrett reduction). The constants are
+//    the bit-reflected fold constants for the CRC-32 polynomial, as given in
+//    Intel's "Fast CRC Computation Using PCLMULQDQ Instruction". Requires at
+//    least 64 bytes and consumes whole 16-byte blocks; the caller finishes
+//    any tail with the table.
+__attribute__((target("pclmul,sse2"))) uint32_t Crc32Pclmul(uint32_t crc, const uint8_t* p, size_t n)
+{
+	const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596LL, 0x0154442bd4LL);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009eLL, 0x01751997d0LL);
+	const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124LL);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641LL, 0x01db710641LL);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+	__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+	__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+	__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+	__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+	p += 64;
+	n -= 64;
+
+	// fold 64 bytes at a time
+	while (n >= 64)
+	{
+		__m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		__m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		__m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30)));
+		p += 64;
+		n -= 64;
+	}
+
+	// fold four lanes into one, then 16 bytes at a time
+	__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+	x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x4), x5);
+	while (n >= 16)
+	{
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), x5);
+		p += 16;
+		n -= 16;
+	}
+
+	// fold 128 bits to 64
+	x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+	// Barrett reduction to 32 bits
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+}
+
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+
+// ARMv8 CRC32 instructions; CRC32X uses the same polynomial
+uint32_t Crc32Arm(uint32_t crc, const uint8_t* p, size_t n)
+{
+	for (; n >= 8; n -= 8, p += 8)
+	{
+		uint64_t v;
+		std::memcpy(&v, p, 8);
+		crc = __crc32d(crc, v);
+	}
+	for (; n > 0; n--, p++)
+		crc = __crc32b(crc, *p);
+	return crc;
+}
+
+#endif
+
+// fastest CRC-32 implementation available on this processor
+enum CrcMethod
+{
+	CrcMethodTable,
+	CrcMethodPclmul,
+	CrcMethodArm
+};
+
+CrcMethod GetCrcMethod()
+{
+#if defined(__ARM_FEATURE_CRC32)
+	return CrcMethodArm;
+#elif defined(CRC_PCLMUL)
+	return __builtin_cpu_supports("pclmul") != 0 ? CrcMethodPclmul : CrcMethodTable;
+#else
+	return CrcMethodTable;
+#endif
+}
+
+const char* GetCrcMethodName(CrcMethod method)
+{
+	return method == CrcMethodPclmul ? "PCLMULQDQ" : method == CrcMethodArm ? "ARMv8 CRC32" : "slicing-by-8 table";
+}
+
+// CRC-32 of a buffer
+uint32_t Crc32(CrcMethod method, const uint8_t* pData, size_t size)
+{
+	uint32_t crc = 0xFFFFFFFFu;
+#if defined(CRC_PCLMUL)
+	if (method == CrcMethodPclmul && size >= 64)
+	{
+		size_t blocks = size & ~static_cast<size_t>(15);
+		crc = Crc32Pclmul(crc, pData, blocks);
+		pData += blocks;
+		size -= blocks;
+	}
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+	if (method == CrcMethodArm)
+		return ~Crc32Arm(crc, pData, size);
+#endif
+	return ~Crc32Table(crc, pData, size);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- PIPELINE -=-=
+// =-=-=-=-=-=-=-=-=-
+
+// CRC result of one frame
+enum CrcState
+{
+	CrcPending,
+	CrcVerified,
+	CrcMismatch,
+	CrcIncomplete
+};
+
+// per-frame record
+struct FrameRecord
+{
+	uint64_t frameId;
+	CrcState crcState;
+};
+
+// one buffer to verify; the image stays out of the stream until the job
+//    comes back
+struct VerifyJob
+{
+	Arena::IImage* pImage;
+	const uint8_t* pData;
+	size_t size;
+	size_t record;
+	uint32_t expected;
+	bool match;
+};
+
+// Verifier
+//    Worker pool computing CRCs. Jobs are submitted and collected by the
+//    acquisition thread only, so images are only handled on that thread;
+//    the workers only read the image data.
+class CrcVerifier
+{
+public:
+	CrcVerifier(size_t numWorkers, CrcMethod method, bool useArena)
+		: m_method(method), m_useArena(useArena), m_stop(false), m_inFlight(0), m_cpuSeconds(0.0), m_bytes(0)
+	{
+		for (size_t i = 0; i < numWorkers; i++)
+			m_workers.push_back(std::thread(&CrcVerifier::Work, this));
+	}
+
+	~CrcVerifier()
+	{
+		Stop();
+	}
+
+	void Submit(const VerifyJob& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(job);
+		}
+		m_inFlight++;
+		m_jobReady.notify_one();
+	}
+
+	// takes a completed job; waits for one if asked to
+	bool Collect(VerifyJob& job, bool wait)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (wait)
+			m_jobDone.wait(lock, [&]() { return !m_done.empty(); });
+		if (m_done.empty())
+			return false;
+		job = m_done.front();
+		m_done.pop_front();
+		m_inFlight--;
+		return true;
+	}
+
+	size_t GetInFlight() const
+	{
+		return m_inFlight;
+	}
+
+	// joins the workers; their CPU time is final afterwards
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_jobReady.notify_all();
+		for (size_t i = 0; i < m_workers.size(); i++)
+			m_workers[i].join();
+		m_workers.clear();
+	}
+
+	double GetCpuSeconds() const
+	{
+		return m_cpuSeconds;
+	}
+
+	uint64_t GetBytes() const
+	{
+		return m_bytes;
+	}
+
+private:
+	void Work()
+	{
+		for (;;)
+		{
+			VerifyJob job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobReady.wait(lock, [&]() { return m_stop || !m_jobs.empty(); });
+				if (m_jobs.empty())
+					break;
+				job = m_jobs.front();
+				m_jobs.pop_front();
+			}
+
+			uint32_t crc = m_useArena ? static_cast<uint32_t>(Arena::CalculateCRC32(job.pData, job.size)) : Crc32(m_method, job.pData, job.size);
+			job.match = crc == job.expected;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_done.push_back(job);
+				m_bytes += job.size;
+			}
+			m_jobDone.notify_one();
+		}
+
+		// CPU time of this worker
+		timespec cpu;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_cpuSeconds += cpu.tv_sec + cpu.tv_nsec * 1e-9;
+	}
+
+	CrcMethod m_method;
+	bool m_useArena;
+	bool m_stop;
+	size_t m_inFlight;
+	double m_cpuSeconds;
+	uint64_t m_bytes;
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	std::condition_variable m_jobDone;
+	std::deque<VerifyJob> m_jobs;
+	std::deque<VerifyJob> m_done;
+	std::vector<std::thread> m_workers;
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// seconds since a start time
+double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// compares VerifyCRC on the acquisition thread with the verification
+// pipeline
+// (1) enables the CRC chunk
+// (2) verifies each frame with VerifyCRC on the acquisition thread
+// (3) checks this CRC against Arena's on the first frame and compares their
+//     throughput
+// (4) verifies each frame on the worker pool while acquiring
+// (5) compares the share of a core each run spent verifying
+void VerifyCrcInPipeline(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	bool chunkModeActiveInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkModeActive");
+
+	// Activate CRC chunk
+	std::cout << TAB1 << "Activate chunk mode and enable CRC chunk\n";
+
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", true);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "CRC");
+	bool chunkEnableInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkEnable");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", true);
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// Verify on the acquisition thread
+	//    VerifyCRC runs between GetImage calls, so its time is taken from
+	//    receiving.
+	std::cout << TAB1 << "Verify " << NUM_IMAGES << " images with VerifyCRC on the acquisition thread\n";
+
+	std::vector<uint8_t> sample;
+	uint32_t sampleChunkCrc = 0;
+	size_t serialFailed = 0;
+	size_t serialIncomplete = 0;
+	double serialVerifySeconds = 0.0;
+
+	pDevice->StartStream(NUM_BUFFERS);
+	auto serialStart = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->IsIncomplete())
+		{
+			serialIncomplete++;
+		}
+		else
+		{
+			auto start = std::chrono::steady_clock::now();
+			bool valid = pImage->AsChunkData()->VerifyCRC();
+			if (!valid)
+				serialFailed++;
+			serialVerifySeconds += SecondsSince(start);
+
+			// keep the first frame that passes, with its CRC chunk, for the
+			// comparison below
+			if (valid && sample.empty())
+			{
+				size_t size = pImage->GetWidth() * pImage->GetHeight() * pImage->GetBitsPerPixel() / 8;
+				sample.assign(pImage->GetData(), pImage->GetData() + size);
+				GenApi::CIntegerPtr pChunkCRC = pImage->AsChunkData()->GetChunk("ChunkCRC");
+				sampleChunkCrc = static_cast<uint32_t>(pChunkCRC->GetValue());
+			}
+		}
+		pDevice->RequeueBuffer(pImage);
+	}
+
+	double serialSeconds = SecondsSince(serialStart);
+	pDevice->StopStream();
+
+	if (sample.empty())
+		throw GenICam::GenericException("no complete image passed VerifyCRC", __FILE__, __LINE__);
+
+	// Compare CRC implementations
+	//    The fast CRC is only used when it gives both Arena's result and the
+	//    device's own CRC chunk for a frame that passed VerifyCRC; otherwise
+	//    the pool calls Arena::CalculateCRC32, which still takes the work off
+	//    the acquisition thread.
+	CrcMethod method = GetCrcMethod();
+	uint32_t fastCrc = Crc32(method, sample.data(), sample.size());
+	bool matchesArena = fastCrc == static_cast<uint32_t>(Arena::CalculateCRC32(sample.data(), sample.size())) && fastCrc == Crc32(CrcMethodTable, sample.data(), sample.size());
+	bool matchesChunk = fastCrc == sampleChunkCrc;
+	bool useArena = !matchesArena || !matchesChunk;
+
+	std::cout << TAB1 << "Compare CRC throughput on one " << sample.size() << "-byte frame\n";
+
+	struct Candidate
+	{
+		const char* name;
+		CrcMethod method;
+		bool arena;
+	};
+	std::vector<Candidate> candidates;
+	candidates.push_back(Candidate{ "Arena::CalculateCRC32", CrcMethodTable, true });
+	candidates.push_back(Candidate{ GetCrcMethodName(CrcMethodTable), CrcMethodTable, false });
+	if (method != CrcMethodTable)
+		candidates.push_back(Candidate{ GetCrcMethodName(method), method, false });
+
+	for (size_t c = 0; c < candidates.size(); c++)
+	{
+		volatile uint32_t sink = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < NUM_THROUGHPUT_PASSES; pass++)
+			sink = sink ^ (candidates[c].arena ? static_cast<uint32_t>(Arena::CalculateCRC32(sample.data(), sample.size())) : Crc32(candidates[c].method, sample.data(), sample.size()));
+		double seconds = SecondsSince(start);
+		std::cout << TAB2 << std::left << std::setw(24) << candidates[c].name << std::right << std::fixed << std::setprecision(2) << sample.size() * NUM_THROUGHPUT_PASSES / seconds / 1e9 << " GB/s\n";
+	}
+
+	if (!matchesArena)
+		std::cout << TAB2 << "Pool uses Arena::CalculateCRC32 (fast CRC does not match Arena's)\n";
+	else if (!matchesChunk)
+		std::cout << TAB2 << "Pool uses Arena::CalculateCRC32 (fast CRC does not match ChunkCRC)\n";
+	else
+		std::cout << TAB2 << "Pool uses " << GetCrcMethodName(method) << "\n";
+
+	// Verify on the worker pool
+	//    The acquisition thread reads the CRC chunk and submits the buffer.
+	//    It collects finished checks without waiting, and only waits when
+	//    MAX_IN_FLIGHT buffers are out, so the stream always keeps some
+	//    buffers to fill.
+	size_t numWorkers = NUM_WORKERS > 0 ? NUM_WORKERS : std::max<size_t>(1, std::min<size_t>(4, std::thread::hardware_concurrency() / 2));
+	std::cout << TAB1 << "Verify " << NUM_IMAGES << " images on " << numWorkers << " worker threads\n";
+
+	std::vector<FrameRecord> records;
+	records.reserve(NUM_IMAGES);
+	CrcVerifier verifier(numWorkers, method, useArena);
+
+	pDevice->StartStream(NUM_BUFFERS);
+	auto pipelineStart = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+
+		FrameRecord record;
+		record.frameId = pImage->GetFrameId();
+		record.crcState = CrcPending;
+		records.push_back(record);
+
+		if (pImage->IsIncomplete())
+		{
+			records.back().crcState = CrcIncomplete;
+			pDevice->RequeueBuffer(pImage);
+		}
+		else
+		{
+			GenApi::CIntegerPtr pChunkCRC = pImage->AsChunkData()->GetChunk("ChunkCRC");
+			VerifyJob job;
+			job.pImage = pImage;
+			job.pData = pImage->GetData();
+			job.size = pImage->GetWidth() * pImage->GetHeight() * pImage->GetBitsPerPixel() / 8;
+			job.record = records.size() - 1;
+			job.expected = static_cast<uint32_t>(pChunkCRC->GetValue());
+			job.match = false;
+			verifier.Submit(job);
+		}
+
+		// record finished checks and return their buffers
+		VerifyJob done;
+		while (verifier.Collect(done, verifier.GetInFlight() >= MAX_IN_FLIGHT))
+		{
+			records[done.record].crcState = done.match ? CrcVerified : CrcMismatch;
+			pDevice->RequeueBuffer(done.pImage);
+		}
+	}
+
+	// the last checks
+	VerifyJob done;
+	while (verifier.GetInFlight() > 0 && verifier.Collect(done, true))
+	{
+		records[done.record].crcState = done.match ? CrcVerified : CrcMismatch;
+		pDevice->RequeueBuffer(done.pImage);
+	}
+
+	double pipelineSeconds = SecondsSince(pipelineStart);
+	verifier.Stop();
+	pDevice->StopStream();
+
+	size_t verified = 0;
+	size_t mismatched = 0;
+	size_t incomplete = 0;
+	for (size_t i = 0; i < records.size(); i++)
+	{
+		verified += records[i].crcState == CrcVerified;
+		mismatched += records[i].crcState == CrcMismatch;
+		incomplete += records[i].crcState == CrcIncomplete;
+	}
+
+	// Compare
+	//    The serial share is time inside VerifyCRC over the run; the pool's
+	//    share is the workers' CPU time over the run.
+	double serialPercent = 100.0 * serialVerifySeconds / serialSeconds;
+	double pipelinePercent = 100.0 * verifier.GetCpuSeconds() / pipelineSeconds;
+
+	std::cout << TAB1 << "Compare\n";
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << TAB2 << "VerifyCRC  " << NUM_IMAGES / serialSeconds << " fps, " << serialPercent << "% of a core verifying, " << serialFailed << " failed, " << serialIncomplete << " incomplete\n";
+	std::cout << TAB2 << "Pipeline   " << NUM_IMAGES / pipelineSeconds << " fps, " << pipelinePercent << "% of a core verifying (" << verifier.GetBytes() / std::max(verifier.GetCpuSeconds(), 1e-9) / 1e9 << " GB/s per core), " << mismatched << " failed, " << incomplete << " incomplete\n";
+	std::cout << TAB2 << verified << " of " << records.size() << " frames marked verified\n";
+	std::cout << TAB2 << (pipelinePercent <= TARGET_CORE_PERCENT ? "Within" : "Above") << " the " << TARGET_CORE_PERCENT << "% target\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", chunkEnableInitial);
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", chunkModeActiveInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ChunkData_CRCPipeline\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		VerifyCrcInPipeline(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
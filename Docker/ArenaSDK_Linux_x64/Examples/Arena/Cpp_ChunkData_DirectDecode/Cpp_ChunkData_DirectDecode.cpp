@@ -0,0 +1,653 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Chunk Data: Direct Decode
+//    This example reads chunk data from raw buffers without GenApi on each
+//    frame. IChunkData::GetChunk attaches the buffer to the chunk adapter and
+//    evaluates nodes every time it is called. At high line rates that costs a
+//    large part of the per-frame budget. Chunk data in a buffer is a list of
+//    chunks. Each chunk is followed by a tag holding its chunk ID and
+//    length, so the list is walked backwards from the end of the payload.
+//    Each chunk feature is a register at an address within one chunk. The
+//    decoder learns all this once: it follows each chunk feature through the
+//    node map to its register and reads the chunk ID, address, length,
+//    endianness and bit field. It walks the tags of the first buffer to find
+//    where each chunk sits. For every later frame it checks the tags at the
+//    learned positions and reads the fields with plain loads. Features whose
+//    value passes through a formula are read through GetChunk instead. The
+//    values go into a columnar table, one array per field. The example checks
+//    the decoder against GetChunk on the first frames and compares their
+//    speed.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images
+#define NUM_IMAGES 1000
+
+// number of images also read through GetChunk, to check the decoder and time
+// GetChunk
+#define NUM_VERIFY 100
+
+// number of table rows printed
+#define NUM_PRINT 5
+
+// chunk selector entry and chunk feature of each field; fields the device
+// does not offer are skipped
+struct ChunkFieldSetting
+{
+	const char* selector;
+	const char* chunkName;
+};
+
+static const ChunkFieldSetting CHUNK_FIELDS[] = {
+	{ "ExposureTime", "ChunkExposureTime" },
+	{ "Gain", "ChunkGain" },
+	{ "Timestamp", "ChunkTimestamp" },
+	{ "FrameID", "ChunkFrameID" },
+	{ "CRC", "ChunkCRC" }
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPERS =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// reads a big-endian 32-bit value
+uint32_t ReadBigEndian32(const uint8_t* p)
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// reads a property of a node, or returns an empty string
+std::string GetProperty(GenApi::INode* pNode, const char* name)
+{
+	GenICam::gcstring value;
+	GenICam::gcstring attribute;
+	if (!pNode->GetProperty(name, value, attribute))
+		return std::string();
+	return value.c_str();
+}
+
+// location of one chunk in a buffer
+struct ChunkLocation
+{
+	uint32_t id;
+	size_t offset;
+	size_t length;
+};
+
+// Walk chunks
+//    Each chunk is followed by an 8-byte tag: the chunk ID and the chunk
+//    length, both big-endian. Starting at the end of the payload, each tag
+//    gives the start of its chunk, which is where the previous tag ends. The
+//    walk must end exactly at the start of the buffer.
+bool WalkChunks(const uint8_t* pBuffer, size_t size, std::vector<ChunkLocation>& chunks)
+{
+	chunks.clear();
+	size_t position = size;
+	while (position > 0)
+	{
+		if (position < 8)
+			return false;
+
+		ChunkLocation chunk;
+		chunk.id = ReadBigEndian32(pBuffer + position - 8);
+		chunk.length = ReadBigEndian32(pBuffer + position - 4);
+		if (chunk.length > position - 8)
+			return false;
+
+		chunk.offset = position - 8 - chunk.length;
+		chunks.push_back(chunk);
+		position = chunk.offset;
+	}
+	return true;
+}
+
+// Metadata table
+//    One column per field, stored as an array of integers or of floating
+//    point values, plus the block ID and completeness of every frame. A
+//    column holds a whole run of one field contiguously, ready to be
+//    written, summed or plotted without gathering.
+struct MetadataColumn
+{
+	std::string name;
+	bool isFloat;
+	std::vector<int64_t> integers;
+	std::vector<double> floats;
+};
+
+struct MetadataTable
+{
+	std::vector<uint64_t> blockIds;
+	std::vector<uint8_t> complete;
+	std::vector<MetadataColumn> columns;
+
+	size_t GetNumRows() const
+	{
+		return blockIds.size();
+	}
+
+	void Reserve(size_t rows)
+	{
+		blockIds.reserve(rows);
+		complete.reserve(rows);
+		for (size_t i = 0; i < columns.size(); i++)
+		{
+			if (columns[i].isFloat)
+				columns[i].floats.reserve(rows);
+			else
+				columns[i].integers.reserve(rows);
+		}
+	}
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- DECODER -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// Chunk decoder
+//    Learns where each field sits from the node map and one buffer, then
+//    decodes fields from raw buffers.
+class ChunkDecoder
+{
+public:
+	// learns the register of each field
+	void LearnFields(GenApi::INodeMap* pNodeMap, const std::vector<std::string>& chunkNames)
+	{
+		m_fields.clear();
+		for (size_t i = 0; i < chunkNames.size(); i++)
+		{
+			FieldLayout field;
+			field.name = chunkNames[i];
+			field.direct = ResolveRegister(pNodeMap, pNodeMap->GetNode(field.name.c_str()), field);
+			if (!field.direct)
+			{
+				GenApi::CFloatPtr pFloat = pNodeMap->GetNode(field.name.c_str());
+				field.isFloat = pFloat.IsValid();
+			}
+			m_fields.push_back(field);
+		}
+	}
+
+	// learns where each chunk sits in a buffer
+	bool LearnLayout(const uint8_t* pBuffer, size_t size)
+	{
+		std::vector<ChunkLocation> chunks;
+		if (!WalkChunks(pBuffer, size, chunks))
+			return false;
+
+		m_chunks = chunks;
+		m_layoutSize = size;
+		for (size_t i = 0; i < m_fields.size(); i++)
+		{
+			FieldLayout& field = m_fields[i];
+			field.chunkIndex = -1;
+			for (size_t j = 0; j < chunks.size() && field.direct; j++)
+			{
+				if (chunks[j].id == field.chunkId && field.address + field.length <= chunks[j].length)
+					field.chunkIndex = static_cast<int>(j);
+			}
+		}
+		return true;
+	}
+
+	// decodes the fields of a buffer into a table row; fields that are not
+	// decoded directly are read from the chunk data object
+	void Decode(const uint8_t* pBuffer, size_t size, Arena::IChunkData* pChunkData, MetadataTable& table)
+	{
+		// the layout holds while every learned tag is where it was
+		if (size != m_layoutSize || !CheckLayout(pBuffer))
+		{
+			m_relearned++;
+			if (!LearnLayout(pBuffer, size))
+			{
+				// the old layout may point past this buffer, so nothing is
+				// read from it; the next buffer learns the layout again
+				m_layoutSize = 0;
+				m_undecoded++;
+				for (size_t i = 0; i < m_fields.size(); i++)
+				{
+					if (table.columns[i].isFloat)
+						table.columns[i].floats.push_back(std::nan(""));
+					else
+						table.columns[i].integers.push_back(0);
+				}
+				return;
+			}
+		}
+
+		for (size_t i = 0; i < m_fields.size(); i++)
+		{
+			const FieldLayout& field = m_fields[i];
+			MetadataColumn& column = table.columns[i];
+
+			if (field.direct && field.chunkIndex >= 0)
+			{
+				const uint8_t* p = pBuffer + m_chunks[field.chunkIndex].offset + field.address;
+				if (column.isFloat)
+					column.floats.push_back(ReadFloat(field, p));
+				else
+					column.integers.push_back(ReadInteger(field, p));
+			}
+			else if (!field.direct && pChunkData)
+			{
+				if (column.isFloat)
+					column.floats.push_back(GenApi::CFloatPtr(pChunkData->GetChunk(field.name.c_str()))->GetValue());
+				else
+					column.integers.push_back(GenApi::CIntegerPtr(pChunkData->GetChunk(field.name.c_str()))->GetValue());
+			}
+			else if (column.isFloat)
+			{
+				column.floats.push_back(std::nan(""));
+			}
+			else
+			{
+				column.integers.push_back(0);
+			}
+		}
+	}
+
+	// creates a table with a column for each field
+	MetadataTable CreateTable() const
+	{
+		MetadataTable table;
+		for (size_t i = 0; i < m_fields.size(); i++)
+		{
+			MetadataColumn column;
+			column.name = m_fields[i].name;
+			column.isFloat = m_fields[i].isFloat;
+			table.columns.push_back(column);
+		}
+		return table;
+	}
+
+	// describes how each field is read
+	void Print() const
+	{
+		for (size_t i = 0; i < m_fields.size(); i++)
+		{
+			const FieldLayout& field = m_fields[i];
+			std::cout << TAB2 << field.name << ": ";
+			if (!field.direct)
+				std::cout << "through GetChunk (not a plain register)\n";
+			else
+				std::cout << "chunk 0x" << std::hex << field.chunkId << std::dec << ", address " << field.address << ", " << field.length << " bytes" << (field.bigEndian ? " big-endian" : " little-endian") << (field.isFloat ? " float" : field.isSigned ? " signed" : " unsigned") << (field.masked ? ", bits " + std::to_string(field.lsb) + ".." + std::to_string(field.msb) : std::string()) << (field.chunkIndex < 0 ? " (chunk not in buffer)" : "") << "\n";
+		}
+	}
+
+	size_t GetRelearned() const
+	{
+		return m_relearned;
+	}
+
+	// buffers whose chunks could not be walked
+	size_t GetUndecoded() const
+	{
+		return m_undecoded;
+	}
+
+private:
+	// how to read one field
+	struct FieldLayout
+	{
+		std::string name;
+		bool direct = false;
+		bool isFloat = false;
+		uint32_t chunkId = 0;
+		size_t address = 0;
+		size_t length = 0;
+		bool bigEndian = false;
+		bool isSigned = false;
+		bool masked = false;
+		int lsb = 0;
+		int msb = 63;
+		int chunkIndex = -1;
+	};
+
+	// Resolve register
+	//    Follows pValue links from a chunk feature to the register holding
+	//    its value. A node with a formula changes the value on the way, so
+	//    such features are left to GenApi.
+	bool ResolveRegister(GenApi::INodeMap* pNodeMap, GenApi::INode* pNode, FieldLayout& field)
+	{
+		for (int depth = 0; pNode && depth < 8; depth++)
+		{
+			if (!GetProperty(pNode, "Formula").empty() || !GetProperty(pNode, "FormulaFrom").empty())
+				return false;
+
+			GenApi::CRegisterPtr pRegister = pNode;
+			if (pRegister.IsValid())
+			{
+				// chunk ID of the register's port
+				GenApi::INode* pPort = pNodeMap->GetNode(GetProperty(pNode, "pPort").c_str());
+				std::string chunkId = pPort ? GetProperty(pPort, "ChunkID") : std::string();
+				if (chunkId.empty())
+					return false;
+
+				field.chunkId = static_cast<uint32_t>(std::strtoul(chunkId.c_str(), nullptr, 16));
+				field.address = static_cast<size_t>(pRegister->GetAddress());
+				field.length = static_cast<size_t>(pRegister->GetLength());
+				field.bigEndian = GetProperty(pNode, "Endianess") == "BigEndian";
+				field.isSigned = GetProperty(pNode, "Sign") == "Signed";
+				field.isFloat = pNode->GetPrincipalInterfaceType() == GenApi::intfIFloat;
+
+				// bit fields, numbered from the least significant bit for
+				// little-endian registers and from the most significant for
+				// big-endian ones
+				std::string bit = GetProperty(pNode, "Bit");
+				std::string lsb = GetProperty(pNode, "LSB");
+				std::string msb = GetProperty(pNode, "MSB");
+				if (!bit.empty() || !lsb.empty())
+				{
+					int bits = static_cast<int>(field.length * 8);
+					int low = std::atoi((bit.empty() ? lsb : bit).c_str());
+					int high = std::atoi((bit.empty() ? msb : bit).c_str());
+					field.masked = true;
+					field.lsb = field.bigEndian ? bits - 1 - low : low;
+					field.msb = field.bigEndian ? bits - 1 - high : high;
+				}
+
+				return field.length >= 1 && field.length <= 8 && (!field.isFloat || field.length == 4 || field.length == 8);
+			}
+
+			std::string next = GetProperty(pNode, "pValue");
+			pNode = next.empty() ? nullptr : pNodeMap->GetNode(next.c_str());
+		}
+		return false;
+	}
+
+	bool CheckLayout(const uint8_t* pBuffer) const
+	{
+		for (size_t i = 0; i < m_chunks.size(); i++)
+		{
+			const uint8_t* pTag = pBuffer + m_chunks[i].offset + m_chunks[i].length;
+			if (ReadBigEndian32(pTag) != m_chunks[i].id || ReadBigEndian32(pTag + 4) != m_chunks[i].length)
+				return false;
+		}
+		return true;
+	}
+
+	static uint64_t ReadRaw(const FieldLayout& field, const uint8_t* p)
+	{
+		uint64_t raw = 0;
+		for (size_t i = 0; i < field.length; i++)
+		{
+			size_t shift = field.bigEndian ? 8 * (field.length - 1 - i) : 8 * i;
+			raw |= static_cast<uint64_t>(p[i]) << shift;
+		}
+		return raw;
+	}
+
+	static int64_t ReadInteger(const FieldLayout& field, const uint8_t* p)
+	{
+		uint64_t raw = ReadRaw(field, p);
+		int bits = static_cast<int>(field.length * 8);
+		if (field.masked)
+		{
+			bits = field.msb - field.lsb + 1;
+			raw >>= field.lsb;
+		}
+		if (bits < 64)
+		{
+			raw &= (1ull << bits) - 1;
+			if (field.isSigned && (raw >> (bits - 1)) != 0)
+				raw |= ~0ull << bits;
+		}
+		return static_cast<int64_t>(raw);
+	}
+
+	static double ReadFloat(const FieldLayout& field, const uint8_t* p)
+	{
+		uint64_t raw = ReadRaw(field, p);
+		if (field.length == 4)
+		{
+			uint32_t bits32 = static_cast<uint32_t>(raw);
+			float value;
+			std::memcpy(&value, &bits32, sizeof(value));
+			return value;
+		}
+		double value;
+		std::memcpy(&value, &raw, sizeof(value));
+		return value;
+	}
+
+	std::vector<FieldLayout> m_fields;
+	std::vector<ChunkLocation> m_chunks;
+	size_t m_layoutSize = 0;
+	size_t m_relearned = 0;
+	size_t m_undecoded = 0;
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// demonstrates decoding chunk data directly
+// (1) activates chunk mode and enables the fields' chunks
+// (2) learns the fields' registers and the layout of the first buffer
+// (3) decodes every buffer into the table
+// (4) reads the first buffers through GetChunk as well, to check and compare
+// (5) prints the table's first rows
+void DecodeChunkData(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	bool chunkModeActiveInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkModeActive");
+
+	// Activate chunk mode and enable chunks
+	std::cout << TAB1 << "Activate chunk mode and enable chunks\n";
+
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", true);
+
+	GenApi::CEnumerationPtr pChunkSelector = pNodeMap->GetNode("ChunkSelector");
+	std::vector<std::string> chunkNames;
+	std::vector<std::string> selectors;
+	std::vector<bool> chunkEnableInitials;
+	for (size_t i = 0; i < sizeof(CHUNK_FIELDS) / sizeof(CHUNK_FIELDS[0]); i++)
+	{
+		GenApi::IEnumEntry* pEntry = pChunkSelector->GetEntryByName(CHUNK_FIELDS[i].selector);
+		if (!pEntry || !GenApi::IsAvailable(pEntry) || !pNodeMap->GetNode(CHUNK_FIELDS[i].chunkName))
+		{
+			std::cout << TAB2 << CHUNK_FIELDS[i].selector << " chunk not offered; skipped\n";
+			continue;
+		}
+
+		pChunkSelector->SetIntValue(pEntry->GetValue());
+		chunkEnableInitials.push_back(Arena::GetNodeValue<bool>(pNodeMap, "ChunkEnable"));
+		Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", true);
+		chunkNames.push_back(CHUNK_FIELDS[i].chunkName);
+		selectors.push_back(CHUNK_FIELDS[i].selector);
+	}
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// Learn fields
+	//    Register addresses and chunk IDs come from the node map and do not
+	//    depend on any buffer.
+	std::cout << TAB1 << "Learn field registers\n";
+
+	ChunkDecoder decoder;
+	decoder.LearnFields(pNodeMap, chunkNames);
+	MetadataTable table = decoder.CreateTable();
+	table.Reserve(NUM_IMAGES);
+
+	// Start stream and decode
+	std::cout << TAB1 << "Decode " << NUM_IMAGES << " images\n";
+
+	pDevice->StartStream();
+
+	double decodeSeconds = 0.0;
+	double getChunkSeconds = 0.0;
+	size_t mismatches = 0;
+	size_t verified = 0;
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		const uint8_t* pBuffer = pImage->GetData();
+		size_t size = pImage->GetSizeFilled();
+
+		// learn layout from the first complete buffer
+		if (i == 0 && (pImage->IsIncomplete() || !decoder.LearnLayout(pBuffer, size)))
+			throw GenICam::GenericException("first buffer has no readable chunk layout", __FILE__, __LINE__);
+		if (i == 0)
+			decoder.Print();
+
+		// Decode
+		//    The chunk data object is only needed for fields that are not
+		//    plain registers; it is not touched otherwise.
+		table.blockIds.push_back(pImage->GetFrameId());
+		table.complete.push_back(pImage->IsIncomplete() ? 0 : 1);
+
+		auto start = std::chrono::steady_clock::now();
+		decoder.Decode(pBuffer, size, pImage->AsChunkData(), table);
+		decodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// Check against GetChunk
+		if (i < NUM_VERIFY && !pImage->IsIncomplete())
+		{
+			start = std::chrono::steady_clock::now();
+			Arena::IChunkData* pChunkData = pImage->AsChunkData();
+			for (size_t j = 0; j < table.columns.size(); j++)
+			{
+				MetadataColumn& column = table.columns[j];
+				GenApi::INode* pChunk = pChunkData->GetChunk(column.name.c_str());
+				bool same = column.isFloat ? std::abs(GenApi::CFloatPtr(pChunk)->GetValue() - column.floats.back()) <= 1e-6 * std::abs(column.floats.back()) : GenApi::CIntegerPtr(pChunk)->GetValue() == column.integers.back();
+				if (!same)
+					mismatches++;
+			}
+			getChunkSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			verified++;
+		}
+
+		pDevice->RequeueBuffer(pImage);
+	}
+
+	pDevice->StopStream();
+
+	// Print table
+	std::cout << TAB1 << "First rows of the table\n";
+	std::cout << TAB2 << std::setw(10) << "BlockID";
+	for (size_t j = 0; j < table.columns.size(); j++)
+		std::cout << std::setw(22) << table.columns[j].name;
+	std::cout << "\n";
+	for (size_t row = 0; row < table.GetNumRows() && row < NUM_PRINT; row++)
+	{
+		std::cout << TAB2 << std::setw(10) << table.blockIds[row];
+		for (size_t j = 0; j < table.columns.size(); j++)
+		{
+			if (table.columns[j].isFloat)
+				std::cout << std::setw(22) << table.columns[j].floats[row];
+			else
+				std::cout << std::setw(22) << table.columns[j].integers[row];
+		}
+		std::cout << "\n";
+	}
+
+	std::cout << TAB1 << "Compare\n";
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << TAB2 << "direct decode " << 1e6 * decodeSeconds / NUM_IMAGES << " us per frame, layout relearned " << decoder.GetRelearned() << " times, " << decoder.GetUndecoded() << " frames undecodable\n";
+	if (verified > 0)
+		std::cout << TAB2 << "GetChunk      " << 1e6 * getChunkSeconds / verified << " us per frame, " << mismatches << " mismatched values in " << verified << " frames\n";
+
+	// return nodes to their initial values
+	for (size_t i = 0; i < selectors.size(); i++)
+	{
+		Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", selectors[i].c_str());
+		Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", chunkEnableInitials[i]);
+	}
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", chunkModeActiveInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ChunkData_DirectDecode\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		DecodeChunkData(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
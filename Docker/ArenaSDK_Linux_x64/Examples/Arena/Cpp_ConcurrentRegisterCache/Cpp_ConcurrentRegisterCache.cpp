@@ -0,0 +1,598 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "GenApi/Synch.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Concurrent Register Cache
+//    This example implements a register cache with the same interface as
+//    GenApi::CValueCache (GetValue, SetValue, InvalidateValue, IsValueValid,
+//    SetCacheShield) that many threads can read without taking a global lock.
+//    CValueCache is a LockableObject: every cached register lookup takes one
+//    lock, so threads polling telemetry (temperature, frame counters)
+//    serialize with the acquisition thread updating exposure. Here the cache
+//    is split into shards by address. Each shard publishes an immutable
+//    address index that readers load without locking (RCU style: replaced
+//    indices are only freed with the cache), and every entry is guarded by a
+//    sequence lock, so readers never write shared memory and simply retry
+//    when they overlap a writer. Writers are serialized per shard only. The
+//    example then runs a contention benchmark that scales readers across
+//    cores against a single-lock cache built like CValueCache, while one
+//    writer keeps updating a register, and checks that no reader ever
+//    observes a torn value.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// number of shards; a power of two
+#define NUM_SHARDS 64
+
+// number of cached registers in the benchmark
+#define NUM_REGISTERS 512
+
+// first register address and spacing
+#define REGISTER_BASE 0x10000
+#define REGISTER_STRIDE 4
+
+// address and size of the register the writer keeps updating; it spans
+//    several 8-byte words of an entry, so a read that mixes two writes shows
+//    up as a torn value
+#define WRITER_ADDRESS 0x8000
+#define WRITER_SIZE 64
+
+// duration of each benchmark run (in milliseconds)
+#define DURATION_MS 300
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// single-lock cache laid out like CValueCache: one lock for all entries
+class LockedRegisterCache : public GenApi::LockableObject<LockedRegisterCache>
+{
+public:
+	void GetValue(int64_t address, uint32_t size, void* pValue) const
+	{
+		GenApi::AutoLock lock(m_Lock);
+		std::map<int64_t, Entry>::const_iterator it = m_entries.find(address);
+		if (it != m_entries.end())
+			memcpy(pValue, &it->second.data[0], std::min<size_t>(size, it->second.data.size()));
+	}
+
+	void SetValue(int64_t address, uint32_t size, const void* pValue)
+	{
+		GenApi::AutoLock lock(m_Lock);
+		Entry& entry = m_entries[address];
+		entry.data.assign(static_cast<const uint8_t*>(pValue), static_cast<const uint8_t*>(pValue) + size);
+		entry.valid = !entry.shield;
+	}
+
+	void InvalidateValue(int64_t address)
+	{
+		GenApi::AutoLock lock(m_Lock);
+		std::map<int64_t, Entry>::iterator it = m_entries.find(address);
+		if (it != m_entries.end())
+			it->second.valid = false;
+	}
+
+	bool IsValueValid(int64_t address, uint32_t size) const
+	{
+		GenApi::AutoLock lock(m_Lock);
+		std::map<int64_t, Entry>::const_iterator it = m_entries.find(address);
+		return it != m_entries.end() && it->second.valid && it->second.data.size() == size;
+	}
+
+	void SetCacheShield(int64_t address, bool shield) const
+	{
+		GenApi::AutoLock lock(m_Lock);
+		Entry& entry = m_entries[address];
+		entry.shield = shield;
+		if (shield)
+			entry.valid = false;
+	}
+
+private:
+	struct Entry
+	{
+		Entry()
+			: valid(false), shield(false)
+		{
+		}
+		std::vector<uint8_t> data;
+		bool valid;
+		bool shield;
+	};
+
+	mutable std::map<int64_t, Entry> m_entries;
+};
+
+// address-sharded cache with lock-free readers
+class ConcurrentRegisterCache
+{
+public:
+	ConcurrentRegisterCache()
+	{
+		for (size_t s = 0; s < NUM_SHARDS; s++)
+		{
+			ShardIndex* pEmpty = new ShardIndex();
+			m_shards[s].retired.push_back(pEmpty);
+			m_shards[s].index.store(pEmpty, std::memory_order_release);
+		}
+	}
+
+	~ConcurrentRegisterCache()
+	{
+		for (size_t s = 0; s < NUM_SHARDS; s++)
+		{
+			for (size_t i = 0; i < m_shards[s].retired.size(); i++)
+				delete m_shards[s].retired[i];
+			for (size_t i = 0; i < m_shards[s].owned.size(); i++)
+			{
+				delete[] m_shards[s].owned[i]->pWords;
+				delete m_shards[s].owned[i];
+			}
+		}
+	}
+
+	// copies the cached bytes; pValue is left untouched when the address has
+	//    never been cached
+	void GetValue(int64_t address, uint32_t size, void* pValue) const
+	{
+		Read(address, size, pValue, false);
+	}
+
+	void SetValue(int64_t address, uint32_t size, const void* pValue)
+	{
+		Shard& shard = ShardOf(address);
+		std::lock_guard<std::mutex> lock(shard.writeLock);
+		Entry* pEntry = FindOrCreate(shard, address, size);
+		uint32_t flags = pEntry->flags.load(std::memory_order_relaxed);
+		Write(pEntry, pValue, size, (flags & SHIELDED) ? flags : (flags | VALID));
+	}
+
+	void InvalidateValue(int64_t address)
+	{
+		Shard& shard = ShardOf(address);
+		std::lock_guard<std::mutex> lock(shard.writeLock);
+		Entry* pEntry = Find(shard.index.load(std::memory_order_relaxed), address);
+		if (pEntry)
+			Write(pEntry, NULL, 0, pEntry->flags.load(std::memory_order_relaxed) & ~VALID);
+	}
+
+	bool IsValueValid(int64_t address, uint32_t size) const
+	{
+		return Read(address, size, NULL, true);
+	}
+
+	// a shielded address is never reported valid until it is unshielded and
+	//    written again
+	void SetCacheShield(int64_t address, bool shield) const
+	{
+		Shard& shard = ShardOf(address);
+		std::lock_guard<std::mutex> lock(shard.writeLock);
+		Entry* pEntry = FindOrCreate(shard, address, 0);
+		uint32_t flags = pEntry->flags.load(std::memory_order_relaxed);
+		Write(pEntry, NULL, 0, shield ? ((flags | SHIELDED) & ~VALID) : (flags & ~SHIELDED));
+	}
+
+	// validity check and copy in one consistent read; this is what readers
+	//    polling telemetry should use
+	bool TryGetValue(int64_t address, uint32_t size, void* pValue) const
+	{
+		return Read(address, size, pValue, true);
+	}
+
+private:
+	enum
+	{
+		VALID = 1,
+		SHIELDED = 2
+	};
+
+	struct Entry
+	{
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint32_t> flags;
+		std::atomic<uint32_t> size;
+		uint32_t capacity; // in 8-byte words
+		std::atomic<uint64_t>* pWords;
+	};
+
+	// immutable once published
+	struct ShardIndex
+	{
+		std::vector<int64_t> addresses;
+		std::vector<Entry*> entries;
+	};
+
+	struct Shard
+	{
+		std::mutex writeLock;
+		std::atomic<const ShardIndex*> index;
+		std::vector<const ShardIndex*> retired;
+		std::vector<Entry*> owned;
+		char padding[64];
+	};
+
+	Shard& ShardOf(int64_t address) const
+	{
+		uint64_t hash = static_cast<uint64_t>(address) * 0x9E3779B97F4A7C15ull;
+		return m_shards[(hash >> 32) & (NUM_SHARDS - 1)];
+	}
+
+	static Entry* Find(const ShardIndex* pIndex, int64_t address)
+	{
+		std::vector<int64_t>::const_iterator it = std::lower_bound(pIndex->addresses.begin(), pIndex->addresses.end(), address);
+		if (it == pIndex->addresses.end() || *it != address)
+			return NULL;
+		return pIndex->entries[it - pIndex->addresses.begin()];
+	}
+
+	// called with the shard write lock held; publishes a new index when the
+	//    address is new or its entry is too small
+	Entry* FindOrCreate(Shard& shard, int64_t address, uint32_t size) const
+	{
+		const ShardIndex* pIndex = shard.index.load(std::memory_order_relaxed);
+		Entry* pEntry = Find(pIndex, address);
+		uint32_t words = (size + 7) / 8;
+		if (pEntry && pEntry->capacity >= words)
+			return pEntry;
+
+		Entry* pNew = new Entry();
+		pNew->sequence.store(0, std::memory_order_relaxed);
+		pNew->flags.store(pEntry ? pEntry->flags.load(std::memory_order_relaxed) & SHIELDED : 0, std::memory_order_relaxed);
+		pNew->size.store(0, std::memory_order_relaxed);
+		pNew->capacity = std::max<uint32_t>(words, 1);
+		pNew->pWords = new std::atomic<uint64_t>[pNew->capacity];
+		for (uint32_t i = 0; i < pNew->capacity; i++)
+			pNew->pWords[i].store(0, std::memory_order_relaxed);
+		shard.owned.push_back(pNew);
+
+		ShardIndex* pNext = new ShardIndex(*pIndex);
+		std::vector<int64_t>::iterator it = std::lower_bound(pNext->addresses.begin(), pNext->addresses.end(), address);
+		size_t position = it - pNext->addresses.begin();
+		if (pEntry)
+			pNext->entries[position] = pNew;
+		else
+		{
+			pNext->addresses.insert(it, address);
+			pNext->entries.insert(pNext->entries.begin() + position, pNew);
+		}
+		shard.retired.push_back(pNext);
+		shard.index.store(pNext, std::memory_order_release);
+		return pNew;
+	}
+
+	// seqlock write; called with the shard write lock held. pValue NULL
+	//    keeps the current bytes and only updates the flags
+	static void Write(Entry* pEntry, const void* pValue, uint32_t size, uint32_t flags)
+	{
+		uint32_t sequence = pEntry->sequence.load(std::memory_order_relaxed);
+		pEntry->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		if (pValue)
+		{
+			const uint8_t* pBytes = static_cast<const uint8_t*>(pValue);
+			for (uint32_t i = 0; i * 8 < size; i++)
+			{
+				uint64_t word = 0;
+				memcpy(&word, pBytes + i * 8, std::min<uint32_t>(8, size - i * 8));
+				pEntry->pWords[i].store(word, std::memory_order_relaxed);
+			}
+			pEntry->size.store(size, std::memory_order_relaxed);
+		}
+		pEntry->flags.store(flags, std::memory_order_relaxed);
+
+		pEntry->sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	// seqlock read; readers never write shared state
+	bool Read(int64_t address, uint32_t size, void* pValue, bool requireValid) const
+	{
+		const ShardIndex* pIndex = ShardOf(address).index.load(std::memory_order_acquire);
+		const Entry* pEntry = Find(pIndex, address);
+		if (!pEntry)
+			return false;
+
+		uint64_t local[8];
+		std::vector<uint64_t> large;
+		uint32_t words = (size + 7) / 8;
+		uint64_t* pLocal = local;
+		if (words > 8)
+		{
+			large.resize(words);
+			pLocal = &large[0];
+		}
+
+		for (;;)
+		{
+			uint32_t before = pEntry->sequence.load(std::memory_order_acquire);
+			if (before & 1)
+			{
+#if defined(__SSE2__)
+				_mm_pause();
+#endif
+				continue;
+			}
+			uint32_t flags = pEntry->flags.load(std::memory_order_relaxed);
+			uint32_t stored = pEntry->size.load(std::memory_order_relaxed);
+			uint32_t count = std::min(words, pEntry->capacity);
+			if (pValue)
+				for (uint32_t i = 0; i < count; i++)
+					pLocal[i] = pEntry->pWords[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (pEntry->sequence.load(std::memory_order_relaxed) != before)
+				continue;
+
+			bool valid = (flags & VALID) && stored == size;
+			if (requireValid && !valid)
+				return false;
+			if (pValue)
+				memcpy(pValue, pLocal, std::min(size, count * 8));
+			return valid;
+		}
+	}
+
+	mutable Shard m_shards[NUM_SHARDS];
+};
+
+// small fast generator for reader addresses
+inline uint32_t XorShift(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+struct RunResult
+{
+	double readsPerSecond;
+	uint64_t tornReads;
+};
+
+// reads through the interface GenApi uses: a validity check, then a copy
+inline bool ReaderLookup(const LockedRegisterCache& cache, int64_t address, uint32_t size, void* pValue)
+{
+	if (!cache.IsValueValid(address, size))
+		return false;
+	cache.GetValue(address, size, pValue);
+	return true;
+}
+
+inline bool ReaderLookup(const ConcurrentRegisterCache& cache, int64_t address, uint32_t size, void* pValue)
+{
+	return cache.TryGetValue(address, size, pValue);
+}
+
+// runs numReaders telemetry readers against one writer
+// (1) readers pick random registers and read them
+// (2) every 16th read checks the writer register for tearing
+// (3) the writer stores a counter in every 4-byte slot of its register and
+//     invalidates a telemetry register now and then
+template <typename Cache>
+RunResult RunContention(Cache& cache, size_t numReaders)
+{
+	std::atomic<bool> stop(false);
+	std::atomic<uint64_t> totalReads(0);
+	std::atomic<uint64_t> tornReads(0);
+
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < numReaders; r++)
+	{
+		readers.push_back(std::thread([&cache, &stop, &totalReads, &tornReads, r]() {
+			uint32_t state = static_cast<uint32_t>(r * 2654435761u + 1);
+			uint64_t reads = 0;
+			uint64_t torn = 0;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				for (int i = 0; i < 64; i++)
+				{
+					uint32_t n = XorShift(state);
+					if ((n & 15) == 0)
+					{
+						uint32_t pattern[WRITER_SIZE / 4];
+						if (ReaderLookup(cache, WRITER_ADDRESS, WRITER_SIZE, pattern))
+						{
+							for (size_t k = 1; k < WRITER_SIZE / 4; k++)
+							{
+								if (pattern[k] != pattern[0])
+								{
+									torn++;
+									break;
+								}
+							}
+						}
+					}
+					else
+					{
+						uint32_t value = 0;
+						ReaderLookup(cache, REGISTER_BASE + (n % NUM_REGISTERS) * REGISTER_STRIDE, 4, &value);
+					}
+					reads++;
+				}
+			}
+			totalReads += reads;
+			tornReads += torn;
+		}));
+	}
+
+	std::thread writer([&cache, &stop]() {
+		uint32_t counter = 0;
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			counter++;
+			uint32_t pattern[WRITER_SIZE / 4];
+			std::fill(pattern, pattern + WRITER_SIZE / 4, counter);
+			cache.SetValue(WRITER_ADDRESS, WRITER_SIZE, pattern);
+			if ((counter & 255) == 0)
+			{
+				int64_t address = REGISTER_BASE + (counter / 256 % NUM_REGISTERS) * REGISTER_STRIDE;
+				cache.InvalidateValue(address);
+				cache.SetValue(address, 4, &counter);
+			}
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(DURATION_MS));
+	stop = true;
+	writer.join();
+	for (size_t r = 0; r < readers.size(); r++)
+		readers[r].join();
+
+	RunResult result;
+	result.readsPerSecond = static_cast<double>(totalReads.load()) * 1000.0 / DURATION_MS;
+	result.tornReads = tornReads.load();
+	return result;
+}
+
+template <typename Cache>
+void Populate(Cache& cache)
+{
+	for (uint32_t i = 0; i < NUM_REGISTERS; i++)
+		cache.SetValue(REGISTER_BASE + i * REGISTER_STRIDE, 4, &i);
+	uint32_t pattern[WRITER_SIZE / 4] = { 0 };
+	cache.SetValue(WRITER_ADDRESS, WRITER_SIZE, pattern);
+}
+
+// checks CValueCache semantics on the concurrent cache
+void CheckSemantics()
+{
+	std::cout << TAB1 << "Check cache semantics\n";
+
+	ConcurrentRegisterCache cache;
+	uint32_t value = 0x12345678;
+	uint32_t readBack = 0;
+	bool ok = true;
+
+	ok = ok && !cache.IsValueValid(0x100, 4);
+	cache.SetValue(0x100, 4, &value);
+	ok = ok && cache.IsValueValid(0x100, 4) && !cache.IsValueValid(0x100, 8);
+	cache.GetValue(0x100, 4, &readBack);
+	ok = ok && readBack == value;
+
+	cache.InvalidateValue(0x100);
+	ok = ok && !cache.IsValueValid(0x100, 4);
+
+	cache.SetCacheShield(0x100, true);
+	cache.SetValue(0x100, 4, &value);
+	ok = ok && !cache.IsValueValid(0x100, 4);
+	cache.SetCacheShield(0x100, false);
+	ok = ok && !cache.IsValueValid(0x100, 4);
+	cache.SetValue(0x100, 4, &value);
+	ok = ok && cache.IsValueValid(0x100, 4);
+
+	// growing an entry republishes the index
+	uint8_t large[64];
+	for (size_t i = 0; i < sizeof(large); i++)
+		large[i] = static_cast<uint8_t>(i);
+	uint8_t largeBack[64] = { 0 };
+	cache.SetValue(0x100, sizeof(large), large);
+	ok = ok && cache.TryGetValue(0x100, sizeof(large), largeBack) && memcmp(large, largeBack, sizeof(large)) == 0;
+
+	std::cout << TAB2 << (ok ? "passed" : "FAILED") << "\n";
+	if (!ok)
+		throw GenICam::GenericException("Concurrent register cache semantics check failed", __FILE__, __LINE__);
+}
+
+// benchmarks both caches with an increasing number of readers
+void BenchmarkContention()
+{
+	std::cout << TAB1 << "Contention benchmark (" << DURATION_MS << " ms per run, 1 writer)\n";
+	std::cout << TAB2 << std::setw(8) << "readers" << std::setw(16) << "single lock" << std::setw(16) << "sharded" << std::setw(10) << "speedup" << std::setw(8) << "torn" << "\n";
+
+	size_t maxReaders = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t readers = 1; readers <= maxReaders; readers *= 2)
+	{
+		LockedRegisterCache locked;
+		Populate(locked);
+		RunResult lockedResult = RunContention(locked, readers);
+
+		ConcurrentRegisterCache sharded;
+		Populate(sharded);
+		RunResult shardedResult = RunContention(sharded, readers);
+
+		std::cout << TAB2 << std::setw(8) << readers
+				  << std::setw(12) << std::fixed << std::setprecision(1) << lockedResult.readsPerSecond / 1e6 << " M/s"
+				  << std::setw(12) << shardedResult.readsPerSecond / 1e6 << " M/s"
+				  << std::setw(9) << shardedResult.readsPerSecond / lockedResult.readsPerSecond << "x"
+				  << std::setw(8) << (lockedResult.tornReads + shardedResult.tornReads) << "\n";
+
+		if (shardedResult.tornReads)
+			throw GenICam::GenericException("Torn read observed in the concurrent register cache", __FILE__, __LINE__);
+	}
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ConcurrentRegisterCache\n";
+
+	try
+	{
+		// run example
+		std::cout << "Commence example\n\n";
+		CheckSemantics();
+		BenchmarkContention();
+		std::cout << "\nExample complete\n";
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
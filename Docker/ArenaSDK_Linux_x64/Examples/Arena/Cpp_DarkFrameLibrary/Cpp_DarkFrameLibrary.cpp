@@ -0,0 +1,620 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Dark Frame Library
+//    This example keeps a library of averaged dark frames taken on a grid of
+//    exposure times and sensor temperatures, so that fresh darks are not
+//    needed before every scan. Dark current grows with both exposure time
+//    and DeviceTemperature (see Cpp_Callback_Polling). The library file holds
+//    a fixed header followed by page-aligned float planes, so it is mapped
+//    into memory with mmap and only the planes in use are ever read from
+//    disk. While acquiring, the example reads the temperature every few
+//    frames; when it or the exposure time moves, a worker thread blends the
+//    four surrounding planes into a new dark plane in one vectorized pass and
+//    publishes it. The acquisition loop keeps subtracting whichever plane is
+//    current and never waits for the interpolation. If no library exists
+//    yet, the example first builds one while the sensor warms up.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// pixel format; a 16-bit container mono format
+#define PIXEL_FORMAT "Mono16"
+
+// library file
+#define LIBRARY_FILE "Cpp_DarkFrameLibrary.dfl"
+
+// exposure times of the library grid (in microseconds)
+static const double LIBRARY_EXPOSURES[] = { 1000.0, 5000.0, 20000.0, 50000.0 };
+
+// number of temperature steps captured while building
+#define NUM_TEMPERATURE_STEPS 3
+
+// temperature rise between steps (in degrees Celsius), and the longest
+//    wait for it (in seconds)
+#define TEMPERATURE_STEP 2.0
+#define TEMPERATURE_WAIT_S 600
+
+// frames averaged into each dark plane, and frames discarded after an
+//    exposure change
+#define NUM_FRAMES_PER_DARK 16
+#define NUM_DISCARDED_FRAMES 2
+
+// incomplete or mis-sized frames tolerated while averaging a dark plane
+#define MAX_BAD_FRAMES 32
+
+// number of images acquired with dark subtraction
+#define NUM_IMAGES 200
+
+// frames between temperature reads while acquiring
+#define POLL_INTERVAL_FRAMES 10
+
+// temperature change that triggers a new dark plane (in degrees Celsius)
+#define TEMPERATURE_TOLERANCE 0.25
+
+// exposure times used while acquiring; the second is set half way through
+#define RUN_EXPOSURE_FIRST 3000.0
+#define RUN_EXPOSURE_SECOND 30000.0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+#define LIBRARY_MAGIC 0x314C4644u // "DFL1"
+#define LIBRARY_MAX_GRID 32
+#define LIBRARY_ALIGNMENT 4096
+
+// fixed-size header at the start of the library file; plane (t, e) starts
+//    at planeOffset + (t * numExposures + e) * planeStride. Temperatures are
+//    stored in capture order.
+struct DarkLibraryHeader
+{
+	uint32_t magic;
+	uint32_t width;
+	uint32_t height;
+	uint32_t numExposures;
+	uint32_t numTemperatures;
+	uint32_t reserved;
+	uint64_t planeOffset;
+	uint64_t planeStride;
+	double exposures[LIBRARY_MAX_GRID];
+	double temperatures[LIBRARY_MAX_GRID];
+};
+
+inline uint64_t AlignUp(uint64_t n)
+{
+	return (n + LIBRARY_ALIGNMENT - 1) / LIBRARY_ALIGNMENT * LIBRARY_ALIGNMENT;
+}
+
+// read-only view of a library file
+class DarkFrameLibrary
+{
+public:
+	explicit DarkFrameLibrary(const char* fileName)
+		: m_pBase(NULL), m_size(0)
+	{
+		int fd = open(fileName, O_RDONLY);
+		if (fd < 0)
+			throw GenICam::GenericException("Could not open dark frame library", __FILE__, __LINE__);
+		struct stat info;
+		if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(DarkLibraryHeader))
+		{
+			close(fd);
+			throw GenICam::GenericException("Dark frame library is truncated", __FILE__, __LINE__);
+		}
+		m_size = static_cast<size_t>(info.st_size);
+		void* pBase = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (pBase == MAP_FAILED)
+			throw GenICam::GenericException("Could not map dark frame library", __FILE__, __LINE__);
+		m_pBase = static_cast<const uint8_t*>(pBase);
+
+		const DarkLibraryHeader& header = Header();
+		uint64_t planes = static_cast<uint64_t>(header.numExposures) * header.numTemperatures;
+		if (header.magic != LIBRARY_MAGIC || header.numExposures == 0 || header.numTemperatures == 0 || header.numExposures > LIBRARY_MAX_GRID || header.numTemperatures > LIBRARY_MAX_GRID || header.planeStride < static_cast<uint64_t>(header.width) * header.height * sizeof(float) || header.planeOffset + planes * header.planeStride > m_size)
+		{
+			munmap(pBase, m_size);
+			throw GenICam::GenericException("Not a valid dark frame library", __FILE__, __LINE__);
+		}
+
+		// temperature axis in ascending order
+		for (uint32_t t = 0; t < header.numTemperatures; t++)
+			m_temperatureOrder.push_back(t);
+		std::sort(m_temperatureOrder.begin(), m_temperatureOrder.end(), [&](uint32_t a, uint32_t b) {
+			return header.temperatures[a] < header.temperatures[b];
+		});
+	}
+
+	~DarkFrameLibrary()
+	{
+		munmap(const_cast<uint8_t*>(m_pBase), m_size);
+	}
+
+	const DarkLibraryHeader& Header() const
+	{
+		return *reinterpret_cast<const DarkLibraryHeader*>(m_pBase);
+	}
+
+	size_t NumPixels() const
+	{
+		return static_cast<size_t>(Header().width) * Header().height;
+	}
+
+	const float* Plane(size_t exposureIndex, size_t temperatureIndex) const
+	{
+		const DarkLibraryHeader& header = Header();
+		uint64_t plane = static_cast<uint64_t>(temperatureIndex) * header.numExposures + exposureIndex;
+		return reinterpret_cast<const float*>(m_pBase + header.planeOffset + plane * header.planeStride);
+	}
+
+	// dark plane for any exposure and temperature; bilinear between the four
+	//    surrounding grid planes, clamped at the edges of the grid
+	void Interpolate(double exposure, double temperature, float* pDark) const
+	{
+		const DarkLibraryHeader& header = Header();
+
+		size_t e0, e1;
+		double we;
+		Bracket(header.exposures, NULL, header.numExposures, exposure, e0, e1, we);
+		size_t t0, t1;
+		double wt;
+		Bracket(header.temperatures, m_temperatureOrder.data(), header.numTemperatures, temperature, t0, t1, wt);
+
+		const float* p00 = Plane(e0, t0);
+		const float* p01 = Plane(e1, t0);
+		const float* p10 = Plane(e0, t1);
+		const float* p11 = Plane(e1, t1);
+		float w00 = static_cast<float>((1.0 - we) * (1.0 - wt));
+		float w01 = static_cast<float>(we * (1.0 - wt));
+		float w10 = static_cast<float>((1.0 - we) * wt);
+		float w11 = static_cast<float>(we * wt);
+
+		size_t n = NumPixels();
+		size_t i = 0;
+#if defined(__SSE2__)
+		__m128 v00 = _mm_set1_ps(w00);
+		__m128 v01 = _mm_set1_ps(w01);
+		__m128 v10 = _mm_set1_ps(w10);
+		__m128 v11 = _mm_set1_ps(w11);
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(p00 + i), v00);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p01 + i), v01));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p10 + i), v10));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(p11 + i), v11));
+			_mm_storeu_ps(pDark + i, sum);
+		}
+#endif
+		for (; i < n; i++)
+			pDark[i] = p00[i] * w00 + p01[i] * w01 + p10[i] * w10 + p11[i] * w11;
+	}
+
+private:
+	// grid indices either side of value and the weight of the upper one;
+	//    pOrder lists the axis in ascending order when it is not stored so
+	static void Bracket(const double* axis, const uint32_t* pOrder, size_t count, double value, size_t& lower, size_t& upper, double& weight)
+	{
+		size_t k = 0;
+		while (k + 1 < count && axis[pOrder ? pOrder[k + 1] : k + 1] <= value)
+			k++;
+		size_t kUpper = std::min(k + 1, count - 1);
+		lower = pOrder ? pOrder[k] : k;
+		upper = pOrder ? pOrder[kUpper] : kUpper;
+		double span = axis[upper] - axis[lower];
+		weight = span > 1e-9 ? std::min(std::max((value - axis[lower]) / span, 0.0), 1.0) : 0.0;
+	}
+
+	const uint8_t* m_pBase;
+	size_t m_size;
+	std::vector<uint32_t> m_temperatureOrder;
+};
+
+// interpolates dark planes on a worker thread and publishes the result
+class DarkFrameProvider
+{
+public:
+	explicit DarkFrameProvider(const DarkFrameLibrary& library)
+		: m_library(library), m_pending(false), m_running(true), m_updates(0)
+	{
+		m_worker = std::thread(&DarkFrameProvider::Work, this);
+	}
+
+	~DarkFrameProvider()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_running = false;
+		}
+		m_wake.notify_one();
+		m_worker.join();
+	}
+
+	// asks for a plane; a newer request replaces one not yet started
+	void Request(double exposure, double temperature)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_exposure = exposure;
+			m_temperature = temperature;
+			m_pending = true;
+		}
+		m_wake.notify_one();
+	}
+
+	// current plane; NULL until the first one is ready
+	std::shared_ptr<const std::vector<float> > Current() const
+	{
+		return std::atomic_load(&m_current);
+	}
+
+	size_t Updates() const
+	{
+		return m_updates.load();
+	}
+
+private:
+	void Work()
+	{
+		for (;;)
+		{
+			double exposure;
+			double temperature;
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_wake.wait(lock, [this]() { return m_pending || !m_running; });
+				if (!m_running)
+					return;
+				exposure = m_exposure;
+				temperature = m_temperature;
+				m_pending = false;
+			}
+
+			// a fresh buffer; the acquisition thread may still hold the old one
+			std::shared_ptr<std::vector<float> > pDark = std::make_shared<std::vector<float> >(m_library.NumPixels());
+			m_library.Interpolate(exposure, temperature, pDark->data());
+			std::atomic_store(&m_current, std::shared_ptr<const std::vector<float> >(pDark));
+			m_updates++;
+		}
+	}
+
+	const DarkFrameLibrary& m_library;
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	double m_exposure;
+	double m_temperature;
+	bool m_pending;
+	bool m_running;
+	std::atomic<size_t> m_updates;
+	std::shared_ptr<const std::vector<float> > m_current;
+	std::thread m_worker;
+};
+
+// calibration kernel: subtracts the dark plane, rounding and clamping at 0
+void SubtractDark(const uint16_t* pRaw, const float* pDark, uint16_t* pOut, size_t n)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zeroPs = _mm_setzero_ps();
+	const __m128i bias = _mm_set1_epi32(0x8000);
+	const __m128i biasPacked = _mm_set1_epi16(static_cast<short>(0x8000));
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRaw + i));
+		__m128 lo = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero)), _mm_loadu_ps(pDark + i));
+		__m128 hi = _mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero)), _mm_loadu_ps(pDark + i + 4));
+		__m128i loInt = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(lo, zeroPs), half));
+		__m128i hiInt = _mm_cvttps_epi32(_mm_add_ps(_mm_max_ps(hi, zeroPs), half));
+
+		// SSE2 only packs signed; shift to signed range and back
+		__m128i packed = _mm_packs_epi32(_mm_sub_epi32(loInt, bias), _mm_sub_epi32(hiInt, bias));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm_add_epi16(packed, biasPacked));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		float value = static_cast<float>(pRaw[i]) - pDark[i];
+		pOut[i] = static_cast<uint16_t>(std::max(value, 0.0f) + 0.5f);
+	}
+}
+
+// averages numFrames complete frames into average; gives up after
+//    MAX_BAD_FRAMES incomplete or mis-sized frames
+void AverageFrames(Arena::IDevice* pDevice, size_t numFrames, std::vector<float>& average)
+{
+	std::vector<double> sum(average.size(), 0.0);
+	size_t badFrames = 0;
+	for (size_t f = 0; f < numFrames;)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		bool good = !pImage->IsIncomplete() && pImage->GetWidth() * pImage->GetHeight() == average.size();
+		if (good)
+		{
+			const uint16_t* pPixels = reinterpret_cast<const uint16_t*>(pImage->GetData());
+			for (size_t i = 0; i < sum.size(); i++)
+				sum[i] += pPixels[i];
+			f++;
+		}
+		pDevice->RequeueBuffer(pImage);
+
+		if (!good && ++badFrames > MAX_BAD_FRAMES)
+			throw GenICam::GenericException("Too many incomplete frames; check the packet size and packet resend", __FILE__, __LINE__);
+	}
+	for (size_t i = 0; i < sum.size(); i++)
+		average[i] = static_cast<float>(sum[i] / numFrames);
+}
+
+void DiscardFrames(Arena::IDevice* pDevice, size_t numFrames)
+{
+	for (size_t f = 0; f < numFrames; f++)
+		pDevice->RequeueBuffer(pDevice->GetImage(TIMEOUT));
+}
+
+// builds the library while the sensor warms up
+// (1) writes a provisional header
+// (2) at each temperature step, captures a dark plane per exposure
+// (3) waits for the sensor to warm by one step, streaming meanwhile
+// (4) rewrites the header with the measured temperatures
+void BuildLibrary(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+	GenApi::CFloatPtr pTemperature = pNodeMap->GetNode("DeviceTemperature");
+	if (!pTemperature || !GenApi::IsReadable(pTemperature))
+		throw GenICam::GenericException("DeviceTemperature node not found/readable", __FILE__, __LINE__);
+
+	std::cout << TAB1 << "Build dark frame library\n";
+	std::cout << TAB2 << "Cover the lens and press enter";
+	std::getchar();
+
+	// provisional header
+	DarkLibraryHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = LIBRARY_MAGIC;
+	header.width = static_cast<uint32_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+	header.height = static_cast<uint32_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	header.numExposures = static_cast<uint32_t>(sizeof(LIBRARY_EXPOSURES) / sizeof(LIBRARY_EXPOSURES[0]));
+	header.numTemperatures = NUM_TEMPERATURE_STEPS;
+	header.planeOffset = AlignUp(sizeof(DarkLibraryHeader));
+	header.planeStride = AlignUp(static_cast<uint64_t>(header.width) * header.height * sizeof(float));
+	for (uint32_t e = 0; e < header.numExposures; e++)
+		header.exposures[e] = LIBRARY_EXPOSURES[e];
+
+	std::ofstream file(LIBRARY_FILE, std::ios::binary | std::ios::trunc);
+	if (!file)
+		throw GenICam::GenericException("Could not create dark frame library", __FILE__, __LINE__);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	std::vector<float> plane(static_cast<size_t>(header.width) * header.height);
+	std::vector<char> padding(LIBRARY_ALIGNMENT, 0);
+	pDevice->StartStream();
+	for (uint32_t t = 0; t < header.numTemperatures; t++)
+	{
+		// wait for the next temperature step
+		if (t > 0)
+		{
+			double target = header.temperatures[t - 1] + TEMPERATURE_STEP;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			while (pTemperature->GetValue() < target && std::chrono::steady_clock::now() - start < std::chrono::seconds(TEMPERATURE_WAIT_S))
+			{
+				DiscardFrames(pDevice, 10);
+				std::cout << "\r" << TAB2 << "waiting for " << target << " C, now " << pTemperature->GetValue() << " C   " << std::flush;
+			}
+			std::cout << "\n";
+		}
+
+		// one plane per exposure; temperature is averaged over the step
+		double temperatureSum = 0.0;
+		for (uint32_t e = 0; e < header.numExposures; e++)
+		{
+			Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", header.exposures[e]);
+			DiscardFrames(pDevice, NUM_DISCARDED_FRAMES);
+			temperatureSum += pTemperature->GetValue();
+			AverageFrames(pDevice, NUM_FRAMES_PER_DARK, plane);
+
+			uint64_t offset = header.planeOffset + (static_cast<uint64_t>(t) * header.numExposures + e) * header.planeStride;
+			file.seekp(static_cast<std::streamoff>(offset));
+			file.write(reinterpret_cast<const char*>(plane.data()), plane.size() * sizeof(float));
+			size_t tail = static_cast<size_t>(header.planeStride - plane.size() * sizeof(float));
+			file.write(padding.data(), tail);
+		}
+		header.temperatures[t] = temperatureSum / header.numExposures;
+		std::cout << TAB2 << "step " << t << ": " << header.numExposures << " planes at " << header.temperatures[t] << " C\n";
+	}
+	pDevice->StopStream();
+
+	// final header
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!file)
+		throw GenICam::GenericException("Could not write dark frame library", __FILE__, __LINE__);
+}
+
+// acquires with dark subtraction from the library
+// (1) maps the library and starts the interpolation worker
+// (2) requests the first plane and waits for it once
+// (3) reads the temperature every few frames and requests new planes
+// (4) changes exposure half way through
+// (5) subtracts the current plane from every frame
+void AcquireWithDarkLibrary(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+	GenApi::CFloatPtr pTemperature = pNodeMap->GetNode("DeviceTemperature");
+
+	// map library
+	DarkFrameLibrary library(LIBRARY_FILE);
+	const DarkLibraryHeader& header = library.Header();
+	std::cout << TAB1 << "Map " << LIBRARY_FILE << ": " << header.numExposures << " exposures x " << header.numTemperatures << " temperatures, " << header.width << "x" << header.height << "\n";
+	if (header.width != Arena::GetNodeValue<int64_t>(pNodeMap, "Width") || header.height != Arena::GetNodeValue<int64_t>(pNodeMap, "Height"))
+		throw GenICam::GenericException("Dark frame library does not match the image size", __FILE__, __LINE__);
+
+	DarkFrameProvider provider(library);
+
+	// first plane
+	double exposure = RUN_EXPOSURE_FIRST;
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposure);
+	double temperature = pTemperature->GetValue();
+	provider.Request(exposure, temperature);
+	while (!provider.Current())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	std::cout << TAB1 << "Acquire " << NUM_IMAGES << " images\n";
+
+	std::vector<uint16_t> calibrated(library.NumPixels());
+	double kernelNs = 0.0;
+	pDevice->StartStream();
+	for (int i = 0; i < NUM_IMAGES; i++)
+	{
+		// change exposure
+		if (i == NUM_IMAGES / 2)
+		{
+			exposure = RUN_EXPOSURE_SECOND;
+			Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposure);
+			provider.Request(exposure, temperature);
+			std::cout << TAB2 << "exposure changed to " << exposure << " us\n";
+		}
+
+		// follow temperature
+		if (i % POLL_INTERVAL_FRAMES == 0)
+		{
+			double now = pTemperature->GetValue();
+			if (std::fabs(now - temperature) > TEMPERATURE_TOLERANCE)
+			{
+				temperature = now;
+				provider.Request(exposure, temperature);
+				std::cout << TAB2 << "temperature moved to " << temperature << " C\n";
+			}
+		}
+
+		// calibrate with whichever plane is current
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (!pImage->IsIncomplete() && pImage->GetWidth() * pImage->GetHeight() == calibrated.size())
+		{
+			std::shared_ptr<const std::vector<float> > pDark = provider.Current();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			SubtractDark(reinterpret_cast<const uint16_t*>(pImage->GetData()), pDark->data(), calibrated.data(), calibrated.size());
+			kernelNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		}
+		pDevice->RequeueBuffer(pImage);
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << provider.Updates() << " dark planes interpolated, subtraction " << kernelNs / NUM_IMAGES / 1000.0 << " us per frame\n";
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_DarkFrameLibrary\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat");
+		GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "ExposureAuto");
+		double exposureTimeInitial = Arena::GetNodeValue<double>(pDevice->GetNodeMap(), "ExposureTime");
+
+		Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", PIXEL_FORMAT);
+		Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "ExposureAuto", "Off");
+		Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+		Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		struct stat info;
+		if (stat(LIBRARY_FILE, &info) != 0)
+			BuildLibrary(pDevice);
+		AcquireWithDarkLibrary(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		Arena::SetNodeValue<double>(pDevice->GetNodeMap(), "ExposureTime", exposureTimeInitial);
+		Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "ExposureAuto", exposureAutoInitial);
+		Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", pixelFormatInitial);
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
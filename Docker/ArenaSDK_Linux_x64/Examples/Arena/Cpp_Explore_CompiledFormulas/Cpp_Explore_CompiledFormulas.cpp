@@ -0,0 +1,1167 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Explore: Compiled Formulas
+//    This example compiles the formulas of SwissKnife, IntSwissKnife,
+//    Converter and IntConverter nodes into flat evaluation programs. GenApi
+//    evaluates these formulas with its math parser on every access; the
+//    compiled programs are built once when the node map is explored, fold
+//    constant symbols and constant subexpressions away, and then only read
+//    the variable nodes and run a short list of instructions. Converter
+//    inversion (setting a feature through FormulaTo) is served by a cached
+//    monotone table over the register range, refined by bisection on the
+//    compiled FormulaFrom. The example benchmarks every formula node of the
+//    system, interface, device and stream node maps against GenApi and checks
+//    that the compiled programs agree with it.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// timeout for detecting camera devices (in milliseconds).
+#define SYSTEM_TIMEOUT 100
+
+// number of timed accesses per node
+#define NUM_ITERATIONS 2000
+
+// number of samples in a converter inversion table
+#define INVERSE_TABLE_SIZE 1025
+
+// relative tolerance when comparing compiled and GenApi values
+#define TOLERANCE 1e-9
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+enum FormulaOp
+{
+	F_CONST,
+	F_VAR,
+	F_NEG,
+	F_NOT,
+	F_BITNOT,
+	F_FUNC,
+	F_ADD,
+	F_SUB,
+	F_MUL,
+	F_DIV,
+	F_MOD,
+	F_POW,
+	F_SHL,
+	F_SHR,
+	F_LT,
+	F_GT,
+	F_LE,
+	F_GE,
+	F_EQ,
+	F_NE,
+	F_AND,
+	F_XOR,
+	F_OR,
+	F_LAND,
+	F_LOR,
+	F_ROUND2,
+	F_SELECT
+};
+
+enum FormulaFunc
+{
+	FN_SGN,
+	FN_NEG,
+	FN_ATAN,
+	FN_COS,
+	FN_SIN,
+	FN_TAN,
+	FN_ABS,
+	FN_EXP,
+	FN_LN,
+	FN_LG,
+	FN_SQRT,
+	FN_TRUNC,
+	FN_FLOOR,
+	FN_CEIL,
+	FN_ROUND,
+	FN_ASIN,
+	FN_ACOS
+};
+
+static const char* const FUNCTION_NAMES[] = {
+	"SGN", "NEG", "ATAN", "COS", "SIN", "TAN", "ABS", "EXP", "LN", "LG",
+	"SQRT", "TRUNC", "FLOOR", "CEIL", "ROUND", "ASIN", "ACOS"
+};
+
+struct FormulaInstruction
+{
+	FormulaOp op;
+	size_t arg; // F_VAR: variable index, F_FUNC: FormulaFunc
+	double dvalue; // F_CONST
+	int64_t ivalue; // F_CONST
+};
+
+size_t Arity(FormulaOp op)
+{
+	if (op == F_CONST || op == F_VAR)
+		return 0;
+	if (op <= F_FUNC)
+		return 1;
+	if (op == F_SELECT)
+		return 3;
+	return 2;
+}
+
+// operator set of each binary precedence level, lowest first
+static const char* const BINARY_LEVELS[][4] = {
+	{ "||", NULL, NULL, NULL },
+	{ "&&", NULL, NULL, NULL },
+	{ "|", NULL, NULL, NULL },
+	{ "^", NULL, NULL, NULL },
+	{ "&", NULL, NULL, NULL },
+	{ "=", "<>", NULL, NULL },
+	{ "<", ">", "<=", ">=" },
+	{ "<<", ">>", NULL, NULL },
+	{ "+", "-", NULL, NULL },
+	{ "*", "/", "%", NULL },
+};
+#define NUM_BINARY_LEVELS (sizeof(BINARY_LEVELS) / sizeof(BINARY_LEVELS[0]))
+
+FormulaOp BinaryOp(const std::string& token)
+{
+	static const char* const tokens[] = { "||", "&&", "|", "^", "&", "=", "<>", "<", ">", "<=", ">=", "<<", ">>", "+", "-", "*", "/", "%", "**" };
+	static const FormulaOp ops[] = { F_LOR, F_LAND, F_OR, F_XOR, F_AND, F_EQ, F_NE, F_LT, F_GT, F_LE, F_GE, F_SHL, F_SHR, F_ADD, F_SUB, F_MUL, F_DIV, F_MOD, F_POW };
+	for (size_t i = 0; i < sizeof(tokens) / sizeof(tokens[0]); i++)
+		if (token == tokens[i])
+			return ops[i];
+	return F_CONST;
+}
+
+// compiles a SwissKnife formula to reverse polish notation; symbols are
+//    looked up in the variable and constant tables of the node
+class FormulaParser
+{
+public:
+	FormulaParser(const std::map<std::string, size_t>& variables, const std::map<std::string, std::string>& constants)
+		: m_variables(variables), m_constants(constants), m_pos(0)
+	{
+	}
+
+	std::vector<FormulaInstruction> Parse(const std::string& formula)
+	{
+		m_text = formula;
+		m_pos = 0;
+		m_code.clear();
+		ParseTernary();
+		SkipSpace();
+		if (m_pos != m_text.size())
+			Fail("unexpected character");
+		return m_code;
+	}
+
+private:
+	// a formula the parser cannot compile is a logic error, kept apart from
+	//    nodes that are merely unavailable
+	void Fail(const char* reason)
+	{
+		std::stringstream ss;
+		ss << "Formula: " << reason << " at position " << m_pos << " in '" << m_text << "'";
+		throw GenICam::LogicalErrorException(ss.str().c_str(), __FILE__, __LINE__);
+	}
+
+	void SkipSpace()
+	{
+		while (m_pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_pos])))
+			m_pos++;
+	}
+
+	// longest operator at the current position
+	std::string PeekOperator()
+	{
+		static const char* const two[] = { "**", "<<", ">>", "<=", ">=", "<>", "&&", "||" };
+		SkipSpace();
+		if (m_pos >= m_text.size())
+			return "";
+		for (size_t i = 0; i < sizeof(two) / sizeof(two[0]); i++)
+			if (m_text.compare(m_pos, 2, two[i]) == 0)
+				return two[i];
+		return std::string(1, m_text[m_pos]);
+	}
+
+	bool Accept(const char* token)
+	{
+		if (PeekOperator() == token)
+		{
+			m_pos += strlen(token);
+			return true;
+		}
+		return false;
+	}
+
+	void Emit(FormulaOp op, size_t arg = 0)
+	{
+		FormulaInstruction inst = { op, arg, 0.0, 0 };
+		m_code.push_back(inst);
+	}
+
+	void EmitConst(double dvalue, int64_t ivalue)
+	{
+		FormulaInstruction inst = { F_CONST, 0, dvalue, ivalue };
+		m_code.push_back(inst);
+	}
+
+	void EmitLiteral(const std::string& literal)
+	{
+		const char* begin = literal.c_str();
+		char* end = NULL;
+		if (literal.size() > 2 && literal[0] == '0' && (literal[1] == 'x' || literal[1] == 'X'))
+		{
+			int64_t value = static_cast<int64_t>(strtoull(begin, &end, 16));
+			EmitConst(static_cast<double>(value), value);
+		}
+		else
+		{
+			double value = strtod(begin, &end);
+			EmitConst(value, static_cast<int64_t>(value));
+		}
+		if (end == begin)
+			Fail("invalid literal");
+	}
+
+	void ParseTernary()
+	{
+		ParseBinary(0);
+		if (Accept("?"))
+		{
+			ParseTernary();
+			if (!Accept(":"))
+				Fail("expected ':'");
+			ParseTernary();
+			Emit(F_SELECT);
+		}
+	}
+
+	void ParseBinary(size_t level)
+	{
+		if (level == NUM_BINARY_LEVELS)
+		{
+			ParseUnary();
+			return;
+		}
+
+		ParseBinary(level + 1);
+		for (;;)
+		{
+			std::string token = PeekOperator();
+			bool found = false;
+			for (size_t i = 0; i < 4 && BINARY_LEVELS[level][i]; i++)
+				found = found || token == BINARY_LEVELS[level][i];
+			if (!found)
+				return;
+			m_pos += token.size();
+			ParseBinary(level + 1);
+			Emit(BinaryOp(token));
+		}
+	}
+
+	void ParseUnary()
+	{
+		if (Accept("-"))
+		{
+			ParseUnary();
+			Emit(F_NEG);
+		}
+		else if (Accept("+"))
+			ParseUnary();
+		else if (Accept("~"))
+		{
+			ParseUnary();
+			Emit(F_BITNOT);
+		}
+		else if (Accept("!"))
+		{
+			ParseUnary();
+			Emit(F_NOT);
+		}
+		else
+		{
+			ParsePrimary();
+			if (Accept("**"))
+			{
+				ParseUnary();
+				Emit(F_POW);
+			}
+		}
+	}
+
+	void ParsePrimary()
+	{
+		SkipSpace();
+		if (m_pos >= m_text.size())
+			Fail("unexpected end of formula");
+
+		if (Accept("("))
+		{
+			ParseTernary();
+			if (!Accept(")"))
+				Fail("expected ')'");
+			return;
+		}
+
+		char c = m_text[m_pos];
+		size_t start = m_pos;
+		if (isdigit(static_cast<unsigned char>(c)) || c == '.')
+		{
+			while (m_pos < m_text.size() && (isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '.' ||
+				((m_text[m_pos] == '-' || m_text[m_pos] == '+') && (m_text[m_pos - 1] == 'e' || m_text[m_pos - 1] == 'E') && m_text[start + 1] != 'x')))
+				m_pos++;
+			EmitLiteral(m_text.substr(start, m_pos - start));
+			return;
+		}
+
+		if (!isalpha(static_cast<unsigned char>(c)) && c != '_')
+			Fail("unexpected character");
+
+		while (m_pos < m_text.size() && (isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_' || m_text[m_pos] == '.'))
+			m_pos++;
+		std::string ident = m_text.substr(start, m_pos - start);
+
+		std::map<std::string, size_t>::const_iterator var = m_variables.find(ident);
+		if (var != m_variables.end())
+		{
+			Emit(F_VAR, var->second);
+			return;
+		}
+
+		std::map<std::string, std::string>::const_iterator constant = m_constants.find(ident);
+		if (constant != m_constants.end())
+		{
+			// Constant and Expression symbols are inlined
+			FormulaParser nested(m_variables, m_constants);
+			std::vector<FormulaInstruction> code = nested.Parse(constant->second);
+			m_code.insert(m_code.end(), code.begin(), code.end());
+			return;
+		}
+
+		std::string upper = ident;
+		for (size_t i = 0; i < upper.size(); i++)
+			upper[i] = static_cast<char>(toupper(static_cast<unsigned char>(upper[i])));
+
+		if (upper == "PI" || upper == "E")
+		{
+			if (Accept("("))
+				Accept(")");
+			double value = upper == "PI" ? 3.14159265358979323846 : 2.71828182845904523536;
+			EmitConst(value, static_cast<int64_t>(value));
+			return;
+		}
+
+		for (size_t fn = 0; fn < sizeof(FUNCTION_NAMES) / sizeof(FUNCTION_NAMES[0]); fn++)
+		{
+			if (upper != FUNCTION_NAMES[fn])
+				continue;
+			if (!Accept("("))
+				Fail("expected '('");
+			ParseTernary();
+			if (fn == FN_ROUND && Accept(","))
+			{
+				ParseTernary();
+				Emit(F_ROUND2);
+			}
+			else
+				Emit(F_FUNC, fn);
+			if (!Accept(")"))
+				Fail("expected ')'");
+			return;
+		}
+
+		Fail("unknown symbol");
+	}
+
+	const std::map<std::string, size_t>& m_variables;
+	const std::map<std::string, std::string>& m_constants;
+	std::string m_text;
+	size_t m_pos;
+	std::vector<FormulaInstruction> m_code;
+};
+
+// arithmetic for float formulas (SwissKnife, Converter)
+inline double ApplyFunc(size_t fn, double a)
+{
+	switch (fn)
+	{
+	case FN_SGN: return a > 0 ? 1.0 : (a < 0 ? -1.0 : 0.0);
+	case FN_NEG: return -a;
+	case FN_ATAN: return atan(a);
+	case FN_COS: return cos(a);
+	case FN_SIN: return sin(a);
+	case FN_TAN: return tan(a);
+	case FN_ABS: return fabs(a);
+	case FN_EXP: return exp(a);
+	case FN_LN: return log(a);
+	case FN_LG: return log10(a);
+	case FN_SQRT: return sqrt(a);
+	case FN_TRUNC: return a < 0 ? ceil(a) : floor(a);
+	case FN_FLOOR: return floor(a);
+	case FN_CEIL: return ceil(a);
+	case FN_ROUND: return floor(a + 0.5);
+	case FN_ASIN: return asin(a);
+	default: return acos(a);
+	}
+}
+
+inline double Apply(FormulaOp op, double a, double b)
+{
+	switch (op)
+	{
+	case F_NEG: return -a;
+	case F_NOT: return a == 0 ? 1.0 : 0.0;
+	case F_BITNOT: return static_cast<double>(~static_cast<int64_t>(a));
+	case F_ADD: return a + b;
+	case F_SUB: return a - b;
+	case F_MUL: return a * b;
+	case F_DIV: return a / b;
+	case F_MOD: return fmod(a, b);
+	case F_POW: return pow(a, b);
+	case F_SHL: return static_cast<double>(static_cast<int64_t>(a) << static_cast<int64_t>(b));
+	case F_SHR: return static_cast<double>(static_cast<int64_t>(a) >> static_cast<int64_t>(b));
+	case F_LT: return a < b ? 1.0 : 0.0;
+	case F_GT: return a > b ? 1.0 : 0.0;
+	case F_LE: return a <= b ? 1.0 : 0.0;
+	case F_GE: return a >= b ? 1.0 : 0.0;
+	case F_EQ: return a == b ? 1.0 : 0.0;
+	case F_NE: return a != b ? 1.0 : 0.0;
+	case F_AND: return static_cast<double>(static_cast<int64_t>(a) & static_cast<int64_t>(b));
+	case F_XOR: return static_cast<double>(static_cast<int64_t>(a) ^ static_cast<int64_t>(b));
+	case F_OR: return static_cast<double>(static_cast<int64_t>(a) | static_cast<int64_t>(b));
+	case F_LAND: return (a != 0 && b != 0) ? 1.0 : 0.0;
+	case F_LOR: return (a != 0 || b != 0) ? 1.0 : 0.0;
+	default:
+	{
+		// F_ROUND2
+		double scale = pow(10.0, b);
+		return floor(a * scale + 0.5) / scale;
+	}
+	}
+}
+
+// arithmetic for integer formulas (IntSwissKnife, IntConverter)
+inline int64_t ApplyFunc(size_t fn, int64_t a)
+{
+	switch (fn)
+	{
+	case FN_SGN: return a > 0 ? 1 : (a < 0 ? -1 : 0);
+	case FN_NEG: return -a;
+	case FN_ABS: return a < 0 ? -a : a;
+	case FN_TRUNC:
+	case FN_FLOOR:
+	case FN_CEIL:
+	case FN_ROUND: return a;
+	default: return static_cast<int64_t>(ApplyFunc(fn, static_cast<double>(a)));
+	}
+}
+
+inline int64_t Apply(FormulaOp op, int64_t a, int64_t b)
+{
+	switch (op)
+	{
+	case F_NEG: return -a;
+	case F_NOT: return a == 0 ? 1 : 0;
+	case F_BITNOT: return ~a;
+	case F_ADD: return a + b;
+	case F_SUB: return a - b;
+	case F_MUL: return a * b;
+	case F_DIV: return b == 0 ? 0 : a / b;
+	case F_MOD: return b == 0 ? 0 : a % b;
+	case F_POW: return static_cast<int64_t>(pow(static_cast<double>(a), static_cast<double>(b)));
+	case F_SHL: return a << b;
+	case F_SHR: return a >> b;
+	case F_LT: return a < b ? 1 : 0;
+	case F_GT: return a > b ? 1 : 0;
+	case F_LE: return a <= b ? 1 : 0;
+	case F_GE: return a >= b ? 1 : 0;
+	case F_EQ: return a == b ? 1 : 0;
+	case F_NE: return a != b ? 1 : 0;
+	case F_AND: return a & b;
+	case F_XOR: return a ^ b;
+	case F_OR: return a | b;
+	case F_LAND: return (a != 0 && b != 0) ? 1 : 0;
+	case F_LOR: return (a != 0 || b != 0) ? 1 : 0;
+	default: return a;
+	}
+}
+
+inline double ConstValue(const FormulaInstruction& inst, double)
+{
+	return inst.dvalue;
+}
+
+inline int64_t ConstValue(const FormulaInstruction& inst, int64_t)
+{
+	return inst.ivalue;
+}
+
+// flat evaluation program over a value type (double or int64_t)
+template <typename T>
+class CompiledFormula
+{
+public:
+	CompiledFormula()
+		: m_maxDepth(0)
+	{
+	}
+
+	explicit CompiledFormula(const std::vector<FormulaInstruction>& code)
+		: m_code(code), m_maxDepth(0)
+	{
+		Fold();
+	}
+
+	// replaces a variable by a constant and refolds
+	void Bind(size_t variable, T value)
+	{
+		for (size_t i = 0; i < m_code.size(); i++)
+		{
+			if (m_code[i].op == F_VAR && m_code[i].arg == variable)
+			{
+				m_code[i].op = F_CONST;
+				m_code[i].dvalue = static_cast<double>(value);
+				m_code[i].ivalue = static_cast<int64_t>(value);
+			}
+		}
+		Fold();
+	}
+
+	T Evaluate(const T* pVariables) const
+	{
+		T* pStack = &m_stack[0];
+		size_t top = 0;
+		for (size_t i = 0; i < m_code.size(); i++)
+		{
+			const FormulaInstruction& inst = m_code[i];
+			switch (inst.op)
+			{
+			case F_CONST:
+				pStack[top++] = ConstValue(inst, T());
+				break;
+			case F_VAR:
+				pStack[top++] = pVariables[inst.arg];
+				break;
+			case F_NEG:
+			case F_NOT:
+			case F_BITNOT:
+				pStack[top - 1] = Apply(inst.op, pStack[top - 1], T());
+				break;
+			case F_FUNC:
+				pStack[top - 1] = ApplyFunc(inst.arg, pStack[top - 1]);
+				break;
+			case F_SELECT:
+				top -= 2;
+				pStack[top - 1] = pStack[top - 1] != 0 ? pStack[top] : pStack[top + 1];
+				break;
+			default:
+				top--;
+				pStack[top - 1] = Apply(inst.op, pStack[top - 1], pStack[top]);
+				break;
+			}
+		}
+		return pStack[0];
+	}
+
+	size_t Size() const
+	{
+		return m_code.size();
+	}
+
+private:
+	// folds every operation whose operands are all constants
+	void Fold()
+	{
+		std::vector<FormulaInstruction> folded;
+		size_t depth = 0;
+		m_maxDepth = 1;
+		for (size_t i = 0; i < m_code.size(); i++)
+		{
+			const FormulaInstruction& inst = m_code[i];
+			size_t arity = Arity(inst.op);
+			depth = depth + 1 - arity;
+			m_maxDepth = std::max(m_maxDepth, depth + arity);
+
+			bool constant = arity > 0 && folded.size() >= arity;
+			for (size_t k = 0; constant && k < arity; k++)
+				constant = folded[folded.size() - 1 - k].op == F_CONST;
+
+			if (!constant)
+			{
+				folded.push_back(inst);
+				continue;
+			}
+
+			std::vector<FormulaInstruction> expression(folded.end() - arity, folded.end());
+			expression.push_back(inst);
+			folded.resize(folded.size() - arity);
+
+			CompiledFormula<T> sub;
+			sub.m_code = expression;
+			sub.m_maxDepth = arity;
+			sub.m_stack.resize(arity);
+			T value = sub.Evaluate(NULL);
+
+			FormulaInstruction result = { F_CONST, 0, static_cast<double>(value), static_cast<int64_t>(value) };
+			folded.push_back(result);
+		}
+		m_code = folded;
+		m_stack.assign(m_maxDepth, T());
+	}
+
+	std::vector<FormulaInstruction> m_code;
+	size_t m_maxDepth;
+	mutable std::vector<T> m_stack;
+};
+
+// splits a tab-delimited property list
+std::vector<std::string> SplitTabs(const GenICam::gcstring& text)
+{
+	std::vector<std::string> items;
+	std::stringstream ss(text.c_str());
+	std::string item;
+	while (std::getline(ss, item, '\t'))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+// reads a variable node; symbols like X.Min or X.Max read the range
+template <typename T>
+T ReadVariable(GenApi::INode* pNode, const std::string& suffix)
+{
+	switch (pNode->GetPrincipalInterfaceType())
+	{
+	case GenApi::intfIFloat:
+	{
+		GenApi::CFloatPtr pFloat = pNode;
+		if (suffix == "Min")
+			return static_cast<T>(pFloat->GetMin());
+		if (suffix == "Max")
+			return static_cast<T>(pFloat->GetMax());
+		if (suffix == "Inc")
+			return static_cast<T>(pFloat->GetInc());
+		return static_cast<T>(pFloat->GetValue());
+	}
+	case GenApi::intfIInteger:
+	{
+		GenApi::CIntegerPtr pInteger = pNode;
+		if (suffix == "Min")
+			return static_cast<T>(pInteger->GetMin());
+		if (suffix == "Max")
+			return static_cast<T>(pInteger->GetMax());
+		if (suffix == "Inc")
+			return static_cast<T>(pInteger->GetInc());
+		return static_cast<T>(pInteger->GetValue());
+	}
+	case GenApi::intfIBoolean:
+	{
+		GenApi::CBooleanPtr pBoolean = pNode;
+		return pBoolean->GetValue() ? 1 : 0;
+	}
+	case GenApi::intfIEnumeration:
+	{
+		GenApi::CEnumerationPtr pEnumeration = pNode;
+		return static_cast<T>(pEnumeration->GetIntValue());
+	}
+	default:
+		throw GenICam::GenericException("Unsupported variable node type", __FILE__, __LINE__);
+	}
+}
+
+// a node whose value never changes after the node map is loaded: a
+//    read-only literal
+bool IsConstantNode(GenApi::INode* pNode)
+{
+	GenICam::gcstring value, attribute;
+	if (pNode->GetAccessMode() != GenApi::RO || !pNode->IsCachable())
+		return false;
+	if (pNode->GetProperty("pValue", value, attribute) || pNode->GetProperty("Address", value, attribute) || pNode->GetProperty("pAddress", value, attribute))
+		return false;
+	return pNode->GetProperty("Value", value, attribute);
+}
+
+// formula of a node with its variable nodes
+template <typename T>
+class CompiledFormulaNode
+{
+public:
+	// formulaProperty is Formula for SwissKnifes, FormulaFrom or FormulaTo for
+	//    converters; inputSymbol names the converter input, which is TO (the
+	//    register value) for FormulaFrom and FROM (the feature value) for
+	//    FormulaTo
+	CompiledFormulaNode(GenApi::INode* pNode, const char* formulaProperty, const char* inputSymbol = NULL)
+		: m_inputIndex(static_cast<size_t>(-1)), m_numFolded(0)
+	{
+		GenICam::gcstring value, attribute;
+		if (!pNode->GetProperty(formulaProperty, value, attribute))
+			throw GenICam::GenericException("Node has no formula", __FILE__, __LINE__);
+		m_formula = value.c_str();
+
+		std::map<std::string, size_t> variables;
+		std::map<std::string, std::string> constants;
+
+		if (inputSymbol)
+		{
+			m_inputIndex = 0;
+			variables[inputSymbol] = 0;
+			m_nodes.push_back(NULL);
+			m_suffixes.push_back("");
+		}
+
+		// pVariable: node names as values, symbols as attributes
+		if (pNode->GetProperty("pVariable", value, attribute))
+		{
+			std::vector<std::string> nodeNames = SplitTabs(value);
+			std::vector<std::string> symbols = SplitTabs(attribute);
+			GenApi::INodeMap* pNodeMap = pNode->GetNodeMap();
+			for (size_t i = 0; i < nodeNames.size() && i < symbols.size(); i++)
+			{
+				GenApi::INode* pVariable = pNodeMap->GetNode(nodeNames[i].c_str());
+				if (!pVariable)
+					throw GenICam::GenericException("Formula variable node not found", __FILE__, __LINE__);
+				static const char* const suffixes[] = { "", "Value", "Min", "Max", "Inc" };
+				for (size_t s = 0; s < sizeof(suffixes) / sizeof(suffixes[0]); s++)
+				{
+					std::string symbol = symbols[i];
+					if (*suffixes[s])
+						symbol += std::string(".") + suffixes[s];
+					variables[symbol] = m_nodes.size();
+					m_nodes.push_back(pVariable);
+					m_suffixes.push_back(suffixes[s]);
+				}
+			}
+		}
+
+		// Constant and Expression symbols
+		if (pNode->GetProperty("Constant", value, attribute))
+		{
+			std::vector<std::string> values = SplitTabs(value);
+			std::vector<std::string> symbols = SplitTabs(attribute);
+			for (size_t i = 0; i < values.size() && i < symbols.size(); i++)
+				constants[symbols[i]] = values[i];
+		}
+		if (pNode->GetProperty("Expression", value, attribute))
+		{
+			std::vector<std::string> values = SplitTabs(value);
+			std::vector<std::string> symbols = SplitTabs(attribute);
+			for (size_t i = 0; i < values.size() && i < symbols.size(); i++)
+				constants[symbols[i]] = values[i];
+		}
+
+		FormulaParser parser(variables, constants);
+		m_program = CompiledFormula<T>(parser.Parse(m_formula));
+
+		// fold variables bound to constant nodes
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			if (m_nodes[i] && IsConstantNode(m_nodes[i]))
+			{
+				m_program.Bind(i, ReadVariable<T>(m_nodes[i], m_suffixes[i]));
+				m_nodes[i] = NULL;
+				m_numFolded++;
+			}
+		}
+		m_values.assign(m_nodes.size(), T());
+	}
+
+	// evaluates with the current variable values and the given input
+	T Evaluate(T input = T()) const
+	{
+		if (m_inputIndex == 0)
+			m_values[0] = input;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+			if (m_nodes[i])
+				m_values[i] = ReadVariable<T>(m_nodes[i], m_suffixes[i]);
+		return m_program.Evaluate(m_values.empty() ? NULL : &m_values[0]);
+	}
+
+	// variable values the last evaluation used, excluding the input
+	std::vector<T> Snapshot() const
+	{
+		std::vector<T> values;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+			if (m_nodes[i])
+				values.push_back(ReadVariable<T>(m_nodes[i], m_suffixes[i]));
+		return values;
+	}
+
+	const std::string& Formula() const
+	{
+		return m_formula;
+	}
+
+	size_t ProgramSize() const
+	{
+		return m_program.Size();
+	}
+
+	size_t NumFolded() const
+	{
+		return m_numFolded;
+	}
+
+private:
+	std::string m_formula;
+	std::vector<GenApi::INode*> m_nodes;
+	std::vector<std::string> m_suffixes;
+	size_t m_inputIndex;
+	size_t m_numFolded;
+	CompiledFormula<T> m_program;
+	mutable std::vector<T> m_values;
+};
+
+// cached monotone table for converter inversion; maps a feature value back
+//    to the register value through the compiled FormulaFrom
+template <typename T>
+class MonotoneInverse
+{
+public:
+	MonotoneInverse(const CompiledFormulaNode<T>& from, double registerMin, double registerMax, bool integerRegister)
+		: m_from(from), m_min(registerMin), m_max(registerMax), m_integer(integerRegister), m_increasing(true), m_valid(false)
+	{
+		Build();
+	}
+
+	bool Valid() const
+	{
+		return m_valid;
+	}
+
+	// register value whose FormulaFrom result is closest to value
+	double Invert(double value)
+	{
+		// the table depends on the other variables of the formula
+		if (m_from.Snapshot() != m_snapshot)
+			Build();
+		if (!m_valid)
+			throw GenICam::GenericException("Converter formula is not monotone", __FILE__, __LINE__);
+
+		// bracket in the table
+		size_t lo = 0;
+		size_t hi = m_outputs.size() - 1;
+		while (hi - lo > 1)
+		{
+			size_t mid = (lo + hi) / 2;
+			if ((m_outputs[mid] <= value) == m_increasing)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		// refine by bisection on the compiled formula
+		double a = m_inputs[lo];
+		double b = m_inputs[hi];
+		for (int i = 0; i < 64 && b - a > (m_integer ? 1.0 : 0.0); i++)
+		{
+			double mid = m_integer ? floor((a + b) / 2) : (a + b) / 2;
+			if (mid == a || mid == b)
+				break;
+			if ((static_cast<double>(m_from.Evaluate(static_cast<T>(mid))) <= value) == m_increasing)
+				a = mid;
+			else
+				b = mid;
+		}
+		double errA = fabs(static_cast<double>(m_from.Evaluate(static_cast<T>(a))) - value);
+		double errB = fabs(static_cast<double>(m_from.Evaluate(static_cast<T>(b))) - value);
+		return errA <= errB ? a : b;
+	}
+
+private:
+	void Build()
+	{
+		m_snapshot = m_from.Snapshot();
+		m_inputs.clear();
+		m_outputs.clear();
+
+		double span = m_max - m_min;
+		size_t count = INVERSE_TABLE_SIZE;
+		if (m_integer && span + 1 < count)
+			count = static_cast<size_t>(span + 1);
+		for (size_t i = 0; i < count; i++)
+		{
+			double input = count > 1 ? m_min + span * static_cast<double>(i) / static_cast<double>(count - 1) : m_min;
+			if (m_integer)
+				input = floor(input);
+			m_inputs.push_back(input);
+			m_outputs.push_back(static_cast<double>(m_from.Evaluate(static_cast<T>(input))));
+		}
+
+		m_increasing = m_outputs.back() >= m_outputs.front();
+		m_valid = m_outputs.size() > 1;
+		for (size_t i = 1; m_valid && i < m_outputs.size(); i++)
+			m_valid = m_increasing ? m_outputs[i] >= m_outputs[i - 1] : m_outputs[i] <= m_outputs[i - 1];
+	}
+
+	const CompiledFormulaNode<T>& m_from;
+	double m_min;
+	double m_max;
+	bool m_integer;
+	bool m_increasing;
+	bool m_valid;
+	std::vector<T> m_snapshot;
+	std::vector<double> m_inputs;
+	std::vector<double> m_outputs;
+};
+
+// times a callable in nanoseconds per call
+template <typename F>
+double TimeNs(F f)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_ITERATIONS; i++)
+		f();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / NUM_ITERATIONS;
+}
+
+bool Agrees(double expected, double actual)
+{
+	return fabs(expected - actual) <= TOLERANCE * std::max(1.0, fabs(expected));
+}
+
+struct BenchmarkTotals
+{
+	size_t nodes;
+	size_t mismatches;
+	size_t compileErrors;
+	size_t failures;
+	double genApiNs;
+	double compiledNs;
+};
+
+// benchmarks one SwissKnife or IntSwissKnife against GenApi
+template <typename T, typename Ptr>
+void BenchmarkSwissKnife(GenApi::INode* pNode, BenchmarkTotals& totals)
+{
+	CompiledFormulaNode<T> compiled(pNode, "Formula");
+	Ptr pValue = pNode;
+
+	volatile T sink = T();
+	double genApiNs = TimeNs([&]() { sink = pValue->GetValue(); });
+	double compiledNs = TimeNs([&]() { sink = compiled.Evaluate(); });
+	(void)sink;
+
+	bool agrees = Agrees(static_cast<double>(pValue->GetValue()), static_cast<double>(compiled.Evaluate()));
+	totals.nodes++;
+	totals.mismatches += agrees ? 0 : 1;
+	totals.genApiNs += genApiNs;
+	totals.compiledNs += compiledNs;
+
+	std::cout << TAB2 << std::left << std::setw(40) << pNode->GetName() << std::right
+			  << std::setw(10) << std::fixed << std::setprecision(0) << genApiNs << " ns"
+			  << std::setw(10) << compiledNs << " ns"
+			  << std::setw(6) << compiled.ProgramSize() << " ops"
+			  << std::setw(4) << compiled.NumFolded() << " folded"
+			  << (agrees ? "" : "  MISMATCH") << "\n";
+}
+
+// benchmarks one Converter or IntConverter against GenApi, including
+//    inversion through the cached table
+template <typename T, typename Ptr>
+void BenchmarkConverter(GenApi::INode* pNode, BenchmarkTotals& totals)
+{
+	CompiledFormulaNode<T> from(pNode, "FormulaFrom", "TO");
+	CompiledFormulaNode<T> to(pNode, "FormulaTo", "FROM");
+
+	// the converter input is its pValue node
+	GenICam::gcstring value, attribute;
+	if (!pNode->GetProperty("pValue", value, attribute))
+		throw GenICam::GenericException("Converter has no pValue", __FILE__, __LINE__);
+	GenApi::INode* pRegister = pNode->GetNodeMap()->GetNode(value);
+	if (!pRegister)
+		throw GenICam::GenericException("Converter pValue node not found", __FILE__, __LINE__);
+
+	Ptr pValue = pNode;
+	volatile T sink = T();
+	double genApiNs = TimeNs([&]() { sink = pValue->GetValue(); });
+	double compiledNs = TimeNs([&]() { sink = from.Evaluate(ReadVariable<T>(pRegister, "")); });
+	(void)sink;
+
+	T registerValue = ReadVariable<T>(pRegister, "");
+	bool agrees = Agrees(static_cast<double>(pValue->GetValue()), static_cast<double>(from.Evaluate(registerValue)));
+
+	// invert the current value through the table and compare the register
+	//    value with FormulaTo
+	double inverseNs = 0.0;
+	bool inverseAgrees = true;
+	bool integerRegister = pRegister->GetPrincipalInterfaceType() == GenApi::intfIInteger;
+	double registerMin = ReadVariable<double>(pRegister, "Min");
+	double registerMax = ReadVariable<double>(pRegister, "Max");
+	MonotoneInverse<T> inverse(from, registerMin, registerMax, integerRegister);
+	if (inverse.Valid())
+	{
+		double target = static_cast<double>(pValue->GetValue());
+		double expected = static_cast<double>(to.Evaluate(static_cast<T>(target)));
+		double actual = 0.0;
+		inverseNs = TimeNs([&]() { actual = inverse.Invert(target); });
+		inverseAgrees = Agrees(static_cast<double>(from.Evaluate(static_cast<T>(expected))), static_cast<double>(from.Evaluate(static_cast<T>(actual))));
+	}
+
+	totals.nodes++;
+	totals.mismatches += (agrees && inverseAgrees) ? 0 : 1;
+	totals.genApiNs += genApiNs;
+	totals.compiledNs += compiledNs;
+
+	std::cout << TAB2 << std::left << std::setw(40) << pNode->GetName() << std::right
+			  << std::setw(10) << std::fixed << std::setprecision(0) << genApiNs << " ns"
+			  << std::setw(10) << compiledNs << " ns"
+			  << std::setw(6) << from.ProgramSize() << " ops"
+			  << std::setw(4) << from.NumFolded() << " folded";
+	if (inverse.Valid())
+		std::cout << "  inverse " << inverseNs << " ns";
+	else
+		std::cout << "  not monotone";
+	std::cout << (agrees && inverseAgrees ? "" : "  MISMATCH") << "\n";
+}
+
+// compiles and benchmarks every formula node of a node map
+// (1) finds SwissKnife, IntSwissKnife, Converter and IntConverter nodes
+// (2) compiles their formulas once, folding constants
+// (3) times GenApi access against the compiled programs
+// (4) checks agreement, including converter inversion
+void BenchmarkNodeMap(const char* name, GenApi::INodeMap* pNodeMap, BenchmarkTotals& totals)
+{
+	std::cout << TAB1 << name << "\n";
+	std::cout << TAB2 << std::left << std::setw(40) << "node" << std::right << std::setw(13) << "GenApi" << std::setw(13) << "compiled" << "\n";
+
+	GenApi::NodeList_t nodes;
+	pNodeMap->GetNodes(nodes);
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		GenApi::INode* pNode = nodes[i];
+		if (!GenApi::IsReadable(pNode))
+			continue;
+
+		GenICam::gcstring value, attribute;
+		bool swissKnife = pNode->GetProperty("Formula", value, attribute);
+		bool converter = pNode->GetProperty("FormulaFrom", value, attribute);
+		if (!swissKnife && !converter)
+			continue;
+
+		bool integer = pNode->GetPrincipalInterfaceType() == GenApi::intfIInteger;
+		try
+		{
+			if (swissKnife && integer)
+				BenchmarkSwissKnife<int64_t, GenApi::CIntegerPtr>(pNode, totals);
+			else if (swissKnife)
+				BenchmarkSwissKnife<double, GenApi::CFloatPtr>(pNode, totals);
+			else if (integer)
+				BenchmarkConverter<int64_t, GenApi::CIntegerPtr>(pNode, totals);
+			else
+				BenchmarkConverter<double, GenApi::CFloatPtr>(pNode, totals);
+		}
+		catch (GenICam::LogicalErrorException& ge)
+		{
+			std::cout << TAB2 << std::left << std::setw(40) << pNode->GetName() << std::right << "  COMPILE ERROR: " << ge.GetDescription() << "\n";
+			totals.compileErrors++;
+		}
+		catch (GenICam::GenericException& ge)
+		{
+			// formulas that read unavailable nodes are reported and skipped
+			std::cout << TAB2 << std::left << std::setw(40) << pNode->GetName() << std::right << "  skipped: " << ge.GetDescription() << "\n";
+			totals.failures++;
+		}
+	}
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Explore_CompiledFormulas\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(SYSTEM_TIMEOUT);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+
+		BenchmarkTotals totals = { 0, 0, 0, 0, 0.0, 0.0 };
+		BenchmarkNodeMap("System node map", pSystem->GetTLSystemNodeMap(), totals);
+		BenchmarkNodeMap("Interface node map", pSystem->GetTLInterfaceNodeMap(deviceInfos[0]), totals);
+		BenchmarkNodeMap("Device node map", pDevice->GetNodeMap(), totals);
+		BenchmarkNodeMap("TL device node map", pDevice->GetTLDeviceNodeMap(), totals);
+		BenchmarkNodeMap("TL stream node map", pDevice->GetTLStreamNodeMap(), totals);
+
+		std::cout << "\n"
+				  << TAB1 << totals.nodes << " formula nodes compiled, " << totals.mismatches << " mismatches, " << totals.compileErrors << " compile errors, " << totals.failures << " skipped\n";
+		if (totals.nodes > 0)
+			std::cout << TAB1 << "Average access: GenApi " << totals.genApiNs / totals.nodes << " ns, compiled " << totals.compiledNs / totals.nodes << " ns\n";
+
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
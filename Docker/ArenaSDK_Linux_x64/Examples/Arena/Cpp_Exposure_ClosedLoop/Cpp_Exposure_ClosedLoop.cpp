@@ -0,0 +1,510 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Exposure: Closed Loop
+//    This example runs auto exposure on the host, one frame at a time. The
+//    camera's own auto exposure is tuned for area scenes and reacts over many
+//    frames. A line scanner that turns towards the sun saturates lines before
+//    it catches up. For each frame, the example takes a histogram of a window
+//    of spectral bands across all rows and reads a high percentile from it.
+//    The window should cover the bands that saturate first. A
+//    proportional-integral (PI) controller on the logarithm of exposure
+//    steers that percentile to a target level. Each step starts from the
+//    exposure the frame was actually taken with, read from its chunk data,
+//    so commands still in flight are not counted twice. If too many pixels
+//    are saturated, the percentile no longer measures the scene. In that
+//    case a saturation guard cuts exposure by a fixed factor. The integral
+//    term stops accumulating while a command has not yet taken effect, or
+//    while exposure is held at a limit. New exposures are written through a
+//    cached ExposureTime node, with no lookup by name, so they apply within
+//    one or two frames. Every line is logged with its chunk exposure, so
+//    that counts can be normalized to counts per millisecond for radiometry.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images
+#define NUM_IMAGES 2000
+
+// monitored window of spectral bands (columns, inclusive)
+#define BAND_FIRST 0
+#define BAND_LAST 2047
+
+// monitored rows: every ROW_STEP'th row
+#define ROW_STEP 1
+
+// percentile that is controlled
+#define PERCENTILE 0.99
+
+// target level of the percentile (fraction of full scale)
+#define TARGET_LEVEL 0.70
+
+// level from which a pixel counts as saturated (fraction of full scale)
+#define SATURATION_LEVEL 0.98
+
+// fraction of saturated pixels that triggers the saturation guard
+#define SATURATION_LIMIT 0.002
+
+// exposure factor applied by the saturation guard
+#define SATURATION_CUT 0.25
+
+// proportional and integral gains, on the logarithm of exposure
+#define KP 0.8
+#define KI 0.05
+
+// largest exposure change per frame (factor)
+#define MAX_STEP 4.0
+
+// relative exposure change below which no command is sent
+#define DEADBAND 0.02
+
+// longest exposure (in microseconds); keep it below the line period so that
+// the frame rate does not drop
+#define MAX_EXPOSURE_US 20000.0
+
+// per-line log
+#define LOG_FILE "Cpp_Exposure_ClosedLoop.csv"
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPERS =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// brightness of the monitored window
+struct WindowStats
+{
+	// percentile level (fraction of full scale)
+	double level = 0.0;
+
+	// fraction of pixels at or above SATURATION_LEVEL
+	double saturated = 0.0;
+};
+
+// counts pixels at or above a threshold in one row
+//    SSE2 compares 16 bytes at a time; 16-bit pixels are biased so that the
+//    signed comparison orders them as unsigned.
+size_t CountSaturated(const uint8_t* pRow, size_t count, size_t bytesPerPixel, uint32_t threshold)
+{
+	size_t saturated = 0;
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	if (bytesPerPixel == 1)
+	{
+		const __m128i thresholdVec = _mm_set1_epi8(static_cast<char>(threshold));
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+			__m128i atOrAbove = _mm_cmpeq_epi8(_mm_max_epu8(v, thresholdVec), v);
+			saturated += __builtin_popcount(_mm_movemask_epi8(atOrAbove));
+		}
+	}
+	else
+	{
+		const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+		const __m128i belowVec = _mm_set1_epi16(static_cast<short>((threshold - 1) ^ 0x8000));
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + 2 * i)), bias);
+			__m128i atOrAbove = _mm_cmpgt_epi16(v, belowVec);
+			saturated += __builtin_popcount(_mm_movemask_epi8(atOrAbove)) / 2;
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		uint32_t value = bytesPerPixel == 1 ? pRow[i] : reinterpret_cast<const uint16_t*>(pRow)[i];
+		if (value >= threshold)
+			saturated++;
+	}
+	return saturated;
+}
+
+// Measure window
+//    Builds a 256-bin histogram of the window from the top 8 significant
+//    bits of each pixel. Four sub-histograms, merged at the end, keep
+//    neighbouring pixels that fall in the same bin from waiting on each
+//    other's increments.
+WindowStats MeasureWindow(const uint8_t* pData, size_t width, size_t height, size_t bytesPerPixel, uint32_t maxValue)
+{
+	size_t first = std::min<size_t>(BAND_FIRST, width - 1);
+	size_t last = std::min<size_t>(BAND_LAST, width - 1);
+	size_t count = last - first + 1;
+	int shift = 0;
+	while ((maxValue >> shift) > 255)
+		shift++;
+	uint32_t threshold = static_cast<uint32_t>(SATURATION_LEVEL * maxValue);
+
+	uint32_t histograms[4][256];
+	std::memset(histograms, 0, sizeof(histograms));
+	size_t saturated = 0;
+	size_t total = 0;
+
+	for (size_t row = 0; row < height; row += ROW_STEP)
+	{
+		const uint8_t* pRow = pData + (row * width + first) * bytesPerPixel;
+		saturated += CountSaturated(pRow, count, bytesPerPixel, threshold);
+		total += count;
+
+		size_t i = 0;
+		if (bytesPerPixel == 1)
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				histograms[0][pRow[i]]++;
+				histograms[1][pRow[i + 1]]++;
+				histograms[2][pRow[i + 2]]++;
+				histograms[3][pRow[i + 3]]++;
+			}
+			for (; i < count; i++)
+				histograms[0][pRow[i]]++;
+		}
+		else
+		{
+			const uint16_t* pPixels = reinterpret_cast<const uint16_t*>(pRow);
+			for (; i + 4 <= count; i += 4)
+			{
+				histograms[0][std::min<uint32_t>(pPixels[i] >> shift, 255)]++;
+				histograms[1][std::min<uint32_t>(pPixels[i + 1] >> shift, 255)]++;
+				histograms[2][std::min<uint32_t>(pPixels[i + 2] >> shift, 255)]++;
+				histograms[3][std::min<uint32_t>(pPixels[i + 3] >> shift, 255)]++;
+			}
+			for (; i < count; i++)
+				histograms[0][std::min<uint32_t>(pPixels[i] >> shift, 255)]++;
+		}
+	}
+
+	// percentile from the merged histogram; the level is the bin's upper edge
+	WindowStats stats;
+	size_t rank = static_cast<size_t>(std::ceil(PERCENTILE * total));
+	size_t cumulative = 0;
+	for (int bin = 0; bin < 256; bin++)
+	{
+		cumulative += histograms[0][bin] + histograms[1][bin] + histograms[2][bin] + histograms[3][bin];
+		if (cumulative >= rank)
+		{
+			stats.level = std::min(1.0, static_cast<double>((bin + 1) << shift) / (maxValue + 1));
+			break;
+		}
+	}
+	stats.saturated = total > 0 ? static_cast<double>(saturated) / total : 0.0;
+	return stats;
+}
+
+// Exposure controller
+//    A PI controller on log exposure. Exposure scales the signal linearly,
+//    so the error log(target / level) is the exposure change, as a log
+//    factor, that would bring the level to the target.
+class ExposureController
+{
+public:
+	ExposureController(double minUs, double maxUs) :
+		m_minUs(minUs),
+		m_maxUs(maxUs),
+		m_integral(0.0),
+		m_commandedUs(0.0)
+	{
+	}
+
+	// returns the exposure for the next frame given a frame and the exposure
+	// it was taken with
+	double Update(const WindowStats& stats, double frameExposureUs)
+	{
+		// a command has taken effect once a frame carries it
+		bool settled = m_commandedUs <= 0.0 || std::abs(frameExposureUs / m_commandedUs - 1.0) < 0.01;
+		double nextUs = 0.0;
+
+		if (stats.saturated > SATURATION_LIMIT)
+		{
+			// saturation guard: the percentile is clipped, so cut by a fixed
+			// factor and drop any upward push stored in the integral
+			m_integral = std::min(m_integral, 0.0);
+			nextUs = frameExposureUs * SATURATION_CUT;
+		}
+		else
+		{
+			double error = std::log(TARGET_LEVEL / std::max(stats.level, 1e-3));
+			double integral = settled ? m_integral + error : m_integral;
+			double step = KP * error + KI * integral;
+			double maxStep = std::log(MAX_STEP);
+			bool limited = step > maxStep || step < -maxStep;
+			step = std::max(-maxStep, std::min(maxStep, step));
+			nextUs = frameExposureUs * std::exp(step);
+
+			// integrate only when the output is free to follow
+			limited = limited || nextUs > m_maxUs || nextUs < m_minUs;
+			if (settled && !limited)
+				m_integral = integral;
+		}
+
+		nextUs = std::max(m_minUs, std::min(m_maxUs, nextUs));
+		return nextUs;
+	}
+
+	// records the exposure sent to the device
+	void Commanded(double exposureUs)
+	{
+		m_commandedUs = exposureUs;
+	}
+
+	double GetCommanded() const
+	{
+		return m_commandedUs;
+	}
+
+private:
+	double m_minUs;
+	double m_maxUs;
+	double m_integral;
+	double m_commandedUs;
+};
+
+// full-scale value of a pixel format, or 0 if unsupported
+uint32_t GetMaxValue(uint64_t pixelFormat)
+{
+	switch (pixelFormat)
+	{
+	case PFNC_Mono8:
+		return 0xFF;
+	case PFNC_Mono10:
+		return 0x3FF;
+	case PFNC_Mono12:
+		return 0xFFF;
+	case PFNC_Mono16:
+		return 0xFFFF;
+	default:
+		return 0;
+	}
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// demonstrates closed-loop exposure control
+// (1) turns off auto exposure and enables the exposure chunk
+// (2) caches the exposure node
+// (3) measures each frame and computes the next exposure
+// (4) sends changed exposures through the cached node
+// (5) logs each line with its chunk exposure
+// (6) reports saturation and how fast commands took effect
+void ControlExposure(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto");
+	double exposureTimeInitial = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+	bool chunkModeActiveInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkModeActive");
+
+	// Turn off auto exposure and enable the exposure chunk
+	//    The exposure chunk records the exposure each frame was taken with,
+	//    which the controller and the radiometric log both need.
+	std::cout << TAB1 << "Turn off auto exposure and enable exposure chunk\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", "Off");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", true);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "ExposureTime");
+	bool chunkEnableInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkEnable");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", true);
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// Cache exposure node
+	//    Looking a node up by name on every frame costs a map search; the
+	//    node pointer stays valid for the life of the device.
+	GenApi::CFloatPtr pExposureTime = pNodeMap->GetNode("ExposureTime");
+	if (!pExposureTime || !GenApi::IsWritable(pExposureTime))
+		throw GenICam::GenericException("ExposureTime node not found/writable", __FILE__, __LINE__);
+
+	double minUs = pExposureTime->GetMin();
+	double maxUs = std::min(pExposureTime->GetMax(), MAX_EXPOSURE_US);
+	ExposureController controller(minUs, maxUs);
+	controller.Commanded(pExposureTime->GetValue());
+
+	std::cout << TAB1 << "Control the " << 100.0 * PERCENTILE << "th percentile of bands " << BAND_FIRST << " to " << BAND_LAST << " at " << 100.0 * TARGET_LEVEL << "% of full scale (" << minUs << " to " << maxUs << " us)\n";
+
+	std::ofstream log(LOG_FILE);
+	log << "frame_id,timestamp_ns,exposure_us,commanded_us,level,saturated,level_per_ms\n";
+
+	// Start stream and control
+	pDevice->StartStream();
+
+	size_t commands = 0;
+	size_t saturatedFrames = 0;
+	size_t incompleteFrames = 0;
+	size_t appliedCommands = 0;
+	size_t latencyFramesTotal = 0;
+	size_t latencyFramesMax = 0;
+	size_t commandFrame = 0;
+	bool awaiting = false;
+	double measureSeconds = 0.0;
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->IsIncomplete())
+		{
+			incompleteFrames++;
+			pDevice->RequeueBuffer(pImage);
+			continue;
+		}
+
+		uint32_t maxValue = GetMaxValue(pImage->GetPixelFormat());
+		if (maxValue == 0)
+		{
+			pDevice->RequeueBuffer(pImage);
+			throw GenICam::GenericException("pixel format must be Mono8, Mono10, Mono12 or Mono16", __FILE__, __LINE__);
+		}
+
+		GenApi::CFloatPtr pChunkExposureTime = pImage->AsChunkData()->GetChunk("ChunkExposureTime");
+		double frameExposureUs = pChunkExposureTime->GetValue();
+
+		// measure
+		auto start = std::chrono::steady_clock::now();
+		WindowStats stats = MeasureWindow(pImage->GetData(), pImage->GetWidth(), pImage->GetHeight(), pImage->GetBitsPerPixel() / 8, maxValue);
+		measureSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// track how many frames a command took to appear in the chunk data
+		if (awaiting && std::abs(frameExposureUs / controller.GetCommanded() - 1.0) < 0.01)
+		{
+			size_t latency = i - commandFrame;
+			latencyFramesTotal += latency;
+			latencyFramesMax = std::max(latencyFramesMax, latency);
+			appliedCommands++;
+			awaiting = false;
+		}
+		if (stats.saturated > SATURATION_LIMIT)
+			saturatedFrames++;
+
+		log << pImage->GetFrameId() << "," << pImage->GetTimestampNs() << "," << frameExposureUs << "," << controller.GetCommanded() << "," << stats.level << "," << stats.saturated << "," << 1000.0 * stats.level / frameExposureUs << "\n";
+
+		// control
+		double nextUs = controller.Update(stats, frameExposureUs);
+		if (std::abs(nextUs / controller.GetCommanded() - 1.0) > DEADBAND)
+		{
+			pExposureTime->SetValue(nextUs);
+			controller.Commanded(nextUs);
+			commands++;
+			commandFrame = i;
+			awaiting = true;
+		}
+
+		pDevice->RequeueBuffer(pImage);
+	}
+
+	pDevice->StopStream();
+
+	// report
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << TAB2 << NUM_IMAGES << " frames, " << incompleteFrames << " incomplete, " << saturatedFrames << " over the saturation limit\n";
+	std::cout << TAB2 << commands << " exposure commands";
+	if (appliedCommands > 0)
+		std::cout << ", applied after " << static_cast<double>(latencyFramesTotal) / appliedCommands << " frames on average (" << latencyFramesMax << " at most)";
+	std::cout << "\n";
+	std::cout << TAB2 << std::setprecision(3) << 1e6 * measureSeconds / NUM_IMAGES << " us per frame to measure\n";
+	std::cout << TAB2 << "line log written to " << LOG_FILE << "\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", chunkEnableInitial);
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", chunkModeActiveInitial);
+	if (exposureAutoInitial == "Off")
+	{
+		Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposureTimeInitial);
+	}
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", exposureAutoInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Exposure_ClosedLoop\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		ControlExposure(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
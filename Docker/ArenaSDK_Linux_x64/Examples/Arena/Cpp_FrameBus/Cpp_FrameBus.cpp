@@ -0,0 +1,462 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Frame Bus
+//    This example publishes acquired frames on a shared-memory ring, so that
+//    other processes can watch a scan without slowing acquisition. The ring
+//    is a file in /dev/shm. It starts with a header, followed by a fixed
+//    number of slots, and each slot holds the metadata and data of one frame.
+//    The acquisition process is the only writer and never waits for
+//    readers. Any number of readers map the ring read-only. Each slot is
+//    guarded by a sequence number, which is odd while the writer fills the
+//    slot. A reader checks that the number did not change while it used the
+//    frame. A reader that falls behind skips to the newest frame. Readers
+//    sleep on a futex word in the header, and the writer wakes them after
+//    each frame. A futex needs no file descriptor passing, unlike an
+//    eventfd. frame_bus.py, next to this example, is a Python reader that
+//    returns zero-copy memoryviews of the ring for notebooks. This example
+//    also runs a C++ reader on a thread of its own, as a stand-in for
+//    another process.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images published
+#define NUM_IMAGES 500
+
+// name of the ring in /dev/shm, shared with frame_bus.py
+#define BUS_NAME "hsi_frame_bus"
+
+// number of slots in the ring; readers can lag this many frames behind
+//    before frames are skipped
+#define BUS_SLOTS 8
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// ring layout, mirrored by frame_bus.py; all fields are little-endian and
+//    at fixed offsets
+const uint32_t BUS_MAGIC = 0x42495348; // "HSIB"
+const uint32_t BUS_VERSION = 1;
+const size_t BUS_HEADER_SIZE = 4096;
+const size_t SLOT_HEADER_SIZE = 64;
+const size_t PAGE_SIZE_BYTES = 4096;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared-memory atomics must be lock-free");
+
+struct BusHeader
+{
+	std::atomic<uint32_t> magic; // written last by the writer
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t slotHeaderSize;
+	uint64_t slotStride;
+	uint64_t dataCapacity;
+	std::atomic<uint64_t> published; // frames published so far
+	std::atomic<uint32_t> futexWord; // incremented after every frame
+	uint32_t writerPid;
+	std::atomic<uint32_t> closed; // non-zero once the writer has stopped
+};
+
+static_assert(offsetof(BusHeader, slotStride) == 16, "layout mirrored by frame_bus.py");
+static_assert(offsetof(BusHeader, published) == 32, "layout mirrored by frame_bus.py");
+static_assert(offsetof(BusHeader, futexWord) == 40, "layout mirrored by frame_bus.py");
+static_assert(offsetof(BusHeader, closed) == 48, "layout mirrored by frame_bus.py");
+
+// frame i lives in slot i % slotCount; its sequence is 2 * i + 1 while being
+//    written and 2 * i + 2 once complete
+struct SlotHeader
+{
+	std::atomic<uint64_t> sequence;
+	uint64_t frameId;
+	uint64_t timestampNs;
+	uint32_t width;
+	uint32_t height;
+	uint32_t pixelFormat;
+	uint32_t bitsPerPixel;
+	uint64_t size;
+};
+
+static_assert(offsetof(SlotHeader, frameId) == 8, "layout mirrored by frame_bus.py");
+static_assert(offsetof(SlotHeader, width) == 24, "layout mirrored by frame_bus.py");
+static_assert(offsetof(SlotHeader, size) == 40, "layout mirrored by frame_bus.py");
+static_assert(sizeof(SlotHeader) <= SLOT_HEADER_SIZE, "slot header too large");
+
+// wakes every waiter on a futex word; the word is shared between processes,
+//    so the private futex operations cannot be used
+void FutexWakeAll(std::atomic<uint32_t>* pWord)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// sleeps while a futex word still holds a value, for at most timeoutMs
+void FutexWait(const std::atomic<uint32_t>* pWord, uint32_t value, int timeoutMs)
+{
+	struct timespec timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+	syscall(SYS_futex, reinterpret_cast<const uint32_t*>(pWord), FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+// maps the ring file; the writer creates it, readers open it read-only
+void* MapBus(const char* name, bool writer, size_t size, int* pFd)
+{
+	std::string path = std::string("/dev/shm/") + name;
+	int fd = writer ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw GenICam::GenericException(("Frame bus could not be opened: " + path).c_str(), __FILE__, __LINE__);
+
+	if (writer && ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		close(fd);
+		throw GenICam::GenericException("Frame bus could not be sized", __FILE__, __LINE__);
+	}
+	if (!writer)
+		size = static_cast<size_t>(lseek(fd, 0, SEEK_END));
+
+	void* pMap = mmap(NULL, size, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	if (pMap == MAP_FAILED)
+	{
+		close(fd);
+		throw GenICam::GenericException("Frame bus could not be mapped", __FILE__, __LINE__);
+	}
+	*pFd = fd;
+	return pMap;
+}
+
+// single writer of the ring
+class FrameBusWriter
+{
+public:
+	FrameBusWriter(const char* name, size_t slotCount, size_t dataCapacity)
+		: m_name(name), m_slotCount(slotCount), m_published(0)
+	{
+		m_slotStride = (SLOT_HEADER_SIZE + dataCapacity + PAGE_SIZE_BYTES - 1) / PAGE_SIZE_BYTES * PAGE_SIZE_BYTES;
+		m_size = BUS_HEADER_SIZE + slotCount * m_slotStride;
+
+		// readers still mapping an earlier ring keep their copy
+		unlink((std::string("/dev/shm/") + name).c_str());
+		m_pBase = static_cast<uint8_t*>(MapBus(name, true, m_size, &m_fd));
+
+		m_pHeader = new (m_pBase) BusHeader();
+		m_pHeader->version = BUS_VERSION;
+		m_pHeader->slotCount = static_cast<uint32_t>(slotCount);
+		m_pHeader->slotHeaderSize = static_cast<uint32_t>(SLOT_HEADER_SIZE);
+		m_pHeader->slotStride = m_slotStride;
+		m_pHeader->dataCapacity = m_slotStride - SLOT_HEADER_SIZE;
+		m_pHeader->published.store(0, std::memory_order_relaxed);
+		m_pHeader->futexWord.store(0, std::memory_order_relaxed);
+		m_pHeader->writerPid = static_cast<uint32_t>(getpid());
+		m_pHeader->closed.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i < slotCount; i++)
+			new (m_pBase + BUS_HEADER_SIZE + i * m_slotStride) SlotHeader();
+		m_pHeader->magic.store(BUS_MAGIC, std::memory_order_release);
+	}
+
+	~FrameBusWriter()
+	{
+		m_pHeader->closed.store(1, std::memory_order_release);
+		m_pHeader->futexWord.fetch_add(1, std::memory_order_release);
+		FutexWakeAll(&m_pHeader->futexWord);
+		munmap(m_pBase, m_size);
+		close(m_fd);
+		unlink((std::string("/dev/shm/") + m_name).c_str());
+	}
+
+	// copies an image into the next slot and wakes the readers
+	void Publish(Arena::IImage* pImage)
+	{
+		size_t size = pImage->GetSizeFilled();
+		if (size > m_pHeader->dataCapacity)
+			throw GenICam::GenericException("Image larger than frame bus slot", __FILE__, __LINE__);
+
+		uint8_t* pSlot = m_pBase + BUS_HEADER_SIZE + (m_published % m_slotCount) * m_slotStride;
+		SlotHeader* pSlotHeader = reinterpret_cast<SlotHeader*>(pSlot);
+
+		pSlotHeader->sequence.store(2 * m_published + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		pSlotHeader->frameId = pImage->GetFrameId();
+		pSlotHeader->timestampNs = pImage->GetTimestampNs();
+		pSlotHeader->width = static_cast<uint32_t>(pImage->GetWidth());
+		pSlotHeader->height = static_cast<uint32_t>(pImage->GetHeight());
+		pSlotHeader->pixelFormat = static_cast<uint32_t>(pImage->GetPixelFormat());
+		pSlotHeader->bitsPerPixel = static_cast<uint32_t>(pImage->GetBitsPerPixel());
+		pSlotHeader->size = size;
+		memcpy(pSlot + SLOT_HEADER_SIZE, pImage->GetData(), size);
+
+		pSlotHeader->sequence.store(2 * m_published + 2, std::memory_order_release);
+
+		m_published++;
+		m_pHeader->published.store(m_published, std::memory_order_release);
+		m_pHeader->futexWord.fetch_add(1, std::memory_order_release);
+		FutexWakeAll(&m_pHeader->futexWord);
+	}
+
+private:
+	std::string m_name;
+	size_t m_slotCount;
+	size_t m_slotStride;
+	size_t m_size;
+	uint64_t m_published;
+	int m_fd;
+	uint8_t* m_pBase;
+	BusHeader* m_pHeader;
+};
+
+// read-only view of the ring, as another process would map it
+class FrameBusReader
+{
+public:
+	explicit FrameBusReader(const char* name)
+		: m_next(0)
+	{
+		m_pBase = static_cast<const uint8_t*>(MapBus(name, false, 0, &m_fd));
+		m_size = static_cast<size_t>(lseek(m_fd, 0, SEEK_END));
+		m_pHeader = reinterpret_cast<const BusHeader*>(m_pBase);
+		if (m_pHeader->magic.load(std::memory_order_acquire) != BUS_MAGIC || m_pHeader->version != BUS_VERSION)
+			throw GenICam::GenericException("Frame bus header not recognized", __FILE__, __LINE__);
+	}
+
+	~FrameBusReader()
+	{
+		munmap(const_cast<uint8_t*>(m_pBase), m_size);
+		close(m_fd);
+	}
+
+	// waits for the next frame and copies it out; skips to the newest frame
+	//    when the writer has lapped the reader, and returns false once the
+	//    writer has closed the ring or the wait timed out
+	bool Next(int timeoutMs, SlotHeader& metadata, std::vector<uint8_t>& data, uint64_t& skipped, uint64_t& torn)
+	{
+		for (;;)
+		{
+			uint32_t word = m_pHeader->futexWord.load(std::memory_order_acquire);
+			uint64_t published = m_pHeader->published.load(std::memory_order_acquire);
+			if (published == m_next)
+			{
+				if (m_pHeader->closed.load(std::memory_order_acquire))
+					return false;
+				FutexWait(&m_pHeader->futexWord, word, timeoutMs);
+				if (m_pHeader->published.load(std::memory_order_acquire) == m_next && !m_pHeader->closed.load(std::memory_order_acquire))
+					return false;
+				continue;
+			}
+
+			uint64_t slotCount = m_pHeader->slotCount;
+			if (published - m_next > slotCount - 1)
+			{
+				skipped += published - 1 - m_next;
+				m_next = published - 1;
+			}
+
+			const uint8_t* pSlot = m_pBase + BUS_HEADER_SIZE + (m_next % slotCount) * m_pHeader->slotStride;
+			const SlotHeader* pSlotHeader = reinterpret_cast<const SlotHeader*>(pSlot);
+			uint64_t expected = 2 * m_next + 2;
+
+			uint64_t before = pSlotHeader->sequence.load(std::memory_order_acquire);
+			metadata.frameId = pSlotHeader->frameId;
+			metadata.timestampNs = pSlotHeader->timestampNs;
+			metadata.width = pSlotHeader->width;
+			metadata.height = pSlotHeader->height;
+			metadata.pixelFormat = pSlotHeader->pixelFormat;
+			metadata.bitsPerPixel = pSlotHeader->bitsPerPixel;
+			metadata.size = std::min<uint64_t>(pSlotHeader->size, m_pHeader->dataCapacity);
+			data.resize(static_cast<size_t>(metadata.size));
+			memcpy(data.data(), pSlot + SLOT_HEADER_SIZE, data.size());
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t after = pSlotHeader->sequence.load(std::memory_order_relaxed);
+
+			m_next++;
+			if (before == expected && after == expected)
+				return true;
+			torn++;
+		}
+	}
+
+private:
+	const uint8_t* m_pBase;
+	size_t m_size;
+	int m_fd;
+	const BusHeader* m_pHeader;
+	uint64_t m_next;
+};
+
+// counts the frames a reader sees; stands in for a separate process
+void ReadFrames(FrameBusReader* pReader, uint64_t* pReceived, uint64_t* pSkipped, uint64_t* pTorn, bool* pOrdered)
+{
+	SlotHeader metadata;
+	std::vector<uint8_t> data;
+	uint64_t lastFrameId = 0;
+	while (pReader->Next(TIMEOUT, metadata, data, *pSkipped, *pTorn))
+	{
+		if (*pReceived > 0 && metadata.frameId <= lastFrameId)
+			*pOrdered = false;
+		lastFrameId = metadata.frameId;
+		(*pReceived)++;
+
+		// simulate a slow reader, such as a notebook redrawing a plot
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+}
+
+// demonstrates the shared-memory frame bus
+// (1) creates the ring, sized for the current image
+// (2) starts a read-only reader
+// (3) acquires images and publishes each one
+// (4) closes the ring and reports what the reader saw
+void PublishFrames(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// create ring
+	std::cout << TAB1 << "Create frame bus /dev/shm/" << BUS_NAME << " with " << BUS_SLOTS << " slots\n";
+
+	size_t payloadSize = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "PayloadSize"));
+	double publishSeconds = 0.0;
+	uint64_t received = 0;
+	uint64_t skipped = 0;
+	uint64_t torn = 0;
+	bool ordered = true;
+
+	std::unique_ptr<FrameBusWriter> pWriter(new FrameBusWriter(BUS_NAME, BUS_SLOTS, payloadSize));
+
+	// start reader
+	//    Python clients attach the same way:
+	//       from frame_bus import FrameBus
+	//       for frame in FrameBus('hsi_frame_bus').frames(): ...
+	std::cout << TAB1 << "Start reader\n";
+
+	FrameBusReader reader(BUS_NAME);
+	std::thread readerThread(ReadFrames, &reader, &received, &skipped, &torn, &ordered);
+
+	// publish
+	std::cout << TAB1 << "Acquire and publish " << NUM_IMAGES << " images\n";
+
+	pDevice->StartStream();
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		pWriter->Publish(pImage);
+		publishSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		pDevice->RequeueBuffer(pImage);
+	}
+	pDevice->StopStream();
+
+	// close ring
+	//    Closing wakes the readers a last time. Their mappings stay valid
+	//    after the file is removed.
+	std::cout << TAB1 << "Close frame bus\n";
+
+	pWriter.reset();
+	readerThread.join();
+
+	std::cout << TAB2 << publishSeconds * 1e6 / NUM_IMAGES << " us per publish of " << payloadSize << " bytes\n";
+	std::cout << TAB2 << "reader received " << received << ", skipped " << skipped << ", torn " << torn << (ordered ? ", in order\n" : ", OUT OF ORDER\n");
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_FrameBus\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		PublishFrames(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
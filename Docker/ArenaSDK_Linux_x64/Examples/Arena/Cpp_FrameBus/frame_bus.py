@@ -0,0 +1,187 @@
+"""Read-only client of the shared-memory frame bus published by Cpp_FrameBus.
+
+The ring is mapped read-only and frames are returned as zero-copy
+memoryviews, so a notebook can watch a live scan without being on the
+acquisition path:
+
+    from frame_bus import FrameBus
+    import numpy as np
+
+    bus = FrameBus('hsi_frame_bus')
+    for frame in bus.frames():
+        image = np.frombuffer(frame.data, dtype=np.uint16).reshape(frame.height, frame.width)
+        ...                       # use the view while frame.valid()
+        if not frame.valid():
+            continue              # the writer reused the slot; drop the result
+
+A view points into the ring and is overwritten once the writer laps the
+reader (after BUS_SLOTS frames). Copy it (bytes(frame.data), image.copy())
+to keep it longer. Layout offsets mirror the structs in Cpp_FrameBus.cpp.
+"""
+
+import ctypes
+import os
+import struct
+
+BUS_MAGIC = 0x42495348
+BUS_VERSION = 1
+BUS_HEADER_SIZE = 4096
+
+_PROT_READ = 0x1
+_MAP_SHARED = 0x01
+_MAP_FAILED = ctypes.c_void_p(-1).value
+_SYS_FUTEX = {'x86_64': 202, 'aarch64': 98, 'armv7l': 240}[os.uname().machine]
+_FUTEX_WAIT = 0
+_PYBUF_READ = 0x100
+
+_libc = ctypes.CDLL(None, use_errno=True)
+_libc.mmap.restype = ctypes.c_void_p
+_libc.mmap.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_long]
+_libc.munmap.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+_libc.syscall.restype = ctypes.c_long
+
+_memory_view = ctypes.pythonapi.PyMemoryView_FromMemory
+_memory_view.restype = ctypes.py_object
+_memory_view.argtypes = [ctypes.c_void_p, ctypes.c_ssize_t, ctypes.c_int]
+
+
+class _Timespec(ctypes.Structure):
+    _fields_ = [('tv_sec', ctypes.c_long), ('tv_nsec', ctypes.c_long)]
+
+
+class Frame(object):
+    """One frame of the ring; data is a read-only view into the slot."""
+
+    def __init__(self, bus, index, slot, sequence):
+        self._bus = bus
+        self._slot = slot
+        self._sequence = sequence
+        self.index = index
+        (self.frame_id, self.timestamp_ns, self.width, self.height,
+         self.pixel_format, self.bits_per_pixel, size) = struct.unpack_from('<QQIIIIQ', bus._view, slot + 8)
+        size = min(size, bus.data_capacity)
+        data = slot + bus.slot_header_size
+        self.data = bus._view[data:data + size]
+
+    def valid(self):
+        """True while the writer has not started to overwrite this slot."""
+        return self._bus._sequence(self._slot) == self._sequence
+
+
+class FrameBus(object):
+    """Read-only mapping of /dev/shm/<name>."""
+
+    def __init__(self, name='hsi_frame_bus'):
+        self._fd = os.open('/dev/shm/' + name, os.O_RDONLY)
+        self._size = os.fstat(self._fd).st_size
+        self._address = _libc.mmap(None, self._size, _PROT_READ, _MAP_SHARED, self._fd, 0)
+        if self._address in (None, _MAP_FAILED):
+            os.close(self._fd)
+            raise OSError(ctypes.get_errno(), 'frame bus could not be mapped')
+        self._view = _memory_view(self._address, self._size, _PYBUF_READ)
+
+        magic, version, self.slot_count, self.slot_header_size, self.slot_stride, self.data_capacity = \
+            struct.unpack_from('<IIIIQQ', self._view, 0)
+        if magic != BUS_MAGIC or version != BUS_VERSION:
+            self.close()
+            raise ValueError('frame bus header not recognized')
+        self.writer_pid = struct.unpack_from('<I', self._view, 44)[0]
+        self.skipped = 0
+        self.torn = 0
+        self._next = self.published()
+
+    def close(self):
+        if self._view is not None:
+            try:
+                self._view.release()
+            except BufferError:
+                # frames still reference the ring; keep it mapped for them
+                return
+            self._view = None
+            _libc.munmap(self._address, self._size)
+            os.close(self._fd)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def published(self):
+        return struct.unpack_from('<Q', self._view, 32)[0]
+
+    def closed(self):
+        return struct.unpack_from('<I', self._view, 48)[0] != 0
+
+    def _sequence(self, slot):
+        return struct.unpack_from('<Q', self._view, slot)[0]
+
+    def _wait(self, word, timeout):
+        ts = _Timespec(int(timeout), int((timeout - int(timeout)) * 1e9))
+        _libc.syscall(_SYS_FUTEX, ctypes.c_void_p(self._address + 40), _FUTEX_WAIT,
+                      ctypes.c_uint32(word), ctypes.byref(ts), None, 0)
+
+    def next(self, timeout=2.0):
+        """Waits for the next frame; returns None on timeout or close.
+
+        A reader that fell more than slot_count - 1 frames behind skips to
+        the newest frame.
+        """
+        while True:
+            word = struct.unpack_from('<I', self._view, 40)[0]
+            published = self.published()
+            if published == self._next:
+                if self.closed():
+                    return None
+                self._wait(word, timeout)
+                if self.published() == self._next:
+                    return None
+                continue
+
+            if published - self._next > self.slot_count - 1:
+                self.skipped += published - 1 - self._next
+                self._next = published - 1
+
+            index = self._next
+            self._next += 1
+            slot = BUS_HEADER_SIZE + (index % self.slot_count) * self.slot_stride
+            expected = 2 * index + 2
+            if self._sequence(slot) != expected:
+                self.torn += 1
+                continue
+            frame = Frame(self, index, slot, expected)
+            if frame.valid():
+                return frame
+            self.torn += 1
+
+    def frames(self, timeout=2.0):
+        """Yields frames until the writer closes the ring or stops publishing."""
+        while True:
+            frame = self.next(timeout)
+            if frame is None:
+                return
+            yield frame
+
+    def latest(self):
+        """Newest complete frame without waiting, or None."""
+        published = self.published()
+        if published == 0:
+            return None
+        self._next = published - 1
+        return self.next(0)
+
+
+if __name__ == '__main__':
+    import sys
+    import time
+
+    with FrameBus(sys.argv[1] if len(sys.argv) > 1 else 'hsi_frame_bus') as bus:
+        print('attached to writer pid %d, %d slots of %d bytes' % (bus.writer_pid, bus.slot_count, bus.data_capacity))
+        count = 0
+        start = time.time()
+        for frame in bus.frames():
+            count += 1
+            if count % 100 == 0:
+                print('frame %d (%dx%d), %.1f FPS, skipped %d, torn %d'
+                      % (frame.frame_id, frame.width, frame.height, count / (time.time() - start), bus.skipped, bus.torn))
+        print('received %d, skipped %d, torn %d' % (count, bus.skipped, bus.torn))
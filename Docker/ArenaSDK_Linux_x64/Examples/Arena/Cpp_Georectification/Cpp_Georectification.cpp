@@ -0,0 +1,923 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "SaveApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Georectification
+//    This example projects pushbroom lines onto the ground as they are
+//    acquired. Poses come from a ROS pose stream, written by
+//    'rostopic echo -p' for a nav_msgs/Odometry topic (robot_localization) or
+//    a geometry_msgs/PoseStamped topic (mavros). The stream can be a file, or
+//    a named pipe for live poses. Position and orientation are interpolated
+//    at the timestamp of every frame. Frame rows run across track and columns
+//    along the spectrum, so every row is one across-track pixel. It is cast
+//    as a ray through the camera model, whose half field of view is 5.35
+//    degrees. Each ray is intersected with a flat ground plane. Each ground
+//    hit is scattered into the nearby cells of a tiled map grid, and every
+//    cell keeps the hit closest to its center. The cell update is a single
+//    atomic compare-and-swap, so each line is scattered by a pool of
+//    persistent worker threads without locks. A live orthomosaic is rewritten
+//    every few lines. At the end, a georeferenced cube is written in the ENVI
+//    format. If the pose file does not exist, a synthetic flight line is used
+//    instead.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) georectified
+#define NUM_LINES 200
+
+// pose stream from 'rostopic echo -p <topic> > poses.csv'; may be a named
+//    pipe (mkfifo) for live poses
+#define POSE_FILE "Cpp_Georectification_poses.csv"
+
+// longest wait for a pose after a frame's timestamp (in milliseconds)
+#define POSE_WAIT_MS 500
+
+// across-track half field of view (in degrees)
+#define HALF_FOV_DEG 5.35
+
+// camera mount relative to the body frame (x forward, y left, z up), in
+//    degrees; all zero looks straight down with the slit across track
+#define MOUNT_ROLL_DEG 0.0
+#define MOUNT_PITCH_DEG 0.0
+#define MOUNT_YAW_DEG 0.0
+
+// height of the ground plane in the pose frame (in meters)
+#define GROUND_HEIGHT_M 0.0
+
+// map cell size (in meters) and tile size (in cells)
+#define CELL_SIZE_M 0.02
+#define TILE_CELLS 256
+
+// cells around each ground hit that it competes for; 1 fills gaps of up to
+//    two cells between neighbouring hits
+#define SCATTER_RADIUS 1
+
+// sensor columns averaged into one band of the georeferenced cube
+#define SPECTRAL_BINNING 8
+
+// lines between live mosaic updates
+#define MOSAIC_INTERVAL 25
+
+// output files
+#define MOSAIC_FILE "Cpp_Georectification_mosaic.png"
+#define CUBE_FILE "Cpp_Georectification.bil"
+#define HEADER_FILE "Cpp_Georectification.hdr"
+
+// synthetic flight line used without a pose file: altitude above the ground
+//    plane (in meters), speed along x (in meters per second), and roll
+//    oscillation (in degrees and hertz)
+#define SYNTHETIC_ALTITUDE_M 30.0
+#define SYNTHETIC_SPEED_M_S 2.0
+#define SYNTHETIC_ROLL_DEG 2.0
+#define SYNTHETIC_ROLL_HZ 0.5
+
+// number of worker threads (0 uses std::thread::hardware_concurrency)
+#define NUM_THREADS 0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+const double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+// pose of the body in the map frame; orientation is a unit quaternion
+//    (x, y, z, w)
+struct Pose
+{
+	int64_t stampNs;
+	double position[3];
+	double orientation[4];
+};
+
+// rotation matrix (row-major) of a unit quaternion
+void QuaternionToMatrix(const double q[4], double m[9])
+{
+	double x = q[0], y = q[1], z = q[2], w = q[3];
+	m[0] = 1 - 2 * (y * y + z * z);
+	m[1] = 2 * (x * y - z * w);
+	m[2] = 2 * (x * z + y * w);
+	m[3] = 2 * (x * y + z * w);
+	m[4] = 1 - 2 * (x * x + z * z);
+	m[5] = 2 * (y * z - x * w);
+	m[6] = 2 * (x * z - y * w);
+	m[7] = 2 * (y * z + x * w);
+	m[8] = 1 - 2 * (x * x + y * y);
+}
+
+// rotation matrix of roll (x), pitch (y), yaw (z), applied in that order
+void EulerToMatrix(double roll, double pitch, double yaw, double m[9])
+{
+	double cr = std::cos(roll), sr = std::sin(roll);
+	double cp = std::cos(pitch), sp = std::sin(pitch);
+	double cy = std::cos(yaw), sy = std::sin(yaw);
+	m[0] = cy * cp;
+	m[1] = cy * sp * sr - sy * cr;
+	m[2] = cy * sp * cr + sy * sr;
+	m[3] = sy * cp;
+	m[4] = sy * sp * sr + cy * cr;
+	m[5] = sy * sp * cr - cy * sr;
+	m[6] = -sp;
+	m[7] = cp * sr;
+	m[8] = cp * cr;
+}
+
+inline void Multiply(const double m[9], const double v[3], double out[3])
+{
+	out[0] = m[0] * v[0] + m[1] * v[1] + m[2] * v[2];
+	out[1] = m[3] * v[0] + m[4] * v[1] + m[5] * v[2];
+	out[2] = m[6] * v[0] + m[7] * v[1] + m[8] * v[2];
+}
+
+// interpolates between two poses: linear in position, spherical in
+//    orientation
+Pose InterpolatePose(const Pose& a, const Pose& b, int64_t stampNs)
+{
+	double t = b.stampNs == a.stampNs ? 0.0 : static_cast<double>(stampNs - a.stampNs) / static_cast<double>(b.stampNs - a.stampNs);
+
+	Pose pose;
+	pose.stampNs = stampNs;
+	for (size_t i = 0; i < 3; i++)
+		pose.position[i] = a.position[i] + t * (b.position[i] - a.position[i]);
+
+	double qb[4] = { b.orientation[0], b.orientation[1], b.orientation[2], b.orientation[3] };
+	double dot = a.orientation[0] * qb[0] + a.orientation[1] * qb[1] + a.orientation[2] * qb[2] + a.orientation[3] * qb[3];
+	if (dot < 0.0)
+	{
+		dot = -dot;
+		for (size_t i = 0; i < 4; i++)
+			qb[i] = -qb[i];
+	}
+	double wa = 1.0 - t;
+	double wb = t;
+	if (dot < 0.9995)
+	{
+		double angle = std::acos(dot);
+		wa = std::sin((1.0 - t) * angle) / std::sin(angle);
+		wb = std::sin(t * angle) / std::sin(angle);
+	}
+	double norm = 0.0;
+	for (size_t i = 0; i < 4; i++)
+	{
+		pose.orientation[i] = wa * a.orientation[i] + wb * qb[i];
+		norm += pose.orientation[i] * pose.orientation[i];
+	}
+	norm = std::sqrt(norm);
+	for (size_t i = 0; i < 4; i++)
+		pose.orientation[i] /= norm;
+	return pose;
+}
+
+// time-ordered poses, read from a rostopic CSV stream on a background
+//    thread or generated for a synthetic flight line
+class PoseStream
+{
+public:
+	// reads poses from a file or named pipe; the reader thread shares the
+	//    stream and the poses, so it can outlive the PoseStream while blocked
+	//    on a pipe
+	explicit PoseStream(const char* path)
+		: m_pShared(std::make_shared<Shared>())
+	{
+		std::shared_ptr<std::ifstream> pInput = std::make_shared<std::ifstream>(path);
+		if (!*pInput)
+			throw GenICam::GenericException("Pose stream could not be opened", __FILE__, __LINE__);
+
+		std::vector<int> columns = ParseHeader(*pInput);
+		m_reader = std::thread(Read, pInput, m_pShared, columns);
+	}
+
+	// synthetic flight line starting at startNs
+	explicit PoseStream(int64_t startNs)
+		: m_pShared(std::make_shared<Shared>())
+	{
+		const double rate = 100.0;
+		m_pShared->done = true;
+		for (size_t i = 0; i < static_cast<size_t>(rate * 3600.0); i++)
+		{
+			double t = i / rate - 1.0;
+			double roll = SYNTHETIC_ROLL_DEG * DEG_TO_RAD * std::sin(2.0 * 3.14159265358979323846 * SYNTHETIC_ROLL_HZ * t);
+			Pose pose;
+			pose.stampNs = startNs + static_cast<int64_t>(t * 1e9);
+			pose.position[0] = SYNTHETIC_SPEED_M_S * t;
+			pose.position[1] = 0.0;
+			pose.position[2] = GROUND_HEIGHT_M + SYNTHETIC_ALTITUDE_M;
+			pose.orientation[0] = std::sin(roll / 2.0);
+			pose.orientation[1] = 0.0;
+			pose.orientation[2] = 0.0;
+			pose.orientation[3] = std::cos(roll / 2.0);
+			m_pShared->poses.push_back(pose);
+		}
+	}
+
+	~PoseStream()
+	{
+		if (m_reader.joinable())
+			m_reader.detach();
+	}
+
+	// pose at a timestamp; waits up to waitMs for a pose after it to arrive
+	bool Interpolate(int64_t stampNs, int waitMs, Pose& pose)
+	{
+		Shared& shared = *m_pShared;
+		std::unique_lock<std::mutex> lock(shared.lock);
+		shared.arrived.wait_for(lock, std::chrono::milliseconds(waitMs), [&]() {
+			return shared.done || (!shared.poses.empty() && shared.poses.back().stampNs >= stampNs);
+		});
+
+		const std::vector<Pose>& poses = shared.poses;
+		if (poses.empty() || stampNs < poses.front().stampNs || stampNs > poses.back().stampNs)
+			return false;
+
+		Pose key;
+		key.stampNs = stampNs;
+		std::vector<Pose>::const_iterator after = std::lower_bound(poses.begin(), poses.end(), key, [](const Pose& a, const Pose& b) {
+			return a.stampNs < b.stampNs;
+		});
+		if (after == poses.begin())
+			pose = *after;
+		else
+			pose = InterpolatePose(*(after - 1), *after, stampNs);
+		return true;
+	}
+
+private:
+	struct Shared
+	{
+		std::mutex lock;
+		std::condition_variable arrived;
+		std::vector<Pose> poses;
+		bool done = false;
+	};
+
+	// finds the stamp, position and orientation columns; Odometry uses
+	//    field.pose.pose.*, PoseStamped field.pose.*
+	static std::vector<int> ParseHeader(std::istream& input)
+	{
+		std::string header;
+		if (!std::getline(input, header))
+			throw GenICam::GenericException("Pose stream is empty", __FILE__, __LINE__);
+
+		const char* suffixes[8] = { "header.stamp", "position.x", "position.y", "position.z", "orientation.x", "orientation.y", "orientation.z", "orientation.w" };
+		std::vector<int> columns(8, -1);
+
+		std::stringstream ss(header);
+		std::string name;
+		for (int column = 0; std::getline(ss, name, ','); column++)
+		{
+			for (size_t i = 0; i < 8; i++)
+			{
+				size_t length = strlen(suffixes[i]);
+				if (columns[i] < 0 && name.size() >= length && name.compare(name.size() - length, length, suffixes[i]) == 0)
+					columns[i] = column;
+			}
+		}
+		for (size_t i = 0; i < 8; i++)
+			if (columns[i] < 0)
+				throw GenICam::GenericException("Pose stream is missing a stamp, position or orientation column", __FILE__, __LINE__);
+		return columns;
+	}
+
+	static void Read(std::shared_ptr<std::ifstream> pInput, std::shared_ptr<Shared> pShared, std::vector<int> columns)
+	{
+		std::string text;
+		std::vector<std::string> fields;
+		while (std::getline(*pInput, text))
+		{
+			fields.clear();
+			std::stringstream ss(text);
+			std::string field;
+			while (std::getline(ss, field, ','))
+				fields.push_back(field);
+
+			bool valid = true;
+			for (size_t i = 0; i < 8 && valid; i++)
+				valid = static_cast<size_t>(columns[i]) < fields.size();
+			if (!valid)
+				continue;
+
+			Pose pose;
+			pose.stampNs = strtoll(fields[columns[0]].c_str(), NULL, 10);
+			for (size_t i = 0; i < 3; i++)
+				pose.position[i] = atof(fields[columns[1 + i]].c_str());
+			for (size_t i = 0; i < 4; i++)
+				pose.orientation[i] = atof(fields[columns[4 + i]].c_str());
+
+			{
+				std::lock_guard<std::mutex> lock(pShared->lock);
+				if (pShared->poses.empty() || pose.stampNs > pShared->poses.back().stampNs)
+					pShared->poses.push_back(pose);
+			}
+			pShared->arrived.notify_all();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pShared->lock);
+			pShared->done = true;
+		}
+		pShared->arrived.notify_all();
+	}
+
+	std::shared_ptr<Shared> m_pShared;
+	std::thread m_reader;
+};
+
+// pushbroom camera: one ray per across-track pixel (sensor row) in the body
+//    frame
+struct CameraModel
+{
+	size_t numPixels;
+	std::vector<double> rays; // 3 per pixel
+
+	void Build(size_t pixels)
+	{
+		numPixels = pixels;
+		double center = 0.5 * static_cast<double>(pixels - 1);
+		double focal = 0.5 * static_cast<double>(pixels) / std::tan(HALF_FOV_DEG * DEG_TO_RAD);
+
+		// camera axes: x across track, y along track, z along the boresight;
+		//    at zero mount angles x points right (-y body), y back (-x body)
+		//    and z down (-z body)
+		const double nadir[9] = {
+			0.0, -1.0, 0.0,
+			-1.0, 0.0, 0.0,
+			0.0, 0.0, -1.0
+		};
+		double mount[9];
+		EulerToMatrix(MOUNT_ROLL_DEG * DEG_TO_RAD, MOUNT_PITCH_DEG * DEG_TO_RAD, MOUNT_YAW_DEG * DEG_TO_RAD, mount);
+		double bodyFromCamera[9];
+		for (size_t r = 0; r < 3; r++)
+			for (size_t c = 0; c < 3; c++)
+				bodyFromCamera[r * 3 + c] = mount[r * 3] * nadir[c] + mount[r * 3 + 1] * nadir[3 + c] + mount[r * 3 + 2] * nadir[6 + c];
+
+		rays.resize(pixels * 3);
+		for (size_t x = 0; x < pixels; x++)
+		{
+			double ray[3] = { (static_cast<double>(x) - center) / focal, 0.0, 1.0 };
+			double norm = std::sqrt(ray[0] * ray[0] + 1.0);
+			ray[0] /= norm;
+			ray[2] /= norm;
+			Multiply(bodyFromCamera, ray, &rays[x * 3]);
+		}
+	}
+};
+
+// map tile: one key per cell packing the squared distance of the winning
+//    hit to the cell center (float bits, high word) and the hit's pixel index
+//    (low word); positive floats order like their bits, so the smallest key
+//    is the nearest hit
+struct MapTile
+{
+	std::atomic<uint64_t> cells[TILE_CELLS * TILE_CELLS];
+
+	MapTile()
+	{
+		for (size_t i = 0; i < TILE_CELLS * TILE_CELLS; i++)
+			cells[i].store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+	}
+};
+
+inline int64_t FloorDiv(int64_t a, int64_t b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// key of a tile; tile coordinates may be negative, so they are packed as
+//    unsigned words
+inline uint64_t TileKey(int64_t tx, int64_t ty)
+{
+	return (static_cast<uint64_t>(tx) << 32) ^ (static_cast<uint64_t>(ty) & 0xFFFFFFFFull);
+}
+
+// tiled map grid in the pose frame; cell (i, j) covers
+//    [i, i + 1) x [j, j + 1) times CELL_SIZE_M
+class MapGrid
+{
+public:
+	~MapGrid()
+	{
+		for (std::unordered_map<uint64_t, MapTile*>::iterator it = m_tiles.begin(); it != m_tiles.end(); ++it)
+			delete it->second;
+	}
+
+	// tile holding a cell, created on first use
+	MapTile* Tile(int64_t tx, int64_t ty)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		MapTile*& pTile = m_tiles[TileKey(tx, ty)];
+		if (!pTile)
+		{
+			pTile = new MapTile();
+			m_bounds[0] = std::min(m_bounds[0], tx);
+			m_bounds[1] = std::min(m_bounds[1], ty);
+			m_bounds[2] = std::max(m_bounds[2], tx);
+			m_bounds[3] = std::max(m_bounds[3], ty);
+		}
+		return pTile;
+	}
+
+	// key of a cell; max for cells never hit
+	uint64_t Cell(int64_t i, int64_t j)
+	{
+		int64_t tx = FloorDiv(i, TILE_CELLS);
+		int64_t ty = FloorDiv(j, TILE_CELLS);
+		std::unordered_map<uint64_t, MapTile*>::const_iterator it = m_tiles.find(TileKey(tx, ty));
+		if (it == m_tiles.end())
+			return std::numeric_limits<uint64_t>::max();
+		return it->second->cells[(j - ty * TILE_CELLS) * TILE_CELLS + (i - tx * TILE_CELLS)].load(std::memory_order_relaxed);
+	}
+
+	// cell range covered by tiles: minimum i, minimum j, maximum i, maximum j
+	bool Bounds(int64_t bounds[4])
+	{
+		if (m_tiles.empty())
+			return false;
+		bounds[0] = m_bounds[0] * TILE_CELLS;
+		bounds[1] = m_bounds[1] * TILE_CELLS;
+		bounds[2] = (m_bounds[2] + 1) * TILE_CELLS - 1;
+		bounds[3] = (m_bounds[3] + 1) * TILE_CELLS - 1;
+		return true;
+	}
+
+	size_t NumTiles() const
+	{
+		return m_tiles.size();
+	}
+
+private:
+	std::mutex m_lock;
+	std::unordered_map<uint64_t, MapTile*> m_tiles;
+	int64_t m_bounds[4] = { std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::min() };
+};
+
+// scatters the ground hits of pixels [first, last) of a line
+void ScatterPixels(const CameraModel& camera, const Pose& pose, uint32_t pixelBase, size_t first, size_t last, MapGrid* pGrid)
+{
+	double bodyToMap[9];
+	QuaternionToMatrix(pose.orientation, bodyToMap);
+
+	// the last tile used is cached to avoid the tile lock
+	int64_t cachedTx = std::numeric_limits<int64_t>::min();
+	int64_t cachedTy = 0;
+	MapTile* pTile = NULL;
+
+	for (size_t x = first; x < last; x++)
+	{
+		double direction[3];
+		Multiply(bodyToMap, &camera.rays[x * 3], direction);
+		if (direction[2] >= -1e-6)
+			continue;
+
+		double s = (GROUND_HEIGHT_M - pose.position[2]) / direction[2];
+		if (s <= 0.0)
+			continue;
+		double gx = (pose.position[0] + s * direction[0]) / CELL_SIZE_M;
+		double gy = (pose.position[1] + s * direction[1]) / CELL_SIZE_M;
+		int64_t ci = static_cast<int64_t>(std::floor(gx));
+		int64_t cj = static_cast<int64_t>(std::floor(gy));
+
+		for (int64_t j = cj - SCATTER_RADIUS; j <= cj + SCATTER_RADIUS; j++)
+		{
+			for (int64_t i = ci - SCATTER_RADIUS; i <= ci + SCATTER_RADIUS; i++)
+			{
+				int64_t tx = FloorDiv(i, TILE_CELLS);
+				int64_t ty = FloorDiv(j, TILE_CELLS);
+				if (tx != cachedTx || ty != cachedTy)
+				{
+					pTile = pGrid->Tile(tx, ty);
+					cachedTx = tx;
+					cachedTy = ty;
+				}
+
+				float dx = static_cast<float>(gx - (i + 0.5));
+				float dy = static_cast<float>(gy - (j + 0.5));
+				float distance = dx * dx + dy * dy;
+				uint32_t bits;
+				memcpy(&bits, &distance, sizeof(bits));
+				uint64_t key = (static_cast<uint64_t>(bits) << 32) | (pixelBase + x);
+
+				std::atomic<uint64_t>& cell = pTile->cells[(j - ty * TILE_CELLS) * TILE_CELLS + (i - tx * TILE_CELLS)];
+				uint64_t current = cell.load(std::memory_order_relaxed);
+				while (key < current && !cell.compare_exchange_weak(current, key, std::memory_order_relaxed))
+				{
+				}
+			}
+		}
+	}
+}
+
+// persistent workers that scatter each line together with the calling
+//    thread; every worker takes a fixed slice of the line's pixels
+class ScatterPool
+{
+public:
+	ScatterPool(size_t numThreads) :
+		m_numThreads(std::max<size_t>(1, numThreads)),
+		m_generation(0),
+		m_pending(0),
+		m_stop(false),
+		m_pCamera(NULL),
+		m_pPose(NULL),
+		m_pixelBase(0),
+		m_pGrid(NULL)
+	{
+		for (size_t t = 1; t < m_numThreads; t++)
+			m_workers.push_back(std::thread(&ScatterPool::Work, this, t));
+	}
+
+	~ScatterPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_stop = true;
+		}
+		m_start.notify_all();
+		for (size_t t = 0; t < m_workers.size(); t++)
+			m_workers[t].join();
+	}
+
+	// scatters one line and returns when every slice is done
+	void ScatterLine(const CameraModel& camera, const Pose& pose, uint32_t pixelBase, MapGrid& grid)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_pCamera = &camera;
+			m_pPose = &pose;
+			m_pixelBase = pixelBase;
+			m_pGrid = &grid;
+			m_pending = m_workers.size();
+			m_generation++;
+		}
+		m_start.notify_all();
+
+		ScatterSlice(0);
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_done.wait(lock, [this]() { return m_pending == 0; });
+	}
+
+private:
+	void ScatterSlice(size_t t)
+	{
+		size_t perThread = (m_pCamera->numPixels + m_numThreads - 1) / m_numThreads;
+		size_t first = std::min(m_pCamera->numPixels, t * perThread);
+		size_t last = std::min(m_pCamera->numPixels, first + perThread);
+		ScatterPixels(*m_pCamera, *m_pPose, m_pixelBase, first, last, m_pGrid);
+	}
+
+	void Work(size_t t)
+	{
+		uint64_t seen = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_start.wait(lock, [&]() { return m_stop || m_generation != seen; });
+				if (m_stop)
+					return;
+				seen = m_generation;
+			}
+
+			ScatterSlice(t);
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (--m_pending == 0)
+				m_done.notify_one();
+		}
+	}
+
+	size_t m_numThreads;
+	std::vector<std::thread> m_workers;
+	std::mutex m_lock;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	uint64_t m_generation;
+	size_t m_pending;
+	bool m_stop;
+
+	// line being scattered, valid while m_pending is above zero
+	const CameraModel* m_pCamera;
+	const Pose* m_pPose;
+	uint32_t m_pixelBase;
+	MapGrid* m_pGrid;
+};
+
+// cell range that was hit at least once
+bool HitBounds(MapGrid& grid, int64_t bounds[4])
+{
+	int64_t tiles[4];
+	if (!grid.Bounds(tiles))
+		return false;
+	bounds[0] = tiles[2];
+	bounds[1] = tiles[3];
+	bounds[2] = tiles[0];
+	bounds[3] = tiles[1];
+	for (int64_t j = tiles[1]; j <= tiles[3]; j++)
+		for (int64_t i = tiles[0]; i <= tiles[2]; i++)
+			if (grid.Cell(i, j) != std::numeric_limits<uint64_t>::max())
+			{
+				bounds[0] = std::min(bounds[0], i);
+				bounds[1] = std::min(bounds[1], j);
+				bounds[2] = std::max(bounds[2], i);
+				bounds[3] = std::max(bounds[3], j);
+			}
+	return bounds[0] <= bounds[2];
+}
+
+// writes the mosaic of a quicklook value per pixel, north up
+void WriteMosaic(MapGrid& grid, const std::vector<uint8_t>& quicklook)
+{
+	int64_t bounds[4];
+	if (!HitBounds(grid, bounds))
+		return;
+
+	size_t width = static_cast<size_t>(bounds[2] - bounds[0] + 1);
+	size_t height = static_cast<size_t>(bounds[3] - bounds[1] + 1);
+	std::vector<uint8_t> mosaic(width * height, 0);
+	for (size_t row = 0; row < height; row++)
+	{
+		int64_t j = bounds[3] - static_cast<int64_t>(row);
+		for (size_t col = 0; col < width; col++)
+		{
+			uint64_t key = grid.Cell(bounds[0] + static_cast<int64_t>(col), j);
+			if (key != std::numeric_limits<uint64_t>::max())
+				mosaic[row * width + col] = quicklook[key & 0xFFFFFFFF];
+		}
+	}
+
+	Save::ImageParams params(width, height, 8);
+	Save::ImageWriter writer(params, MOSAIC_FILE);
+	writer << mosaic.data();
+}
+
+// writes the georeferenced cube (ENVI BIL, uint16, north up) from the binned
+//    lines; cells never hit are zero
+void WriteCube(MapGrid& grid, const std::vector<std::vector<uint16_t> >& lines, size_t numBands, size_t numPixels)
+{
+	int64_t bounds[4];
+	if (!HitBounds(grid, bounds))
+		throw GenICam::GenericException("No ground hits", __FILE__, __LINE__);
+
+	size_t width = static_cast<size_t>(bounds[2] - bounds[0] + 1);
+	size_t height = static_cast<size_t>(bounds[3] - bounds[1] + 1);
+
+	std::ofstream cube(CUBE_FILE, std::ios::binary);
+	std::vector<uint16_t> row(numBands * width);
+	for (size_t r = 0; r < height; r++)
+	{
+		int64_t j = bounds[3] - static_cast<int64_t>(r);
+		std::fill(row.begin(), row.end(), 0);
+		for (size_t col = 0; col < width; col++)
+		{
+			uint64_t key = grid.Cell(bounds[0] + static_cast<int64_t>(col), j);
+			if (key == std::numeric_limits<uint64_t>::max())
+				continue;
+			uint32_t pixel = static_cast<uint32_t>(key & 0xFFFFFFFF);
+			const std::vector<uint16_t>& line = lines[pixel / numPixels];
+			size_t x = pixel % numPixels;
+			for (size_t b = 0; b < numBands; b++)
+				row[b * width + col] = line[b * numPixels + x];
+		}
+		cube.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(uint16_t));
+	}
+
+	// map info gives the pose-frame coordinates of the upper-left corner
+	std::ofstream header(HEADER_FILE);
+	header << std::setprecision(12);
+	header << "ENVI\n";
+	header << "description = {Georectified pushbroom cube, pose frame coordinates}\n";
+	header << "samples = " << width << "\n";
+	header << "lines = " << height << "\n";
+	header << "bands = " << numBands << "\n";
+	header << "header offset = 0\n";
+	header << "file type = ENVI Standard\n";
+	header << "data type = 12\n";
+	header << "interleave = bil\n";
+	header << "byte order = 0\n";
+	header << "map info = {Arbitrary, 1, 1, " << bounds[0] * CELL_SIZE_M << ", " << (bounds[3] + 1) * CELL_SIZE_M << ", " << CELL_SIZE_M << ", " << CELL_SIZE_M << ", 0, units=Meters}\n";
+	header << "data ignore value = 0\n";
+
+	std::cout << TAB2 << width << " x " << height << " cells (" << width * CELL_SIZE_M << " x " << height * CELL_SIZE_M << " m), " << numBands << " bands to " << CUBE_FILE << "\n";
+}
+
+// averages SPECTRAL_BINNING sensor columns of each row into the bands of
+//    that row's pixel, stored band by band, and returns a quicklook (mean of
+//    all bands, 8 bits) per row
+void BinLine(const uint16_t* pFrame, size_t numRows, size_t numColumns, std::vector<uint16_t>& line, uint8_t* pQuicklook)
+{
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	line.resize(numBands * numRows);
+	for (size_t x = 0; x < numRows; x++)
+	{
+		const uint16_t* pSrc = pFrame + x * numColumns;
+		uint32_t total = 0;
+		for (size_t b = 0; b < numBands; b++)
+		{
+			uint32_t sum = 0;
+			for (size_t c = 0; c < SPECTRAL_BINNING; c++)
+				sum += pSrc[b * SPECTRAL_BINNING + c];
+			line[b * numRows + x] = static_cast<uint16_t>(sum / SPECTRAL_BINNING);
+			total += sum / SPECTRAL_BINNING;
+		}
+		pQuicklook[x] = static_cast<uint8_t>(total / numBands >> 8);
+	}
+}
+
+// demonstrates real-time georectification
+// (1) opens the pose stream, or generates a synthetic flight line
+// (2) relates the camera clock to the pose clock
+// (3) interpolates the pose of each frame and scatters its pixels
+// (4) rewrites the live mosaic every few lines
+// (5) writes the georeferenced cube
+void Georectify(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	size_t numRows = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	size_t numColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	if (numBands == 0 || static_cast<uint64_t>(numRows) * NUM_LINES > 0xFFFFFFFFull)
+		throw GenICam::GenericException("Frame size not supported", __FILE__, __LINE__);
+
+	CameraModel camera;
+	camera.Build(numRows);
+	std::cout << TAB1 << numRows << " across-track pixels, half field of view " << HALF_FOV_DEG << " deg\n";
+
+	ScatterPool pool(NUM_THREADS > 0 ? NUM_THREADS : std::thread::hardware_concurrency());
+
+	// camera timestamps are on the pose clock when PTP is enabled; otherwise
+	//    the offset is estimated from the arrival of the first frame
+	GenApi::CBooleanPtr pPtpEnable = pNodeMap->GetNode("PtpEnable");
+	bool ptp = pPtpEnable && GenApi::IsReadable(pPtpEnable) && pPtpEnable->GetValue();
+	std::cout << TAB1 << "Camera timestamps " << (ptp ? "from PTP" : "offset by the arrival of the first frame") << "\n";
+
+	// acquire and georectify
+	std::cout << TAB1 << "Acquire and georectify " << NUM_LINES << " lines\n";
+
+	// stat rather than a test open, which would hang up on the writer of a
+	//    named pipe before PoseStream opens it
+	struct stat poseFileInfo;
+	bool hasPoseFile = stat(POSE_FILE, &poseFileInfo) == 0;
+	std::unique_ptr<PoseStream> pPoses;
+	MapGrid grid;
+	std::vector<std::vector<uint16_t> > lines;
+	std::vector<uint8_t> quicklook(numRows * NUM_LINES, 0);
+	int64_t offsetNs = 0;
+	size_t skipped = 0;
+	double scatterSeconds = 0.0;
+
+	pDevice->StartStream();
+	for (size_t i = 0; i < NUM_LINES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		int64_t hostNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		int64_t frameNs = static_cast<int64_t>(pImage->GetTimestampNs());
+
+		if (i == 0)
+		{
+			offsetNs = ptp ? 0 : hostNs - frameNs;
+			if (hasPoseFile)
+				pPoses.reset(new PoseStream(POSE_FILE));
+			else
+				pPoses.reset(new PoseStream(frameNs + offsetNs));
+			std::cout << TAB2 << (hasPoseFile ? "poses from " POSE_FILE : "synthetic flight line (no " POSE_FILE ")") << "\n";
+		}
+
+		Arena::IImage* pMono16 = Arena::ImageFactory::Convert(pImage, Mono16);
+		lines.push_back(std::vector<uint16_t>());
+		BinLine(reinterpret_cast<const uint16_t*>(pMono16->GetData()), numRows, numColumns, lines.back(), &quicklook[i * numRows]);
+		Arena::ImageFactory::Destroy(pMono16);
+		pDevice->RequeueBuffer(pImage);
+
+		Pose pose;
+		if (!pPoses->Interpolate(frameNs + offsetNs, POSE_WAIT_MS, pose))
+		{
+			skipped++;
+			continue;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		pool.ScatterLine(camera, pose, static_cast<uint32_t>(i * numRows), grid);
+		scatterSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if ((i + 1) % MOSAIC_INTERVAL == 0)
+		{
+			WriteMosaic(grid, quicklook);
+			std::cout << TAB2 << "line " << i + 1 << ": mosaic updated (" << grid.NumTiles() << " tiles)\n";
+		}
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << scatterSeconds * 1000.0 / std::max<size_t>(1, NUM_LINES - skipped) << " ms per line, " << skipped << " lines without a pose\n";
+
+	// write outputs
+	std::cout << TAB1 << "Write mosaic and georeferenced cube\n";
+
+	WriteMosaic(grid, quicklook);
+	WriteCube(grid, lines, numBands, numRows);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Georectification\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		Georectify(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,452 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Image Factory Benchmark
+//    This example times every image factory operation (Copy, Convert,
+//    SelectBits, SelectBitsAndScale and ProcessSoftwareLUT) on synthetic
+//    frames created with Arena::ImageFactory::Create, across a set of PFNC
+//    source formats, conversion targets, Bayer algorithms and frame sizes. No
+//    camera is needed. Each result reports nanoseconds per pixel, throughput
+//    (bytes read plus bytes written per second) and the number and size of
+//    heap allocations per call, and the whole run is written to a JSON file
+//    tagged with the SDK version so that results from different SDK releases
+//    can be compared. Combinations the SDK does not support are recorded as
+//    unsupported instead of aborting the run.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// results file
+#define JSON_FILE "Cpp_ImageFactory_Benchmark.json"
+
+// minimum measuring time per operation (in milliseconds)
+#define MIN_DURATION_MS 200
+
+// minimum number of timed calls per operation
+#define MIN_ITERATIONS 3
+
+// frame sizes to benchmark
+static const size_t SIZES[][2] = {
+	{ 640, 480 },
+	{ 2048, 1536 },
+	{ 4096, 3000 },
+};
+
+// source formats; synthetic frames are created in each
+static const PfncFormat SOURCE_FORMATS[] = {
+	Mono8,
+	Mono10,
+	Mono10p,
+	Mono12,
+	Mono12p,
+	Mono16,
+	BayerRG8,
+	BayerRG10p,
+	BayerRG12p,
+	BayerRG16,
+	RGB8,
+	BGR8,
+	RGBa8,
+	BGRa8,
+	RGB16,
+	YCbCr422_8,
+	YUV422_8_UYVY,
+};
+
+// destination formats for Convert
+static const PfncFormat DESTINATION_FORMATS[] = {
+	Mono8,
+	Mono16,
+	RGB8,
+	BGR8,
+	BGRa8,
+	RGB16,
+};
+
+// Bayer algorithms used when converting from Bayer formats
+static const Arena::EBayerAlgorithm BAYER_ALGORITHMS[] = {
+	Arena::DirectionalInterpolation,
+	Arena::AdaptiveHomogeneityDirected,
+};
+
+// bits kept by SelectBits and SelectBitsAndScale
+#define SELECT_NUM_BITS 8
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// heap allocations made through operator new, including those made inside
+//    the SDK libraries; allocations made directly with malloc are not seen.
+//    The replacements are kept out of line so the compiler does not pair
+//    inlined free calls with operator new.
+static std::atomic<uint64_t> g_allocations(0);
+static std::atomic<uint64_t> g_allocatedBytes(0);
+
+__attribute__((noinline)) void* operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	operator delete(p);
+}
+
+struct BenchmarkResult
+{
+	std::string operation;
+	std::string source;
+	std::string destination;
+	std::string algorithm;
+	size_t width;
+	size_t height;
+	bool supported;
+	std::string error;
+	size_t iterations;
+	double nsPerPixel;
+	double gbPerSecond;
+	double allocationsPerCall;
+	double allocatedBytesPerCall;
+};
+
+inline size_t BitsPerPixel(uint64_t pixelFormat)
+{
+	return static_cast<size_t>((pixelFormat >> 16) & 0xFF);
+}
+
+inline size_t FrameBytes(size_t width, size_t height, uint64_t pixelFormat)
+{
+	return (width * height * BitsPerPixel(pixelFormat) + 7) / 8;
+}
+
+// deterministic noise so every format sees the same kind of content
+std::vector<uint8_t> SyntheticData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 0x12345678;
+	for (size_t i = 0; i < size; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		data[i] = static_cast<uint8_t>(state >> 24);
+	}
+	return data;
+}
+
+bool IsBayer(PfncFormat pixelFormat)
+{
+	return std::string(GetPixelFormatName(pixelFormat)).compare(0, 5, "Bayer") == 0;
+}
+
+// samples per pixel; packed 4:2:2 formats carry two per pixel on average
+size_t GetNumChannels(PfncFormat pixelFormat)
+{
+	std::string name = GetPixelFormatName(pixelFormat);
+	if (name.compare(0, 4, "Mono") == 0 || name.compare(0, 5, "Bayer") == 0)
+		return 1;
+	if (name.compare(0, 4, "RGBa") == 0 || name.compare(0, 4, "BGRa") == 0)
+		return 4;
+	if (name.compare(0, 8, "YCbCr422") == 0 || name.compare(0, 6, "YUV422") == 0)
+		return 2;
+	return 3;
+}
+
+bool IsSingleChannel(PfncFormat pixelFormat)
+{
+	return GetNumChannels(pixelFormat) == 1;
+}
+
+// times one operation; op returns the produced image, which is destroyed
+//    inside the timed region since the allocation is part of the cost
+template <typename F>
+BenchmarkResult Measure(const char* operation, Arena::IImage* pSource, const std::string& destination, const std::string& algorithm, F op)
+{
+	BenchmarkResult result;
+	result.operation = operation;
+	result.source = GetPixelFormatName(static_cast<PfncFormat>(pSource->GetPixelFormat()));
+	result.destination = destination;
+	result.algorithm = algorithm;
+	result.width = pSource->GetWidth();
+	result.height = pSource->GetHeight();
+	result.supported = true;
+	result.iterations = 0;
+	result.nsPerPixel = 0.0;
+	result.gbPerSecond = 0.0;
+	result.allocationsPerCall = 0.0;
+	result.allocatedBytesPerCall = 0.0;
+
+	size_t outputBytes = 0;
+	try
+	{
+		// warm up, and find the output size
+		Arena::IImage* pResult = op();
+		outputBytes = pResult->GetSizeFilled();
+		Arena::ImageFactory::Destroy(pResult);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		result.supported = false;
+		result.error = ge.GetDescription();
+		return result;
+	}
+
+	uint64_t allocations = g_allocations.load();
+	uint64_t allocatedBytes = g_allocatedBytes.load();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point end = start;
+	while (result.iterations < MIN_ITERATIONS || end - start < std::chrono::milliseconds(MIN_DURATION_MS))
+	{
+		Arena::ImageFactory::Destroy(op());
+		result.iterations++;
+		end = std::chrono::steady_clock::now();
+	}
+
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / result.iterations;
+	result.nsPerPixel = ns / (result.width * result.height);
+	result.gbPerSecond = (pSource->GetSizeFilled() + outputBytes) / ns;
+	result.allocationsPerCall = static_cast<double>(g_allocations.load() - allocations) / result.iterations;
+	result.allocatedBytesPerCall = static_cast<double>(g_allocatedBytes.load() - allocatedBytes) / result.iterations;
+	return result;
+}
+
+void PrintResult(const BenchmarkResult& result)
+{
+	std::stringstream label;
+	label << result.operation;
+	if (!result.destination.empty())
+		label << " -> " << result.destination;
+	if (!result.algorithm.empty())
+		label << " (" << result.algorithm << ")";
+
+	std::cout << TAB2 << std::left << std::setw(52) << label.str() << std::right;
+	if (!result.supported)
+	{
+		std::cout << "unsupported\n";
+		return;
+	}
+	std::cout << std::fixed << std::setprecision(3) << std::setw(9) << result.nsPerPixel << " ns/px "
+			  << std::setw(8) << result.gbPerSecond << " GB/s "
+			  << std::setprecision(1) << std::setw(6) << result.allocationsPerCall << " allocs\n";
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+// benchmarks every operation on one synthetic frame
+// (1) copy
+// (2) convert to each destination format, once per Bayer algorithm for
+//     Bayer sources
+// (3) select bits with and without scaling for formats wider than 8 bits
+// (4) software LUT for single channel formats
+void BenchmarkFrame(size_t width, size_t height, PfncFormat sourceFormat, std::vector<BenchmarkResult>& results)
+{
+	std::vector<uint8_t> data = SyntheticData(FrameBytes(width, height, sourceFormat));
+	Arena::IImage* pSource = Arena::ImageFactory::Create(data.data(), data.size(), width, height, sourceFormat);
+
+	std::cout << TAB1 << GetPixelFormatName(sourceFormat) << " " << width << "x" << height << "\n";
+
+	// copy
+	results.push_back(Measure("Copy", pSource, "", "", [&]() {
+		return Arena::ImageFactory::Copy(pSource);
+	}));
+	PrintResult(results.back());
+
+	// convert
+	size_t numAlgorithms = IsBayer(sourceFormat) ? sizeof(BAYER_ALGORITHMS) / sizeof(BAYER_ALGORITHMS[0]) : 1;
+	for (size_t d = 0; d < sizeof(DESTINATION_FORMATS) / sizeof(DESTINATION_FORMATS[0]); d++)
+	{
+		PfncFormat destinationFormat = DESTINATION_FORMATS[d];
+		for (size_t a = 0; a < numAlgorithms; a++)
+		{
+			Arena::EBayerAlgorithm algorithm = BAYER_ALGORITHMS[a];
+			std::string algorithmName = !IsBayer(sourceFormat) ? "" : algorithm == Arena::DirectionalInterpolation ? "DirectionalInterpolation" : "AdaptiveHomogeneityDirected";
+			results.push_back(Measure("Convert", pSource, GetPixelFormatName(destinationFormat), algorithmName, [&]() {
+				return Arena::ImageFactory::Convert(pSource, destinationFormat, algorithm);
+			}));
+			PrintResult(results.back());
+		}
+	}
+
+	// select bits
+	if (pSource->GetBitsPerPixel() / GetNumChannels(sourceFormat) > SELECT_NUM_BITS)
+	{
+		results.push_back(Measure("SelectBits", pSource, "", "", [&]() {
+			return Arena::ImageFactory::SelectBits(pSource, SELECT_NUM_BITS, 0);
+		}));
+		PrintResult(results.back());
+
+		results.push_back(Measure("SelectBitsAndScale", pSource, "", "", [&]() {
+			return Arena::ImageFactory::SelectBitsAndScale(pSource, SELECT_NUM_BITS, 0.0);
+		}));
+		PrintResult(results.back());
+	}
+
+	// software LUT; one output byte per possible input value, inverting
+	if (IsSingleChannel(sourceFormat))
+	{
+		size_t bits = BitsPerPixel(sourceFormat) > 8 ? 16 : 8;
+		std::vector<uint8_t> lut(static_cast<size_t>(1) << bits);
+		for (size_t i = 0; i < lut.size(); i++)
+			lut[i] = static_cast<uint8_t>(~(i >> (bits - 8)));
+		results.push_back(Measure("ProcessSoftwareLUT", pSource, "", "", [&]() {
+			return Arena::ImageFactory::ProcessSoftwareLUT(pSource, lut.data(), lut.size());
+		}));
+		PrintResult(results.back());
+	}
+
+	Arena::ImageFactory::Destroy(pSource);
+}
+
+std::string JsonString(const std::string& value)
+{
+	std::string escaped = "\"";
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		char c = value[i];
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+		if (static_cast<unsigned char>(c) < 0x20)
+			c = ' ';
+		escaped += c;
+	}
+	return escaped + "\"";
+}
+
+void WriteJson(const char* fileName, const std::vector<BenchmarkResult>& results)
+{
+	std::ofstream file(fileName);
+	if (!file)
+		throw GenICam::GenericException("Could not open results file", __FILE__, __LINE__);
+
+	file << "{\n";
+	file << "  \"sdkVersion\": " << JsonString(Arena::GetVersion().c_str()) << ",\n";
+	file << "  \"compiler\": " << JsonString(__VERSION__) << ",\n";
+	file << "  \"minDurationMs\": " << MIN_DURATION_MS << ",\n";
+	file << "  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& r = results[i];
+		file << "    {\"operation\": " << JsonString(r.operation)
+			 << ", \"source\": " << JsonString(r.source)
+			 << ", \"destination\": " << JsonString(r.destination)
+			 << ", \"bayerAlgorithm\": " << JsonString(r.algorithm)
+			 << ", \"width\": " << r.width
+			 << ", \"height\": " << r.height
+			 << ", \"supported\": " << (r.supported ? "true" : "false");
+		if (r.supported)
+		{
+			file << ", \"iterations\": " << r.iterations
+				 << ", \"nsPerPixel\": " << r.nsPerPixel
+				 << ", \"gbPerSecond\": " << r.gbPerSecond
+				 << ", \"allocationsPerCall\": " << r.allocationsPerCall
+				 << ", \"allocatedBytesPerCall\": " << r.allocatedBytesPerCall;
+		}
+		else
+			file << ", \"error\": " << JsonString(r.error);
+		file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n";
+	file << "}\n";
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ImageFactory_Benchmark\n";
+
+	try
+	{
+		// run example
+		std::cout << "Commence example\n\n";
+		std::vector<BenchmarkResult> results;
+		for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+		{
+			for (size_t f = 0; f < sizeof(SOURCE_FORMATS) / sizeof(SOURCE_FORMATS[0]); f++)
+				BenchmarkFrame(SIZES[s][0], SIZES[s][1], SOURCE_FORMATS[f], results);
+		}
+
+		WriteJson(JSON_FILE, results);
+		std::cout << "\n" << TAB1 << results.size() << " results written to " << JSON_FILE << "\n";
+		std::cout << "\nExample complete\n";
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,644 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "GenApi/PortStackedImpl.h"
+#include "GenApi/SelectorSet.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Lookup Tables: Bulk Upload
+//    This example uploads whole tables behind selector-indexed features, such
+//    as LUTValue selected by LUTIndex or the defect pixel positions selected
+//    by DefectCorrectionIndex, without writing the index and the value node
+//    once per entry. The register behind the value node is resolved through
+//    the node map: the selector set confirms that the index selects the
+//    value, and the register address is sampled at three index values to
+//    find the base address and the stride. If entries are packed
+//    back-to-back, the table is written with a few large IPort::Write calls.
+//    If they are interleaved with other registers, a stacked port writes
+//    many registers per request, and otherwise each entry is one port write.
+//    Features that cannot be resolved to a plain register (masked bits,
+//    computed values) fall back to a concatenated node write. The uploader
+//    is first checked bit for bit against per-node writes on a virtual
+//    device described by an XML string, so no camera is needed for that
+//    part. If a camera is connected, its LUT is then uploaded both ways and
+//    timed, and its defect pixel list is rewritten in bulk.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// timeout for detecting camera devices (in milliseconds)
+#define SYSTEM_TIMEOUT 100
+
+// largest single port write (in bytes); GigE Vision WRITEMEM carries at most
+//    536 bytes of data
+#define MAX_BLOCK_BYTES 512
+
+// most register entries in one stacked write
+#define MAX_STACK_ENTRIES 64
+
+// number of camera LUT entries written one node at a time for comparison
+#define NUM_NODE_WRITES 256
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// where the entries of a selector-indexed register feature live
+struct IndexedRegisterLayout
+{
+	bool resolved;
+	std::string reason;
+	GenApi::IPort* pPort;
+	int64_t firstIndex;
+	int64_t lastIndex;
+	int64_t baseAddress;
+	int64_t stride;
+	size_t length;
+	bool bigEndian;
+};
+
+// what an upload did
+struct UploadStats
+{
+	std::string method;
+	size_t portWrites;
+	size_t registersWritten;
+	double milliseconds;
+};
+
+// an Integer node that only forwards to another node through pValue is
+//    followed to the register behind it
+GenApi::INode* FollowValueNode(GenApi::INodeMap* pNodeMap, GenApi::INode* pNode)
+{
+	GenICam::gcstring value;
+	GenICam::gcstring attribute;
+	while (pNode && !dynamic_cast<GenApi::IRegister*>(pNode) && pNode->GetPrincipalInterfaceType() == GenApi::intfIInteger && pNode->GetProperty("pValue", value, attribute))
+		pNode = pNodeMap->GetNode(value);
+	return pNode;
+}
+
+// resolves the register layout behind valueName as indexed by indexName
+// (1) finds the register behind the value node
+// (2) rejects masked registers, which need read-modify-write
+// (3) checks that the index node selects the value node
+// (4) finds the port
+// (5) samples the register address at three index values
+IndexedRegisterLayout ResolveIndexedRegister(GenApi::INodeMap* pNodeMap, const char* indexName, const char* valueName)
+{
+	IndexedRegisterLayout layout;
+	layout.resolved = false;
+	layout.pPort = NULL;
+	layout.firstIndex = 0;
+	layout.lastIndex = 0;
+	layout.baseAddress = 0;
+	layout.stride = 0;
+	layout.length = 0;
+	layout.bigEndian = false;
+
+	GenApi::CIntegerPtr pIndex = pNodeMap->GetNode(indexName);
+	GenApi::INode* pValueNode = pNodeMap->GetNode(valueName);
+	if (!pIndex || !pValueNode)
+		throw GenICam::GenericException("Requisite node(s) for indexed register do(es) not exist", __FILE__, __LINE__);
+	layout.firstIndex = pIndex->GetMin();
+	layout.lastIndex = pIndex->GetMax();
+
+	// find register
+	GenApi::INode* pRegisterNode = FollowValueNode(pNodeMap, pValueNode);
+	GenApi::IRegister* pRegister = dynamic_cast<GenApi::IRegister*>(pRegisterNode);
+	if (!pRegister)
+	{
+		layout.reason = "value is not backed by a register";
+		return layout;
+	}
+
+	// reject masked registers
+	GenICam::gcstring value;
+	GenICam::gcstring attribute;
+	if (pRegisterNode->GetProperty("LSB", value, attribute) || pRegisterNode->GetProperty("Bit", value, attribute))
+	{
+		layout.reason = "value occupies part of a register";
+		return layout;
+	}
+
+	// check selector
+	GenApi::CSelectorSet selectors(pValueNode);
+	GenApi::FeatureList_t selectorList;
+	selectors.GetSelectorList(selectorList);
+	bool selected = false;
+	for (size_t i = 0; i < selectorList.size(); i++)
+		selected = selected || selectorList[i]->GetNode()->GetName() == indexName;
+	if (!selected)
+	{
+		layout.reason = "index does not select value";
+		return layout;
+	}
+
+	// find port
+	if (!pRegisterNode->GetProperty("pPort", value, attribute))
+	{
+		layout.reason = "register has no port";
+		return layout;
+	}
+	layout.pPort = dynamic_cast<GenApi::IPort*>(pNodeMap->GetNode(value));
+	if (!layout.pPort)
+	{
+		layout.reason = "port node is not a port";
+		return layout;
+	}
+
+	layout.length = static_cast<size_t>(pRegister->GetLength());
+	layout.bigEndian = pRegisterNode->GetProperty("Endianess", value, attribute) && value == "BigEndian";
+
+	// sample addresses; other selectors keep their current values
+	int64_t indexInitial = pIndex->GetValue();
+	pIndex->SetValue(layout.firstIndex);
+	int64_t firstAddress = pRegister->GetAddress();
+	pIndex->SetValue(layout.lastIndex);
+	int64_t lastAddress = pRegister->GetAddress();
+	int64_t secondAddress = firstAddress;
+	if (layout.lastIndex > layout.firstIndex)
+	{
+		pIndex->SetValue(layout.firstIndex + 1);
+		secondAddress = pRegister->GetAddress();
+	}
+	pIndex->SetValue(indexInitial);
+
+	layout.baseAddress = firstAddress;
+	layout.stride = secondAddress - firstAddress;
+	if (lastAddress != firstAddress + layout.stride * (layout.lastIndex - layout.firstIndex) || (layout.lastIndex > layout.firstIndex && layout.stride < static_cast<int64_t>(layout.length)))
+	{
+		layout.reason = "register address is not linear in the index";
+		return layout;
+	}
+
+	layout.resolved = true;
+	return layout;
+}
+
+void EncodeRegister(int64_t value, size_t length, bool bigEndian, uint8_t* pBytes)
+{
+	for (size_t b = 0; b < length; b++)
+	{
+		uint8_t byte = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * b));
+		pBytes[bigEndian ? length - 1 - b : b] = byte;
+	}
+}
+
+int64_t DecodeRegister(const uint8_t* pBytes, size_t length, bool bigEndian)
+{
+	uint64_t value = 0;
+	for (size_t b = 0; b < length; b++)
+		value |= static_cast<uint64_t>(pBytes[bigEndian ? length - 1 - b : b]) << (8 * b);
+	return static_cast<int64_t>(value);
+}
+
+// writes values to entries firstIndex, firstIndex + 1, ... of valueName;
+//    port nodes do not expose stacked access, so a caller that owns a port
+//    implementation with stacked writes passes it in
+UploadStats BulkUpload(GenApi::INodeMap* pNodeMap, const char* indexName, const char* valueName, int64_t firstIndex, const std::vector<int64_t>& values, GenApi::IPortStacked* pStackedPort = NULL)
+{
+	UploadStats stats;
+	stats.portWrites = 0;
+	stats.registersWritten = 0;
+
+	IndexedRegisterLayout layout = ResolveIndexedRegister(pNodeMap, indexName, valueName);
+	if (layout.resolved && (firstIndex < layout.firstIndex || firstIndex + static_cast<int64_t>(values.size()) - 1 > layout.lastIndex))
+		throw GenICam::GenericException("Table does not fit the index range", __FILE__, __LINE__);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GenApi::IPortStacked* pStacked = pStackedPort ? pStackedPort : dynamic_cast<GenApi::IPortStacked*>(layout.pPort);
+	int64_t address = layout.baseAddress + (firstIndex - layout.firstIndex) * layout.stride;
+
+	if (layout.resolved && layout.stride == static_cast<int64_t>(layout.length))
+	{
+		// packed entries: a few large block writes
+		stats.method = "block writes";
+		std::vector<uint8_t> bytes(values.size() * layout.length);
+		for (size_t i = 0; i < values.size(); i++)
+			EncodeRegister(values[i], layout.length, layout.bigEndian, &bytes[i * layout.length]);
+
+		size_t blockBytes = std::max<size_t>(MAX_BLOCK_BYTES / layout.length, 1) * layout.length;
+		for (size_t offset = 0; offset < bytes.size(); offset += blockBytes)
+		{
+			size_t n = std::min(blockBytes, bytes.size() - offset);
+			layout.pPort->Write(&bytes[offset], address + static_cast<int64_t>(offset), static_cast<int64_t>(n));
+			stats.portWrites++;
+		}
+		stats.registersWritten = values.size();
+	}
+	else if (layout.resolved)
+	{
+		// interleaved entries: stacked writes where the port supports them
+		std::vector<uint8_t> bytes(values.size() * layout.length);
+		std::vector<GenApi::PORT_REGISTER_STACK_ENTRY> entries(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			EncodeRegister(values[i], layout.length, layout.bigEndian, &bytes[i * layout.length]);
+			entries[i].Address = static_cast<uint64_t>(address + static_cast<int64_t>(i) * layout.stride);
+			entries[i].pBuffer = &bytes[i * layout.length];
+			entries[i].Size = layout.length;
+		}
+
+		if (pStacked)
+		{
+			stats.method = "stacked writes";
+			for (size_t i = 0; i < entries.size(); i += MAX_STACK_ENTRIES)
+			{
+				pStacked->Write(&entries[i], std::min<size_t>(MAX_STACK_ENTRIES, entries.size() - i));
+				stats.portWrites++;
+			}
+		}
+		else
+		{
+			stats.method = "register writes";
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				layout.pPort->Write(entries[i].pBuffer, static_cast<int64_t>(entries[i].Address), static_cast<int64_t>(entries[i].Size));
+				stats.portWrites++;
+			}
+		}
+		stats.registersWritten = values.size();
+	}
+	else
+	{
+		// unresolved: let the node map write index and value pairs
+		stats.method = "concatenated node writes (" + layout.reason + ")";
+		GenApi::CIntegerPtr pIndex = pNodeMap->GetNode(indexName);
+		GenApi::CIntegerPtr pValue = pNodeMap->GetNode(valueName);
+		int64_t indexInitial = pIndex->GetValue();
+
+		GenApi::CNodeWriteConcatenatorRef concatenator(pNodeMap->NewNodeWriteConcatenator());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			concatenator._Add(indexName, firstIndex + static_cast<int64_t>(i));
+			concatenator._Add(valueName, values[i]);
+		}
+		concatenator._Add(indexName, indexInitial);
+		if (!pNodeMap->ConcatenatedWrite(concatenator))
+		{
+			stats.method = "node writes (" + layout.reason + ")";
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				pIndex->SetValue(firstIndex + static_cast<int64_t>(i));
+				pValue->SetValue(values[i]);
+			}
+			pIndex->SetValue(indexInitial);
+		}
+		stats.portWrites = 2 * values.size() + 1;
+		stats.registersWritten = values.size();
+	}
+
+	// the node map cached values before the raw writes
+	pNodeMap->GetNode(valueName)->InvalidateNode();
+
+	stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+// reads entries firstIndex, firstIndex + 1, ... of valueName; block reads
+//    where the layout allows, node reads otherwise
+std::vector<int64_t> BulkRead(GenApi::INodeMap* pNodeMap, const char* indexName, const char* valueName, int64_t firstIndex, size_t count)
+{
+	std::vector<int64_t> values(count);
+	IndexedRegisterLayout layout = ResolveIndexedRegister(pNodeMap, indexName, valueName);
+	if (layout.resolved && layout.stride == static_cast<int64_t>(layout.length))
+	{
+		std::vector<uint8_t> bytes(count * layout.length);
+		int64_t address = layout.baseAddress + (firstIndex - layout.firstIndex) * layout.stride;
+		size_t blockBytes = std::max<size_t>(MAX_BLOCK_BYTES / layout.length, 1) * layout.length;
+		for (size_t offset = 0; offset < bytes.size(); offset += blockBytes)
+			layout.pPort->Read(&bytes[offset], address + static_cast<int64_t>(offset), static_cast<int64_t>(std::min(blockBytes, bytes.size() - offset)));
+		for (size_t i = 0; i < count; i++)
+			values[i] = DecodeRegister(&bytes[i * layout.length], layout.length, layout.bigEndian);
+		return values;
+	}
+
+	GenApi::CIntegerPtr pIndex = pNodeMap->GetNode(indexName);
+	GenApi::CIntegerPtr pValue = pNodeMap->GetNode(valueName);
+	int64_t indexInitial = pIndex->GetValue();
+	for (size_t i = 0; i < count; i++)
+	{
+		pIndex->SetValue(firstIndex + static_cast<int64_t>(i));
+		values[i] = pValue->GetValue();
+	}
+	pIndex->SetValue(indexInitial);
+	return values;
+}
+
+void PrintStats(const char* table, const UploadStats& stats)
+{
+	std::cout << TAB2 << table << ": " << stats.registersWritten << " entries, " << stats.portWrites << " writes, " << stats.milliseconds << " ms, " << stats.method << "\n";
+}
+
+// virtual device: a LUT of packed 32-bit big-endian entries, defect
+//    positions interleaved as X, Y pairs, and a gain table stored in the
+//    upper bits of its registers
+static const char* VIRTUAL_DEVICE_XML =
+	"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+	"<RegisterDescription ModelName=\"VirtualDevice\" VendorName=\"LUCID\" ToolTip=\"\" StandardNameSpace=\"None\""
+	" SchemaMajorVersion=\"1\" SchemaMinorVersion=\"1\" SchemaSubMinorVersion=\"0\" MajorVersion=\"1\" MinorVersion=\"0\" SubMinorVersion=\"0\""
+	" ProductGuid=\"6B1D5C8E-4F7A-4D2B-9E31-0C5A7F28D410\" VersionGuid=\"6B1D5C8E-4F7A-4D2B-9E31-0C5A7F28D411\""
+	" xmlns=\"http://www.genicam.org/GenApi/Version_1_1\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+	" xsi:schemaLocation=\"http://www.genicam.org/GenApi/Version_1_1 http://www.genicam.org/GenApi/GenApiSchema_Version_1_1.xsd\">\n"
+	"<Category Name=\"Root\" NameSpace=\"Standard\"><pFeature>LUTValue</pFeature><pFeature>DefectCorrectionPositionX</pFeature><pFeature>GainTableValue</pFeature></Category>\n"
+	"<Integer Name=\"LUTIndex\"><Value>0</Value><Min>0</Min><Max>4095</Max><pSelected>LUTValue</pSelected></Integer>\n"
+	"<IntReg Name=\"LUTValue\"><Address>0x10000</Address><pIndex Offset=\"4\">LUTIndex</pIndex><Length>4</Length><AccessMode>RW</AccessMode>"
+	"<pPort>Device</pPort><Cachable>NoCache</Cachable><Sign>Unsigned</Sign><Endianess>BigEndian</Endianess></IntReg>\n"
+	"<Integer Name=\"DefectCorrectionIndex\"><Value>0</Value><Min>0</Min><Max>255</Max>"
+	"<pSelected>DefectCorrectionPositionX</pSelected><pSelected>DefectCorrectionPositionY</pSelected></Integer>\n"
+	"<IntReg Name=\"DefectCorrectionPositionX\"><Address>0x20000</Address><pIndex Offset=\"8\">DefectCorrectionIndex</pIndex><Length>4</Length><AccessMode>RW</AccessMode>"
+	"<pPort>Device</pPort><Cachable>NoCache</Cachable><Sign>Unsigned</Sign><Endianess>BigEndian</Endianess></IntReg>\n"
+	"<IntReg Name=\"DefectCorrectionPositionY\"><Address>0x20004</Address><pIndex Offset=\"8\">DefectCorrectionIndex</pIndex><Length>4</Length><AccessMode>RW</AccessMode>"
+	"<pPort>Device</pPort><Cachable>NoCache</Cachable><Sign>Unsigned</Sign><Endianess>BigEndian</Endianess></IntReg>\n"
+	"<Integer Name=\"GainTableIndex\"><Value>0</Value><Min>0</Min><Max>255</Max><pSelected>GainTableValue</pSelected></Integer>\n"
+	"<MaskedIntReg Name=\"GainTableValue\"><Address>0x30000</Address><pIndex Offset=\"4\">GainTableIndex</pIndex><Length>4</Length><AccessMode>RW</AccessMode>"
+	"<pPort>Device</pPort><Cachable>NoCache</Cachable><LSB>16</LSB><MSB>31</MSB><Sign>Unsigned</Sign><Endianess>LittleEndian</Endianess></MaskedIntReg>\n"
+	"<Port Name=\"Device\"/>\n"
+	"</RegisterDescription>\n";
+
+// register memory of the virtual device; supports stacked writes
+class VirtualDevicePort : public GenApi::CPortStackedImpl
+{
+public:
+	VirtualDevicePort()
+		: m_memory(0x40000, 0), m_writes(0)
+	{
+	}
+
+	virtual GenApi::EAccessMode GetAccessMode() const
+	{
+		return GenApi::RW;
+	}
+
+	virtual void Read(void* pBuffer, int64_t address, int64_t length)
+	{
+		CheckRange(address, length);
+		memcpy(pBuffer, &m_memory[static_cast<size_t>(address)], static_cast<size_t>(length));
+	}
+
+	virtual void Write(const void* pBuffer, int64_t address, int64_t length)
+	{
+		CheckRange(address, length);
+		memcpy(&m_memory[static_cast<size_t>(address)], pBuffer, static_cast<size_t>(length));
+		m_writes++;
+	}
+
+	virtual void Read(GenApi::PORT_REGISTER_STACK_ENTRY* pEntries, size_t numEntries)
+	{
+		for (size_t i = 0; i < numEntries; i++)
+			Read(pEntries[i].pBuffer, static_cast<int64_t>(pEntries[i].Address), static_cast<int64_t>(pEntries[i].Size));
+	}
+
+	virtual void Write(GenApi::PORT_REGISTER_STACK_ENTRY* pEntries, size_t numEntries)
+	{
+		for (size_t i = 0; i < numEntries; i++)
+		{
+			CheckRange(static_cast<int64_t>(pEntries[i].Address), static_cast<int64_t>(pEntries[i].Size));
+			memcpy(&m_memory[static_cast<size_t>(pEntries[i].Address)], pEntries[i].pBuffer, pEntries[i].Size);
+		}
+		m_writes++;
+	}
+
+	const std::vector<uint8_t>& Memory() const
+	{
+		return m_memory;
+	}
+
+	size_t Writes() const
+	{
+		return m_writes;
+	}
+
+private:
+	void CheckRange(int64_t address, int64_t length)
+	{
+		if (address < 0 || length < 0 || static_cast<size_t>(address + length) > m_memory.size())
+			throw GenICam::GenericException("Virtual device access out of range", __FILE__, __LINE__);
+	}
+
+	std::vector<uint8_t> m_memory;
+	size_t m_writes;
+};
+
+// checks the bulk uploader against per-node writes on the virtual device
+// (1) creates two virtual devices
+// (2) writes every table one node at a time to the first
+// (3) writes every table in bulk to the second
+// (4) compares register memory byte for byte
+bool VerifyOnVirtualDevice()
+{
+	std::cout << TAB1 << "Verify bulk upload on virtual device\n";
+
+	// create devices
+	GenApi::CNodeMapRef referenceMap;
+	GenApi::CNodeMapRef bulkMap;
+	VirtualDevicePort referencePort;
+	VirtualDevicePort bulkPort;
+	referenceMap._LoadXMLFromString(VIRTUAL_DEVICE_XML);
+	bulkMap._LoadXMLFromString(VIRTUAL_DEVICE_XML);
+	referenceMap._Connect(&referencePort, "Device");
+	bulkMap._Connect(&bulkPort, "Device");
+
+	// tables; the defect list starts part way in
+	static const char* const TABLES[][2] = {
+		{ "LUTIndex", "LUTValue" },
+		{ "DefectCorrectionIndex", "DefectCorrectionPositionX" },
+		{ "DefectCorrectionIndex", "DefectCorrectionPositionY" },
+		{ "GainTableIndex", "GainTableValue" },
+	};
+	static const int64_t FIRST_INDEX[] = { 0, 16, 16, 0 };
+	static const size_t COUNT[] = { 4096, 200, 200, 256 };
+
+	bool identical = true;
+	for (size_t t = 0; t < sizeof(TABLES) / sizeof(TABLES[0]); t++)
+	{
+		std::vector<int64_t> values(COUNT[t]);
+		uint32_t state = 0x9E3779B9u + static_cast<uint32_t>(t);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			state = state * 1664525u + 1013904223u;
+			values[i] = t == 0 ? static_cast<int64_t>(4095 - i) : t == 3 ? static_cast<int64_t>(state >> 16) : static_cast<int64_t>(state >> 20);
+		}
+
+		// per-node reference
+		GenApi::CIntegerPtr pIndex = referenceMap._GetNode(TABLES[t][0]);
+		GenApi::CIntegerPtr pValue = referenceMap._GetNode(TABLES[t][1]);
+		size_t writesBefore = referencePort.Writes();
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			pIndex->SetValue(FIRST_INDEX[t] + static_cast<int64_t>(i));
+			pValue->SetValue(values[i]);
+		}
+		pIndex->SetValue(0);
+		size_t referenceWrites = referencePort.Writes() - writesBefore;
+
+		// bulk
+		UploadStats stats = BulkUpload(bulkMap._Ptr, TABLES[t][0], TABLES[t][1], FIRST_INDEX[t], values, &bulkPort);
+		std::vector<int64_t> readBack = BulkRead(bulkMap._Ptr, TABLES[t][0], TABLES[t][1], FIRST_INDEX[t], values.size());
+		bool readBackMatches = readBack == values;
+		identical = identical && readBackMatches;
+
+		PrintStats(TABLES[t][1], stats);
+		std::cout << TAB3 << "per-node reference used " << referenceWrites << " port writes, read back " << (readBackMatches ? "matches" : "DIFFERS") << "\n";
+	}
+
+	bool memoryMatches = referencePort.Memory() == bulkPort.Memory();
+	std::cout << TAB2 << "register memory " << (memoryMatches ? "bit-exact" : "DIFFERS") << "\n";
+	return identical && memoryMatches;
+}
+
+// uploads the camera LUT in bulk and rewrites the defect list
+// (1) resolves and reports the LUT register layout
+// (2) saves the current LUT
+// (3) times a slice written one node at a time
+// (4) uploads an inverted LUT in bulk and checks it
+// (5) restores the LUT
+// (6) rewrites existing defect positions in bulk
+void UploadToCamera(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// resolve layout
+	std::cout << TAB1 << "Resolve camera LUT layout\n";
+
+	IndexedRegisterLayout layout = ResolveIndexedRegister(pNodeMap, "LUTIndex", "LUTValue");
+	if (layout.resolved)
+		std::cout << TAB2 << "LUTValue[" << layout.firstIndex << ".." << layout.lastIndex << "] at 0x" << std::hex << layout.baseAddress << std::dec << ", stride " << layout.stride << ", " << layout.length << " bytes, " << (layout.bigEndian ? "big" : "little") << " endian\n";
+	else
+		std::cout << TAB2 << "not resolved: " << layout.reason << "\n";
+
+	// save LUT
+	size_t numEntries = static_cast<size_t>(layout.lastIndex - layout.firstIndex + 1);
+	std::vector<int64_t> original = BulkRead(pNodeMap, "LUTIndex", "LUTValue", layout.firstIndex, numEntries);
+
+	// time per-node slice
+	std::cout << TAB1 << "Upload inverted LUT\n";
+
+	GenApi::CIntegerPtr pLUTIndex = pNodeMap->GetNode("LUTIndex");
+	GenApi::CIntegerPtr pLUTValue = pNodeMap->GetNode("LUTValue");
+	int64_t maxValue = pLUTValue->GetMax();
+	std::vector<int64_t> inverted(numEntries);
+	for (size_t i = 0; i < numEntries; i++)
+		inverted[i] = std::max<int64_t>(maxValue - static_cast<int64_t>(i) * maxValue / static_cast<int64_t>(std::max<size_t>(numEntries - 1, 1)), 0);
+
+	size_t numNodeWrites = std::min<size_t>(NUM_NODE_WRITES, numEntries);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < numNodeWrites; i++)
+	{
+		pLUTIndex->SetValue(layout.firstIndex + static_cast<int64_t>(i));
+		pLUTValue->SetValue(inverted[i]);
+	}
+	double nodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << TAB2 << "node writes: " << numNodeWrites << " entries in " << nodeMs << " ms, about " << nodeMs * numEntries / numNodeWrites << " ms for the full table\n";
+
+	// bulk upload and check
+	UploadStats stats = BulkUpload(pNodeMap, "LUTIndex", "LUTValue", layout.firstIndex, inverted);
+	PrintStats("LUTValue", stats);
+	std::vector<int64_t> readBack = BulkRead(pNodeMap, "LUTIndex", "LUTValue", layout.firstIndex, numEntries);
+	std::cout << TAB2 << "read back " << (readBack == inverted ? "matches" : "DIFFERS") << "\n";
+
+	// restore LUT
+	stats = BulkUpload(pNodeMap, "LUTIndex", "LUTValue", layout.firstIndex, original);
+	PrintStats("restore LUTValue", stats);
+
+	// rewrite defects
+	std::cout << TAB1 << "Rewrite defect pixel list\n";
+
+	GenApi::CIntegerPtr pDefectCount = pNodeMap->GetNode("DefectCorrectionCount");
+	if (!pDefectCount || !GenApi::IsReadable(pDefectCount) || pDefectCount->GetValue() == 0)
+	{
+		std::cout << TAB2 << "no defect pixels stored, skipping\n";
+		return;
+	}
+	size_t numDefects = static_cast<size_t>(pDefectCount->GetValue());
+	std::vector<int64_t> xs = BulkRead(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionX", 0, numDefects);
+	std::vector<int64_t> ys = BulkRead(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionY", 0, numDefects);
+	PrintStats("DefectCorrectionPositionX", BulkUpload(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionX", 0, xs));
+	PrintStats("DefectCorrectionPositionY", BulkUpload(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionY", 0, ys));
+	bool unchanged = BulkRead(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionX", 0, numDefects) == xs && BulkRead(pNodeMap, "DefectCorrectionIndex", "DefectCorrectionPositionY", 0, numDefects) == ys;
+	std::cout << TAB2 << numDefects << " defect positions " << (unchanged ? "unchanged" : "CHANGED") << "\n";
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_LUT_BulkUpload\n";
+
+	try
+	{
+		// run example on virtual device
+		std::cout << "Commence example\n\n";
+		if (!VerifyOnVirtualDevice())
+			throw GenICam::GenericException("Bulk upload differs from per-node writes", __FILE__, __LINE__);
+
+		// prepare camera
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(SYSTEM_TIMEOUT);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+			std::cout << "\n" << TAB1 << "No camera connected, skipping camera upload\n";
+		else
+		{
+			Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+			std::cout << "\n";
+			UploadToCamera(pDevice);
+			pSystem->DestroyDevice(pDevice);
+		}
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,470 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LUT_HAVE_AVX2_PATH 1
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Lookup Tables: Software LUT Engine
+//    This example applies lookup tables to 10, 12 and 16-bit mono images in
+//    software. ImageFactory::ProcessSoftwareLUT only takes 8-bit tables and
+//    always allocates a new image, and the camera LUT (see Cpp_LUT) is
+//    programmed one entry at a time. Here a table has one 16-bit output per
+//    possible input value (1024, 4096 or 65536 entries). Tables can be
+//    composed, so a dark offset, a linearisation curve and a radiance gain
+//    collapse into a single table and cost one memory pass per frame instead
+//    of a conversion to floating point. Tables are applied either in place or
+//    into a buffer taken from a preallocated pool, which is wrapped as an
+//    image with ImageFactory::Shallow without copying. On processors with
+//    AVX2 the lookup uses hardware gathers; the portable path is an unrolled
+//    scalar loop. Both paths are checked against each other and against the
+//    floating point computation they replace.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// pixel format acquired; Mono10, Mono12 or Mono16
+#define PIXEL_FORMAT "Mono12"
+
+// black level subtracted before linearisation (in counts)
+#define DARK_OFFSET 64
+
+// gamma of the curve removed by linearisation
+#define LINEARISATION_GAMMA 2.2
+
+// radiance per linear count, scaled into the 16-bit output
+#define RADIANCE_GAIN 0.85
+
+// number of timed passes for each method
+#define NUM_ITERATIONS 20
+
+// number of buffers in the output pool
+#define POOL_SIZE 4
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// one output per input value; a spare entry at the end lets the gather path
+//    read 32 bits at the last index
+class SoftwareLUT
+{
+public:
+	SoftwareLUT(size_t inputBits, size_t outputBits)
+		: m_inputBits(inputBits), m_outputBits(outputBits), m_table((static_cast<size_t>(1) << inputBits) + 1, 0)
+	{
+		if (inputBits < 1 || inputBits > 16 || outputBits < 1 || outputBits > 16)
+			throw GenICam::GenericException("LUT bit depth must be between 1 and 16", __FILE__, __LINE__);
+	}
+
+	size_t InputBits() const
+	{
+		return m_inputBits;
+	}
+
+	size_t OutputBits() const
+	{
+		return m_outputBits;
+	}
+
+	size_t Size() const
+	{
+		return m_table.size() - 1;
+	}
+
+	uint16_t MaxInput() const
+	{
+		return static_cast<uint16_t>(Size() - 1);
+	}
+
+	uint16_t MaxOutput() const
+	{
+		return static_cast<uint16_t>((1u << m_outputBits) - 1);
+	}
+
+	uint16_t& operator[](size_t index)
+	{
+		return m_table[index];
+	}
+
+	uint16_t operator[](size_t index) const
+	{
+		return m_table[index];
+	}
+
+	const uint16_t* Data() const
+	{
+		return m_table.data();
+	}
+
+	// table of f(x) for every input, rounded and clamped to the output range
+	template <typename F>
+	static SoftwareLUT FromFunction(size_t inputBits, size_t outputBits, F f)
+	{
+		SoftwareLUT lut(inputBits, outputBits);
+		for (size_t i = 0; i < lut.Size(); i++)
+		{
+			double value = std::floor(f(static_cast<double>(i)) + 0.5);
+			lut[i] = static_cast<uint16_t>(std::min(std::max(value, 0.0), static_cast<double>(lut.MaxOutput())));
+		}
+		return lut;
+	}
+
+	// single table equal to applying first, then second; outputs of first
+	//    beyond the input range of second are clamped
+	static SoftwareLUT Compose(const SoftwareLUT& first, const SoftwareLUT& second)
+	{
+		SoftwareLUT lut(first.InputBits(), second.OutputBits());
+		for (size_t i = 0; i < lut.Size(); i++)
+			lut[i] = second[std::min(first[i], second.MaxInput())];
+		return lut;
+	}
+
+private:
+	size_t m_inputBits;
+	size_t m_outputBits;
+	std::vector<uint16_t> m_table;
+};
+
+// portable path, unrolled by four; inputs above the table are clamped
+void ApplyLUTScalar(const SoftwareLUT& lut, const uint16_t* pSrc, uint16_t* pDst, size_t count)
+{
+	const uint16_t* pTable = lut.Data();
+	const uint16_t maxInput = lut.MaxInput();
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		uint16_t a = std::min(pSrc[i + 0], maxInput);
+		uint16_t b = std::min(pSrc[i + 1], maxInput);
+		uint16_t c = std::min(pSrc[i + 2], maxInput);
+		uint16_t d = std::min(pSrc[i + 3], maxInput);
+		pDst[i + 0] = pTable[a];
+		pDst[i + 1] = pTable[b];
+		pDst[i + 2] = pTable[c];
+		pDst[i + 3] = pTable[d];
+	}
+	for (; i < count; i++)
+		pDst[i] = pTable[std::min(pSrc[i], maxInput)];
+}
+
+#if defined(LUT_HAVE_AVX2_PATH)
+// AVX2 path; sixteen pixels per iteration, each gather reads 32 bits at
+//    index * 2 and keeps the low half
+__attribute__((target("avx2"))) void ApplyLUTAvx2(const SoftwareLUT& lut, const uint16_t* pSrc, uint16_t* pDst, size_t count)
+{
+	const int* pTable = reinterpret_cast<const int*>(lut.Data());
+	const __m256i maxInput = _mm256_set1_epi32(lut.MaxInput());
+	const __m256i lowHalf = _mm256_set1_epi32(0xFFFF);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i));
+		__m256i lo = _mm256_min_epu32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(pixels)), maxInput);
+		__m256i hi = _mm256_min_epu32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(pixels, 1)), maxInput);
+		lo = _mm256_and_si256(_mm256_i32gather_epi32(pTable, lo, 2), lowHalf);
+		hi = _mm256_and_si256(_mm256_i32gather_epi32(pTable, hi, 2), lowHalf);
+
+		// packus interleaves the 128-bit lanes; restore pixel order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), packed);
+	}
+	ApplyLUTScalar(lut, pSrc + i, pDst + i, count - i);
+}
+#endif
+
+bool HasAvx2()
+{
+#if defined(LUT_HAVE_AVX2_PATH)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+// pSrc and pDst may be the same buffer
+void ApplyLUT(const SoftwareLUT& lut, const uint16_t* pSrc, uint16_t* pDst, size_t count, bool allowAvx2 = true)
+{
+#if defined(LUT_HAVE_AVX2_PATH)
+	static const bool hasAvx2 = HasAvx2();
+	if (allowAvx2 && hasAvx2)
+	{
+		ApplyLUTAvx2(lut, pSrc, pDst, count);
+		return;
+	}
+#endif
+	ApplyLUTScalar(lut, pSrc, pDst, count);
+}
+
+// fixed set of frame buffers reused for LUT output
+class FrameBufferPool
+{
+public:
+	FrameBufferPool(size_t numBuffers, size_t pixelsPerBuffer)
+		: m_buffers(numBuffers, std::vector<uint16_t>(pixelsPerBuffer))
+	{
+		for (size_t i = 0; i < numBuffers; i++)
+			m_free.push_back(m_buffers[i].data());
+	}
+
+	uint16_t* Acquire()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_free.empty())
+			throw GenICam::GenericException("Frame buffer pool exhausted", __FILE__, __LINE__);
+		uint16_t* pBuffer = m_free.back();
+		m_free.pop_back();
+		return pBuffer;
+	}
+
+	void Release(uint16_t* pBuffer)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_free.push_back(pBuffer);
+	}
+
+private:
+	std::mutex m_lock;
+	std::vector<std::vector<uint16_t> > m_buffers;
+	std::vector<uint16_t*> m_free;
+};
+
+// the computation the composed table replaces
+inline uint16_t RadianceFloat(uint16_t pixel, double maxInput)
+{
+	double counts = std::max(static_cast<double>(pixel) - DARK_OFFSET, 0.0);
+	double linear = std::pow(counts / (maxInput - DARK_OFFSET), LINEARISATION_GAMMA);
+	double radiance = std::floor(linear * RADIANCE_GAIN * 65535.0 + 0.5);
+	return static_cast<uint16_t>(std::min(radiance, 65535.0));
+}
+
+template <typename F>
+double TimeNsPerPixel(size_t numPixels, F f)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_ITERATIONS; i++)
+		f();
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(numPixels) * NUM_ITERATIONS);
+}
+
+// demonstrates the software LUT engine on an acquired image
+// (1) acquires an image in a 16-bit container format
+// (2) builds dark offset, linearisation and radiance tables
+// (3) composes them into one table and checks it
+// (4) compares floating point, chained, scalar and AVX2 processing
+// (5) applies the table into a pooled buffer and wraps it as an image
+void ApplySoftwareLUTs(Arena::IDevice* pDevice)
+{
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat");
+
+	// acquire image
+	std::cout << TAB1 << "Acquire " << PIXEL_FORMAT << " image\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", PIXEL_FORMAT);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	pDevice->StartStream();
+	Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+	Arena::IImage* pCopy = Arena::ImageFactory::Copy(pImage);
+	pDevice->RequeueBuffer(pImage);
+	pDevice->StopStream();
+
+	if (pCopy->GetBitsPerPixel() != 16)
+	{
+		Arena::ImageFactory::Destroy(pCopy);
+		Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", pixelFormatInitial);
+		throw GenICam::GenericException("Pixel format must use a 16-bit container", __FILE__, __LINE__);
+	}
+
+	size_t width = pCopy->GetWidth();
+	size_t height = pCopy->GetHeight();
+	size_t numPixels = width * height;
+	size_t inputBits = std::string(PIXEL_FORMAT) == "Mono10" ? 10 : std::string(PIXEL_FORMAT) == "Mono12" ? 12 : 16;
+	std::vector<uint16_t> source(numPixels);
+	memcpy(source.data(), pCopy->GetData(), numPixels * sizeof(uint16_t));
+	Arena::ImageFactory::Destroy(pCopy);
+
+	// build tables; each stage keeps 16 bits of precision for the next
+	std::cout << TAB1 << "Build " << (1u << inputBits) << "-entry tables\n";
+
+	double maxInput = static_cast<double>((1u << inputBits) - 1);
+	SoftwareLUT darkOffset = SoftwareLUT::FromFunction(inputBits, 16, [&](double x) {
+		return std::max(x - DARK_OFFSET, 0.0) * 65535.0 / (maxInput - DARK_OFFSET);
+	});
+	SoftwareLUT linearise = SoftwareLUT::FromFunction(16, 16, [](double x) {
+		return std::pow(x / 65535.0, LINEARISATION_GAMMA) * 65535.0;
+	});
+	SoftwareLUT radiance = SoftwareLUT::FromFunction(16, 16, [](double x) {
+		return x * RADIANCE_GAIN;
+	});
+
+	// compose, and check against applying the tables one after another
+	SoftwareLUT composed = SoftwareLUT::Compose(SoftwareLUT::Compose(darkOffset, linearise), radiance);
+	std::cout << TAB1 << "Compose into one " << composed.Size() << "-entry table\n";
+
+	size_t chainMismatches = 0;
+	int maxFloatError = 0;
+	for (size_t i = 0; i < composed.Size(); i++)
+	{
+		if (composed[i] != radiance[linearise[darkOffset[i]]])
+			chainMismatches++;
+		int error = std::abs(static_cast<int>(composed[i]) - static_cast<int>(RadianceFloat(static_cast<uint16_t>(i), maxInput)));
+		maxFloatError = std::max(maxFloatError, error);
+	}
+	std::cout << TAB2 << "mismatches against chained tables: " << chainMismatches << "\n";
+	std::cout << TAB2 << "largest difference from floating point: " << maxFloatError << " counts (of 65535)\n";
+
+	// time each method
+	std::cout << TAB1 << "Process " << width << "x" << height << " image (" << NUM_ITERATIONS << " passes)\n";
+
+	std::vector<uint16_t> floatOutput(numPixels);
+	double floatNs = TimeNsPerPixel(numPixels, [&]() {
+		for (size_t i = 0; i < numPixels; i++)
+			floatOutput[i] = RadianceFloat(source[i], maxInput);
+	});
+
+	std::vector<uint16_t> chained(numPixels);
+	double chainedNs = TimeNsPerPixel(numPixels, [&]() {
+		ApplyLUT(darkOffset, source.data(), chained.data(), numPixels);
+		ApplyLUT(linearise, chained.data(), chained.data(), numPixels);
+		ApplyLUT(radiance, chained.data(), chained.data(), numPixels);
+	});
+
+	std::vector<uint16_t> scalar(numPixels);
+	double scalarNs = TimeNsPerPixel(numPixels, [&]() {
+		ApplyLUT(composed, source.data(), scalar.data(), numPixels, false);
+	});
+
+	std::cout << TAB2 << "floating point:            " << floatNs << " ns/pixel\n";
+	std::cout << TAB2 << "three tables, chained:     " << chainedNs << " ns/pixel\n";
+	std::cout << TAB2 << "composed table, scalar:    " << scalarNs << " ns/pixel\n";
+
+	if (HasAvx2())
+	{
+		std::vector<uint16_t> gathered(numPixels);
+		double avx2Ns = TimeNsPerPixel(numPixels, [&]() {
+			ApplyLUT(composed, source.data(), gathered.data(), numPixels);
+		});
+		std::cout << TAB2 << "composed table, AVX2:      " << avx2Ns << " ns/pixel\n";
+		std::cout << TAB2 << "AVX2 matches scalar:       " << (gathered == scalar ? "yes" : "no") << "\n";
+	}
+	else
+		std::cout << TAB2 << "AVX2 not available, gather path skipped\n";
+
+	std::cout << TAB2 << "chained matches composed:  " << (chained == scalar ? "yes" : "no") << "\n";
+
+	// in place
+	std::vector<uint16_t> inPlace = source;
+	double inPlaceNs = TimeNsPerPixel(numPixels, [&]() {
+		ApplyLUT(composed, inPlace.data(), inPlace.data(), numPixels);
+		memcpy(inPlace.data(), source.data(), numPixels * sizeof(uint16_t));
+	});
+	ApplyLUT(composed, inPlace.data(), inPlace.data(), numPixels);
+	std::cout << TAB2 << "composed table, in place:  " << inPlaceNs << " ns/pixel (including restore copy)\n";
+	std::cout << TAB2 << "in place matches:          " << (inPlace == scalar ? "yes" : "no") << "\n";
+
+	// into a pooled buffer, wrapped as an image without a copy
+	std::cout << TAB1 << "Apply into pooled buffer\n";
+
+	FrameBufferPool pool(POOL_SIZE, numPixels);
+	uint16_t* pBuffer = pool.Acquire();
+	ApplyLUT(composed, source.data(), pBuffer, numPixels);
+	Arena::IImage* pOutput = Arena::ImageFactory::Shallow(reinterpret_cast<const uint8_t*>(pBuffer), numPixels * sizeof(uint16_t), width, height, Mono16);
+	std::cout << TAB2 << "output " << GetPixelFormatName(static_cast<PfncFormat>(pOutput->GetPixelFormat())) << " " << pOutput->GetWidth() << "x" << pOutput->GetHeight() << ", first pixel " << reinterpret_cast<const uint16_t*>(pOutput->GetData())[0] << "\n";
+	Arena::ImageFactory::Destroy(pOutput);
+	pool.Release(pBuffer);
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_LUT_Software\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		ApplySoftwareLUTs(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,675 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Pixel Correction: Defect Detection
+//    This example finds defective pixels instead of correcting one chosen
+//    pixel (see Cpp_PixelCorrection). A stack of dark frames (lens covered)
+//    and a stack of flat frames (uniform illumination) are accumulated with
+//    Welford's streaming mean and variance, so no frame is kept in memory.
+//    Hot pixels have a dark level far above the sensor's typical dark level,
+//    dead pixels respond much less to light than the pixels around them, and
+//    noisy pixels have an unusually large temporal variance. The worst
+//    defects are mapped back to sensor coordinates through the image offset
+//    and binning, and added to the camera's correction list until the
+//    device accepts no more. All defects are written to a compact defect map
+//    file and compiled into a correction table for a software kernel: each
+//    defect is replaced by the average of the nearest good pixels in the
+//    same column. For a pushbroom hyperspectral sensor the columns are
+//    spectral bands and the rows run across track, so correcting along the
+//    column never mixes bands.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// pixel format; 8-bit or 16-bit container mono formats
+#define PIXEL_FORMAT "Mono16"
+
+// number of frames in each stack
+#define NUM_DARK_FRAMES 32
+#define NUM_FLAT_FRAMES 32
+
+// hot: dark mean above the median dark mean by this many robust standard
+//    deviations
+#define HOT_SIGMA 8.0
+
+// dead: flat response below this fraction of the median response of its tile
+#define DEAD_FRACTION 0.5
+
+// noisy: dark standard deviation above this multiple of the median
+#define NOISY_FACTOR 5.0
+
+// tile size for local flat response medians (in pixels)
+#define TILE_SIZE 32
+
+// furthest good neighbour searched along a column (in pixels)
+#define MAX_NEIGHBOUR_DISTANCE 4
+
+// incomplete or mis-sized frames tolerated while accumulating a stack
+#define MAX_BAD_FRAMES 32
+
+// defect map file
+#define DEFECT_MAP_FILE "Cpp_PixelCorrection_Detection_defects.bin"
+
+// save the device correction list to the camera's non-volatile memory
+#define SAVE_TO_DEVICE false
+
+// number of frames corrected in software as a timing check
+#define NUM_CORRECTED_FRAMES 20
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+enum DefectClass
+{
+	DEFECT_NONE = 0,
+	DEFECT_HOT = 1,
+	DEFECT_DEAD = 2,
+	DEFECT_NOISY = 3
+};
+
+static const char* const DEFECT_NAMES[] = { "good", "hot", "dead", "noisy" };
+
+// per-pixel streaming mean and variance (Welford)
+class PixelStatistics
+{
+public:
+	PixelStatistics(size_t width, size_t height)
+		: m_width(width), m_height(height), m_count(0), m_mean(width * height, 0.0f), m_m2(width * height, 0.0f)
+	{
+	}
+
+	// adds one frame of 8-bit or 16-bit pixels
+	void Add(const uint8_t* pData, size_t bitsPerPixel)
+	{
+		m_count++;
+		float invCount = 1.0f / static_cast<float>(m_count);
+		size_t n = m_width * m_height;
+		float* pMean = m_mean.data();
+		float* pM2 = m_m2.data();
+		size_t i = 0;
+
+		if (bitsPerPixel == 16)
+		{
+			const uint16_t* pPixels = reinterpret_cast<const uint16_t*>(pData);
+#if defined(__SSE2__)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 inv = _mm_set1_ps(invCount);
+			for (; i + 8 <= n; i += 8)
+			{
+				__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels + i));
+				Update4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(pixels, zero)), inv, pMean + i, pM2 + i);
+				Update4(_mm_cvtepi32_ps(_mm_unpackhi_epi16(pixels, zero)), inv, pMean + i + 4, pM2 + i + 4);
+			}
+#endif
+			for (; i < n; i++)
+				Update1(static_cast<float>(pPixels[i]), invCount, pMean[i], pM2[i]);
+		}
+		else
+		{
+#if defined(__SSE2__)
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 inv = _mm_set1_ps(invCount);
+			for (; i + 16 <= n; i += 16)
+			{
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData + i));
+				__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+				__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+				Update4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), inv, pMean + i, pM2 + i);
+				Update4(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), inv, pMean + i + 4, pM2 + i + 4);
+				Update4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), inv, pMean + i + 8, pM2 + i + 8);
+				Update4(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), inv, pMean + i + 12, pM2 + i + 12);
+			}
+#endif
+			for (; i < n; i++)
+				Update1(static_cast<float>(pData[i]), invCount, pMean[i], pM2[i]);
+		}
+	}
+
+	size_t Width() const
+	{
+		return m_width;
+	}
+
+	size_t Height() const
+	{
+		return m_height;
+	}
+
+	float Mean(size_t i) const
+	{
+		return m_mean[i];
+	}
+
+	float StdDev(size_t i) const
+	{
+		return m_count > 1 ? std::sqrt(m_m2[i] / static_cast<float>(m_count - 1)) : 0.0f;
+	}
+
+private:
+	static inline void Update1(float x, float invCount, float& mean, float& m2)
+	{
+		float delta = x - mean;
+		mean += delta * invCount;
+		m2 += delta * (x - mean);
+	}
+
+#if defined(__SSE2__)
+	static inline void Update4(__m128 x, __m128 invCount, float* pMean, float* pM2)
+	{
+		__m128 mean = _mm_loadu_ps(pMean);
+		__m128 delta = _mm_sub_ps(x, mean);
+		mean = _mm_add_ps(mean, _mm_mul_ps(delta, invCount));
+		__m128 m2 = _mm_add_ps(_mm_loadu_ps(pM2), _mm_mul_ps(delta, _mm_sub_ps(x, mean)));
+		_mm_storeu_ps(pMean, mean);
+		_mm_storeu_ps(pM2, m2);
+	}
+#endif
+
+	size_t m_width;
+	size_t m_height;
+	size_t m_count;
+	std::vector<float> m_mean;
+	std::vector<float> m_m2;
+};
+
+float Median(std::vector<float> values)
+{
+	if (values.empty())
+		return 0.0f;
+	std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+	return values[values.size() / 2];
+}
+
+struct Defect
+{
+	uint32_t x;
+	uint32_t y;
+	DefectClass type;
+	float severity;
+};
+
+// classifies every pixel from the dark and flat statistics
+// (1) hot: dark mean against the median and median absolute deviation
+// (2) noisy: dark standard deviation against its median
+// (3) dead: flat response against the median response of its tile
+std::vector<Defect> ClassifyPixels(const PixelStatistics& dark, const PixelStatistics& flat)
+{
+	size_t width = dark.Width();
+	size_t height = dark.Height();
+	size_t n = width * height;
+
+	// hot
+	std::vector<float> values(n);
+	for (size_t i = 0; i < n; i++)
+		values[i] = dark.Mean(i);
+	float darkMedian = Median(values);
+	for (size_t i = 0; i < n; i++)
+		values[i] = std::fabs(dark.Mean(i) - darkMedian);
+	float darkSigma = std::max(1.4826f * Median(values), 0.5f);
+
+	// noisy
+	for (size_t i = 0; i < n; i++)
+		values[i] = dark.StdDev(i);
+	float noiseMedian = std::max(Median(values), 0.5f);
+
+	// dead; tile medians follow vignetting and illumination gradients
+	size_t tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	size_t tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+	std::vector<float> tileMedians(tilesX * tilesY);
+	std::vector<float> tile;
+	for (size_t ty = 0; ty < tilesY; ty++)
+	{
+		for (size_t tx = 0; tx < tilesX; tx++)
+		{
+			tile.clear();
+			for (size_t y = ty * TILE_SIZE; y < std::min(height, (ty + 1) * TILE_SIZE); y++)
+			{
+				for (size_t x = tx * TILE_SIZE; x < std::min(width, (tx + 1) * TILE_SIZE); x++)
+					tile.push_back(flat.Mean(y * width + x) - dark.Mean(y * width + x));
+			}
+			tileMedians[ty * tilesX + tx] = Median(tile);
+		}
+	}
+
+	std::vector<Defect> defects;
+	for (size_t y = 0; y < height; y++)
+	{
+		for (size_t x = 0; x < width; x++)
+		{
+			size_t i = y * width + x;
+			float hotScore = (dark.Mean(i) - darkMedian) / darkSigma;
+			float tileMedian = tileMedians[(y / TILE_SIZE) * tilesX + x / TILE_SIZE];
+			float response = flat.Mean(i) - dark.Mean(i);
+			float noiseScore = dark.StdDev(i) / noiseMedian;
+
+			Defect defect;
+			defect.x = static_cast<uint32_t>(x);
+			defect.y = static_cast<uint32_t>(y);
+			defect.type = DEFECT_NONE;
+			defect.severity = 0.0f;
+			if (hotScore > HOT_SIGMA)
+			{
+				defect.type = DEFECT_HOT;
+				defect.severity = hotScore / HOT_SIGMA;
+			}
+			else if (tileMedian > 0.0f && response < DEAD_FRACTION * tileMedian)
+			{
+				defect.type = DEFECT_DEAD;
+				defect.severity = DEAD_FRACTION * tileMedian / std::max(response, 1.0f);
+			}
+			else if (noiseScore > NOISY_FACTOR)
+			{
+				defect.type = DEFECT_NOISY;
+				defect.severity = noiseScore / NOISY_FACTOR;
+			}
+			if (defect.type != DEFECT_NONE)
+				defects.push_back(defect);
+		}
+	}
+
+	// worst first
+	std::sort(defects.begin(), defects.end(), [](const Defect& a, const Defect& b) {
+		return a.severity > b.severity;
+	});
+	return defects;
+}
+
+// correction table; target pixel i is replaced by the average of pixels
+//    first[i] and second[i] of the same column, all stored as linear indices
+struct DefectCorrectionTable
+{
+	std::vector<uint32_t> target;
+	std::vector<uint32_t> first;
+	std::vector<uint32_t> second;
+};
+
+DefectCorrectionTable BuildCorrectionTable(const std::vector<Defect>& defects, size_t width, size_t height)
+{
+	std::vector<uint8_t> bad(width * height, 0);
+	for (size_t i = 0; i < defects.size(); i++)
+		bad[defects[i].y * width + defects[i].x] = 1;
+
+	// row order keeps the kernel's memory accesses moving forward
+	std::vector<uint32_t> targets;
+	for (size_t i = 0; i < defects.size(); i++)
+		targets.push_back(static_cast<uint32_t>(defects[i].y * width + defects[i].x));
+	std::sort(targets.begin(), targets.end());
+
+	DefectCorrectionTable table;
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		size_t y = targets[i] / width;
+		size_t x = targets[i] % width;
+		long above = -1;
+		long below = -1;
+		for (size_t d = 1; d <= MAX_NEIGHBOUR_DISTANCE && (above < 0 || below < 0); d++)
+		{
+			if (above < 0 && y >= d && !bad[(y - d) * width + x])
+				above = static_cast<long>(y - d);
+			if (below < 0 && y + d < height && !bad[(y + d) * width + x])
+				below = static_cast<long>(y + d);
+		}
+		if (above < 0 && below < 0)
+			continue; // a cluster too tall to fill from the column; left as is
+		if (above < 0)
+			above = below;
+		if (below < 0)
+			below = above;
+
+		table.target.push_back(targets[i]);
+		table.first.push_back(static_cast<uint32_t>(above * width + x));
+		table.second.push_back(static_cast<uint32_t>(below * width + x));
+	}
+	return table;
+}
+
+// software correction kernel; a branch-free loop over the table. Every
+//    source pixel is a good pixel, so the order of the writes does not matter
+template <typename T>
+void CorrectFrame(const DefectCorrectionTable& table, T* pPixels)
+{
+	const uint32_t* pTarget = table.target.data();
+	const uint32_t* pFirst = table.first.data();
+	const uint32_t* pSecond = table.second.data();
+	size_t n = table.target.size();
+	for (size_t i = 0; i < n; i++)
+		pPixels[pTarget[i]] = static_cast<T>((static_cast<uint32_t>(pPixels[pFirst[i]]) + pPixels[pSecond[i]] + 1) >> 1);
+}
+
+// compact defect map: a header and one 32-bit word per defect holding the
+//    linear pixel index and the class in the low two bits
+void SaveDefectMap(const char* fileName, const std::vector<Defect>& defects, size_t width, size_t height)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+		throw GenICam::GenericException("Could not open defect map file", __FILE__, __LINE__);
+
+	uint32_t header[4] = { 0x5044464Du, static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(defects.size()) };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	for (size_t i = 0; i < defects.size(); i++)
+	{
+		uint32_t word = static_cast<uint32_t>((defects[i].y * width + defects[i].x) << 2) | static_cast<uint32_t>(defects[i].type);
+		file.write(reinterpret_cast<const char*>(&word), sizeof(word));
+	}
+}
+
+// acquires numFrames complete frames into stats; gives up after
+//    MAX_BAD_FRAMES incomplete or mis-sized frames
+void AccumulateFrames(Arena::IDevice* pDevice, size_t numFrames, PixelStatistics& stats)
+{
+	size_t badFrames = 0;
+	pDevice->StartStream();
+	for (size_t i = 0; i < numFrames;)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		bool good = !pImage->IsIncomplete() && pImage->GetWidth() == stats.Width() && pImage->GetHeight() == stats.Height();
+		if (good)
+		{
+			stats.Add(pImage->GetData(), pImage->GetBitsPerPixel());
+			i++;
+		}
+		pDevice->RequeueBuffer(pImage);
+
+		if (!good && ++badFrames > MAX_BAD_FRAMES)
+		{
+			pDevice->StopStream();
+			throw GenICam::GenericException("Too many incomplete frames; check the packet size and packet resend", __FILE__, __LINE__);
+		}
+	}
+	pDevice->StopStream();
+}
+
+// image geometry relative to the sensor; the correction list holds sensor
+//    pixels, the images are offset and possibly binned
+struct SensorGeometry
+{
+	int64_t offsetX;
+	int64_t offsetY;
+	int64_t binningHorizontal;
+	int64_t binningVertical;
+};
+
+int64_t GetOptionalInt(GenApi::INodeMap* pNodeMap, const char* nodeName, int64_t fallback)
+{
+	GenApi::CIntegerPtr pInteger = pNodeMap->GetNode(nodeName);
+	return pInteger && GenApi::IsReadable(pInteger) ? pInteger->GetValue() : fallback;
+}
+
+SensorGeometry GetSensorGeometry(GenApi::INodeMap* pNodeMap)
+{
+	SensorGeometry geometry;
+	geometry.offsetX = GetOptionalInt(pNodeMap, "OffsetX", 0);
+	geometry.offsetY = GetOptionalInt(pNodeMap, "OffsetY", 0);
+	geometry.binningHorizontal = std::max<int64_t>(1, GetOptionalInt(pNodeMap, "BinningHorizontal", 1));
+	geometry.binningVertical = std::max<int64_t>(1, GetOptionalInt(pNodeMap, "BinningVertical", 1));
+	return geometry;
+}
+
+// adds the worst defects to the camera's correction list, skipping pixels
+//    already in it, until the device accepts no more. Image coordinates are
+//    offset (OffsetX and OffsetY count binned pixels) and scaled to the
+//    sensor; a binned pixel covers several sensor pixels and all of them are
+//    listed, since the image cannot tell which one is defective.
+size_t UploadDefects(Arena::IDevice* pDevice, const std::vector<Defect>& defects, const SensorGeometry& geometry)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+	GenApi::CIntegerPtr pIndex = pNodeMap->GetNode("DefectCorrectionIndex");
+	GenApi::CIntegerPtr pCount = pNodeMap->GetNode("DefectCorrectionCount");
+	GenApi::CIntegerPtr pX = pNodeMap->GetNode("DefectCorrectionPositionX");
+	GenApi::CIntegerPtr pY = pNodeMap->GetNode("DefectCorrectionPositionY");
+	GenApi::CCommandPtr pGetNewDefect = pNodeMap->GetNode("DefectCorrectionGetNewDefect");
+	if (!pIndex || !pCount || !pX || !pY || !pGetNewDefect)
+		throw GenICam::GenericException("Requisite defect correction node(s) do(es) not exist", __FILE__, __LINE__);
+
+	// existing entries
+	int64_t count = pCount->GetValue();
+	std::vector<std::pair<int64_t, int64_t> > existing;
+	for (int64_t i = 0; i < count; i++)
+	{
+		pIndex->SetValue(i);
+		existing.push_back(std::make_pair(pX->GetValue(), pY->GetValue()));
+	}
+	std::sort(existing.begin(), existing.end());
+	std::cout << TAB2 << count << " entries in use\n";
+
+	// Grow the list
+	//    Getting a new defect appends an entry and selects it. When the list
+	//    is full the command is rejected or the count stops growing.
+	size_t added = 0;
+	bool full = false;
+	for (size_t i = 0; i < defects.size() && !full; i++)
+	{
+		int64_t firstX = (geometry.offsetX + defects[i].x) * geometry.binningHorizontal;
+		int64_t firstY = (geometry.offsetY + defects[i].y) * geometry.binningVertical;
+		for (int64_t y = firstY; y < firstY + geometry.binningVertical && !full; y++)
+		{
+			for (int64_t x = firstX; x < firstX + geometry.binningHorizontal && !full; x++)
+			{
+				std::pair<int64_t, int64_t> position(x, y);
+				if (std::binary_search(existing.begin(), existing.end(), position))
+					continue;
+
+				try
+				{
+					pGetNewDefect->Execute();
+				}
+				catch (GenICam::GenericException&)
+				{
+					full = true;
+					break;
+				}
+				if (pCount->GetValue() <= count)
+				{
+					full = true;
+					break;
+				}
+				count = pCount->GetValue();
+
+				pX->SetValue(position.first);
+				pY->SetValue(position.second);
+				added++;
+			}
+		}
+	}
+	if (full)
+		std::cout << TAB2 << "correction list full at " << count << " entries\n";
+
+	Arena::ExecuteNode(pNodeMap, "DefectCorrectionApply");
+	if (SAVE_TO_DEVICE)
+		Arena::ExecuteNode(pNodeMap, "DefectCorrectionSave");
+	return added;
+}
+
+// detects defective pixels and corrects them
+// (1) accumulates a dark stack
+// (2) accumulates a flat stack
+// (3) classifies pixels
+// (4) saves the defect map
+// (5) uploads the worst defects to the camera
+// (6) corrects frames in software
+void DetectDefects(Arena::IDevice* pDevice)
+{
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat");
+	bool defectCorrectionEnableInitial = Arena::GetNodeValue<bool>(pDevice->GetNodeMap(), "DefectCorrectionEnable");
+
+	// the camera's own correction would hide the defects being measured
+	Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", PIXEL_FORMAT);
+	Arena::SetNodeValue<bool>(pDevice->GetNodeMap(), "DefectCorrectionEnable", false);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	size_t width = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pDevice->GetNodeMap(), "Width"));
+	size_t height = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pDevice->GetNodeMap(), "Height"));
+	SensorGeometry geometry = GetSensorGeometry(pDevice->GetNodeMap());
+
+	// dark stack
+	std::cout << TAB1 << "Cover the lens and press enter";
+	std::getchar();
+	PixelStatistics dark(width, height);
+	AccumulateFrames(pDevice, NUM_DARK_FRAMES, dark);
+	std::cout << TAB2 << NUM_DARK_FRAMES << " dark frames accumulated\n";
+
+	// flat stack
+	std::cout << TAB1 << "Point the camera at a uniform, evenly lit target and press enter";
+	std::getchar();
+	PixelStatistics flat(width, height);
+	AccumulateFrames(pDevice, NUM_FLAT_FRAMES, flat);
+	std::cout << TAB2 << NUM_FLAT_FRAMES << " flat frames accumulated\n";
+
+	// classify
+	std::cout << TAB1 << "Classify pixels\n";
+
+	std::vector<Defect> defects = ClassifyPixels(dark, flat);
+	size_t counts[4] = { 0, 0, 0, 0 };
+	for (size_t i = 0; i < defects.size(); i++)
+		counts[defects[i].type]++;
+	for (int c = DEFECT_HOT; c <= DEFECT_NOISY; c++)
+		std::cout << TAB2 << DEFECT_NAMES[c] << ": " << counts[c] << "\n";
+	for (size_t i = 0; i < std::min<size_t>(defects.size(), 5); i++)
+		std::cout << TAB3 << "(" << defects[i].x << ", " << defects[i].y << ") " << DEFECT_NAMES[defects[i].type] << ", severity " << defects[i].severity << "\n";
+
+	// save defect map
+	SaveDefectMap(DEFECT_MAP_FILE, defects, width, height);
+	std::cout << TAB1 << "Save defect map to " << DEFECT_MAP_FILE << " (" << 16 + 4 * defects.size() << " bytes)\n";
+
+	// upload
+	std::cout << TAB1 << "Upload worst defects to camera\n";
+	std::cout << TAB2 << "image offset (" << geometry.offsetX << ", " << geometry.offsetY << "), binning " << geometry.binningHorizontal << " x " << geometry.binningVertical << "\n";
+	size_t added = UploadDefects(pDevice, defects, geometry);
+	std::cout << TAB2 << added << " sensor pixels added; defects not in the list are corrected in software only\n";
+
+	// software correction
+	std::cout << TAB1 << "Correct " << NUM_CORRECTED_FRAMES << " frames in software\n";
+
+	DefectCorrectionTable table = BuildCorrectionTable(defects, width, height);
+	std::cout << TAB2 << table.target.size() << " of " << defects.size() << " defects correctable from their column\n";
+
+	double correctionNs = 0.0;
+	pDevice->StartStream();
+	for (int i = 0; i < NUM_CORRECTED_FRAMES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		Arena::IImage* pCopy = Arena::ImageFactory::Copy(pImage);
+		pDevice->RequeueBuffer(pImage);
+
+		uint8_t* pData = const_cast<uint8_t*>(pCopy->GetData());
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (pCopy->GetBitsPerPixel() == 16)
+			CorrectFrame(table, reinterpret_cast<uint16_t*>(pData));
+		else
+			CorrectFrame(table, pData);
+		correctionNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+		Arena::ImageFactory::Destroy(pCopy);
+	}
+	pDevice->StopStream();
+	std::cout << TAB2 << "average correction time " << correctionNs / NUM_CORRECTED_FRAMES / 1000.0 << " us per frame\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<bool>(pDevice->GetNodeMap(), "DefectCorrectionEnable", defectCorrectionEnableInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetNodeMap(), "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_PixelCorrection_Detection\n";
+	std::cout << "Example may change device settings -- proceed? ('y' to continue) ";
+	char continueExample = 'a';
+	std::cin >> continueExample;
+
+	// clear input
+	while (std::cin.get() != '\n')
+		continue;
+
+	if (continueExample == 'y')
+	{
+		try
+		{
+			// prepare example
+			Arena::ISystem* pSystem = Arena::OpenSystem();
+			pSystem->UpdateDevices(100);
+			std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+			if (deviceInfos.size() == 0)
+			{
+				std::cout << "\nNo camera connected\nPress enter to complete\n";
+				std::getchar();
+				return 0;
+			}
+			Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+			// run example
+			std::cout << "Commence example\n\n";
+			DetectDefects(pDevice);
+			std::cout << "\nExample complete\n";
+
+			// clean up example
+			pSystem->DestroyDevice(pDevice);
+			Arena::CloseSystem(pSystem);
+		}
+		catch (GenICam::GenericException& ge)
+		{
+			std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+			exceptionThrown = true;
+		}
+		catch (std::exception& ex)
+		{
+			std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+			exceptionThrown = true;
+		}
+		catch (...)
+		{
+			std::cout << "\nUnexpected exception thrown\n";
+			exceptionThrown = true;
+		}
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,779 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+#include "GenApi/impl/xxhash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Save: Metadata Sidecar
+//    This example writes the metadata of every line of a scan to a columnar
+//    sidecar file saved next to the raw data. The metadata is timestamp,
+//    frame ID, exposure, gain and device temperature. Each column is an
+//    array of fixed-width 8-byte values, split into blocks of rows. The
+//    minimum and maximum of every block are kept in a separate statistics
+//    table. A footer holds an xxHash of the rest of the file, so damage is
+//    caught before the file is trusted. The reader maps the file into memory
+//    and reads values in place. A query such as "lines between t0 and t1
+//    with exposure above x" first uses the block statistics to skip blocks
+//    that cannot match. It only checks rows in blocks that can. The lines
+//    it returns are read straight from their offsets in the data file, and
+//    the rest of the data file is never read. The reader also checks that
+//    frame IDs are continuous.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) in the scan
+#define NUM_IMAGES 2000
+
+// raw data and sidecar files
+#define DATA_FILE "Cpp_Save_MetadataSidecar.raw"
+#define SIDECAR_FILE "Cpp_Save_MetadataSidecar.meta"
+
+// rows per block of the sidecar; the block is the unit queries skip
+#define ROWS_PER_BLOCK 128
+
+// the exposure alternates between two values every EXPOSURE_PERIOD lines,
+// so that a query on exposure has something to select
+#define EXPOSURE_LOW 2000.0
+#define EXPOSURE_HIGH 8000.0
+#define EXPOSURE_PERIOD 300
+
+// device temperature is a register read, so it is sampled every
+// TEMPERATURE_PERIOD lines and held in between
+#define TEMPERATURE_PERIOD 100
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SIDECAR =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+#define SIDECAR_MAGIC 0x3143534Du // "MSC1"
+#define SIDECAR_FOOTER_MAGIC 0x4643534Du // "MSCF"
+#define SIDECAR_VERSION 1
+#define SIDECAR_MAX_COLUMNS 16
+#define SIDECAR_NAME_LENGTH 32
+
+// one 8-byte cell; integer or floating point depending on the column
+union SidecarValue
+{
+	int64_t i;
+	double f;
+};
+
+enum SidecarType
+{
+	SidecarInteger = 0,
+	SidecarFloat = 1
+};
+
+// column descriptor; column data is numRows values at dataOffset, block
+//    statistics are numBlocks (minimum, maximum) pairs at statsOffset
+struct SidecarColumn
+{
+	char name[SIDECAR_NAME_LENGTH];
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t dataOffset;
+	uint64_t statsOffset;
+};
+
+// fixed-size header at the start of the sidecar; lineBytes is the size of
+//    one line in the data file, so line n starts at n * lineBytes
+struct SidecarHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numColumns;
+	uint32_t rowsPerBlock;
+	uint64_t numRows;
+	uint64_t numBlocks;
+	uint64_t lineBytes;
+	SidecarColumn columns[SIDECAR_MAX_COLUMNS];
+};
+
+// footer at the end of the sidecar; hash covers every byte before it
+struct SidecarFooter
+{
+	uint64_t hash;
+	uint32_t magic;
+	uint32_t reserved;
+};
+
+// XXH64
+//    The GenICam libraries build xxHash in for their own use but do not
+//    export it. This is the reference 64-bit algorithm for the prototype in
+//    GenApi/impl/xxhash.h.
+namespace
+{
+const uint64_t XXH_PRIME64_1 = 11400714785074694791ULL;
+const uint64_t XXH_PRIME64_2 = 14029467366897019727ULL;
+const uint64_t XXH_PRIME64_3 = 1609587929392839161ULL;
+const uint64_t XXH_PRIME64_4 = 9650029242287828579ULL;
+const uint64_t XXH_PRIME64_5 = 2870177450012600261ULL;
+
+inline uint64_t XxhRotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t XxhRead64(const uint8_t* p)
+{
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline uint32_t XxhRead32(const uint8_t* p)
+{
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline uint64_t XxhRound(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH_PRIME64_2;
+	return XxhRotl(acc, 31) * XXH_PRIME64_1;
+}
+
+inline uint64_t XxhMergeRound(uint64_t acc, uint64_t value)
+{
+	acc ^= XxhRound(0, value);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+} // namespace
+
+unsigned long long XXH64(const void* input, size_t length, unsigned long long seed)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(input);
+	const uint8_t* pEnd = p + length;
+	uint64_t h;
+
+	if (length >= 32)
+	{
+		uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = seed + XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - XXH_PRIME64_1;
+		for (; p + 32 <= pEnd; p += 32)
+		{
+			v1 = XxhRound(v1, XxhRead64(p));
+			v2 = XxhRound(v2, XxhRead64(p + 8));
+			v3 = XxhRound(v3, XxhRead64(p + 16));
+			v4 = XxhRound(v4, XxhRead64(p + 24));
+		}
+		h = XxhRotl(v1, 1) + XxhRotl(v2, 7) + XxhRotl(v3, 12) + XxhRotl(v4, 18);
+		h = XxhMergeRound(h, v1);
+		h = XxhMergeRound(h, v2);
+		h = XxhMergeRound(h, v3);
+		h = XxhMergeRound(h, v4);
+	}
+	else
+	{
+		h = seed + XXH_PRIME64_5;
+	}
+
+	h += length;
+	for (; p + 8 <= pEnd; p += 8)
+	{
+		h ^= XxhRound(0, XxhRead64(p));
+		h = XxhRotl(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (p + 4 <= pEnd)
+	{
+		h ^= static_cast<uint64_t>(XxhRead32(p)) * XXH_PRIME64_1;
+		h = XxhRotl(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+	for (; p < pEnd; p++)
+	{
+		h ^= *p * XXH_PRIME64_5;
+		h = XxhRotl(h, 11) * XXH_PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+// orders two cells of a column
+inline bool SidecarLess(uint32_t type, SidecarValue a, SidecarValue b)
+{
+	return type == SidecarFloat ? a.f < b.f : a.i < b.i;
+}
+
+// whether a cell lies in [minimum, maximum]; NaN lies in no range
+inline bool SidecarInRange(uint32_t type, SidecarValue value, SidecarValue minimum, SidecarValue maximum)
+{
+	if (type == SidecarFloat && std::isnan(value.f))
+		return false;
+	return !SidecarLess(type, value, minimum) && !SidecarLess(type, maximum, value);
+}
+
+// Sidecar writer
+//    Collects rows in memory; metadata is a few dozen bytes per line, small
+//    next to the lines themselves. Close lays out the file, computes block
+//    statistics and the hash, and writes it under a temporary name before
+//    renaming it, so a reader never sees a partial sidecar.
+class SidecarWriter
+{
+public:
+	SidecarWriter(const std::vector<std::pair<std::string, SidecarType>>& columns, uint32_t rowsPerBlock, uint64_t lineBytes)
+		: m_columns(columns), m_data(columns.size()), m_rowsPerBlock(rowsPerBlock), m_lineBytes(lineBytes)
+	{
+		if (columns.empty() || columns.size() > SIDECAR_MAX_COLUMNS || rowsPerBlock == 0)
+			throw GenICam::GenericException("Invalid sidecar layout", __FILE__, __LINE__);
+	}
+
+	// appends one row; one value per column, in column order
+	void AppendRow(const SidecarValue* pRow)
+	{
+		for (size_t c = 0; c < m_data.size(); c++)
+			m_data[c].push_back(pRow[c]);
+	}
+
+	void Close(const std::string& fileName)
+	{
+		uint64_t numRows = m_data[0].size();
+		uint64_t numBlocks = (numRows + m_rowsPerBlock - 1) / m_rowsPerBlock;
+
+		SidecarHeader header;
+		std::memset(&header, 0, sizeof(header));
+		header.magic = SIDECAR_MAGIC;
+		header.version = SIDECAR_VERSION;
+		header.numColumns = static_cast<uint32_t>(m_columns.size());
+		header.rowsPerBlock = m_rowsPerBlock;
+		header.numRows = numRows;
+		header.numBlocks = numBlocks;
+		header.lineBytes = m_lineBytes;
+
+		// statistics of all columns first, then the columns; everything is
+		// a multiple of 8 bytes, so every value is aligned in the mapping
+		uint64_t offset = sizeof(SidecarHeader);
+		for (size_t c = 0; c < m_columns.size(); c++)
+		{
+			std::strncpy(header.columns[c].name, m_columns[c].first.c_str(), SIDECAR_NAME_LENGTH - 1);
+			header.columns[c].type = m_columns[c].second;
+			header.columns[c].statsOffset = offset;
+			offset += numBlocks * 2 * sizeof(SidecarValue);
+		}
+		for (size_t c = 0; c < m_columns.size(); c++)
+		{
+			header.columns[c].dataOffset = offset;
+			offset += numRows * sizeof(SidecarValue);
+		}
+
+		std::vector<uint8_t> file(offset + sizeof(SidecarFooter));
+		std::memcpy(file.data(), &header, sizeof(header));
+		for (size_t c = 0; c < m_columns.size(); c++)
+		{
+			uint32_t type = header.columns[c].type;
+			const std::vector<SidecarValue>& column = m_data[c];
+			SidecarValue* pStats = reinterpret_cast<SidecarValue*>(file.data() + header.columns[c].statsOffset);
+			for (uint64_t b = 0; b < numBlocks; b++)
+			{
+				uint64_t first = b * m_rowsPerBlock;
+				uint64_t last = std::min<uint64_t>(first + m_rowsPerBlock, numRows);
+				// NaN never matches a range, so it is left out of the
+				// statistics; a block of only NaN has an empty range
+				SidecarValue minimum;
+				SidecarValue maximum;
+				if (type == SidecarFloat)
+				{
+					minimum.f = std::numeric_limits<double>::infinity();
+					maximum.f = -std::numeric_limits<double>::infinity();
+				}
+				else
+				{
+					minimum.i = std::numeric_limits<int64_t>::max();
+					maximum.i = std::numeric_limits<int64_t>::min();
+				}
+				for (uint64_t r = first; r < last; r++)
+				{
+					if (type == SidecarFloat && std::isnan(column[r].f))
+						continue;
+					if (SidecarLess(type, column[r], minimum))
+						minimum = column[r];
+					if (SidecarLess(type, maximum, column[r]))
+						maximum = column[r];
+				}
+				pStats[2 * b] = minimum;
+				pStats[2 * b + 1] = maximum;
+			}
+			if (numRows > 0)
+				std::memcpy(file.data() + header.columns[c].dataOffset, column.data(), numRows * sizeof(SidecarValue));
+		}
+
+		SidecarFooter footer;
+		footer.hash = XXH64(file.data(), offset, 0);
+		footer.magic = SIDECAR_FOOTER_MAGIC;
+		footer.reserved = 0;
+		std::memcpy(file.data() + offset, &footer, sizeof(footer));
+
+		std::string tempName = fileName + ".tmp";
+		std::ofstream out(tempName.c_str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+		out.close();
+		if (!out || std::rename(tempName.c_str(), fileName.c_str()) != 0)
+			throw GenICam::GenericException("Could not write sidecar", __FILE__, __LINE__);
+	}
+
+private:
+	std::vector<std::pair<std::string, SidecarType>> m_columns;
+	std::vector<std::vector<SidecarValue>> m_data;
+	uint32_t m_rowsPerBlock;
+	uint64_t m_lineBytes;
+};
+
+// inclusive range on one column
+struct SidecarRange
+{
+	size_t column;
+	SidecarValue minimum;
+	SidecarValue maximum;
+};
+
+// Sidecar reader
+//    Read-only view of a sidecar. The file is mapped and checked once;
+//    columns and statistics are then read in place.
+class SidecarReader
+{
+public:
+	explicit SidecarReader(const char* fileName)
+		: m_pBase(NULL), m_size(0)
+	{
+		int fd = open(fileName, O_RDONLY);
+		if (fd < 0)
+			throw GenICam::GenericException("Could not open sidecar", __FILE__, __LINE__);
+		struct stat info;
+		if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SidecarHeader) + sizeof(SidecarFooter))
+		{
+			close(fd);
+			throw GenICam::GenericException("Sidecar is truncated", __FILE__, __LINE__);
+		}
+		m_size = static_cast<size_t>(info.st_size);
+		void* pBase = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (pBase == MAP_FAILED)
+			throw GenICam::GenericException("Could not map sidecar", __FILE__, __LINE__);
+		m_pBase = static_cast<const uint8_t*>(pBase);
+
+		// footer first: nothing else is trusted until the hash matches
+		SidecarFooter footer;
+		std::memcpy(&footer, m_pBase + m_size - sizeof(footer), sizeof(footer));
+		if (footer.magic != SIDECAR_FOOTER_MAGIC || footer.hash != XXH64(m_pBase, m_size - sizeof(footer), 0))
+		{
+			munmap(pBase, m_size);
+			throw GenICam::GenericException("Sidecar failed its integrity check", __FILE__, __LINE__);
+		}
+
+		const SidecarHeader& header = Header();
+		bool valid = header.magic == SIDECAR_MAGIC && header.version == SIDECAR_VERSION && header.numColumns > 0 && header.numColumns <= SIDECAR_MAX_COLUMNS && header.rowsPerBlock > 0 && header.numBlocks == (header.numRows + header.rowsPerBlock - 1) / header.rowsPerBlock;
+		for (uint32_t c = 0; valid && c < header.numColumns; c++)
+		{
+			const SidecarColumn& column = header.columns[c];
+			valid = column.type <= SidecarFloat && column.dataOffset % 8 == 0 && column.statsOffset % 8 == 0 && column.dataOffset + header.numRows * sizeof(SidecarValue) <= m_size - sizeof(footer) && column.statsOffset + header.numBlocks * 2 * sizeof(SidecarValue) <= m_size - sizeof(footer);
+		}
+		if (!valid)
+		{
+			munmap(pBase, m_size);
+			throw GenICam::GenericException("Not a valid sidecar", __FILE__, __LINE__);
+		}
+	}
+
+	~SidecarReader()
+	{
+		munmap(const_cast<uint8_t*>(m_pBase), m_size);
+	}
+
+	const SidecarHeader& Header() const
+	{
+		return *reinterpret_cast<const SidecarHeader*>(m_pBase);
+	}
+
+	// index of a column by name; throws if it does not exist
+	size_t FindColumn(const char* name) const
+	{
+		const SidecarHeader& header = Header();
+		for (uint32_t c = 0; c < header.numColumns; c++)
+		{
+			if (std::strncmp(header.columns[c].name, name, SIDECAR_NAME_LENGTH) == 0)
+				return c;
+		}
+		throw GenICam::GenericException((std::string("Sidecar has no column ") + name).c_str(), __FILE__, __LINE__);
+	}
+
+	const SidecarValue* Column(size_t column) const
+	{
+		return reinterpret_cast<const SidecarValue*>(m_pBase + Header().columns[column].dataOffset);
+	}
+
+	// (minimum, maximum) pair of a block
+	const SidecarValue* BlockStats(size_t column, uint64_t block) const
+	{
+		return reinterpret_cast<const SidecarValue*>(m_pBase + Header().columns[column].statsOffset) + 2 * block;
+	}
+
+	// Query
+	//    Returns the rows inside every range. A block is skipped when its
+	//    statistics show any range cannot match in it; only rows of the
+	//    remaining blocks are read.
+	std::vector<uint64_t> Query(const std::vector<SidecarRange>& ranges, uint64_t& blocksRead) const
+	{
+		const SidecarHeader& header = Header();
+		std::vector<uint64_t> rows;
+		blocksRead = 0;
+
+		for (uint64_t b = 0; b < header.numBlocks; b++)
+		{
+			bool possible = true;
+			for (size_t k = 0; possible && k < ranges.size(); k++)
+			{
+				uint32_t type = header.columns[ranges[k].column].type;
+				const SidecarValue* pStats = BlockStats(ranges[k].column, b);
+				possible = !SidecarLess(type, pStats[1], ranges[k].minimum) && !SidecarLess(type, ranges[k].maximum, pStats[0]);
+			}
+			if (!possible)
+				continue;
+
+			blocksRead++;
+			uint64_t first = b * header.rowsPerBlock;
+			uint64_t last = std::min<uint64_t>(first + header.rowsPerBlock, header.numRows);
+			for (uint64_t r = first; r < last; r++)
+			{
+				bool match = true;
+				for (size_t k = 0; match && k < ranges.size(); k++)
+				{
+					uint32_t type = header.columns[ranges[k].column].type;
+					SidecarValue value = Column(ranges[k].column)[r];
+					match = SidecarInRange(type, value, ranges[k].minimum, ranges[k].maximum);
+				}
+				if (match)
+					rows.push_back(r);
+			}
+		}
+		return rows;
+	}
+
+	// rows whose integer value does not follow the previous row's by one
+	std::vector<uint64_t> FindGaps(size_t column) const
+	{
+		const SidecarValue* pValues = Column(column);
+		std::vector<uint64_t> gaps;
+		for (uint64_t r = 1; r < Header().numRows; r++)
+		{
+			if (pValues[r].i != pValues[r - 1].i + 1)
+				gaps.push_back(r);
+		}
+		return gaps;
+	}
+
+private:
+	const uint8_t* m_pBase;
+	size_t m_size;
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// column order of the sidecar written by this example
+enum MetadataColumnIndex
+{
+	ColumnTimestamp,
+	ColumnFrameId,
+	ColumnExposureTime,
+	ColumnGain,
+	ColumnTemperature,
+	NUM_COLUMNS
+};
+
+// demonstrates writing and querying a metadata sidecar
+// (1) enables exposure and gain chunks and sets a manual exposure
+// (2) saves each line to the data file and its metadata to the writer
+// (3) closes the sidecar, writing statistics and the hash footer
+// (4) maps the sidecar and checks frame ID continuity
+// (5) queries a time window with an exposure threshold
+// (6) reads the matching lines from the data file by offset
+void WriteAndQuerySidecar(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	bool chunkModeActiveInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkModeActive");
+	GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto");
+	double exposureTimeInitial = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+
+	// Enable exposure and gain chunks
+	std::cout << TAB1 << "Enable exposure and gain chunks\n";
+
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", true);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "ExposureTime");
+	bool exposureChunkInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkEnable");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", true);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "Gain");
+	bool gainChunkInitial = Arena::GetNodeValue<bool>(pNodeMap, "ChunkEnable");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", true);
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", "Off");
+	GenApi::CFloatPtr pExposureTime = pNodeMap->GetNode("ExposureTime");
+	pExposureTime->SetValue(EXPOSURE_LOW);
+
+	// temperature is optional
+	GenApi::CFloatPtr pTemperature = pNodeMap->GetNode("DeviceTemperature");
+	bool hasTemperature = pTemperature.IsValid() && GenApi::IsReadable(pTemperature);
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// Save lines and metadata
+	//    Every line is appended to the data file at a fixed size, so its
+	//    offset follows from its row. The chunk data after the image is not
+	//    saved; its values are in the sidecar.
+	std::cout << TAB1 << "Save " << NUM_IMAGES << " lines to " << DATA_FILE << "\n";
+
+	std::vector<std::pair<std::string, SidecarType>> columns(NUM_COLUMNS);
+	columns[ColumnTimestamp] = std::make_pair("TimestampNs", SidecarInteger);
+	columns[ColumnFrameId] = std::make_pair("FrameID", SidecarInteger);
+	columns[ColumnExposureTime] = std::make_pair("ExposureTime", SidecarFloat);
+	columns[ColumnGain] = std::make_pair("Gain", SidecarFloat);
+	columns[ColumnTemperature] = std::make_pair("DeviceTemperature", SidecarFloat);
+
+	std::ofstream data(DATA_FILE, std::ios::binary | std::ios::trunc);
+	std::unique_ptr<SidecarWriter> pWriter;
+	uint64_t lineBytes = 0;
+	double temperature = std::numeric_limits<double>::quiet_NaN();
+	size_t incomplete = 0;
+
+	pDevice->StartStream();
+
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		if (i > 0 && i % EXPOSURE_PERIOD == 0)
+			pExposureTime->SetValue((i / EXPOSURE_PERIOD) % 2 ? EXPOSURE_HIGH : EXPOSURE_LOW);
+		if (hasTemperature && i % TEMPERATURE_PERIOD == 0)
+			temperature = pTemperature->GetValue();
+
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+
+		// the line size is fixed by the first image
+		if (!pWriter)
+		{
+			lineBytes = pImage->GetWidth() * pImage->GetHeight() * pImage->GetBitsPerPixel() / 8;
+			pWriter.reset(new SidecarWriter(columns, ROWS_PER_BLOCK, lineBytes));
+		}
+
+		// an incomplete image still takes its row, so rows and lines stay
+		// aligned; its chunk values are not trusted
+		SidecarValue row[NUM_COLUMNS];
+		row[ColumnTimestamp].i = static_cast<int64_t>(pImage->GetTimestampNs());
+		row[ColumnFrameId].i = static_cast<int64_t>(pImage->GetFrameId());
+		row[ColumnExposureTime].f = std::numeric_limits<double>::quiet_NaN();
+		row[ColumnGain].f = std::numeric_limits<double>::quiet_NaN();
+		row[ColumnTemperature].f = temperature;
+
+		if (pImage->IsIncomplete())
+		{
+			incomplete++;
+		}
+		else
+		{
+			Arena::IChunkData* pChunkData = pImage->AsChunkData();
+			row[ColumnExposureTime].f = GenApi::CFloatPtr(pChunkData->GetChunk("ChunkExposureTime"))->GetValue();
+			row[ColumnGain].f = GenApi::CFloatPtr(pChunkData->GetChunk("ChunkGain"))->GetValue();
+		}
+
+		pWriter->AppendRow(row);
+		data.write(reinterpret_cast<const char*>(pImage->GetData()), static_cast<std::streamsize>(lineBytes));
+
+		pDevice->RequeueBuffer(pImage);
+	}
+
+	pDevice->StopStream();
+	data.close();
+
+	// Close sidecar
+	std::cout << TAB1 << "Write " << SIDECAR_FILE << " (" << incomplete << " incomplete lines)\n";
+
+	pWriter->Close(SIDECAR_FILE);
+
+	// Map sidecar and check continuity
+	//    Mapping checks the hash footer before any value is used.
+	std::cout << TAB1 << "Map sidecar\n";
+
+	SidecarReader reader(SIDECAR_FILE);
+	const SidecarHeader& header = reader.Header();
+	size_t timestampColumn = reader.FindColumn("TimestampNs");
+	size_t exposureColumn = reader.FindColumn("ExposureTime");
+
+	std::cout << TAB2 << header.numRows << " rows in " << header.numBlocks << " blocks of " << header.rowsPerBlock << "\n";
+
+	std::vector<uint64_t> gaps = reader.FindGaps(reader.FindColumn("FrameID"));
+	std::cout << TAB2 << "Frame ID gaps: " << gaps.size();
+	for (size_t i = 0; i < gaps.size() && i < 5; i++)
+		std::cout << (i ? ", " : " at rows ") << gaps[i];
+	std::cout << "\n";
+
+	// Query
+	//    Lines in the middle half of the scan's time span with an exposure
+	//    above the midpoint of the two exposures.
+	const SidecarValue* pTimestamps = reader.Column(timestampColumn);
+	int64_t start = pTimestamps[0].i;
+	int64_t span = pTimestamps[header.numRows - 1].i - start;
+
+	SidecarRange timeRange;
+	timeRange.column = timestampColumn;
+	timeRange.minimum.i = start + span / 4;
+	timeRange.maximum.i = start + 3 * (span / 4);
+
+	SidecarRange exposureRange;
+	exposureRange.column = exposureColumn;
+	exposureRange.minimum.f = std::nextafter((EXPOSURE_LOW + EXPOSURE_HIGH) / 2, std::numeric_limits<double>::infinity());
+	exposureRange.maximum.f = std::numeric_limits<double>::infinity();
+
+	std::vector<SidecarRange> ranges;
+	ranges.push_back(timeRange);
+	ranges.push_back(exposureRange);
+
+	std::cout << TAB1 << "Query lines with t in [" << timeRange.minimum.i << ", " << timeRange.maximum.i << "] ns and exposure > " << (EXPOSURE_LOW + EXPOSURE_HIGH) / 2 << " us\n";
+
+	uint64_t blocksRead = 0;
+	auto queryStart = std::chrono::steady_clock::now();
+	std::vector<uint64_t> rows = reader.Query(ranges, blocksRead);
+	double queryUs = 1e6 * std::chrono::duration<double>(std::chrono::steady_clock::now() - queryStart).count();
+
+	std::cout << TAB2 << rows.size() << " lines matched; " << blocksRead << " of " << header.numBlocks << " blocks read in " << std::fixed << std::setprecision(1) << queryUs << " us\n";
+
+	// Read matching lines
+	//    Only the matching lines are read from the data file, each from its
+	//    own offset.
+	if (!rows.empty())
+	{
+		std::cout << TAB1 << "Read matching lines from " << DATA_FILE << "\n";
+
+		int fd = open(DATA_FILE, O_RDONLY);
+		if (fd < 0)
+			throw GenICam::GenericException("Could not open data file", __FILE__, __LINE__);
+
+		std::vector<uint8_t> line(static_cast<size_t>(header.lineBytes));
+		const SidecarValue* pExposures = reader.Column(exposureColumn);
+		for (size_t i = 0; i < rows.size() && i < 5; i++)
+		{
+			ssize_t got = pread(fd, line.data(), line.size(), static_cast<off_t>(rows[i] * header.lineBytes));
+			double mean = 0.0;
+			for (size_t p = 0; got > 0 && p < static_cast<size_t>(got); p++)
+				mean += line[p];
+			std::cout << TAB2 << "line " << rows[i] << ": exposure " << pExposures[rows[i]].f << " us, mean byte " << (got > 0 ? mean / got : 0.0) << "\n";
+		}
+		close(fd);
+	}
+
+	// return nodes to their initial values
+	pExposureTime->SetValue(exposureTimeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", exposureAutoInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "Gain");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", gainChunkInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ChunkSelector", "ExposureTime");
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkEnable", exposureChunkInitial);
+	Arena::SetNodeValue<bool>(pNodeMap, "ChunkModeActive", chunkModeActiveInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Save_MetadataSidecar\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		WriteAndQuerySidecar(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,868 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Scan Daemon
+//    This example is a headless scan service. It replaces the scan loop of
+//    the notebooks, so scan throughput is bounded by the sensor rather than
+//    by Python. At startup it applies an OpenHSI settings file (window,
+//    binning, pixel format and exposure). It also loads calibration arrays
+//    exported from the OpenHSI calibration pickle. Four threads form a
+//    pipeline, and each can be pinned to a CPU. The acquisition thread copies
+//    frames into a pool of preallocated buffers. It never waits, and drops a
+//    frame when the pool is empty. The calibration thread crops the frame to
+//    the slit rows, subtracts the dark frame, applies the gain, and
+//    transposes the frame into a cube line. The writer thread appends lines
+//    to an ENVI cube. The telemetry thread reports rates, queue depths and
+//    drops. Scans are started and stopped through a local control socket.
+//    It accepts one command per line:
+//       start [lines]   starts a scan, of a number of lines or until stopped
+//       stop            stops the current scan
+//       status          returns the telemetry of the last interval
+//       quit            stops the daemon
+//    for example: echo status | nc -U /tmp/hsi_scan_daemon.sock
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// OpenHSI settings file (from notebook 01); camera settings are left as they
+//    are if it does not exist
+#define SETTINGS_FILE "OpenHSI-12_settings_Mono12_bin1.json"
+
+// calibration arrays exported by export_calibration.py (float32 .npy);
+//    dark and gain have the cropped frame shape, wavelengths one entry per
+//    column; missing files leave the counts uncalibrated
+#define DARK_FILE "Cpp_ScanDaemon_dark.npy"
+#define GAIN_FILE "Cpp_ScanDaemon_gain.npy"
+#define WAVELENGTH_FILE "Cpp_ScanDaemon_wavelengths.npy"
+
+// control socket path
+#define CONTROL_SOCKET "/tmp/hsi_scan_daemon.sock"
+
+// scans are written to <prefix>_<n>.bil and .hdr
+#define CUBE_PREFIX "Cpp_ScanDaemon_scan"
+
+// frames buffered between the pipeline stages
+#define POOL_FRAMES 64
+
+// CPU of each pipeline thread; -1 leaves the thread unpinned
+#define CPU_ACQUISITION 1
+#define CPU_CALIBRATION 2
+#define CPU_WRITER 3
+#define CPU_TELEMETRY 0
+
+// telemetry interval (in milliseconds)
+#define TELEMETRY_INTERVAL_MS 1000
+
+// lines scanned at startup without a start command, after which the daemon
+//    quits; 0 waits for commands
+#define AUTO_SCAN_LINES 0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// camera settings of an OpenHSI settings file; resolution and offsets are
+//    (rows, columns), rows run across track and columns along the spectrum
+struct OpenHsiSettings
+{
+	int64_t rowSlice[2];
+	int64_t winResolution[2];
+	int64_t winOffset[2];
+	int64_t binxy[2];
+	double exposureMs;
+	std::string pixelFormat;
+};
+
+// numbers of a JSON array, or the single number of a JSON value
+std::vector<double> JsonNumbers(const std::string& text, const std::string& key)
+{
+	std::vector<double> numbers;
+	size_t position = text.find("\"" + key + "\"");
+	if (position == std::string::npos)
+		return numbers;
+	position = text.find(':', position);
+	size_t end = text.find_first_of(text[text.find_first_not_of(" \t\r\n", position + 1)] == '[' ? "]" : ",}", position);
+	std::string value = text.substr(position + 1, end - position - 1);
+	std::replace(value.begin(), value.end(), '[', ' ');
+	std::replace(value.begin(), value.end(), ',', ' ');
+	std::stringstream ss(value);
+	double number;
+	while (ss >> number)
+		numbers.push_back(number);
+	return numbers;
+}
+
+std::string JsonString(const std::string& text, const std::string& key)
+{
+	size_t position = text.find("\"" + key + "\"");
+	if (position == std::string::npos)
+		return "";
+	size_t first = text.find('"', text.find(':', position)) + 1;
+	return text.substr(first, text.find('"', first) - first);
+}
+
+OpenHsiSettings LoadSettings(const char* path)
+{
+	std::ifstream file(path);
+	std::stringstream ss;
+	ss << file.rdbuf();
+	std::string text = ss.str();
+
+	OpenHsiSettings settings;
+	std::vector<double> rowSlice = JsonNumbers(text, "row_slice");
+	std::vector<double> winResolution = JsonNumbers(text, "win_resolution");
+	std::vector<double> winOffset = JsonNumbers(text, "win_offset");
+	std::vector<double> binxy = JsonNumbers(text, "binxy");
+	std::vector<double> exposureMs = JsonNumbers(text, "exposure_ms");
+	settings.pixelFormat = JsonString(text, "pixel_format");
+	if (rowSlice.size() != 2 || winResolution.size() != 2 || winOffset.size() != 2 || binxy.size() != 2 || exposureMs.size() != 1 || settings.pixelFormat.empty())
+		throw GenICam::GenericException("OpenHSI settings file incomplete", __FILE__, __LINE__);
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		settings.rowSlice[i] = static_cast<int64_t>(rowSlice[i]);
+		settings.winResolution[i] = static_cast<int64_t>(winResolution[i]);
+		settings.winOffset[i] = static_cast<int64_t>(winOffset[i]);
+		settings.binxy[i] = static_cast<int64_t>(binxy[i]);
+	}
+	settings.exposureMs = exposureMs[0];
+	return settings;
+}
+
+// float32 or float64 array of a little-endian, C-ordered .npy file
+bool LoadNpy(const char* path, std::vector<size_t>& shape, std::vector<float>& values)
+{
+	std::ifstream file(path, std::ios::binary);
+	char magic[8];
+	if (!file.read(magic, 8) || memcmp(magic, "\x93NUMPY", 6) != 0)
+		return false;
+
+	size_t headerLength = 0;
+	if (magic[6] == 1)
+	{
+		uint8_t length[2];
+		file.read(reinterpret_cast<char*>(length), 2);
+		headerLength = length[0] | (length[1] << 8);
+	}
+	else
+	{
+		uint8_t length[4];
+		file.read(reinterpret_cast<char*>(length), 4);
+		headerLength = length[0] | (length[1] << 8) | (length[2] << 16) | (static_cast<size_t>(length[3]) << 24);
+	}
+	std::string header(headerLength, ' ');
+	file.read(&header[0], static_cast<std::streamsize>(headerLength));
+
+	bool doubles = header.find("'<f8'") != std::string::npos;
+	if ((!doubles && header.find("'<f4'") == std::string::npos) || header.find("'fortran_order': True") != std::string::npos)
+		throw GenICam::GenericException((std::string("Calibration array must be little-endian C-ordered float: ") + path).c_str(), __FILE__, __LINE__);
+
+	size_t first = header.find('(', header.find("'shape'")) + 1;
+	std::string dims = header.substr(first, header.find(')', first) - first);
+	std::replace(dims.begin(), dims.end(), ',', ' ');
+	std::stringstream ss(dims);
+	size_t dim;
+	size_t count = 1;
+	shape.clear();
+	while (ss >> dim)
+	{
+		shape.push_back(dim);
+		count *= dim;
+	}
+
+	values.resize(count);
+	if (doubles)
+	{
+		std::vector<double> raw(count);
+		file.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(count * sizeof(double)));
+		std::copy(raw.begin(), raw.end(), values.begin());
+	}
+	else
+		file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(float)));
+	if (!file)
+		throw GenICam::GenericException((std::string("Calibration array truncated: ") + path).c_str(), __FILE__, __LINE__);
+	return true;
+}
+
+// per-pixel calibration of the cropped frame: (count - dark) * gain
+struct Calibration
+{
+	size_t firstRow;
+	size_t rows;
+	size_t columns;
+	std::vector<float> dark;
+	std::vector<float> gain;
+	std::vector<float> wavelengths;
+	bool calibrated;
+};
+
+Calibration LoadCalibration(size_t firstRow, size_t rows, size_t columns)
+{
+	Calibration calibration;
+	calibration.firstRow = firstRow;
+	calibration.rows = rows;
+	calibration.columns = columns;
+	calibration.dark.assign(rows * columns, 0.0f);
+	calibration.gain.assign(rows * columns, 1.0f);
+
+	std::vector<size_t> shape;
+	bool dark = LoadNpy(DARK_FILE, shape, calibration.dark);
+	if (dark && (shape.size() != 2 || shape[0] != rows || shape[1] != columns))
+		throw GenICam::GenericException("Dark array does not match the cropped frame", __FILE__, __LINE__);
+	bool gain = LoadNpy(GAIN_FILE, shape, calibration.gain);
+	if (gain && (shape.size() != 2 || shape[0] != rows || shape[1] != columns))
+		throw GenICam::GenericException("Gain array does not match the cropped frame", __FILE__, __LINE__);
+	if (LoadNpy(WAVELENGTH_FILE, shape, calibration.wavelengths) && calibration.wavelengths.size() != columns)
+		throw GenICam::GenericException("Wavelength array does not match the frame columns", __FILE__, __LINE__);
+
+	calibration.calibrated = dark || gain;
+	return calibration;
+}
+
+// bounded hand-off between pipeline stages; Pop returns false once the
+//    queue is closed and empty
+template<typename T>
+class BlockingQueue
+{
+public:
+	void Push(const T& value)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_items.push_back(value);
+		}
+		m_ready.notify_one();
+	}
+
+	bool TryPop(T& value)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_items.empty())
+			return false;
+		value = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
+
+	bool Pop(T& value)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_ready.wait(lock, [&]() { return !m_items.empty() || m_closed; });
+		if (m_items.empty())
+			return false;
+		value = m_items.front();
+		m_items.pop_front();
+		return true;
+	}
+
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_closed = true;
+		}
+		m_ready.notify_all();
+	}
+
+	size_t Size()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_items.size();
+	}
+
+private:
+	std::mutex m_lock;
+	std::condition_variable m_ready;
+	std::deque<T> m_items;
+	bool m_closed = false;
+};
+
+// marks the end of a scan in the stage queues
+const size_t END_OF_SCAN = static_cast<size_t>(-1);
+
+// state shared by the pipeline, telemetry and control threads
+struct Daemon
+{
+	Arena::IDevice* pDevice;
+	Calibration calibration;
+	size_t frameRows;
+	size_t frameColumns;
+
+	// frame and line pools; indices circulate through the queues
+	std::vector<std::vector<uint16_t> > frames;
+	std::vector<std::vector<float> > lines;
+	BlockingQueue<size_t> freeFrames;
+	BlockingQueue<size_t> rawFrames;
+	BlockingQueue<size_t> freeLines;
+	BlockingQueue<size_t> calibratedLines;
+
+	// commands from the control thread
+	std::atomic<bool> startRequested;
+	std::atomic<bool> stopRequested;
+	std::atomic<bool> quit;
+	std::atomic<uint64_t> requestedLines;
+
+	// counters
+	std::atomic<bool> scanning;
+	std::atomic<uint64_t> scans;
+	std::atomic<uint64_t> acquired;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> incomplete;
+	std::atomic<uint64_t> calibrated;
+	std::atomic<uint64_t> written;
+
+	std::mutex statusLock;
+	std::string status;
+};
+
+// pins the calling thread to a CPU
+void PinThread(const char* name, int cpu)
+{
+	if (cpu < 0)
+		return;
+	if (cpu >= static_cast<int>(std::thread::hardware_concurrency()))
+	{
+		std::cout << TAB2 << name << " thread left unpinned (no CPU " << cpu << ")\n";
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+		std::cout << TAB2 << name << " thread could not be pinned to CPU " << cpu << "\n";
+}
+
+// acquisition stage: the only thread that touches the device
+void AcquisitionThread(Daemon* pDaemon)
+{
+	PinThread("Acquisition", CPU_ACQUISITION);
+	size_t frameSize = pDaemon->frameRows * pDaemon->frameColumns;
+
+	while (!pDaemon->quit)
+	{
+		if (!pDaemon->startRequested.exchange(false))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+
+		uint64_t requested = pDaemon->requestedLines;
+		uint64_t lines = 0;
+		pDaemon->stopRequested = false;
+		pDaemon->scanning = true;
+		pDaemon->pDevice->StartStream();
+
+		// a failed acquisition ends the scan, not the daemon
+		try
+		{
+			while (!pDaemon->stopRequested && !pDaemon->quit && (requested == 0 || lines < requested))
+			{
+				Arena::IImage* pImage = pDaemon->pDevice->GetImage(TIMEOUT);
+				pDaemon->acquired++;
+
+				size_t index;
+				if (pImage->IsIncomplete() || pImage->GetSizeFilled() < frameSize * sizeof(uint16_t))
+					pDaemon->incomplete++;
+				else if (!pDaemon->freeFrames.TryPop(index))
+					pDaemon->dropped++;
+				else
+				{
+					memcpy(pDaemon->frames[index].data(), pImage->GetData(), frameSize * sizeof(uint16_t));
+					pDaemon->rawFrames.Push(index);
+					lines++;
+				}
+				pDaemon->pDevice->RequeueBuffer(pImage);
+			}
+		}
+		catch (GenICam::GenericException& ge)
+		{
+			std::cout << TAB2 << "Scan aborted: " << ge.what() << "\n";
+		}
+
+		pDaemon->pDevice->StopStream();
+		pDaemon->rawFrames.Push(END_OF_SCAN);
+		pDaemon->scanning = false;
+	}
+	pDaemon->rawFrames.Close();
+}
+
+// calibration stage: crops, calibrates and transposes a frame into a BIL
+//    line (bands = frame columns, samples = cropped frame rows)
+void CalibrationThread(Daemon* pDaemon)
+{
+	PinThread("Calibration", CPU_CALIBRATION);
+	const Calibration& calibration = pDaemon->calibration;
+
+	size_t frameIndex;
+	while (pDaemon->rawFrames.Pop(frameIndex))
+	{
+		if (frameIndex == END_OF_SCAN)
+		{
+			pDaemon->calibratedLines.Push(END_OF_SCAN);
+			continue;
+		}
+
+		size_t lineIndex;
+		if (!pDaemon->freeLines.Pop(lineIndex))
+			break;
+		const uint16_t* pFrame = pDaemon->frames[frameIndex].data() + calibration.firstRow * pDaemon->frameColumns;
+		float* pLine = pDaemon->lines[lineIndex].data();
+
+		// rows are read in blocks so the transposed writes stay in cache
+		const size_t block = 16;
+		for (size_t r0 = 0; r0 < calibration.rows; r0 += block)
+		{
+			size_t r1 = std::min(calibration.rows, r0 + block);
+			for (size_t c = 0; c < calibration.columns; c++)
+			{
+				float* pBand = pLine + c * calibration.rows;
+				for (size_t r = r0; r < r1; r++)
+				{
+					size_t i = r * calibration.columns + c;
+					pBand[r] = (static_cast<float>(pFrame[r * pDaemon->frameColumns + c]) - calibration.dark[i]) * calibration.gain[i];
+				}
+			}
+		}
+
+		pDaemon->freeFrames.Push(frameIndex);
+		pDaemon->calibratedLines.Push(lineIndex);
+		pDaemon->calibrated++;
+	}
+	pDaemon->calibratedLines.Close();
+}
+
+void WriteHeader(const std::string& path, const Calibration& calibration, uint64_t lines)
+{
+	std::ofstream header(path.c_str());
+	header << "ENVI\n";
+	header << "description = {" << (calibration.calibrated ? "Calibrated" : "Uncalibrated") << " pushbroom scan}\n";
+	header << "samples = " << calibration.rows << "\n";
+	header << "lines = " << lines << "\n";
+	header << "bands = " << calibration.columns << "\n";
+	header << "header offset = 0\n";
+	header << "file type = ENVI Standard\n";
+	header << "data type = 4\n";
+	header << "interleave = bil\n";
+	header << "byte order = 0\n";
+	if (!calibration.wavelengths.empty())
+	{
+		header << "wavelength units = Nanometers\n";
+		header << "wavelength = {";
+		for (size_t b = 0; b < calibration.wavelengths.size(); b++)
+			header << (b ? ", " : "") << calibration.wavelengths[b];
+		header << "}\n";
+	}
+}
+
+// writer stage: appends lines to the cube of the current scan
+void WriterThread(Daemon* pDaemon)
+{
+	PinThread("Writer", CPU_WRITER);
+	const Calibration& calibration = pDaemon->calibration;
+	size_t lineBytes = calibration.rows * calibration.columns * sizeof(float);
+
+	std::ofstream cube;
+	std::string name;
+	uint64_t lines = 0;
+
+	size_t lineIndex;
+	while (pDaemon->calibratedLines.Pop(lineIndex))
+	{
+		if (lineIndex == END_OF_SCAN)
+		{
+			if (cube.is_open())
+			{
+				cube.close();
+				WriteHeader(name + ".hdr", calibration, lines);
+				std::cout << TAB2 << "Scan written: " << name << ".bil (" << lines << " lines)\n";
+			}
+			lines = 0;
+			continue;
+		}
+
+		if (!cube.is_open())
+		{
+			std::stringstream ss;
+			ss << CUBE_PREFIX << "_" << ++pDaemon->scans;
+			name = ss.str();
+			cube.open((name + ".bil").c_str(), std::ios::binary);
+		}
+		cube.write(reinterpret_cast<const char*>(pDaemon->lines[lineIndex].data()), static_cast<std::streamsize>(lineBytes));
+		pDaemon->freeLines.Push(lineIndex);
+		pDaemon->written++;
+		lines++;
+	}
+}
+
+// telemetry stage: rates over the last interval and queue depths
+void TelemetryThread(Daemon* pDaemon)
+{
+	PinThread("Telemetry", CPU_TELEMETRY);
+	uint64_t lastAcquired = 0;
+	uint64_t lastWritten = 0;
+	std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+
+	while (!pDaemon->quit)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(TELEMETRY_INTERVAL_MS));
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - last).count();
+		uint64_t acquired = pDaemon->acquired;
+		uint64_t written = pDaemon->written;
+
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(1);
+		ss << (pDaemon->scanning ? "scanning" : "idle")
+		   << " acquired=" << acquired << " (" << (acquired - lastAcquired) / seconds << " FPS)"
+		   << " written=" << written << " (" << (written - lastWritten) / seconds << " lines/s)"
+		   << " dropped=" << pDaemon->dropped << " incomplete=" << pDaemon->incomplete
+		   << " queued=" << pDaemon->rawFrames.Size() << "/" << pDaemon->calibratedLines.Size()
+		   << " scans=" << pDaemon->scans;
+		{
+			std::lock_guard<std::mutex> lock(pDaemon->statusLock);
+			pDaemon->status = ss.str();
+		}
+		if (pDaemon->scanning || acquired != lastAcquired || written != lastWritten)
+			std::cout << TAB2 << ss.str() << "\n";
+
+		lastAcquired = acquired;
+		lastWritten = written;
+		last = now;
+	}
+}
+
+// runs one control command and returns its reply
+std::string HandleCommand(Daemon* pDaemon, const std::string& text)
+{
+	std::stringstream ss(text);
+	std::string command;
+	ss >> command;
+
+	if (command == "start")
+	{
+		uint64_t lines = 0;
+		ss >> lines;
+		if (pDaemon->scanning || pDaemon->startRequested)
+			return "error: scan in progress";
+		pDaemon->requestedLines = lines;
+		pDaemon->startRequested = true;
+		return "ok";
+	}
+	if (command == "stop")
+	{
+		pDaemon->stopRequested = true;
+		return "ok";
+	}
+	if (command == "status")
+	{
+		std::lock_guard<std::mutex> lock(pDaemon->statusLock);
+		return pDaemon->status.empty() ? std::string("idle") : pDaemon->status;
+	}
+	if (command == "quit")
+	{
+		pDaemon->quit = true;
+		return "ok";
+	}
+	return "error: unknown command '" + command + "'";
+}
+
+// control socket: one client at a time, one command per line
+void ControlThread(Daemon* pDaemon, int server)
+{
+	while (!pDaemon->quit)
+	{
+		struct pollfd pfd = { server, POLLIN, 0 };
+		if (poll(&pfd, 1, 200) <= 0)
+			continue;
+		int client = accept(server, NULL, NULL);
+		if (client < 0)
+			continue;
+
+		std::string pending;
+		char buffer[256];
+		ssize_t n;
+		while (!pDaemon->quit && (n = read(client, buffer, sizeof(buffer))) > 0)
+		{
+			pending.append(buffer, static_cast<size_t>(n));
+			size_t end;
+			while ((end = pending.find('\n')) != std::string::npos)
+			{
+				std::string reply = HandleCommand(pDaemon, pending.substr(0, end)) + "\n";
+				pending.erase(0, end + 1);
+				if (write(client, reply.data(), reply.size()) < 0)
+					break;
+			}
+		}
+		close(client);
+	}
+}
+
+int OpenControlSocket()
+{
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, CONTROL_SOCKET, sizeof(address.sun_path) - 1);
+	unlink(CONTROL_SOCKET);
+	if (server < 0 || bind(server, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 4) != 0)
+		throw GenICam::GenericException("Control socket could not be opened: " CONTROL_SOCKET, __FILE__, __LINE__);
+	return server;
+}
+
+// applies the window, binning, pixel format and exposure of an OpenHSI
+//    settings file
+void ApplySettings(GenApi::INodeMap* pNodeMap, const OpenHsiSettings& settings)
+{
+	if (settings.binxy[0] != 1 || settings.binxy[1] != 1)
+	{
+		Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "BinningSelector", "Sensor");
+		Arena::SetNodeValue<int64_t>(pNodeMap, "BinningVertical", settings.binxy[0]);
+		Arena::SetNodeValue<int64_t>(pNodeMap, "BinningHorizontal", settings.binxy[1]);
+	}
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", settings.pixelFormat.c_str());
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetY", 0);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetX", 0);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "Height", settings.winResolution[0]);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "Width", settings.winResolution[1]);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetY", settings.winOffset[0]);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetX", settings.winOffset[1]);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", "Off");
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", settings.exposureMs * 1000.0);
+}
+
+// demonstrates a headless scan service
+// (1) applies the OpenHSI settings and loads the calibration
+// (2) allocates the frame and line pools
+// (3) starts the pipeline, telemetry and control threads
+// (4) serves commands until told to quit
+// (5) stops the threads
+void RunScanDaemon(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat");
+	int64_t widthInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "Width");
+	int64_t heightInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "Height");
+	int64_t offsetXInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "OffsetX");
+	int64_t offsetYInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "OffsetY");
+	GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto");
+	double exposureTimeInitial = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+	GenApi::CIntegerPtr pBinningVertical = pNodeMap->GetNode("BinningVertical");
+	bool binning = pBinningVertical && GenApi::IsAvailable(pBinningVertical);
+	int64_t binningVerticalInitial = binning ? Arena::GetNodeValue<int64_t>(pNodeMap, "BinningVertical") : 1;
+	int64_t binningHorizontalInitial = binning ? Arena::GetNodeValue<int64_t>(pNodeMap, "BinningHorizontal") : 1;
+
+	// apply settings
+	std::cout << TAB1 << "Apply settings\n";
+
+	size_t firstRow = 0;
+	size_t lastRow = 0;
+	if (std::ifstream(SETTINGS_FILE).good())
+	{
+		OpenHsiSettings settings = LoadSettings(SETTINGS_FILE);
+		ApplySettings(pNodeMap, settings);
+		firstRow = static_cast<size_t>(settings.rowSlice[0]);
+		lastRow = static_cast<size_t>(settings.rowSlice[1]);
+		std::cout << TAB2 << SETTINGS_FILE << ": " << settings.winResolution[0] << " x " << settings.winResolution[1] << " " << settings.pixelFormat << ", exposure " << settings.exposureMs << " ms\n";
+	}
+	else
+	{
+		std::cout << TAB2 << "no " << SETTINGS_FILE << ", camera settings unchanged\n";
+	}
+
+	if (Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat") != "Mono12" && Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat") != "Mono16")
+		Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", "Mono16");
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	Daemon daemon;
+	daemon.pDevice = pDevice;
+	daemon.frameRows = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	daemon.frameColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+	if (lastRow == 0 || lastRow > daemon.frameRows || firstRow >= lastRow)
+	{
+		firstRow = 0;
+		lastRow = daemon.frameRows;
+	}
+
+	// load calibration
+	std::cout << TAB1 << "Load calibration\n";
+
+	daemon.calibration = LoadCalibration(firstRow, lastRow - firstRow, daemon.frameColumns);
+	std::cout << TAB2 << "rows " << firstRow << " to " << lastRow << " of " << daemon.frameRows << ", " << daemon.frameColumns << " bands, " << (daemon.calibration.calibrated ? "dark and gain from " DARK_FILE " and " GAIN_FILE : "uncalibrated counts") << "\n";
+
+	// allocate pools
+	daemon.frames.assign(POOL_FRAMES, std::vector<uint16_t>(daemon.frameRows * daemon.frameColumns));
+	daemon.lines.assign(POOL_FRAMES, std::vector<float>(daemon.calibration.rows * daemon.calibration.columns));
+	for (size_t i = 0; i < POOL_FRAMES; i++)
+	{
+		daemon.freeFrames.Push(i);
+		daemon.freeLines.Push(i);
+	}
+
+	daemon.startRequested = AUTO_SCAN_LINES > 0;
+	daemon.stopRequested = false;
+	daemon.quit = false;
+	daemon.requestedLines = AUTO_SCAN_LINES;
+	daemon.scanning = false;
+	daemon.scans = 0;
+	daemon.acquired = 0;
+	daemon.dropped = 0;
+	daemon.incomplete = 0;
+	daemon.calibrated = 0;
+	daemon.written = 0;
+
+	// start threads
+	std::cout << TAB1 << "Start pipeline; control socket " << CONTROL_SOCKET << "\n";
+
+	int server = OpenControlSocket();
+	std::thread acquisition(AcquisitionThread, &daemon);
+	std::thread calibration(CalibrationThread, &daemon);
+	std::thread writer(WriterThread, &daemon);
+	std::thread telemetry(TelemetryThread, &daemon);
+	std::thread control(ControlThread, &daemon, server);
+
+	// serve
+	if (AUTO_SCAN_LINES > 0)
+	{
+		while (daemon.startRequested || daemon.scanning)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		daemon.quit = true;
+	}
+
+	// stop threads
+	//    The acquisition thread closes the pipeline once it sees quit; the
+	//    calibration and writer threads drain their queues before exiting.
+	acquisition.join();
+	calibration.join();
+	writer.join();
+	telemetry.join();
+	control.join();
+	close(server);
+	unlink(CONTROL_SOCKET);
+
+	std::cout << TAB1 << "Daemon stopped: " << daemon.acquired << " frames, " << daemon.written << " lines written, " << daemon.dropped << " dropped\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposureTimeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", exposureAutoInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetX", 0);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetY", 0);
+	if (binning)
+	{
+		Arena::SetNodeValue<int64_t>(pNodeMap, "BinningVertical", binningVerticalInitial);
+		Arena::SetNodeValue<int64_t>(pNodeMap, "BinningHorizontal", binningHorizontalInitial);
+	}
+	Arena::SetNodeValue<int64_t>(pNodeMap, "Width", widthInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "Height", heightInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetX", offsetXInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "OffsetY", offsetYInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ScanDaemon\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		RunScanDaemon(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,62 @@
+"""Exports an OpenHSI calibration pickle to the arrays read by Cpp_ScanDaemon.
+
+    python3 export_calibration.py OpenHSI-12_settings_Mono12_bin1.json \
+                                  OpenHSI-12_calibration_Mono12_bin1.pkl
+
+writes, next to the daemon:
+    Cpp_ScanDaemon_dark.npy          float32 (rows, columns), counts
+    Cpp_ScanDaemon_gain.npy          float32 (rows, columns), radiance per count
+    Cpp_ScanDaemon_wavelengths.npy   float32 (columns,), nanometers
+
+rows are the settings' row_slice and columns the frame columns. The
+daemon computes (count - dark) * gain. The radiance reference 'rad_ref'
+is read at the settings' exposure. Its zero-luminance entry is the dark
+frame. The entry at the settings' luminance, with the spectral radiance
+fit 'sfit', gives the gain. Unpickling needs the packages the
+calibration was saved with (numpy, scipy, xarray).
+"""
+
+import json
+import pickle
+import sys
+
+import numpy as np
+
+
+def main(settings_path, calibration_path, prefix='Cpp_ScanDaemon'):
+    with open(settings_path) as f:
+        settings = json.load(f)
+    with open(calibration_path, 'rb') as f:
+        calibration = pickle.load(f)
+
+    rows = settings['row_slice'][1] - settings['row_slice'][0]
+    columns = settings['win_resolution'][1]
+    exposure = settings['exposure_ms']
+    luminance = settings['luminance']
+
+    reference = calibration['rad_ref'].interp(exposure=exposure)
+    dark = np.asarray(reference.sel(luminance=0), dtype=np.float32)
+    bright = np.asarray(reference.sel(luminance=luminance), dtype=np.float32)
+    if dark.shape != (rows, columns):
+        sys.exit('rad_ref is %s, the daemon needs the uncorrected frame shape %s'
+                 % (dark.shape, (rows, columns)))
+
+    wavelengths = np.asarray(calibration['wavelengths'], dtype=np.float32)
+    radiance = np.asarray(calibration['sfit'](wavelengths), dtype=np.float32)
+    radiance *= luminance / calibration['spec_rad_ref_luminance']
+    signal = bright - dark
+    gain = np.where(signal > 0, radiance[np.newaxis, :] / np.maximum(signal, 1e-6), 0).astype(np.float32)
+
+    np.save(prefix + '_dark.npy', np.ascontiguousarray(dark))
+    np.save(prefix + '_gain.npy', np.ascontiguousarray(gain))
+    if wavelengths.shape == (columns,):
+        np.save(prefix + '_wavelengths.npy', wavelengths)
+    else:
+        print('wavelengths have %d entries for %d columns; not exported' % (wavelengths.size, columns))
+    print('exported %d x %d calibration at %.3f ms, luminance %d' % (rows, columns, exposure, luminance))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2])
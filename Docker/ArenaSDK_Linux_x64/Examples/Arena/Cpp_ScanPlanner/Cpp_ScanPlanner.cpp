@@ -0,0 +1,441 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Scan Planner
+//    This example plans a pushbroom scan so that ground pixels come out
+//    square. The across-track ground sample distance follows from the
+//    altitude, the 5.35 degree half field of view and the number of image
+//    rows, which run across track (the columns hold the spectrum). The
+//    platform moves one ground sample per frame when the frame rate is the
+//    ground speed divided by that distance. The exposure is then set to the
+//    longest time that fits in one frame period. Frame rate and exposure are
+//    written together with a concatenated node write, in an order that
+//    keeps both inside their limits at every step. While streaming, speed and
+//    altitude are read from a ROS odometry stream ('rostopic echo -p' of a
+//    nav_msgs/Odometry topic, as a file or named pipe). The scan is planned
+//    again whenever they change enough, without restarting the stream. If
+//    the odometry file does not exist, a speed ramp is simulated.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of images acquired
+#define NUM_IMAGES 300
+
+// odometry stream from 'rostopic echo -p <odometry topic> > odometry.csv';
+//    may be a named pipe (mkfifo) for live odometry
+#define ODOMETRY_FILE "Cpp_ScanPlanner_odometry.csv"
+
+// height of the ground in the odometry frame (in meters)
+#define GROUND_HEIGHT_M 0.0
+
+// speed and altitude simulated without an odometry file: the speed ramps
+//    from the first to the last value over the acquisition
+#define SIMULATED_SPEED_FIRST_M_S 1.0
+#define SIMULATED_SPEED_LAST_M_S 3.0
+#define SIMULATED_ALTITUDE_M 30.0
+
+// across-track half field of view (in degrees)
+#define HALF_FOV_DEG 5.35
+
+// image rows the slit spans, the length of the OpenHSI settings' row_slice
+//    (880 of 912 on the OpenHSI); 0 uses the image height
+#define ROW_SLICE_ROWS 0
+
+// time kept free in every frame period for readout (in microseconds)
+#define EXPOSURE_MARGIN_US 100.0
+
+// relative change of the planned frame rate that triggers a new plan
+#define REPLAN_THRESHOLD 0.02
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+const double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+// limits of the frame rate and exposure nodes; the frame rate ceiling is
+//    read at the shortest exposure, since the device lowers it as exposure
+//    grows
+struct CameraLimits
+{
+	size_t acrossTrackPixels;
+	double frameRateMin;
+	double frameRateMax;
+	double exposureMin;
+	double exposureMax;
+};
+
+// scan plan for one speed and altitude
+struct ScanPlan
+{
+	double speed;
+	double altitude;
+	double gsd;
+	double frameRate;
+	double exposureUs;
+
+	// along-track distance between frames over the across-track ground
+	//    sample distance; above 1 when the speed needs more than the
+	//    maximum frame rate and the scan leaves gaps
+	double alongOverAcross;
+};
+
+// plans frame rate and exposure for square ground pixels
+ScanPlan PlanScan(double speed, double altitude, const CameraLimits& limits)
+{
+	ScanPlan plan;
+	plan.speed = speed;
+	plan.altitude = altitude;
+	plan.gsd = 2.0 * altitude * std::tan(HALF_FOV_DEG * DEG_TO_RAD) / static_cast<double>(limits.acrossTrackPixels);
+
+	double frameRate = plan.gsd > 0.0 ? speed / plan.gsd : limits.frameRateMin;
+	plan.frameRate = std::min(limits.frameRateMax, std::max(limits.frameRateMin, frameRate));
+
+	double periodUs = 1e6 / plan.frameRate;
+	plan.exposureUs = std::min(limits.exposureMax, std::max(limits.exposureMin, periodUs - EXPOSURE_MARGIN_US));
+	plan.alongOverAcross = plan.gsd > 0.0 ? speed / plan.frameRate / plan.gsd : 0.0;
+	return plan;
+}
+
+// writes a plan with one concatenated node write; a shorter frame period
+//    needs the shorter exposure first, a longer one the slower frame rate
+//    first
+void ApplyPlan(GenApi::INodeMap* pNodeMap, const ScanPlan& plan)
+{
+	double exposureCurrent = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+	bool exposureFirst = plan.exposureUs < exposureCurrent;
+
+	GenApi::CNodeWriteConcatenatorRef concatenator(pNodeMap->NewNodeWriteConcatenator());
+	if (exposureFirst)
+		concatenator._Add("ExposureTime", plan.exposureUs);
+	concatenator._Add("AcquisitionFrameRate", plan.frameRate);
+	if (!exposureFirst)
+		concatenator._Add("ExposureTime", plan.exposureUs);
+
+	if (!pNodeMap->ConcatenatedWrite(concatenator))
+	{
+		if (exposureFirst)
+			Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", plan.exposureUs);
+		Arena::SetNodeValue<double>(pNodeMap, "AcquisitionFrameRate", plan.frameRate);
+		if (!exposureFirst)
+			Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", plan.exposureUs);
+	}
+}
+
+void PrintPlan(const ScanPlan& plan)
+{
+	std::cout << TAB2 << plan.speed << " m/s at " << plan.altitude << " m: ground sample " << plan.gsd * 100.0 << " cm, " << plan.frameRate << " FPS, exposure " << plan.exposureUs << " us";
+	if (plan.alongOverAcross > 1.0 + 1e-6)
+		std::cout << " (frame rate limited, along-track spacing " << plan.alongOverAcross << "x)";
+	std::cout << "\n";
+}
+
+// latest speed and altitude, read from a rostopic CSV odometry stream on a
+//    background thread; the thread shares the stream and the state, so it
+//    can outlive the reader while blocked on a pipe
+class OdometryStream
+{
+public:
+	explicit OdometryStream(const char* path)
+		: m_pShared(std::make_shared<Shared>())
+	{
+		std::shared_ptr<std::ifstream> pInput = std::make_shared<std::ifstream>(path);
+		std::string header;
+		if (!*pInput || !std::getline(*pInput, header))
+			throw GenICam::GenericException("Odometry stream could not be read", __FILE__, __LINE__);
+
+		// ground speed from the twist, altitude from the pose
+		const char* suffixes[3] = { "twist.twist.linear.x", "twist.twist.linear.y", "pose.pose.position.z" };
+		std::vector<int> columns(3, -1);
+		std::stringstream ss(header);
+		std::string name;
+		for (int column = 0; std::getline(ss, name, ','); column++)
+		{
+			for (size_t i = 0; i < 3; i++)
+			{
+				size_t length = strlen(suffixes[i]);
+				if (columns[i] < 0 && name.size() >= length && name.compare(name.size() - length, length, suffixes[i]) == 0)
+					columns[i] = column;
+			}
+		}
+		for (size_t i = 0; i < 3; i++)
+			if (columns[i] < 0)
+				throw GenICam::GenericException("Odometry stream is missing a twist or position column", __FILE__, __LINE__);
+
+		std::thread(Read, pInput, m_pShared, columns).detach();
+	}
+
+	// latest speed and altitude; waits up to waitMs for the first message
+	bool Latest(int waitMs, double& speed, double& altitude)
+	{
+		Shared& shared = *m_pShared;
+		std::unique_lock<std::mutex> lock(shared.lock);
+		shared.arrived.wait_for(lock, std::chrono::milliseconds(waitMs), [&]() {
+			return shared.done || shared.received;
+		});
+		speed = shared.speed;
+		altitude = shared.altitude;
+		return shared.received;
+	}
+
+private:
+	struct Shared
+	{
+		std::mutex lock;
+		std::condition_variable arrived;
+		double speed = 0.0;
+		double altitude = 0.0;
+		bool received = false;
+		bool done = false;
+	};
+
+	static void Read(std::shared_ptr<std::ifstream> pInput, std::shared_ptr<Shared> pShared, std::vector<int> columns)
+	{
+		std::string text;
+		std::vector<std::string> fields;
+		while (std::getline(*pInput, text))
+		{
+			fields.clear();
+			std::stringstream ss(text);
+			std::string field;
+			while (std::getline(ss, field, ','))
+				fields.push_back(field);
+			if (static_cast<size_t>(*std::max_element(columns.begin(), columns.end())) >= fields.size())
+				continue;
+
+			double vx = atof(fields[columns[0]].c_str());
+			double vy = atof(fields[columns[1]].c_str());
+			{
+				std::lock_guard<std::mutex> lock(pShared->lock);
+				pShared->speed = std::sqrt(vx * vx + vy * vy);
+				pShared->altitude = atof(fields[columns[2]].c_str()) - GROUND_HEIGHT_M;
+				pShared->received = true;
+			}
+			pShared->arrived.notify_all();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pShared->lock);
+			pShared->done = true;
+		}
+		pShared->arrived.notify_all();
+	}
+
+	std::shared_ptr<Shared> m_pShared;
+};
+
+// demonstrates along-track scan planning
+// (1) reads the frame rate and exposure limits
+// (2) plans and applies the initial scan
+// (3) starts the stream
+// (4) plans again as speed and altitude change
+// (5) measures the along-track spacing of the acquired frames
+void PlanAndAcquire(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto");
+	double exposureTimeInitial = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+	bool acquisitionFrameRateEnableInitial = Arena::GetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable");
+	double acquisitionFrameRateInitial = Arena::GetNodeValue<double>(pNodeMap, "AcquisitionFrameRate");
+
+	// read limits
+	//    The frame rate ceiling depends on the exposure time, so it is read
+	//    while the exposure is at its minimum.
+	std::cout << TAB1 << "Read frame rate and exposure limits\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", "Off");
+	Arena::SetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable", true);
+
+	GenApi::CFloatPtr pExposureTime = pNodeMap->GetNode("ExposureTime");
+	GenApi::CFloatPtr pFrameRate = pNodeMap->GetNode("AcquisitionFrameRate");
+	if (!pExposureTime || !GenApi::IsWritable(pExposureTime) || !pFrameRate || !GenApi::IsWritable(pFrameRate))
+		throw GenICam::GenericException("ExposureTime or AcquisitionFrameRate node not writable", __FILE__, __LINE__);
+
+	CameraLimits limits;
+	int64_t height = Arena::GetNodeValue<int64_t>(pNodeMap, "Height");
+	limits.acrossTrackPixels = static_cast<size_t>(ROW_SLICE_ROWS > 0 && ROW_SLICE_ROWS < height ? ROW_SLICE_ROWS : height);
+	limits.exposureMin = pExposureTime->GetMin();
+	limits.exposureMax = pExposureTime->GetMax();
+	pExposureTime->SetValue(limits.exposureMin);
+	limits.frameRateMin = pFrameRate->GetMin();
+	limits.frameRateMax = pFrameRate->GetMax();
+
+	std::cout << TAB2 << limits.acrossTrackPixels << " across-track pixels, " << limits.frameRateMin << " to " << limits.frameRateMax << " FPS, exposure " << limits.exposureMin << " to " << limits.exposureMax << " us\n";
+
+	// open speed and altitude source
+	//    stat rather than a test open, which would hang up on the writer of a
+	//    named pipe before OdometryStream opens it
+	std::unique_ptr<OdometryStream> pOdometry;
+	struct stat odometryFileInfo;
+	if (stat(ODOMETRY_FILE, &odometryFileInfo) == 0)
+		pOdometry.reset(new OdometryStream(ODOMETRY_FILE));
+
+	double speed = SIMULATED_SPEED_FIRST_M_S;
+	double altitude = SIMULATED_ALTITUDE_M;
+	if (pOdometry && !pOdometry->Latest(TIMEOUT, speed, altitude))
+		throw GenICam::GenericException("No odometry received", __FILE__, __LINE__);
+
+	std::cout << TAB1 << "Plan scan from " << (pOdometry ? "odometry in " ODOMETRY_FILE : "simulated speed ramp (no " ODOMETRY_FILE ")") << "\n";
+
+	ScanPlan plan = PlanScan(speed, altitude, limits);
+	ApplyPlan(pNodeMap, plan);
+	PrintPlan(plan);
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// acquire and replan
+	//    The along-track distance of every frame is the speed times the
+	//    interval between device timestamps; square pixels keep it at one
+	//    ground sample.
+	std::cout << TAB1 << "Acquire " << NUM_IMAGES << " images and plan again as speed changes\n";
+
+	size_t replans = 0;
+	double spacingSum = 0.0;
+	double spacingMax = 0.0;
+	size_t intervals = 0;
+	uint64_t previousNs = 0;
+
+	pDevice->StartStream();
+	for (size_t i = 0; i < NUM_IMAGES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		uint64_t timestampNs = pImage->GetTimestampNs();
+		pDevice->RequeueBuffer(pImage);
+
+		if (pOdometry)
+			pOdometry->Latest(0, speed, altitude);
+		else
+			speed = SIMULATED_SPEED_FIRST_M_S + (SIMULATED_SPEED_LAST_M_S - SIMULATED_SPEED_FIRST_M_S) * static_cast<double>(i) / NUM_IMAGES;
+
+		if (i > 0)
+		{
+			double spacing = speed * static_cast<double>(timestampNs - previousNs) * 1e-9 / plan.gsd;
+			spacingSum += spacing;
+			spacingMax = std::max(spacingMax, spacing);
+			intervals++;
+		}
+		previousNs = timestampNs;
+
+		ScanPlan next = PlanScan(speed, altitude, limits);
+		if (std::fabs(next.frameRate - plan.frameRate) > REPLAN_THRESHOLD * plan.frameRate || std::fabs(next.gsd - plan.gsd) > REPLAN_THRESHOLD * plan.gsd)
+		{
+			ApplyPlan(pNodeMap, next);
+			plan = next;
+			replans++;
+			PrintPlan(plan);
+		}
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << replans << " replans, along-track spacing " << spacingSum / std::max<size_t>(1, intervals) << " ground samples on average (maximum " << spacingMax << ")\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", std::min(exposureTimeInitial, 1e6 / acquisitionFrameRateInitial));
+	Arena::SetNodeValue<double>(pNodeMap, "AcquisitionFrameRate", acquisitionFrameRateInitial);
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposureTimeInitial);
+	Arena::SetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable", acquisitionFrameRateEnableInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", exposureAutoInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_ScanPlanner\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		PlanAndAcquire(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
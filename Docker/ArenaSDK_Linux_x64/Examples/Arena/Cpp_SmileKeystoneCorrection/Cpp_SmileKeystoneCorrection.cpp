@@ -0,0 +1,685 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Smile and Keystone Correction
+//    This example resamples pushbroom frames onto a uniform wavelength grid.
+//    A pushbroom frame holds one line: rows run across track and columns
+//    along the spectrum. The wavelength of a sensor column changes slightly
+//    across the slit (smile). The spatial position seen by a row also
+//    changes slightly with wavelength (keystone). Evaluating the calibration
+//    and interpolating every pixel of every frame is expensive. Instead, the
+//    calibration is turned once into a sparse separable operator with small
+//    fixed stencils. A spatial pass uses one stencil per output row and block
+//    of 4 sensor columns, stored in block CSR with a fixed stencil length so
+//    that it runs on whole SIMD vectors. A spectral pass uses a 4-tap cubic
+//    stencil per output band of every row. Each frame from
+//    IImage::GetData() is then corrected with two streaming passes. The
+//    operator is checked against a synthetic frame rendered from the
+//    calibration and against direct per-pixel interpolation.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) in the cube
+#define NUM_LINES 200
+
+// wavelength calibration polynomial (in nanometers):
+//    wavelength = sum of WAVELENGTH_COEFFICIENTS[i][j] * t^i * u^j
+//    where t runs from 0 (first sensor column) to 1 (last sensor column) and
+//    u from -1 (first row) to 1 (last row); the u^2 terms are the smile
+static const double WAVELENGTH_COEFFICIENTS[3][3] = {
+	{ 400.0, 0.0, 1.2 },
+	{ 600.0, 0.0, 0.6 },
+	{ -8.0, 0.0, 0.0 },
+};
+
+// keystone: shift (in pixels) of the first and last rows between the first
+//    and last sensor columns; the shift grows linearly from the slit center
+#define KEYSTONE_EDGE_PIXELS 1.5
+
+// uniform output wavelength grid (in nanometers)
+#define OUTPUT_FIRST_NM 420.0
+#define OUTPUT_LAST_NM 980.0
+#define OUTPUT_STEP_NM 2.0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// number of columns in a spatial block; one SSE vector
+#define BLOCK_COLUMNS 4
+
+// cube stored band-interleaved by line: each line is numBands rows of
+//    numSamples pixels
+struct Cube
+{
+	size_t numLines;
+	size_t numBands;
+	size_t numSamples;
+	std::vector<uint16_t> data;
+
+	uint16_t* Line(size_t line)
+	{
+		return &data[line * numBands * numSamples];
+	}
+};
+
+inline double NormalizedColumn(double column, size_t numColumns)
+{
+	return column / static_cast<double>(numColumns - 1);
+}
+
+inline double NormalizedRow(double row, size_t numRows)
+{
+	double center = 0.5 * static_cast<double>(numRows - 1);
+	return (row - center) / center;
+}
+
+inline size_t PadToBlock(size_t count)
+{
+	return (count + BLOCK_COLUMNS - 1) / BLOCK_COLUMNS * BLOCK_COLUMNS;
+}
+
+// calibrated wavelength and its derivative along t
+inline double CalibratedWavelength(double t, double u, double* pSlope)
+{
+	double value = 0.0;
+	double slope = 0.0;
+	double tPower = 1.0;
+	for (size_t i = 0; i < 3; i++)
+	{
+		double columnTerm = WAVELENGTH_COEFFICIENTS[i][0] + u * (WAVELENGTH_COEFFICIENTS[i][1] + u * WAVELENGTH_COEFFICIENTS[i][2]);
+		value += columnTerm * tPower;
+		if (i + 1 < 3)
+			slope += (i + 1) * (WAVELENGTH_COEFFICIENTS[i + 1][0] + u * (WAVELENGTH_COEFFICIENTS[i + 1][1] + u * WAVELENGTH_COEFFICIENTS[i + 1][2])) * tPower;
+		tPower *= t;
+	}
+	if (pSlope)
+		*pSlope = slope;
+	return value;
+}
+
+// fractional sensor column at which a row sees a wavelength; inverts the
+//    calibration polynomial with Newton iterations
+double ColumnPosition(double wavelength, double row, size_t numRows, size_t numColumns)
+{
+	double u = NormalizedRow(row, numRows);
+	double t = 0.5;
+	for (size_t i = 0; i < 8; i++)
+	{
+		double slope = 0.0;
+		double value = CalibratedWavelength(t, u, &slope);
+		if (slope <= 0.0)
+			throw GenICam::GenericException("Wavelength calibration is not increasing along the columns", __FILE__, __LINE__);
+		t = std::min(1.5, std::max(-0.5, t - (value - wavelength) / slope));
+	}
+	return t * static_cast<double>(numColumns - 1);
+}
+
+// fractional sensor row that sees the spatial position of output row 'row'
+//    in sensor column 'column'
+inline double SourceRow(double column, double row, size_t numRows, size_t numColumns)
+{
+	return row + KEYSTONE_EDGE_PIXELS * NormalizedRow(row, numRows) * (NormalizedColumn(column, numColumns) - 0.5);
+}
+
+// 4-tap cubic (Catmull-Rom) stencil at a fractional position; returns the
+//    first tap. Taps outside [0, count) are folded onto the edge samples, so
+//    the stencil always stays inside the row or column.
+int CubicStencil(double position, size_t count, float* pWeights)
+{
+	double f = std::floor(position);
+	double t = position - f;
+	double w[4] = {
+		((-0.5 * t + 1.0) * t - 0.5) * t,
+		(1.5 * t - 2.5) * t * t + 1.0,
+		((-1.5 * t + 2.0) * t + 0.5) * t,
+		(0.5 * t - 0.5) * t * t,
+	};
+
+	long last = static_cast<long>(count) - 1;
+	long first = static_cast<long>(std::max(-4.0, std::min(f, static_cast<double>(count)))) - 1;
+	long start = std::max(0L, std::min(first, last - 3));
+	for (size_t k = 0; k < 4; k++)
+		pWeights[k] = 0.0f;
+	for (long k = 0; k < 4; k++)
+	{
+		long j = std::max(0L, std::min(first + k, last));
+		pWeights[j - start] += static_cast<float>(w[k]);
+	}
+	return static_cast<int>(start);
+}
+
+// sparse separable resampling operator for one frame size
+struct SmileKeystoneOperator
+{
+	size_t numRows;
+	size_t numColumns;
+	size_t stride; // numColumns padded to whole blocks
+	size_t numBands;
+	size_t bandStride; // numBands padded to whole blocks
+	size_t sampleStride; // numRows padded to whole blocks
+
+	// spatial pass: block CSR with a fixed stencil; per output row and
+	//    block of sensor columns, a first sensor row and spatialStencil x
+	//    BLOCK_COLUMNS weights, tap-major
+	size_t spatialStencil;
+	std::vector<int> spatialFirst;
+	std::vector<float> spatialWeights;
+
+	// spectral pass: first sensor column and 4 weights per output row and
+	//    band
+	std::vector<int> spectralFirst;
+	std::vector<float> spectralWeights;
+
+	// working buffers: the frame as float, the spatially resampled frame,
+	//    its spectra (one row per sample) and the spectra transposed to
+	//    bands (one row per band)
+	std::vector<float> frame;
+	std::vector<float> intermediate;
+	std::vector<float> spectra;
+	std::vector<float> bands;
+};
+
+inline double OutputWavelength(size_t band)
+{
+	return OUTPUT_FIRST_NM + OUTPUT_STEP_NM * static_cast<double>(band);
+}
+
+// builds the operator from the calibration
+void BuildOperator(size_t numRows, size_t numColumns, SmileKeystoneOperator& op)
+{
+	if (numRows < 4 || numColumns < 8)
+		throw GenICam::GenericException("Frame too small for resampling", __FILE__, __LINE__);
+
+	op.numRows = numRows;
+	op.numColumns = numColumns;
+	op.stride = PadToBlock(numColumns);
+	op.numBands = static_cast<size_t>(std::floor((OUTPUT_LAST_NM - OUTPUT_FIRST_NM) / OUTPUT_STEP_NM + 1e-9)) + 1;
+	op.bandStride = PadToBlock(op.numBands);
+	op.sampleStride = PadToBlock(numRows);
+
+	// spatial stencils per sensor column
+	size_t numBlocks = op.stride / BLOCK_COLUMNS;
+	std::vector<int> columnFirst(numRows * op.stride, 0);
+	std::vector<float> columnWeights(numRows * op.stride * 4, 0.0f);
+	for (size_t y = 0; y < numRows; y++)
+	{
+		for (size_t c = 0; c < numColumns; c++)
+		{
+			size_t i = y * op.stride + c;
+			double position = SourceRow(static_cast<double>(c), static_cast<double>(y), numRows, numColumns);
+			columnFirst[i] = CubicStencil(position, numRows, &columnWeights[i * 4]);
+		}
+	}
+
+	// the stencil of a block covers the stencils of all its columns; its
+	//    length is fixed to the widest block
+	std::vector<int> blockFirst(numRows * numBlocks);
+	int spread = 0;
+	for (size_t y = 0; y < numRows; y++)
+	{
+		for (size_t k = 0; k < numBlocks; k++)
+		{
+			int lo = numRows;
+			int hi = 0;
+			for (size_t lane = 0; lane < BLOCK_COLUMNS && k * BLOCK_COLUMNS + lane < numColumns; lane++)
+			{
+				int first = columnFirst[y * op.stride + k * BLOCK_COLUMNS + lane];
+				lo = std::min(lo, first);
+				hi = std::max(hi, first);
+			}
+			blockFirst[y * numBlocks + k] = lo;
+			spread = std::max(spread, hi - lo);
+		}
+	}
+	op.spatialStencil = std::min(numRows, static_cast<size_t>(spread) + 4);
+
+	op.spatialFirst.resize(numRows * numBlocks);
+	op.spatialWeights.assign(numRows * numBlocks * op.spatialStencil * BLOCK_COLUMNS, 0.0f);
+	for (size_t y = 0; y < numRows; y++)
+	{
+		for (size_t k = 0; k < numBlocks; k++)
+		{
+			size_t block = y * numBlocks + k;
+			int first = std::min(blockFirst[block], static_cast<int>(numRows - op.spatialStencil));
+			op.spatialFirst[block] = first;
+
+			float* pWeights = &op.spatialWeights[block * op.spatialStencil * BLOCK_COLUMNS];
+			for (size_t lane = 0; lane < BLOCK_COLUMNS && k * BLOCK_COLUMNS + lane < numColumns; lane++)
+			{
+				size_t i = y * op.stride + k * BLOCK_COLUMNS + lane;
+				size_t offset = static_cast<size_t>(columnFirst[i] - first);
+				for (size_t tap = 0; tap < 4; tap++)
+					pWeights[(offset + tap) * BLOCK_COLUMNS + lane] = columnWeights[i * 4 + tap];
+			}
+		}
+	}
+
+	// spectral stencils per output row and band
+	op.spectralFirst.resize(numRows * op.numBands);
+	op.spectralWeights.resize(numRows * op.numBands * 4);
+	for (size_t y = 0; y < numRows; y++)
+	{
+		for (size_t b = 0; b < op.numBands; b++)
+		{
+			size_t i = y * op.numBands + b;
+			double position = ColumnPosition(OutputWavelength(b), static_cast<double>(y), numRows, numColumns);
+			op.spectralFirst[i] = CubicStencil(position, numColumns, &op.spectralWeights[i * 4]);
+		}
+	}
+
+	op.frame.assign(numRows * op.stride, 0.0f);
+	op.intermediate.assign(numRows * op.stride, 0.0f);
+	op.spectra.assign(op.sampleStride * op.bandStride, 0.0f);
+	op.bands.assign(op.bandStride * op.sampleStride, 0.0f);
+}
+
+// converts a row of unsigned 16-bit pixels to float
+inline void ConvertRow(const uint16_t* pSrc, size_t count, float* pDst)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+		_mm_storeu_ps(pDst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+		_mm_storeu_ps(pDst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = static_cast<float>(pSrc[i]);
+}
+
+// spatial pass for one output row; every block reads whole vectors from
+//    consecutive rows of the frame
+inline void ResampleSpatial(const SmileKeystoneOperator& op, size_t y, float* pDst)
+{
+	size_t numBlocks = op.stride / BLOCK_COLUMNS;
+	const int* pFirst = &op.spatialFirst[y * numBlocks];
+	const float* pWeights = &op.spatialWeights[y * numBlocks * op.spatialStencil * BLOCK_COLUMNS];
+
+	for (size_t k = 0; k < numBlocks; k++)
+	{
+		const float* pSrc = &op.frame[pFirst[k] * op.stride + k * BLOCK_COLUMNS];
+		const float* w = pWeights + k * op.spatialStencil * BLOCK_COLUMNS;
+#if defined(__SSE2__)
+		__m128 sum = _mm_setzero_ps();
+		for (size_t tap = 0; tap < op.spatialStencil; tap++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSrc + tap * op.stride), _mm_loadu_ps(w + tap * BLOCK_COLUMNS)));
+		_mm_storeu_ps(pDst + k * BLOCK_COLUMNS, sum);
+#else
+		for (size_t lane = 0; lane < BLOCK_COLUMNS; lane++)
+		{
+			float sum = 0.0f;
+			for (size_t tap = 0; tap < op.spatialStencil; tap++)
+				sum += pSrc[tap * op.stride + lane] * w[tap * BLOCK_COLUMNS + lane];
+			pDst[k * BLOCK_COLUMNS + lane] = sum;
+		}
+#endif
+	}
+}
+
+// spectral pass over one row; 4 output bands at a time, each a 4-tap dot
+//    product, summed across lanes with a 4x4 transpose
+inline void ResampleSpectrum(const float* pSrc, const int* pFirst, const float* pWeights, size_t count, float* pDst)
+{
+	size_t b = 0;
+#if defined(__SSE2__)
+	for (; b + 4 <= count; b += 4)
+	{
+		__m128 a0 = _mm_mul_ps(_mm_loadu_ps(pSrc + pFirst[b]), _mm_loadu_ps(pWeights + 4 * b));
+		__m128 a1 = _mm_mul_ps(_mm_loadu_ps(pSrc + pFirst[b + 1]), _mm_loadu_ps(pWeights + 4 * b + 4));
+		__m128 a2 = _mm_mul_ps(_mm_loadu_ps(pSrc + pFirst[b + 2]), _mm_loadu_ps(pWeights + 4 * b + 8));
+		__m128 a3 = _mm_mul_ps(_mm_loadu_ps(pSrc + pFirst[b + 3]), _mm_loadu_ps(pWeights + 4 * b + 12));
+		_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+		_mm_storeu_ps(pDst + b, _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+	}
+#endif
+	for (; b < count; b++)
+	{
+		const float* p = pSrc + pFirst[b];
+		const float* w = pWeights + 4 * b;
+		pDst[b] = p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+	}
+}
+
+// transposes the spectra (one row of bandStride per sample) into bands (one
+//    row of sampleStride per band) in 4 x 4 blocks
+inline void TransposeSpectra(const float* pSrc, size_t sampleStride, size_t bandStride, float* pDst)
+{
+	for (size_t x = 0; x < sampleStride; x += 4)
+	{
+		for (size_t b = 0; b < bandStride; b += 4)
+		{
+			const float* p = pSrc + x * bandStride + b;
+			float* q = pDst + b * sampleStride + x;
+#if defined(__SSE2__)
+			__m128 r0 = _mm_loadu_ps(p);
+			__m128 r1 = _mm_loadu_ps(p + bandStride);
+			__m128 r2 = _mm_loadu_ps(p + 2 * bandStride);
+			__m128 r3 = _mm_loadu_ps(p + 3 * bandStride);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(q, r0);
+			_mm_storeu_ps(q + sampleStride, r1);
+			_mm_storeu_ps(q + 2 * sampleStride, r2);
+			_mm_storeu_ps(q + 3 * sampleStride, r3);
+#else
+			for (size_t i = 0; i < 4; i++)
+				for (size_t j = 0; j < 4; j++)
+					q[j * sampleStride + i] = p[i * bandStride + j];
+#endif
+		}
+	}
+}
+
+// rounds and clamps a float row to 16 bits
+inline void StoreRounded(const float* pSrc, size_t count, uint16_t* pDst)
+{
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 vMin = _mm_setzero_ps();
+	const __m128 vMax = _mm_set1_ps(65535.0f);
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i sign = _mm_set1_epi16(static_cast<short>(0x8000));
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 a = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_loadu_ps(pSrc + i), half), vMin), vMax);
+		__m128 b = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_loadu_ps(pSrc + i + 4), half), vMin), vMax);
+
+		// SSE2 has no unsigned 32 to 16-bit pack; shift into signed range,
+		//    pack with signed saturation and flip the sign bit back
+		__m128i ia = _mm_sub_epi32(_mm_cvttps_epi32(a), bias);
+		__m128i ib = _mm_sub_epi32(_mm_cvttps_epi32(b), bias);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_xor_si128(_mm_packs_epi32(ia, ib), sign));
+	}
+#endif
+	for (; i < count; i++)
+		pDst[i] = static_cast<uint16_t>(std::min(std::max(pSrc[i] + 0.5f, 0.0f), 65535.0f));
+}
+
+// corrects one frame into one cube line (numBands rows of numRows)
+void CorrectFrame(const uint16_t* pFrame, SmileKeystoneOperator& op, uint16_t* pLine)
+{
+	for (size_t y = 0; y < op.numRows; y++)
+		ConvertRow(pFrame + y * op.numColumns, op.numColumns, &op.frame[y * op.stride]);
+
+	for (size_t y = 0; y < op.numRows; y++)
+	{
+		ResampleSpatial(op, y, &op.intermediate[y * op.stride]);
+		ResampleSpectrum(&op.intermediate[y * op.stride], &op.spectralFirst[y * op.numBands], &op.spectralWeights[y * op.numBands * 4], op.numBands, &op.spectra[y * op.bandStride]);
+	}
+
+	TransposeSpectra(op.spectra.data(), op.sampleStride, op.bandStride, op.bands.data());
+	for (size_t b = 0; b < op.numBands; b++)
+		StoreRounded(&op.bands[b * op.sampleStride], op.numRows, pLine + b * op.numRows);
+}
+
+// corrects one frame by evaluating the calibration and interpolating every
+//    output pixel directly, as a reference
+void CorrectFrameDirect(const uint16_t* pFrame, size_t numRows, size_t numColumns, size_t numBands, std::vector<float>& out)
+{
+	out.resize(numBands * numRows);
+	for (size_t b = 0; b < numBands; b++)
+	{
+		for (size_t y = 0; y < numRows; y++)
+		{
+			float columnWeights[4];
+			int firstColumn = CubicStencil(ColumnPosition(OutputWavelength(b), static_cast<double>(y), numRows, numColumns), numColumns, columnWeights);
+
+			float sum = 0.0f;
+			for (size_t k = 0; k < 4; k++)
+			{
+				size_t c = firstColumn + k;
+				float rowWeights[4];
+				int firstRow = CubicStencil(SourceRow(static_cast<double>(c), static_cast<double>(y), numRows, numColumns), numRows, rowWeights);
+				const uint16_t* p = pFrame + firstRow * numColumns + c;
+				sum += columnWeights[k] * (p[0] * rowWeights[0] + p[numColumns] * rowWeights[1] + p[2 * numColumns] * rowWeights[2] + p[3 * numColumns] * rowWeights[3]);
+			}
+			out[b * numRows + y] = sum;
+		}
+	}
+}
+
+// smooth synthetic scene radiance at a wavelength and spatial position
+inline double SyntheticScene(double wavelength, double row)
+{
+	return 20000.0 + 12000.0 * std::sin(wavelength / 25.0) * (1.0 + 0.3 * std::cos(row / 40.0));
+}
+
+// renders the synthetic scene through the calibration: each sensor pixel
+//    sees the wavelength and spatial position the calibration assigns to it
+void RenderSyntheticFrame(size_t numRows, size_t numColumns, std::vector<uint16_t>& frame)
+{
+	frame.resize(numRows * numColumns);
+	for (size_t y = 0; y < numRows; y++)
+	{
+		for (size_t c = 0; c < numColumns; c++)
+		{
+			// invert the keystone: find the output row whose source is y
+			double row = static_cast<double>(y);
+			for (size_t i = 0; i < 4; i++)
+				row = static_cast<double>(y) - (SourceRow(static_cast<double>(c), row, numRows, numColumns) - row);
+
+			double wavelength = CalibratedWavelength(NormalizedColumn(static_cast<double>(c), numColumns), NormalizedRow(row, numRows), NULL);
+			frame[y * numColumns + c] = static_cast<uint16_t>(SyntheticScene(wavelength, row) + 0.5);
+		}
+	}
+}
+
+// demonstrates smile and keystone correction at line rate
+// (1) selects an unpacked 12 or 16-bit mono format
+// (2) builds the resampling operator from the calibration
+// (3) checks it on a synthetic frame, against the scene and direct
+//     interpolation
+// (4) corrects every acquired frame into the cube
+// (5) compares with direct interpolation of the last frame
+// (6) restores the pixel format
+void AcquireWithSmileKeystoneCorrection(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat");
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// select pixel format
+	//    Mono12 is unpacked into 16-bit containers, so both formats are read
+	//    straight from the image buffer without conversion.
+	GenApi::CEnumerationPtr pPixelFormat = pNodeMap->GetNode("PixelFormat");
+	GenApi::CEnumEntryPtr pMono12 = pPixelFormat->GetEntryByName("Mono12");
+	const char* pixelFormat = (pMono12 != 0 && GenApi::IsAvailable(pMono12)) ? "Mono12" : "Mono16";
+	std::cout << TAB1 << "Set pixel format to " << pixelFormat << "\n";
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormat);
+
+	size_t numRows = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	size_t numColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+
+	// build operator
+	std::cout << TAB1 << "Build resampling operator for " << numColumns << " x " << numRows << " frames\n";
+
+	SmileKeystoneOperator op;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BuildOperator(numRows, numColumns, op);
+	double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	size_t operatorBytes = op.spatialFirst.size() * sizeof(int) + op.spatialWeights.size() * sizeof(float) + op.spectralFirst.size() * sizeof(int) + op.spectralWeights.size() * sizeof(float);
+	std::cout << TAB2 << op.numBands << " bands from " << OUTPUT_FIRST_NM << " to " << OUTPUT_LAST_NM << " nm\n";
+	std::cout << TAB2 << "spatial stencil " << op.spatialStencil << ", spectral stencil 4 (" << operatorBytes / (1024 * 1024) << " MiB, built in " << buildSeconds * 1000.0 << " ms)\n";
+
+	// check on synthetic frame
+	std::cout << TAB1 << "Check on a synthetic frame rendered from the calibration\n";
+
+	std::vector<uint16_t> synthetic;
+	RenderSyntheticFrame(numRows, numColumns, synthetic);
+
+	std::vector<uint16_t> corrected(op.numBands * numRows);
+	CorrectFrame(synthetic.data(), op, corrected.data());
+
+	std::vector<float> direct;
+	CorrectFrameDirect(synthetic.data(), numRows, numColumns, op.numBands, direct);
+
+	double maxSceneError = 0.0;
+	double maxDirectError = 0.0;
+	for (size_t b = 0; b < op.numBands; b++)
+	{
+		for (size_t y = 2; y + 2 < numRows; y++)
+		{
+			double value = corrected[b * numRows + y];
+			maxSceneError = std::max(maxSceneError, std::fabs(value - SyntheticScene(OutputWavelength(b), static_cast<double>(y))));
+			maxDirectError = std::max(maxDirectError, std::fabs(value - direct[b * numRows + y]));
+		}
+	}
+	std::cout << TAB2 << "max error against scene: " << maxSceneError << " counts\n";
+	std::cout << TAB2 << "max difference from direct interpolation: " << maxDirectError << " counts\n";
+	if (maxDirectError > 1.0)
+		throw GenICam::GenericException("Resampling operator does not match direct interpolation", __FILE__, __LINE__);
+
+	// acquire and correct
+	std::cout << TAB1 << "Acquire and correct " << NUM_LINES << " lines\n";
+
+	Cube cube;
+	cube.numLines = NUM_LINES;
+	cube.numBands = op.numBands;
+	cube.numSamples = numRows;
+	cube.data.resize(cube.numLines * cube.numBands * cube.numSamples);
+
+	std::vector<uint16_t> lastFrame;
+	double correctSeconds = 0.0;
+
+	pDevice->StartStream();
+	for (size_t line = 0; line < NUM_LINES; line++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->GetWidth() != numColumns || pImage->GetHeight() != numRows || pImage->GetBitsPerPixel() != 16)
+		{
+			pDevice->RequeueBuffer(pImage);
+			pDevice->StopStream();
+			throw GenICam::GenericException("Unexpected image size or format", __FILE__, __LINE__);
+		}
+
+		const uint16_t* pFrame = reinterpret_cast<const uint16_t*>(pImage->GetData());
+
+		start = std::chrono::steady_clock::now();
+		CorrectFrame(pFrame, op, cube.Line(line));
+		correctSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (line == NUM_LINES - 1)
+			lastFrame.assign(pFrame, pFrame + numRows * numColumns);
+
+		pDevice->RequeueBuffer(pImage);
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << correctSeconds * 1000.0 / NUM_LINES << " ms per frame (" << NUM_LINES / correctSeconds << " lines/s)\n";
+
+	// compare with direct interpolation
+	std::cout << TAB1 << "Compare with direct interpolation of the last frame\n";
+
+	start = std::chrono::steady_clock::now();
+	CorrectFrameDirect(lastFrame.data(), numRows, numColumns, op.numBands, direct);
+	double directSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << TAB2 << directSeconds * 1000.0 << " ms per frame (" << directSeconds * NUM_LINES / correctSeconds << "x slower)\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_SmileKeystoneCorrection\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		AcquireWithSmileKeystoneCorrection(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,1115 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Spectral Matcher
+//    This example labels every pixel of a pushbroom stream with the closest
+//    entry of a spectral library (paints, vegetation, water, ...) by
+//    spectral angle (SAM). Comparing every pixel with thousands of entries
+//    does not keep up with the line rate, so the library is indexed once.
+//    All spectra are normalized to unit length. For unit vectors the
+//    smallest angle is also the smallest Euclidean distance. The spectra are
+//    reduced with PCA, and a hierarchical navigable small world (HNSW) graph
+//    is built over the reduced spectra. Each line is matched as one batch,
+//    split across threads. Every pixel is normalized and projected, a few
+//    candidates are found in the graph, and they are reranked by the exact
+//    full-band angle. All distance and dot-product kernels use SIMD. Recall
+//    and speed are compared with brute-force SAM on a sample of pixels.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) matched
+#define NUM_LINES 100
+
+// sensor columns averaged into one band; the spectral axis of a pushbroom
+//    frame runs along the image width and every row is one pixel of the line
+#define SPECTRAL_BINNING 8
+
+// wavelength range covered by the sensor columns (in nanometers)
+#define WAVELENGTH_FIRST_NM 400.0
+#define WAVELENGTH_LAST_NM 1000.0
+
+// library file: a header line "name,<wavelength nm>,..." followed by one
+//    line per entry "<name>,<value>,..."; a synthetic library of
+//    NUM_SYNTHETIC_ENTRIES is generated when the file does not exist
+#define LIBRARY_FILE "Cpp_SpectralMatcher_library.csv"
+#define NUM_SYNTHETIC_ENTRIES 5000
+
+// PCA dimensions of the index; a multiple of 4
+#define REDUCED_DIMENSIONS 32
+
+// graph degree and candidate list sizes of the index
+#define GRAPH_DEGREE 16
+#define EF_CONSTRUCTION 100
+#define EF_SEARCH 48
+
+// candidates from the index reranked by exact spectral angle
+#define RERANK_CANDIDATES 8
+
+// pixels with a larger best angle are labeled unknown (in radians)
+#define MAX_ANGLE 0.10
+
+// pixels per line compared against brute force
+#define NUM_CHECK_PIXELS 64
+
+// number of worker threads (0 uses std::thread::hardware_concurrency)
+#define NUM_THREADS 0
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+inline size_t RoundUp4(size_t n)
+{
+	return (n + 3) / 4 * 4;
+}
+
+inline double BandWavelength(size_t band, size_t numBands)
+{
+	return WAVELENGTH_FIRST_NM + (WAVELENGTH_LAST_NM - WAVELENGTH_FIRST_NM) * (band + 0.5) / static_cast<double>(numBands);
+}
+
+// dot product; count is a multiple of 4
+inline float Dot(const float* a, const float* b, size_t count)
+{
+#if defined(__SSE2__)
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	if (i < count)
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	__m128 sum = _mm_add_ps(sum0, sum1);
+	sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(sum);
+#else
+	float sum = 0.0f;
+	for (size_t i = 0; i < count; i++)
+		sum += a[i] * b[i];
+	return sum;
+#endif
+}
+
+// squared Euclidean distance; count is a multiple of 4
+inline float SquaredDistance(const float* a, const float* b, size_t count)
+{
+#if defined(__SSE2__)
+	__m128 sum = _mm_setzero_ps();
+	for (size_t i = 0; i < count; i += 4)
+	{
+		__m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+		sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+	}
+	sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(sum);
+#else
+	float sum = 0.0f;
+	for (size_t i = 0; i < count; i++)
+		sum += (a[i] - b[i]) * (a[i] - b[i]);
+	return sum;
+#endif
+}
+
+// scales a spectrum to unit length; returns false for an all-zero spectrum
+inline bool Normalize(float* p, size_t count)
+{
+	float norm = std::sqrt(Dot(p, p, count));
+	if (norm <= 0.0f)
+		return false;
+	float scale = 1.0f / norm;
+	for (size_t i = 0; i < count; i++)
+		p[i] *= scale;
+	return true;
+}
+
+// library of unit spectra sampled at the band centers, padded with zeros to
+//    a multiple of 4 bands
+struct SpectralLibrary
+{
+	size_t numBands;
+	size_t stride;
+	std::vector<std::string> names;
+	std::vector<float> spectra;
+
+	size_t Size() const
+	{
+		return names.size();
+	}
+
+	const float* Spectrum(size_t i) const
+	{
+		return &spectra[i * stride];
+	}
+
+	void Add(const std::string& name, const std::vector<double>& values)
+	{
+		names.push_back(name);
+		spectra.resize(names.size() * stride, 0.0f);
+		float* p = &spectra[(names.size() - 1) * stride];
+		for (size_t b = 0; b < numBands; b++)
+			p[b] = static_cast<float>(values[b]);
+		if (!Normalize(p, stride))
+		{
+			names.pop_back();
+			spectra.resize(names.size() * stride);
+		}
+	}
+};
+
+// reads the library file and resamples each entry to the band centers;
+//    returns false if the file does not exist
+bool LoadLibrary(const char* fileName, SpectralLibrary& library)
+{
+	std::ifstream file(fileName);
+	if (!file)
+		return false;
+
+	std::string text;
+	std::getline(file, text);
+	std::vector<double> wavelengths;
+	{
+		std::stringstream ss(text);
+		std::string field;
+		std::getline(ss, field, ',');
+		while (std::getline(ss, field, ','))
+			wavelengths.push_back(atof(field.c_str()));
+	}
+	if (wavelengths.size() < 2)
+		throw GenICam::GenericException("Library file has no wavelengths", __FILE__, __LINE__);
+	for (size_t i = 1; i < wavelengths.size(); i++)
+		if (wavelengths[i] <= wavelengths[i - 1])
+			throw GenICam::GenericException("Library wavelengths must increase", __FILE__, __LINE__);
+
+	std::vector<double> resampled(library.numBands);
+	while (std::getline(file, text))
+	{
+		if (text.empty())
+			continue;
+		std::stringstream ss(text);
+		std::string name;
+		std::getline(ss, name, ',');
+		std::vector<double> values;
+		std::string field;
+		while (std::getline(ss, field, ','))
+			values.push_back(atof(field.c_str()));
+		if (values.size() != wavelengths.size())
+			throw GenICam::GenericException("Library entry has the wrong number of values", __FILE__, __LINE__);
+
+		// linear interpolation, clamped at the ends
+		for (size_t b = 0; b < library.numBands; b++)
+		{
+			double nm = BandWavelength(b, library.numBands);
+			size_t j = std::upper_bound(wavelengths.begin(), wavelengths.end(), nm) - wavelengths.begin();
+			if (j == 0)
+				resampled[b] = values.front();
+			else if (j == wavelengths.size())
+				resampled[b] = values.back();
+			else
+			{
+				double t = (nm - wavelengths[j - 1]) / (wavelengths[j] - wavelengths[j - 1]);
+				resampled[b] = values[j - 1] + t * (values[j] - values[j - 1]);
+			}
+		}
+		library.Add(name, resampled);
+	}
+	return true;
+}
+
+// generates vegetation (red edge), water (decaying) and paint (one or two
+//    reflectance peaks) spectra with random parameters
+void GenerateSyntheticLibrary(size_t count, SpectralLibrary& library)
+{
+	std::mt19937 generator(2021);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::vector<double> values(library.numBands);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		std::stringstream name;
+		size_t family = i % 3;
+		double a = uniform(generator);
+		double b = uniform(generator);
+		double c = uniform(generator);
+		for (size_t k = 0; k < library.numBands; k++)
+		{
+			double nm = BandWavelength(k, library.numBands);
+			if (family == 0)
+			{
+				double edge = 690.0 + 40.0 * a;
+				double green = 0.05 + 0.1 * b * std::exp(-(nm - 550.0) * (nm - 550.0) / 1200.0);
+				values[k] = green + (0.3 + 0.4 * c) / (1.0 + std::exp(-(nm - edge) / 12.0));
+			}
+			else if (family == 1)
+			{
+				values[k] = (0.02 + 0.1 * a) * std::exp(-(nm - 400.0) / (80.0 + 200.0 * b)) + 0.01 * c;
+			}
+			else
+			{
+				double peak = 420.0 + 560.0 * a;
+				double second = 420.0 + 560.0 * c;
+				values[k] = 0.05 + 0.6 * std::exp(-(nm - peak) * (nm - peak) / (800.0 + 4000.0 * b)) + 0.2 * std::exp(-(nm - second) * (nm - second) / 2000.0);
+			}
+		}
+		name << (family == 0 ? "vegetation_" : (family == 1 ? "water_" : "paint_")) << i / 3;
+		library.Add(name.str(), values);
+	}
+}
+
+// symmetric eigendecomposition by cyclic Jacobi rotations; each solve starts
+//    from the eigenvectors of the previous one, so a slowly changing matrix
+//    is already almost diagonal
+class SymmetricEigen
+{
+public:
+	SymmetricEigen()
+		: m_size(0), m_sweeps(0)
+	{
+	}
+
+	// eigenvalues in descending order; eigenvector j is column j of Vectors()
+	void Solve(const std::vector<double>& matrix, size_t n)
+	{
+		if (m_size != n)
+		{
+			m_size = n;
+			m_vectors.assign(n * n, 0.0);
+			for (size_t i = 0; i < n; i++)
+				m_vectors[i * n + i] = 1.0;
+		}
+
+		// a = V^T * matrix * V
+		std::vector<double> temp(n * n, 0.0);
+		for (size_t i = 0; i < n; i++)
+			for (size_t k = 0; k < n; k++)
+			{
+				double m = matrix[i * n + k];
+				for (size_t j = 0; j < n; j++)
+					temp[i * n + j] += m * m_vectors[k * n + j];
+			}
+		std::vector<double> a(n * n, 0.0);
+		for (size_t k = 0; k < n; k++)
+			for (size_t i = 0; i < n; i++)
+			{
+				double v = m_vectors[k * n + i];
+				for (size_t j = 0; j < n; j++)
+					a[i * n + j] += v * temp[k * n + j];
+			}
+
+		double total = 0.0;
+		for (size_t i = 0; i < n * n; i++)
+			total += a[i] * a[i];
+
+		for (m_sweeps = 0; m_sweeps < 50; m_sweeps++)
+		{
+			double off = 0.0;
+			for (size_t p = 0; p < n; p++)
+				for (size_t q = p + 1; q < n; q++)
+					off += a[p * n + q] * a[p * n + q];
+			if (off <= 1e-24 * total)
+				break;
+
+			for (size_t p = 0; p < n; p++)
+			{
+				for (size_t q = p + 1; q < n; q++)
+				{
+					double apq = a[p * n + q];
+					if (std::fabs(apq) < 1e-300)
+						continue;
+					double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+					double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					double c = 1.0 / std::sqrt(t * t + 1.0);
+					double s = t * c;
+
+					for (size_t k = 0; k < n; k++)
+					{
+						double akp = a[k * n + p];
+						double akq = a[k * n + q];
+						a[k * n + p] = c * akp - s * akq;
+						a[k * n + q] = s * akp + c * akq;
+					}
+					for (size_t k = 0; k < n; k++)
+					{
+						double apk = a[p * n + k];
+						double aqk = a[q * n + k];
+						a[p * n + k] = c * apk - s * aqk;
+						a[q * n + k] = s * apk + c * aqk;
+					}
+					for (size_t k = 0; k < n; k++)
+					{
+						double vkp = m_vectors[k * n + p];
+						double vkq = m_vectors[k * n + q];
+						m_vectors[k * n + p] = c * vkp - s * vkq;
+						m_vectors[k * n + q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		// sort descending
+		std::vector<size_t> order(n);
+		for (size_t i = 0; i < n; i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return a[x * n + x] > a[y * n + y]; });
+
+		m_values.resize(n);
+		std::vector<double> sorted(n * n);
+		for (size_t j = 0; j < n; j++)
+		{
+			m_values[j] = a[order[j] * n + order[j]];
+			for (size_t i = 0; i < n; i++)
+				sorted[i * n + j] = m_vectors[i * n + order[j]];
+		}
+		m_vectors.swap(sorted);
+	}
+
+	const std::vector<double>& Values() const
+	{
+		return m_values;
+	}
+
+	const std::vector<double>& Vectors() const
+	{
+		return m_vectors;
+	}
+
+	size_t Sweeps() const
+	{
+		return m_sweeps;
+	}
+
+private:
+	size_t m_size;
+	size_t m_sweeps;
+	std::vector<double> m_values;
+	std::vector<double> m_vectors;
+};
+
+// PCA of the library spectra; projects unit spectra to REDUCED_DIMENSIONS
+struct ReducedSpace
+{
+	size_t stride;
+	size_t dimensions;
+	std::vector<float> mean;
+	std::vector<float> basis; // dimensions x stride
+	double retained;
+
+	void Build(const SpectralLibrary& library)
+	{
+		size_t n = library.numBands;
+		stride = library.stride;
+		dimensions = std::min(static_cast<size_t>(REDUCED_DIMENSIONS), RoundUp4(n));
+
+		std::vector<double> sum(n, 0.0);
+		for (size_t i = 0; i < library.Size(); i++)
+			for (size_t b = 0; b < n; b++)
+				sum[b] += library.Spectrum(i)[b];
+		mean.assign(stride, 0.0f);
+		for (size_t b = 0; b < n; b++)
+			mean[b] = static_cast<float>(sum[b] / library.Size());
+
+		std::vector<double> covariance(n * n, 0.0);
+		std::vector<double> centered(n);
+		for (size_t i = 0; i < library.Size(); i++)
+		{
+			for (size_t b = 0; b < n; b++)
+				centered[b] = library.Spectrum(i)[b] - mean[b];
+			for (size_t r = 0; r < n; r++)
+				for (size_t c = r; c < n; c++)
+					covariance[r * n + c] += centered[r] * centered[c];
+		}
+		for (size_t r = 0; r < n; r++)
+			for (size_t c = 0; c < r; c++)
+				covariance[r * n + c] = covariance[c * n + r];
+
+		SymmetricEigen eigen;
+		eigen.Solve(covariance, n);
+		const std::vector<double>& values = eigen.Values();
+		const std::vector<double>& vectors = eigen.Vectors();
+
+		basis.assign(dimensions * stride, 0.0f);
+		double kept = 0.0;
+		double total = 0.0;
+		for (size_t j = 0; j < n; j++)
+		{
+			total += std::max(values[j], 0.0);
+			if (j < dimensions)
+			{
+				kept += std::max(values[j], 0.0);
+				for (size_t b = 0; b < n; b++)
+					basis[j * stride + b] = static_cast<float>(vectors[b * n + j]);
+			}
+		}
+		retained = total > 0.0 ? kept / total : 1.0;
+	}
+
+	// out[d] = basis[d] . (x - mean)
+	void Project(const float* pSpectrum, float* pCentered, float* pOut) const
+	{
+		for (size_t b = 0; b < stride; b++)
+			pCentered[b] = pSpectrum[b] - mean[b];
+		for (size_t d = 0; d < dimensions; d++)
+			pOut[d] = Dot(&basis[d * stride], pCentered, stride);
+	}
+};
+
+// per-thread search state; nodes are marked visited with the current epoch
+//    so the marks never need clearing
+struct SearchScratch
+{
+	std::vector<uint32_t> marks;
+	uint32_t epoch;
+
+	SearchScratch()
+		: epoch(0)
+	{
+	}
+};
+
+typedef std::pair<float, uint32_t> Candidate;
+
+// hierarchical navigable small world graph over fixed-size vectors
+class HnswIndex
+{
+public:
+	HnswIndex(const float* pVectors, size_t count, size_t dimensions)
+		: m_pVectors(pVectors), m_count(count), m_dimensions(dimensions), m_entry(0), m_topLevel(0)
+	{
+		std::mt19937 generator(7);
+		std::uniform_real_distribution<double> uniform(1e-12, 1.0);
+		double levelScale = 1.0 / std::log(static_cast<double>(GRAPH_DEGREE));
+
+		m_links.resize(count);
+		SearchScratch scratch;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t level = static_cast<size_t>(-std::log(uniform(generator)) * levelScale);
+			m_links[i].resize(level + 1);
+			if (i == 0)
+			{
+				m_topLevel = level;
+				continue;
+			}
+			Insert(static_cast<uint32_t>(i), level, scratch);
+		}
+	}
+
+	// k nearest vectors to a query, nearest first
+	void Search(const float* pQuery, size_t k, size_t ef, SearchScratch& scratch, std::vector<Candidate>& result) const
+	{
+		uint32_t entry = m_entry;
+		float entryDistance = Distance(pQuery, entry);
+		for (size_t level = m_topLevel; level > 0; level--)
+			Greedy(pQuery, level, entry, entryDistance);
+
+		SearchLayer(pQuery, entry, entryDistance, 0, std::max(ef, k), scratch, result);
+		if (result.size() > k)
+			result.resize(k);
+	}
+
+	size_t TopLevel() const
+	{
+		return m_topLevel;
+	}
+
+	size_t NumLinks() const
+	{
+		size_t links = 0;
+		for (size_t i = 0; i < m_count; i++)
+			for (size_t l = 0; l < m_links[i].size(); l++)
+				links += m_links[i][l].size();
+		return links;
+	}
+
+private:
+	float Distance(const float* pQuery, uint32_t node) const
+	{
+		return SquaredDistance(pQuery, m_pVectors + node * m_dimensions, m_dimensions);
+	}
+
+	size_t MaxDegree(size_t level) const
+	{
+		return level == 0 ? 2 * GRAPH_DEGREE : GRAPH_DEGREE;
+	}
+
+	// moves to the closest neighbour until no neighbour is closer
+	void Greedy(const float* pQuery, size_t level, uint32_t& entry, float& entryDistance) const
+	{
+		bool moved = true;
+		while (moved)
+		{
+			moved = false;
+			const std::vector<uint32_t>& neighbours = m_links[entry][level];
+			for (size_t i = 0; i < neighbours.size(); i++)
+			{
+				float d = Distance(pQuery, neighbours[i]);
+				if (d < entryDistance)
+				{
+					entryDistance = d;
+					entry = neighbours[i];
+					moved = true;
+				}
+			}
+		}
+	}
+
+	// best-first search of one level keeping the ef closest; result sorted
+	//    nearest first
+	void SearchLayer(const float* pQuery, uint32_t entry, float entryDistance, size_t level, size_t ef, SearchScratch& scratch, std::vector<Candidate>& result) const
+	{
+		if (scratch.marks.size() != m_count)
+		{
+			scratch.marks.assign(m_count, 0);
+			scratch.epoch = 0;
+		}
+		if (++scratch.epoch == 0)
+		{
+			std::fill(scratch.marks.begin(), scratch.marks.end(), 0);
+			scratch.epoch = 1;
+		}
+
+		// candidates: nearest on top; found: farthest on top
+		std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate> > candidates;
+		std::priority_queue<Candidate> found;
+		candidates.push(Candidate(entryDistance, entry));
+		found.push(Candidate(entryDistance, entry));
+		scratch.marks[entry] = scratch.epoch;
+
+		while (!candidates.empty())
+		{
+			Candidate current = candidates.top();
+			if (current.first > found.top().first && found.size() >= ef)
+				break;
+			candidates.pop();
+
+			const std::vector<uint32_t>& neighbours = m_links[current.second][level];
+			for (size_t i = 0; i < neighbours.size(); i++)
+			{
+				uint32_t node = neighbours[i];
+				if (scratch.marks[node] == scratch.epoch)
+					continue;
+				scratch.marks[node] = scratch.epoch;
+
+				float d = Distance(pQuery, node);
+				if (found.size() < ef || d < found.top().first)
+				{
+					candidates.push(Candidate(d, node));
+					found.push(Candidate(d, node));
+					if (found.size() > ef)
+						found.pop();
+				}
+			}
+		}
+
+		result.resize(found.size());
+		for (size_t i = result.size(); i > 0; i--)
+		{
+			result[i - 1] = found.top();
+			found.pop();
+		}
+	}
+
+	// neighbour selection heuristic: keeps a candidate only if it is closer
+	//    to the node than to every neighbour kept so far, which spreads links
+	//    across clusters; fills up with the closest rejected candidates
+	void SelectNeighbours(const std::vector<Candidate>& sorted, size_t maxDegree, std::vector<uint32_t>& selected) const
+	{
+		selected.clear();
+		std::vector<uint32_t> rejected;
+		for (size_t i = 0; i < sorted.size() && selected.size() < maxDegree; i++)
+		{
+			const float* pCandidate = m_pVectors + sorted[i].second * m_dimensions;
+			bool keep = true;
+			for (size_t j = 0; j < selected.size() && keep; j++)
+				if (Distance(pCandidate, selected[j]) < sorted[i].first)
+					keep = false;
+			if (keep)
+				selected.push_back(sorted[i].second);
+			else
+				rejected.push_back(sorted[i].second);
+		}
+		for (size_t i = 0; i < rejected.size() && selected.size() < maxDegree; i++)
+			selected.push_back(rejected[i]);
+	}
+
+	void Insert(uint32_t node, size_t level, SearchScratch& scratch)
+	{
+		const float* pVector = m_pVectors + node * m_dimensions;
+		uint32_t entry = m_entry;
+		float entryDistance = Distance(pVector, entry);
+		for (size_t l = m_topLevel; l > level; l--)
+			Greedy(pVector, l, entry, entryDistance);
+
+		std::vector<Candidate> found;
+		std::vector<uint32_t> selected;
+		for (size_t l = std::min(level, m_topLevel) + 1; l-- > 0;)
+		{
+			SearchLayer(pVector, entry, entryDistance, l, EF_CONSTRUCTION, scratch, found);
+			SelectNeighbours(found, GRAPH_DEGREE, selected);
+			m_links[node][l] = selected;
+
+			// link back, pruning neighbours that grow past the maximum degree
+			for (size_t i = 0; i < selected.size(); i++)
+			{
+				std::vector<uint32_t>& back = m_links[selected[i]][l];
+				back.push_back(node);
+				if (back.size() > MaxDegree(l))
+				{
+					const float* pNeighbour = m_pVectors + selected[i] * m_dimensions;
+					std::vector<Candidate> sorted(back.size());
+					for (size_t j = 0; j < back.size(); j++)
+						sorted[j] = Candidate(Distance(pNeighbour, back[j]), back[j]);
+					std::sort(sorted.begin(), sorted.end());
+					SelectNeighbours(sorted, MaxDegree(l), back);
+				}
+			}
+
+			entry = found[0].second;
+			entryDistance = found[0].first;
+		}
+
+		if (level > m_topLevel)
+		{
+			m_topLevel = level;
+			m_entry = node;
+		}
+	}
+
+	const float* m_pVectors;
+	size_t m_count;
+	size_t m_dimensions;
+	uint32_t m_entry;
+	size_t m_topLevel;
+	std::vector<std::vector<std::vector<uint32_t> > > m_links;
+};
+
+// index over a library: reduced vectors and their graph
+struct SpectralMatcher
+{
+	const SpectralLibrary* pLibrary;
+	ReducedSpace space;
+	std::vector<float> reduced;
+	std::unique_ptr<HnswIndex> pIndex;
+
+	void Build(const SpectralLibrary& library)
+	{
+		pLibrary = &library;
+		space.Build(library);
+
+		std::vector<float> centered(library.stride);
+		reduced.resize(library.Size() * space.dimensions);
+		for (size_t i = 0; i < library.Size(); i++)
+			space.Project(library.Spectrum(i), centered.data(), &reduced[i * space.dimensions]);
+
+		pIndex.reset(new HnswIndex(reduced.data(), library.Size(), space.dimensions));
+	}
+};
+
+// label of a pixel; entry is -1 for unknown
+struct Match
+{
+	int entry;
+	float angle;
+};
+
+// matches one line (bands x samples) as a batch: samples [first, last)
+void MatchSamples(const SpectralMatcher& matcher, const std::vector<float>& line, size_t numSamples, size_t first, size_t last, std::vector<Match>* pMatches)
+{
+	const SpectralLibrary& library = *matcher.pLibrary;
+	std::vector<float> spectrum(library.stride, 0.0f);
+	std::vector<float> centered(library.stride);
+	std::vector<float> query(matcher.space.dimensions);
+	std::vector<Candidate> candidates;
+	SearchScratch scratch;
+
+	for (size_t s = first; s < last; s++)
+	{
+		Match& match = (*pMatches)[s];
+		match.entry = -1;
+		match.angle = static_cast<float>(M_PI / 2);
+
+		for (size_t b = 0; b < library.numBands; b++)
+			spectrum[b] = line[b * numSamples + s];
+		if (!Normalize(spectrum.data(), library.stride))
+			continue;
+
+		matcher.space.Project(spectrum.data(), centered.data(), query.data());
+		matcher.pIndex->Search(query.data(), RERANK_CANDIDATES, EF_SEARCH, scratch, candidates);
+
+		// rerank by exact angle
+		float bestCosine = -2.0f;
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			float cosine = Dot(spectrum.data(), library.Spectrum(candidates[i].second), library.stride);
+			if (cosine > bestCosine)
+			{
+				bestCosine = cosine;
+				match.entry = static_cast<int>(candidates[i].second);
+			}
+		}
+		match.angle = std::acos(std::min(1.0f, std::max(-1.0f, bestCosine)));
+		if (match.angle > MAX_ANGLE)
+			match.entry = -1;
+	}
+}
+
+// Match pool
+//    Persistent worker threads matching one line at a time. The calling
+//    thread matches the first slice itself and waits for the others, so a
+//    line costs two wakeups instead of creating and joining threads.
+class MatchPool
+{
+public:
+	MatchPool(size_t numThreads) :
+		m_numThreads(std::max<size_t>(1, numThreads)),
+		m_generation(0),
+		m_pending(0),
+		m_stop(false),
+		m_pMatcher(NULL),
+		m_pLine(NULL),
+		m_numSamples(0),
+		m_pMatches(NULL)
+	{
+		for (size_t t = 1; t < m_numThreads; t++)
+			m_workers.push_back(std::thread(&MatchPool::Work, this, t));
+	}
+
+	~MatchPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_stop = true;
+		}
+		m_start.notify_all();
+		for (size_t t = 0; t < m_workers.size(); t++)
+			m_workers[t].join();
+	}
+
+	// matches one line and returns when every slice is done
+	void MatchLine(const SpectralMatcher& matcher, const std::vector<float>& line, size_t numSamples, std::vector<Match>& matches)
+	{
+		matches.resize(numSamples);
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_pMatcher = &matcher;
+			m_pLine = &line;
+			m_numSamples = numSamples;
+			m_pMatches = &matches;
+			m_pending = m_workers.size();
+			m_generation++;
+		}
+		m_start.notify_all();
+
+		MatchSlice(0);
+
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_done.wait(lock, [this]() { return m_pending == 0; });
+	}
+
+private:
+	void MatchSlice(size_t t)
+	{
+		size_t perThread = (m_numSamples + m_numThreads - 1) / m_numThreads;
+		size_t first = std::min(m_numSamples, t * perThread);
+		size_t last = std::min(m_numSamples, first + perThread);
+		MatchSamples(*m_pMatcher, *m_pLine, m_numSamples, first, last, m_pMatches);
+	}
+
+	void Work(size_t t)
+	{
+		uint64_t seen = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_start.wait(lock, [&]() { return m_stop || m_generation != seen; });
+				if (m_stop)
+					return;
+				seen = m_generation;
+			}
+
+			MatchSlice(t);
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (--m_pending == 0)
+				m_done.notify_one();
+		}
+	}
+
+	size_t m_numThreads;
+	std::vector<std::thread> m_workers;
+	std::mutex m_lock;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	uint64_t m_generation;
+	size_t m_pending;
+	bool m_stop;
+
+	// line being matched, valid while m_pending is above zero
+	const SpectralMatcher* m_pMatcher;
+	const std::vector<float>* m_pLine;
+	size_t m_numSamples;
+	std::vector<Match>* m_pMatches;
+};
+
+// exact best angle over the whole library
+Match MatchBruteForce(const SpectralLibrary& library, const std::vector<float>& line, size_t numSamples, size_t s)
+{
+	Match match = { -1, static_cast<float>(M_PI / 2) };
+	std::vector<float> spectrum(library.stride, 0.0f);
+	for (size_t b = 0; b < library.numBands; b++)
+		spectrum[b] = line[b * numSamples + s];
+	if (!Normalize(spectrum.data(), library.stride))
+		return match;
+
+	float bestCosine = -2.0f;
+	for (size_t i = 0; i < library.Size(); i++)
+	{
+		float cosine = Dot(spectrum.data(), library.Spectrum(i), library.stride);
+		if (cosine > bestCosine)
+		{
+			bestCosine = cosine;
+			match.entry = static_cast<int>(i);
+		}
+	}
+	match.angle = std::acos(std::min(1.0f, std::max(-1.0f, bestCosine)));
+	if (match.angle > MAX_ANGLE)
+		match.entry = -1;
+	return match;
+}
+
+// averages SPECTRAL_BINNING sensor columns of each row into the bands of
+//    that row's sample; the line is stored band by band
+void BinLine(const uint16_t* pFrame, size_t numRows, size_t numColumns, std::vector<float>& line)
+{
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	line.resize(numBands * numRows);
+	for (size_t s = 0; s < numRows; s++)
+	{
+		const uint16_t* pSrc = pFrame + s * numColumns;
+		for (size_t b = 0; b < numBands; b++)
+		{
+			uint32_t sum = 0;
+			for (size_t c = 0; c < SPECTRAL_BINNING; c++)
+				sum += pSrc[b * SPECTRAL_BINNING + c];
+			line[b * numRows + s] = static_cast<float>(sum);
+		}
+	}
+}
+
+// demonstrates real-time spectral matching
+// (1) loads or generates the library at the band centers
+// (2) reduces it with PCA and builds the graph index
+// (3) matches every acquired line as a batch
+// (4) compares a sample of pixels with brute-force SAM
+// (5) reports throughput and the most frequent labels
+void MatchSpectra(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	size_t numColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	if (numBands < 4)
+		throw GenICam::GenericException("Frame too small", __FILE__, __LINE__);
+
+	// load library
+	SpectralLibrary library;
+	library.numBands = numBands;
+	library.stride = RoundUp4(numBands);
+	if (LoadLibrary(LIBRARY_FILE, library))
+		std::cout << TAB1 << "Load " << library.Size() << " spectra from " << LIBRARY_FILE << "\n";
+	else
+	{
+		GenerateSyntheticLibrary(NUM_SYNTHETIC_ENTRIES, library);
+		std::cout << TAB1 << "Generate " << library.Size() << " synthetic spectra (no " << LIBRARY_FILE << ")\n";
+	}
+	if (library.Size() == 0)
+		throw GenICam::GenericException("Spectral library is empty", __FILE__, __LINE__);
+
+	// build index
+	std::cout << TAB1 << "Build index\n";
+
+	SpectralMatcher matcher;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	matcher.Build(library);
+	double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << TAB2 << numBands << " bands reduced to " << matcher.space.dimensions << " (" << matcher.space.retained * 100.0 << "% of library variance)\n";
+	std::cout << TAB2 << matcher.pIndex->TopLevel() + 1 << " levels, " << matcher.pIndex->NumLinks() << " links, built in " << buildSeconds * 1000.0 << " ms\n";
+
+	// acquire and match
+	std::cout << TAB1 << "Acquire and match " << NUM_LINES << " lines\n";
+
+	std::vector<float> line;
+	std::vector<Match> matches;
+	MatchPool pool(NUM_THREADS > 0 ? NUM_THREADS : std::thread::hardware_concurrency());
+	std::map<int, size_t> counts;
+	size_t numPixels = 0;
+	size_t checked = 0;
+	size_t agreed = 0;
+	double matchSeconds = 0.0;
+	double bruteSeconds = 0.0;
+
+	pDevice->StartStream();
+	for (size_t i = 0; i < NUM_LINES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->GetWidth() != numColumns)
+		{
+			pDevice->RequeueBuffer(pImage);
+			pDevice->StopStream();
+			throw GenICam::GenericException("Unexpected image width", __FILE__, __LINE__);
+		}
+		Arena::IImage* pMono16 = Arena::ImageFactory::Convert(pImage, Mono16);
+		size_t numSamples = pMono16->GetHeight();
+		BinLine(reinterpret_cast<const uint16_t*>(pMono16->GetData()), numSamples, numColumns, line);
+		Arena::ImageFactory::Destroy(pMono16);
+		pDevice->RequeueBuffer(pImage);
+
+		start = std::chrono::steady_clock::now();
+		pool.MatchLine(matcher, line, numSamples, matches);
+		matchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		numPixels += numSamples;
+
+		for (size_t s = 0; s < numSamples; s++)
+			counts[matches[s].entry]++;
+
+		// brute force on a sample of pixels
+		start = std::chrono::steady_clock::now();
+		for (size_t k = 0; k < NUM_CHECK_PIXELS && k < numSamples; k++)
+		{
+			size_t s = (k * 7919 + i * 104729) % numSamples;
+			Match exact = MatchBruteForce(library, line, numSamples, s);
+			checked++;
+			if (exact.entry == matches[s].entry)
+				agreed++;
+		}
+		bruteSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	pDevice->StopStream();
+
+	std::cout << TAB2 << "index: " << numPixels / matchSeconds << " pixels/s (" << matchSeconds * 1000.0 / NUM_LINES << " ms per line)\n";
+	std::cout << TAB2 << "brute force: " << checked / bruteSeconds << " pixels/s on one thread\n";
+	std::cout << TAB2 << "agreement with brute force: " << 100.0 * agreed / std::max<size_t>(checked, 1) << "% of " << checked << " pixels\n";
+
+	// most frequent labels
+	std::vector<std::pair<size_t, int> > ranked;
+	for (std::map<int, size_t>::const_iterator it = counts.begin(); it != counts.end(); ++it)
+		ranked.push_back(std::make_pair(it->second, it->first));
+	std::sort(ranked.rbegin(), ranked.rend());
+
+	std::cout << TAB1 << "Most frequent labels\n";
+	for (size_t i = 0; i < ranked.size() && i < 5; i++)
+		std::cout << TAB2 << (ranked[i].second < 0 ? std::string("unknown") : library.names[ranked[i].second]) << ": " << 100.0 * ranked[i].first / numPixels << "%\n";
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_SpectralMatcher\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		MatchSpectra(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
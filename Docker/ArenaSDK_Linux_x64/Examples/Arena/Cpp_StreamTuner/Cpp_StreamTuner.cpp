@@ -0,0 +1,635 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Stream Tuner
+//    This example finds stream settings that suit the host it runs on and
+//    saves them as a profile. The number of buffers, the stream channel
+//    packet size ('DeviceStreamChannelPacketSize'), the packet delay
+//    ('GevSCPD') and the buffer handling mode depend on the network adapter,
+//    its driver settings and the CPU. Tuning them by hand is trial and error.
+//    The tuner runs a short stream for each candidate setting and measures
+//    three things: the fraction of frames the application did not receive
+//    complete, the process CPU usage, and the latency from the device
+//    timestamp to the application. It sweeps one parameter at a time and
+//    keeps the best value before moving to the next. The frame rate is fixed
+//    for all trials, so a setting cannot save CPU by slowing the stream down.
+//    A profile is acceptable if it drops at most MAX_DROP_RATE of frames and
+//    delivers at least the baseline frame rate. Among acceptable profiles,
+//    the one using clearly less CPU wins, and otherwise the one with the
+//    lower 99th percentile latency. The best profile is written to
+//    PROFILE_FILE along with the host, the device, the image format and the
+//    frame rate it was tuned for. On the next run on the same host, device
+//    and format, the profile is applied and verified with a single stream
+//    instead of tuned again. Applications read the same file at startup.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// duration of each trial stream (in seconds)
+#define TRIAL_SECONDS 2.0
+
+// images discarded at the start of each trial stream
+#define WARMUP_IMAGES 10
+
+// image timeout within a trial; a setting that delivers nothing times out
+// until the trial ends
+#define TRIAL_TIMEOUT 500
+
+// simulated application work per image (in microseconds); set it to the
+// application's processing time so that the number of buffers is tuned for it
+#define PROCESSING_TIME_US 0
+
+// highest acceptable fraction of dropped frames
+#define MAX_DROP_RATE 0.0005
+
+// CPU usage difference (in fractions of a core) below which two profiles
+// count as equal and latency decides
+#define CPU_TOLERANCE 0.02
+
+// frame rate fixed for all trials (in frames per second); 0 keeps the
+// device's current frame rate
+#define TRIAL_FRAME_RATE 0.0
+
+// fraction of the baseline frame rate a trial may fall short by, for
+// measurement noise, before it is rejected
+#define FPS_TOLERANCE 0.01
+
+// profile file
+#define PROFILE_FILE "Cpp_StreamTuner.profile"
+
+// tune even if the profile file matches this host, device and format
+#define RETUNE false
+
+// timeout for detecting camera devices (in milliseconds)
+#define SYSTEM_TIMEOUT 100
+
+// candidate packet sizes (in bytes); sizes above the adapter's MTU deliver
+// nothing and are rejected by the measurement
+static const int64_t PACKET_SIZES[] = { 1500, 4000, 8000, 9000 };
+
+// candidate packet delays (in GevSCPD units)
+static const int64_t PACKET_DELAYS[] = { 0, 5000, 20000, 80000 };
+
+// candidate numbers of buffers
+static const int64_t NUM_BUFFERS[] = { 10, 30, 100, 300 };
+
+// candidate buffer handling modes
+static const char* const BUFFER_HANDLING_MODES[] = { "OldestFirst", "NewestOnly" };
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPERS =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// stream settings
+struct StreamProfile
+{
+	int64_t numBuffers = 10;
+	int64_t packetSize = 1500;
+	int64_t packetDelay = 0;
+	std::string bufferHandlingMode = "OldestFirst";
+};
+
+// what a profile is tuned for
+struct ProfileKey
+{
+	std::string host;
+	std::string serialNumber;
+	int64_t width = 0;
+	int64_t height = 0;
+	std::string pixelFormat;
+	double frameRate = 0.0;
+
+	bool operator==(const ProfileKey& other) const
+	{
+		return host == other.host && serialNumber == other.serialNumber && width == other.width && height == other.height && pixelFormat == other.pixelFormat && std::abs(frameRate - other.frameRate) <= 0.001 * frameRate;
+	}
+};
+
+// measurements of one trial stream
+struct TrialResult
+{
+	size_t received = 0;
+	size_t complete = 0;
+	size_t expected = 0;
+	size_t timeouts = 0;
+	double dropRate = 1.0;
+	double cpu = 0.0;
+	double fps = 0.0; // complete frames per second
+	bool hasLatency = false;
+	double latencyMedianMs = 0.0;
+	double latencyP99Ms = 0.0;
+};
+
+// sets integer value safely
+// (1) ensures increment
+// (2) ensures over minimum
+// (3) ensures below maximum
+// (4) sets value
+int64_t SetIntValue(GenApi::INodeMap* pNodeMap, const char* nodeName, int64_t value)
+{
+	// get node
+	GenApi::CIntegerPtr pInteger = pNodeMap->GetNode(nodeName);
+
+	// ensure increment
+	value = (((value - pInteger->GetMin()) / pInteger->GetInc()) * pInteger->GetInc()) + pInteger->GetMin();
+
+	// check min/max values
+	if (value < pInteger->GetMin())
+	{
+		value = pInteger->GetMin();
+	}
+
+	if (value > pInteger->GetMax())
+	{
+		value = pInteger->GetMax();
+	}
+
+	// set value
+	pInteger->SetValue(value);
+
+	// return value for output
+	return value;
+}
+
+// host monotonic time (in nanoseconds)
+int64_t HostNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// process CPU time, user and system, of all threads (in seconds)
+double ProcessCpuSeconds()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Device clock offset
+//    Latches the device timestamp between two host clock readings, so that
+//    image timestamps convert to host time. Returns false if the device has
+//    no timestamp latch.
+bool GetDeviceClockOffset(GenApi::INodeMap* pNodeMap, int64_t& offsetNs)
+{
+	GenApi::CCommandPtr pLatch = pNodeMap->GetNode("TimestampLatch");
+	GenApi::CIntegerPtr pLatchValue = pNodeMap->GetNode("TimestampLatchValue");
+	if (!pLatch || !pLatchValue || !GenApi::IsWritable(pLatch) || !GenApi::IsReadable(pLatchValue))
+		return false;
+
+	int64_t before = HostNs();
+	pLatch->Execute();
+	int64_t after = HostNs();
+	offsetNs = before + (after - before) / 2 - pLatchValue->GetValue();
+	return true;
+}
+
+// percentile of a sorted list
+double Percentile(const std::vector<double>& sorted, double fraction)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+// whether a trial drops few enough frames and keeps up with the baseline
+//    frame rate
+bool IsAcceptable(const TrialResult& result, double minFps)
+{
+	return result.dropRate <= MAX_DROP_RATE && result.fps >= minFps;
+}
+
+// whether trial a is better than trial b; trials run at the same frame rate,
+//    so CPU usage compares the cost of the same frames
+bool IsBetter(const TrialResult& a, const TrialResult& b, double minFps)
+{
+	bool aAcceptable = IsAcceptable(a, minFps);
+	bool bAcceptable = IsAcceptable(b, minFps);
+	if (aAcceptable != bAcceptable)
+		return aAcceptable;
+	if (!aAcceptable)
+		return a.dropRate != b.dropRate ? a.dropRate < b.dropRate : a.fps > b.fps;
+	if (std::abs(a.cpu - b.cpu) > CPU_TOLERANCE)
+		return a.cpu < b.cpu;
+	if (a.hasLatency && b.hasLatency)
+		return a.latencyP99Ms < b.latencyP99Ms;
+	return a.dropRate < b.dropRate;
+}
+
+// describes a profile on one line
+std::string Describe(const StreamProfile& profile)
+{
+	std::ostringstream ss;
+	ss << profile.numBuffers << " buffers, packet size " << profile.packetSize << ", delay " << profile.packetDelay << ", " << profile.bufferHandlingMode;
+	return ss.str();
+}
+
+// describes a trial on one line
+std::string Describe(const TrialResult& result)
+{
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(2);
+	ss << "drop " << 100.0 * result.dropRate << "%, CPU " << 100.0 * result.cpu << "%, " << result.fps << " fps";
+	if (result.hasLatency)
+		ss << ", latency " << result.latencyMedianMs << "/" << result.latencyP99Ms << " ms (median/p99)";
+	return ss.str();
+}
+
+// writes a profile as 'key = value' lines
+void WriteProfile(const char* fileName, const ProfileKey& key, const StreamProfile& profile, const TrialResult& result)
+{
+	std::ofstream file(fileName);
+	if (!file)
+		throw GenICam::GenericException((std::string("could not write ") + fileName).c_str(), __FILE__, __LINE__);
+
+	file << "# stream profile written by Cpp_StreamTuner\n";
+	file << "host = " << key.host << "\n";
+	file << "serialNumber = " << key.serialNumber << "\n";
+	file << "width = " << key.width << "\n";
+	file << "height = " << key.height << "\n";
+	file << "pixelFormat = " << key.pixelFormat << "\n";
+	file << "frameRate = " << key.frameRate << "\n";
+	file << "numBuffers = " << profile.numBuffers << "\n";
+	file << "packetSize = " << profile.packetSize << "\n";
+	file << "packetDelay = " << profile.packetDelay << "\n";
+	file << "bufferHandlingMode = " << profile.bufferHandlingMode << "\n";
+	file << "# measured: " << Describe(result) << "\n";
+}
+
+// reads a profile; returns false if there is no readable profile
+bool ReadProfile(const char* fileName, ProfileKey& key, StreamProfile& profile)
+{
+	std::ifstream file(fileName);
+	if (!file)
+		return false;
+
+	std::string line;
+	size_t fields = 0;
+	while (std::getline(file, line))
+	{
+		size_t equals = line.find('=');
+		if (line.empty() || line[0] == '#' || equals == std::string::npos)
+			continue;
+
+		std::string name = line.substr(0, line.find_last_not_of(" \t", equals - 1) + 1);
+		std::string value = line.substr(std::min(line.find_first_not_of(" \t", equals + 1), line.size()));
+
+		if (name == "host")
+			key.host = value;
+		else if (name == "serialNumber")
+			key.serialNumber = value;
+		else if (name == "width")
+			key.width = std::atoll(value.c_str());
+		else if (name == "height")
+			key.height = std::atoll(value.c_str());
+		else if (name == "pixelFormat")
+			key.pixelFormat = value;
+		else if (name == "frameRate")
+			key.frameRate = std::atof(value.c_str());
+		else if (name == "numBuffers")
+			profile.numBuffers = std::atoll(value.c_str());
+		else if (name == "packetSize")
+			profile.packetSize = std::atoll(value.c_str());
+		else if (name == "packetDelay")
+			profile.packetDelay = std::atoll(value.c_str());
+		else if (name == "bufferHandlingMode")
+			profile.bufferHandlingMode = value;
+		else
+			continue;
+		fields++;
+	}
+	return fields == 10;
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// applies a profile and returns the values the device accepted
+StreamProfile ApplyProfile(Arena::IDevice* pDevice, const StreamProfile& profile)
+{
+	StreamProfile applied = profile;
+
+	applied.packetSize = SetIntValue(pDevice->GetNodeMap(), "DeviceStreamChannelPacketSize", profile.packetSize);
+	applied.packetDelay = SetIntValue(pDevice->GetNodeMap(), "GevSCPD", profile.packetDelay);
+	Arena::SetNodeValue<GenICam::gcstring>(pDevice->GetTLStreamNodeMap(), "StreamBufferHandlingMode", profile.bufferHandlingMode.c_str());
+	return applied;
+}
+
+// runs a trial stream with the current settings
+// (1) measures the device clock offset
+// (2) starts the stream and discards warm-up images
+// (3) receives images until the trial time is up
+// (4) computes drop rate from frame IDs, CPU usage and latency
+TrialResult RunTrial(Arena::IDevice* pDevice, const StreamProfile& profile)
+{
+	TrialResult result;
+	int64_t offsetNs = 0;
+	result.hasLatency = GetDeviceClockOffset(pDevice->GetNodeMap(), offsetNs);
+
+	pDevice->StartStream(static_cast<size_t>(profile.numBuffers));
+
+	for (int i = 0; i < WARMUP_IMAGES; i++)
+	{
+		try
+		{
+			pDevice->RequeueBuffer(pDevice->GetImage(TRIAL_TIMEOUT));
+		}
+		catch (GenICam::TimeoutException&)
+		{
+			break;
+		}
+	}
+
+	std::vector<double> latenciesMs;
+	uint64_t lastFrameId = 0;
+	uint64_t frameIdSpan = 0;
+
+	double cpuStart = ProcessCpuSeconds();
+	auto start = std::chrono::steady_clock::now();
+	auto end = start + std::chrono::duration<double>(TRIAL_SECONDS);
+	while (std::chrono::steady_clock::now() < end)
+	{
+		Arena::IImage* pImage = nullptr;
+		try
+		{
+			pImage = pDevice->GetImage(TRIAL_TIMEOUT);
+		}
+		catch (GenICam::TimeoutException&)
+		{
+			result.timeouts++;
+			continue;
+		}
+
+		int64_t receivedNs = HostNs();
+		uint64_t frameId = pImage->GetFrameId();
+		if (result.received > 0 && frameId > lastFrameId)
+			frameIdSpan += frameId - lastFrameId;
+		else if (result.received > 0)
+			frameIdSpan += frameId + 0xFFFF - lastFrameId;	// 16-bit block IDs wrap to 1
+		lastFrameId = frameId;
+
+		result.received++;
+		if (!pImage->IsIncomplete())
+			result.complete++;
+		if (result.hasLatency)
+			latenciesMs.push_back((receivedNs - (static_cast<int64_t>(pImage->GetTimestampNs()) + offsetNs)) / 1e6);
+
+		if (PROCESSING_TIME_US > 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(PROCESSING_TIME_US));
+
+		pDevice->RequeueBuffer(pImage);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.cpu = (ProcessCpuSeconds() - cpuStart) / seconds;
+
+	pDevice->StopStream();
+
+	// Compute drop rate
+	//    Every frame the device sent advanced the frame ID, so the span of
+	//    frame IDs is the number of frames the application should have
+	//    received. Frames lost in transport, lost for lack of buffers or
+	//    skipped by 'NewestOnly' all count as dropped.
+	result.expected = result.received > 0 ? static_cast<size_t>(frameIdSpan) + 1 : 0;
+	result.dropRate = result.expected > 0 ? 1.0 - static_cast<double>(result.complete) / result.expected : 1.0;
+	result.fps = result.complete / seconds;
+
+	std::sort(latenciesMs.begin(), latenciesMs.end());
+	result.hasLatency = !latenciesMs.empty();
+	result.latencyMedianMs = Percentile(latenciesMs, 0.5);
+	result.latencyP99Ms = Percentile(latenciesMs, 0.99);
+	return result;
+}
+
+// runs a trial for each candidate of one parameter and keeps the best;
+//    candidates slower than minFps are rejected
+template <typename T>
+void SweepParameter(Arena::IDevice* pDevice, const char* name, const T* candidates, size_t numCandidates, T StreamProfile::*field, double minFps, StreamProfile& best, TrialResult& bestResult)
+{
+	std::cout << TAB1 << "Sweep " << name << "\n";
+
+	for (size_t i = 0; i < numCandidates; i++)
+	{
+		StreamProfile profile = best;
+		profile.*field = candidates[i];
+		profile = ApplyProfile(pDevice, profile);
+
+		// clamping can turn two candidates into the same value
+		if (profile.*field == best.*field && bestResult.expected > 0)
+			continue;
+
+		TrialResult result = RunTrial(pDevice, profile);
+		std::cout << TAB2 << Describe(profile) << ": " << Describe(result) << "\n";
+
+		if (IsBetter(result, bestResult, minFps))
+		{
+			best = profile;
+			bestResult = result;
+		}
+	}
+
+	std::cout << TAB2 << "keep " << Describe(best) << "\n";
+}
+
+// demonstrates tuning stream settings
+// (1) reads the profile and applies it if it matches this host, device and
+//     format
+// (2) otherwise sweeps packet size, packet delay, number of buffers and
+//     buffer handling mode in turn
+// (3) writes the best profile
+// (4) restores settings
+void TuneStream(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+	GenApi::INodeMap* pTLStreamNodeMap = pDevice->GetTLStreamNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring acquisitionModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode");
+	int64_t packetSizeInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize");
+	int64_t packetDelayInitial = Arena::GetNodeValue<int64_t>(pNodeMap, "GevSCPD");
+	GenICam::gcstring bufferHandlingModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pTLStreamNodeMap, "StreamBufferHandlingMode");
+	bool autoNegotiateInitial = Arena::GetNodeValue<bool>(pTLStreamNodeMap, "StreamAutoNegotiatePacketSize");
+	bool frameRateEnableInitial = Arena::GetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable");
+	double frameRateInitial = Arena::GetNodeValue<double>(pNodeMap, "AcquisitionFrameRate");
+
+	// Prepare
+	//    The tuner sets the packet size itself, so auto negotiation is turned
+	//    off. Packet resend stays on; resent packets cost CPU and latency,
+	//    which the measurements include.
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", "Continuous");
+	Arena::SetNodeValue<bool>(pTLStreamNodeMap, "StreamAutoNegotiatePacketSize", false);
+	Arena::SetNodeValue<bool>(pTLStreamNodeMap, "StreamPacketResendEnable", true);
+
+	// Fix frame rate
+	//    Without a fixed frame rate, a long packet delay or a small packet
+	//    size lowers the frame rate and with it the CPU usage, and would win
+	//    by slowing the stream down.
+	Arena::SetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable", true);
+	GenApi::CFloatPtr pFrameRate = pNodeMap->GetNode("AcquisitionFrameRate");
+	double frameRate = TRIAL_FRAME_RATE > 0.0 ? TRIAL_FRAME_RATE : frameRateInitial;
+	frameRate = std::min(pFrameRate->GetMax(), std::max(pFrameRate->GetMin(), frameRate));
+	pFrameRate->SetValue(frameRate);
+
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+
+	ProfileKey key;
+	key.host = host;
+	key.serialNumber = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "DeviceSerialNumber").c_str();
+	key.width = Arena::GetNodeValue<int64_t>(pNodeMap, "Width");
+	key.height = Arena::GetNodeValue<int64_t>(pNodeMap, "Height");
+	key.pixelFormat = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat").c_str();
+	key.frameRate = pFrameRate->GetValue();
+
+	std::cout << TAB1 << "Tune for " << key.host << ", device " << key.serialNumber << ", " << key.width << "x" << key.height << " " << key.pixelFormat << " at " << key.frameRate << " fps\n";
+
+	// Reuse a matching profile
+	ProfileKey savedKey;
+	StreamProfile saved;
+	if (!RETUNE && ReadProfile(PROFILE_FILE, savedKey, saved) && savedKey == key)
+	{
+		std::cout << TAB1 << "Apply profile from " << PROFILE_FILE << "\n";
+
+		StreamProfile applied = ApplyProfile(pDevice, saved);
+		TrialResult result = RunTrial(pDevice, applied);
+		std::cout << TAB2 << Describe(applied) << ": " << Describe(result) << "\n";
+
+		if (result.dropRate > MAX_DROP_RATE)
+			std::cout << TAB2 << "profile no longer meets the drop rate limit; set RETUNE to tune again\n";
+	}
+	else
+	{
+		// Sweep
+		//    Packet size goes first because it sets the packet rate that the
+		//    delay, the buffers and the host must cope with.
+		StreamProfile best;
+		best.packetSize = packetSizeInitial;
+		best.packetDelay = packetDelayInitial;
+		best = ApplyProfile(pDevice, best);
+		TrialResult bestResult = RunTrial(pDevice, best);
+		std::cout << TAB1 << "Baseline\n";
+		std::cout << TAB2 << Describe(best) << ": " << Describe(bestResult) << "\n";
+
+		// candidates must deliver the frame rate the baseline delivered
+		double minFps = bestResult.fps * (1.0 - FPS_TOLERANCE);
+
+		SweepParameter(pDevice, "packet size", PACKET_SIZES, sizeof(PACKET_SIZES) / sizeof(PACKET_SIZES[0]), &StreamProfile::packetSize, minFps, best, bestResult);
+		SweepParameter(pDevice, "packet delay", PACKET_DELAYS, sizeof(PACKET_DELAYS) / sizeof(PACKET_DELAYS[0]), &StreamProfile::packetDelay, minFps, best, bestResult);
+		SweepParameter(pDevice, "number of buffers", NUM_BUFFERS, sizeof(NUM_BUFFERS) / sizeof(NUM_BUFFERS[0]), &StreamProfile::numBuffers, minFps, best, bestResult);
+
+		std::vector<std::string> modes(BUFFER_HANDLING_MODES, BUFFER_HANDLING_MODES + sizeof(BUFFER_HANDLING_MODES) / sizeof(BUFFER_HANDLING_MODES[0]));
+		SweepParameter(pDevice, "buffer handling mode", modes.data(), modes.size(), &StreamProfile::bufferHandlingMode, minFps, best, bestResult);
+
+		// Write profile
+		std::cout << TAB1 << "Best: " << Describe(best) << "\n";
+		std::cout << TAB2 << Describe(bestResult) << "\n";
+		if (!IsAcceptable(bestResult, minFps))
+			std::cout << TAB2 << "no candidate meets the drop rate limit at the baseline frame rate; check the adapter's MTU and receive buffers\n";
+
+		WriteProfile(PROFILE_FILE, key, best, bestResult);
+		std::cout << TAB1 << "Write " << PROFILE_FILE << "\n";
+	}
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<bool>(pTLStreamNodeMap, "StreamAutoNegotiatePacketSize", autoNegotiateInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pTLStreamNodeMap, "StreamBufferHandlingMode", bufferHandlingModeInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "GevSCPD", packetDelayInitial);
+	Arena::SetNodeValue<int64_t>(pNodeMap, "DeviceStreamChannelPacketSize", packetSizeInitial);
+	Arena::SetNodeValue<double>(pNodeMap, "AcquisitionFrameRate", frameRateInitial);
+	Arena::SetNodeValue<bool>(pNodeMap, "AcquisitionFrameRateEnable", frameRateEnableInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", acquisitionModeInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_StreamTuner\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(SYSTEM_TIMEOUT);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		TuneStream(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
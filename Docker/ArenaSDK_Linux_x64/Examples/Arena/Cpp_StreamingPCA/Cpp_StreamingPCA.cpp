@@ -0,0 +1,888 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Streaming PCA and MNF
+//    This example reduces a pushbroom stream from its spectral bands to a few
+//    principal components while scanning, instead of running PCA offline on a
+//    complete cube. Each frame is one line of the cube: rows run across track
+//    and columns along the spectrum, so every row is one spectrum. The band
+//    covariance is updated incrementally with a blocked SIMD rank-k update
+//    per line. For MNF (minimum noise fraction), the noise covariance is also
+//    updated, from differences between neighbouring samples. A worker thread
+//    periodically refreshes the eigenbasis from a snapshot of the statistics.
+//    The Jacobi solver is warm-started from the previous eigenvectors, so a
+//    refresh costs a sweep or two. Each line is projected onto the current
+//    basis as it arrives. The reduced lines are written to an ENVI BIL file,
+//    and every basis used goes to a sidecar file so the bands can be
+//    reconstructed later.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define TIMEOUT 2000
+
+// number of lines (images) acquired
+#define NUM_LINES 500
+
+// sensor columns averaged into one band before the covariance update; the
+//    spectral axis of a pushbroom frame runs along the image width
+#define SPECTRAL_BINNING 8
+
+// number of components kept
+#define NUM_COMPONENTS 16
+
+// true for MNF (components ordered by signal to noise), false for PCA
+//    (components ordered by variance)
+#define USE_MNF true
+
+// lines accumulated before the first basis, and lines between refreshes
+#define WARMUP_LINES 50
+#define REFRESH_INTERVAL 100
+
+// reduced stream (ENVI BIL, float32) and basis sidecar
+#define OUTPUT_FILE "Cpp_StreamingPCA.bil"
+#define HEADER_FILE "Cpp_StreamingPCA.hdr"
+#define BASIS_FILE "Cpp_StreamingPCA_basis.bin"
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// samples per block of the rank-k update; a block of all bands stays in cache
+#define UPDATE_BLOCK 256
+
+inline size_t RoundUp4(size_t n)
+{
+	return (n + 3) / 4 * 4;
+}
+
+// line of the cube as float bands x samples, both padded to multiples of 4
+//    with zeros, and offset by a per-band shift
+struct Line
+{
+	size_t numBands;
+	size_t numSamples;
+	size_t paddedBands;
+	size_t stride;
+	std::vector<float> data;
+
+	void Resize(size_t bands, size_t samples)
+	{
+		numBands = bands;
+		numSamples = samples;
+		paddedBands = RoundUp4(bands);
+		stride = RoundUp4(samples);
+		data.assign(paddedBands * stride, 0.0f);
+	}
+
+	float* Band(size_t band)
+	{
+		return &data[band * stride];
+	}
+
+	const float* Band(size_t band) const
+	{
+		return &data[band * stride];
+	}
+};
+
+// averages SPECTRAL_BINNING sensor columns into each band and subtracts the
+//    shift of the band; every row is one sample of the line
+void BinLine(const uint16_t* pFrame, size_t numRows, size_t numColumns, const std::vector<float>& shift, Line& line)
+{
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	if (line.numBands != numBands || line.numSamples != numRows)
+		line.Resize(numBands, numRows);
+
+	const float scale = 1.0f / SPECTRAL_BINNING;
+	for (size_t s = 0; s < numRows; s++)
+	{
+		const uint16_t* pRow = pFrame + s * numColumns;
+		for (size_t b = 0; b < numBands; b++)
+		{
+			const uint16_t* pColumns = pRow + b * SPECTRAL_BINNING;
+			size_t c = 0;
+			uint32_t sum = 0;
+#if defined(__SSE2__)
+			const __m128i zero = _mm_setzero_si128();
+			__m128i vSum = zero;
+			for (; c + 8 <= SPECTRAL_BINNING; c += 8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pColumns + c));
+				vSum = _mm_add_epi32(vSum, _mm_add_epi32(_mm_unpacklo_epi16(v, zero), _mm_unpackhi_epi16(v, zero)));
+			}
+			vSum = _mm_add_epi32(vSum, _mm_shuffle_epi32(vSum, _MM_SHUFFLE(1, 0, 3, 2)));
+			vSum = _mm_add_epi32(vSum, _mm_shuffle_epi32(vSum, _MM_SHUFFLE(2, 3, 0, 1)));
+			sum = static_cast<uint32_t>(_mm_cvtsi128_si32(vSum));
+#endif
+			for (; c < SPECTRAL_BINNING; c++)
+				sum += pColumns[c];
+			line.Band(b)[s] = static_cast<float>(sum) * scale - (shift.empty() ? 0.0f : shift[b]);
+		}
+	}
+}
+
+// differences between neighbouring samples, for the noise covariance
+void DifferenceLine(const Line& line, Line& difference)
+{
+	if (difference.numBands != line.numBands || difference.numSamples != line.numSamples)
+		difference.Resize(line.numBands, line.numSamples);
+
+	for (size_t b = 0; b < line.numBands; b++)
+	{
+		const float* pSrc = line.Band(b);
+		float* pDst = difference.Band(b);
+		for (size_t s = 0; s + 1 < line.numSamples; s++)
+			pDst[s] = pSrc[s + 1] - pSrc[s];
+	}
+}
+
+#if defined(__SSE2__)
+inline double HorizontalSum(__m128 v)
+{
+	__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2));
+	__m128 sums = _mm_add_ps(v, shuffled);
+	shuffled = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+#endif
+
+// scatter += X * X^T over the upper triangle in blocks of 2 x 4 bands; dot
+//    products run over UPDATE_BLOCK samples in float, then add into double
+void RankKUpdate(const Line& x, std::vector<double>& scatter)
+{
+	size_t n = x.paddedBands;
+	for (size_t k0 = 0; k0 < x.stride; k0 += UPDATE_BLOCK)
+	{
+		size_t k1 = std::min(x.stride, k0 + UPDATE_BLOCK);
+		for (size_t i = 0; i < n; i += 2)
+		{
+			const float* a0 = x.Band(i);
+			const float* a1 = x.Band(i + 1);
+			for (size_t j = i / 4 * 4; j < n; j += 4)
+			{
+				const float* b0 = x.Band(j);
+				const float* b1 = x.Band(j + 1);
+				const float* b2 = x.Band(j + 2);
+				const float* b3 = x.Band(j + 3);
+				double sums[2][4];
+#if defined(__SSE2__)
+				__m128 acc00 = _mm_setzero_ps(), acc01 = _mm_setzero_ps(), acc02 = _mm_setzero_ps(), acc03 = _mm_setzero_ps();
+				__m128 acc10 = _mm_setzero_ps(), acc11 = _mm_setzero_ps(), acc12 = _mm_setzero_ps(), acc13 = _mm_setzero_ps();
+				for (size_t k = k0; k < k1; k += 4)
+				{
+					__m128 va0 = _mm_loadu_ps(a0 + k);
+					__m128 va1 = _mm_loadu_ps(a1 + k);
+					__m128 vb = _mm_loadu_ps(b0 + k);
+					acc00 = _mm_add_ps(acc00, _mm_mul_ps(va0, vb));
+					acc10 = _mm_add_ps(acc10, _mm_mul_ps(va1, vb));
+					vb = _mm_loadu_ps(b1 + k);
+					acc01 = _mm_add_ps(acc01, _mm_mul_ps(va0, vb));
+					acc11 = _mm_add_ps(acc11, _mm_mul_ps(va1, vb));
+					vb = _mm_loadu_ps(b2 + k);
+					acc02 = _mm_add_ps(acc02, _mm_mul_ps(va0, vb));
+					acc12 = _mm_add_ps(acc12, _mm_mul_ps(va1, vb));
+					vb = _mm_loadu_ps(b3 + k);
+					acc03 = _mm_add_ps(acc03, _mm_mul_ps(va0, vb));
+					acc13 = _mm_add_ps(acc13, _mm_mul_ps(va1, vb));
+				}
+				sums[0][0] = HorizontalSum(acc00);
+				sums[0][1] = HorizontalSum(acc01);
+				sums[0][2] = HorizontalSum(acc02);
+				sums[0][3] = HorizontalSum(acc03);
+				sums[1][0] = HorizontalSum(acc10);
+				sums[1][1] = HorizontalSum(acc11);
+				sums[1][2] = HorizontalSum(acc12);
+				sums[1][3] = HorizontalSum(acc13);
+#else
+				const float* a[2] = { a0, a1 };
+				const float* b[4] = { b0, b1, b2, b3 };
+				for (size_t r = 0; r < 2; r++)
+				{
+					for (size_t c = 0; c < 4; c++)
+					{
+						float sum = 0.0f;
+						for (size_t k = k0; k < k1; k++)
+							sum += a[r][k] * b[c][k];
+						sums[r][c] = sum;
+					}
+				}
+#endif
+				for (size_t r = 0; r < 2; r++)
+					for (size_t c = 0; c < 4; c++)
+						scatter[(i + r) * n + j + c] += sums[r][c];
+			}
+		}
+	}
+}
+
+// band statistics accumulated line by line; all values are offset by the
+//    shift (the band means of the first line) to keep the sums well
+//    conditioned
+struct CovarianceStatistics
+{
+	size_t numBands;
+	size_t paddedBands;
+	std::vector<float> shift;
+
+	size_t count;
+	std::vector<double> sum;
+	std::vector<double> scatter;
+
+	size_t noiseCount;
+	std::vector<double> noiseScatter;
+};
+
+void AddLine(const Line& line, const Line& difference, CovarianceStatistics& stats)
+{
+	for (size_t b = 0; b < line.numBands; b++)
+	{
+		const float* p = line.Band(b);
+		double sum = 0.0;
+		for (size_t s = 0; s < line.numSamples; s++)
+			sum += p[s];
+		stats.sum[b] += sum;
+	}
+	stats.count += line.numSamples;
+	RankKUpdate(line, stats.scatter);
+
+	if (USE_MNF)
+	{
+		stats.noiseCount += line.numSamples - 1;
+		RankKUpdate(difference, stats.noiseScatter);
+	}
+}
+
+// symmetric eigendecomposition by cyclic Jacobi rotations; each solve starts
+//    from the eigenvectors of the previous one, so a slowly changing matrix
+//    is already almost diagonal
+class SymmetricEigen
+{
+public:
+	SymmetricEigen()
+		: m_size(0), m_sweeps(0)
+	{
+	}
+
+	// eigenvalues in descending order; eigenvector j is column j of Vectors()
+	void Solve(const std::vector<double>& matrix, size_t n)
+	{
+		if (m_size != n)
+		{
+			m_size = n;
+			m_vectors.assign(n * n, 0.0);
+			for (size_t i = 0; i < n; i++)
+				m_vectors[i * n + i] = 1.0;
+		}
+
+		// a = V^T * matrix * V
+		std::vector<double> temp(n * n, 0.0);
+		for (size_t i = 0; i < n; i++)
+			for (size_t k = 0; k < n; k++)
+			{
+				double m = matrix[i * n + k];
+				for (size_t j = 0; j < n; j++)
+					temp[i * n + j] += m * m_vectors[k * n + j];
+			}
+		std::vector<double> a(n * n, 0.0);
+		for (size_t k = 0; k < n; k++)
+			for (size_t i = 0; i < n; i++)
+			{
+				double v = m_vectors[k * n + i];
+				for (size_t j = 0; j < n; j++)
+					a[i * n + j] += v * temp[k * n + j];
+			}
+
+		double total = 0.0;
+		for (size_t i = 0; i < n * n; i++)
+			total += a[i] * a[i];
+
+		for (m_sweeps = 0; m_sweeps < 50; m_sweeps++)
+		{
+			double off = 0.0;
+			for (size_t p = 0; p < n; p++)
+				for (size_t q = p + 1; q < n; q++)
+					off += a[p * n + q] * a[p * n + q];
+			if (off <= 1e-24 * total)
+				break;
+
+			for (size_t p = 0; p < n; p++)
+			{
+				for (size_t q = p + 1; q < n; q++)
+				{
+					double apq = a[p * n + q];
+					if (std::fabs(apq) < 1e-300)
+						continue;
+					double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+					double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+					double c = 1.0 / std::sqrt(t * t + 1.0);
+					double s = t * c;
+
+					for (size_t k = 0; k < n; k++)
+					{
+						double akp = a[k * n + p];
+						double akq = a[k * n + q];
+						a[k * n + p] = c * akp - s * akq;
+						a[k * n + q] = s * akp + c * akq;
+					}
+					for (size_t k = 0; k < n; k++)
+					{
+						double apk = a[p * n + k];
+						double aqk = a[q * n + k];
+						a[p * n + k] = c * apk - s * aqk;
+						a[q * n + k] = s * apk + c * aqk;
+					}
+					for (size_t k = 0; k < n; k++)
+					{
+						double vkp = m_vectors[k * n + p];
+						double vkq = m_vectors[k * n + q];
+						m_vectors[k * n + p] = c * vkp - s * vkq;
+						m_vectors[k * n + q] = s * vkp + c * vkq;
+					}
+				}
+			}
+		}
+
+		// sort descending
+		std::vector<size_t> order(n);
+		for (size_t i = 0; i < n; i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return a[x * n + x] > a[y * n + y]; });
+
+		m_values.resize(n);
+		std::vector<double> sorted(n * n);
+		for (size_t j = 0; j < n; j++)
+		{
+			m_values[j] = a[order[j] * n + order[j]];
+			for (size_t i = 0; i < n; i++)
+				sorted[i * n + j] = m_vectors[i * n + order[j]];
+		}
+		m_vectors.swap(sorted);
+	}
+
+	const std::vector<double>& Values() const
+	{
+		return m_values;
+	}
+
+	const std::vector<double>& Vectors() const
+	{
+		return m_vectors;
+	}
+
+	size_t Sweeps() const
+	{
+		return m_sweeps;
+	}
+
+private:
+	size_t m_size;
+	size_t m_sweeps;
+	std::vector<double> m_values;
+	std::vector<double> m_vectors;
+};
+
+// projection onto the leading components
+struct ProjectionBasis
+{
+	size_t version;
+	size_t numBands;
+	size_t numComponents;
+	size_t numLines; // lines in the statistics
+	std::vector<float> mean;
+	std::vector<float> transform; // numComponents x numBands
+	std::vector<float> offset; // transform * (mean - shift)
+	double retained; // fraction of the eigenvalue sum kept
+	size_t sweeps;
+	double seconds;
+};
+
+// computes a basis from a snapshot of the statistics
+std::shared_ptr<ProjectionBasis> ComputeBasis(const CovarianceStatistics& stats, size_t version, size_t numLines, SymmetricEigen& signalEigen, SymmetricEigen& noiseEigen)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	size_t n = stats.numBands;
+	size_t pn = stats.paddedBands;
+	double count = static_cast<double>(stats.count);
+
+	// covariance from the upper triangle of the scatter
+	std::vector<double> covariance(n * n);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = i; j < n; j++)
+		{
+			double c = (stats.scatter[i * pn + j] - stats.sum[i] * stats.sum[j] / count) / (count - 1.0);
+			covariance[i * n + j] = c;
+			covariance[j * n + i] = c;
+		}
+
+	size_t k = std::min(static_cast<size_t>(NUM_COMPONENTS), n);
+	std::shared_ptr<ProjectionBasis> pBasis = std::make_shared<ProjectionBasis>();
+	pBasis->version = version;
+	pBasis->numBands = n;
+	pBasis->numComponents = k;
+	pBasis->numLines = numLines;
+	pBasis->transform.assign(k * n, 0.0f);
+
+	std::vector<double> transform(n * k, 0.0); // columns are components
+	if (!USE_MNF)
+	{
+		signalEigen.Solve(covariance, n);
+		for (size_t i = 0; i < n; i++)
+			for (size_t c = 0; c < k; c++)
+				transform[i * k + c] = signalEigen.Vectors()[i * n + c];
+	}
+	else
+	{
+		// noise covariance; neighbour differences carry twice the noise
+		std::vector<double> noise(n * n);
+		double noiseCount = static_cast<double>(stats.noiseCount);
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = i; j < n; j++)
+			{
+				double c = stats.noiseScatter[i * pn + j] / (2.0 * noiseCount);
+				noise[i * n + j] = c;
+				noise[j * n + i] = c;
+			}
+
+		// whitening: W = U * diag(1 / sqrt(noise eigenvalues))
+		noiseEigen.Solve(noise, n);
+		double floor = std::max(noiseEigen.Values()[0] * 1e-9, 1e-30);
+		std::vector<double> whitening(n * n);
+		for (size_t j = 0; j < n; j++)
+		{
+			double scale = 1.0 / std::sqrt(std::max(noiseEigen.Values()[j], floor));
+			for (size_t i = 0; i < n; i++)
+				whitening[i * n + j] = noiseEigen.Vectors()[i * n + j] * scale;
+		}
+
+		// PCA of the noise-whitened covariance W^T * C * W
+		std::vector<double> temp(n * n, 0.0);
+		for (size_t i = 0; i < n; i++)
+			for (size_t m = 0; m < n; m++)
+			{
+				double c = covariance[i * n + m];
+				for (size_t j = 0; j < n; j++)
+					temp[i * n + j] += c * whitening[m * n + j];
+			}
+		std::vector<double> whitened(n * n, 0.0);
+		for (size_t m = 0; m < n; m++)
+			for (size_t i = 0; i < n; i++)
+			{
+				double w = whitening[m * n + i];
+				for (size_t j = 0; j < n; j++)
+					whitened[i * n + j] += w * temp[m * n + j];
+			}
+		signalEigen.Solve(whitened, n);
+
+		// transform = W * V[:, :k]
+		for (size_t i = 0; i < n; i++)
+			for (size_t m = 0; m < n; m++)
+			{
+				double w = whitening[i * n + m];
+				for (size_t c = 0; c < k; c++)
+					transform[i * k + c] += w * signalEigen.Vectors()[m * n + c];
+			}
+	}
+
+	double kept = 0.0;
+	double total = 0.0;
+	for (size_t i = 0; i < n; i++)
+	{
+		double value = std::max(signalEigen.Values()[i], 0.0);
+		total += value;
+		if (i < k)
+			kept += value;
+	}
+	pBasis->retained = total > 0.0 ? kept / total : 0.0;
+	pBasis->sweeps = signalEigen.Sweeps();
+
+	pBasis->mean.resize(n);
+	pBasis->offset.assign(k, 0.0f);
+	for (size_t i = 0; i < n; i++)
+	{
+		double centre = stats.sum[i] / count;
+		pBasis->mean[i] = static_cast<float>(stats.shift[i] + centre);
+		for (size_t c = 0; c < k; c++)
+		{
+			pBasis->transform[c * n + i] = static_cast<float>(transform[i * k + c]);
+			pBasis->offset[c] += static_cast<float>(transform[i * k + c] * centre);
+		}
+	}
+
+	pBasis->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return pBasis;
+}
+
+// refreshes the basis on a worker thread; the latest snapshot wins
+class BasisRefresher
+{
+public:
+	BasisRefresher()
+		: m_snapshotLines(0), m_pending(false), m_running(true), m_version(0)
+	{
+		m_worker = std::thread(&BasisRefresher::Work, this);
+	}
+
+	~BasisRefresher()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_running = false;
+		}
+		m_wake.notify_one();
+		m_worker.join();
+	}
+
+	void Request(const CovarianceStatistics& stats, size_t numLines)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_snapshot = stats;
+			m_snapshotLines = numLines;
+			m_pending = true;
+		}
+		m_wake.notify_one();
+	}
+
+	// current basis; NULL until the first one is ready
+	std::shared_ptr<const ProjectionBasis> Current() const
+	{
+		return std::atomic_load(&m_current);
+	}
+
+private:
+	void Work()
+	{
+		for (;;)
+		{
+			CovarianceStatistics stats;
+			size_t numLines;
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_wake.wait(lock, [this]() { return m_pending || !m_running; });
+				if (!m_running)
+					return;
+				stats = m_snapshot;
+				numLines = m_snapshotLines;
+				m_pending = false;
+			}
+
+			std::shared_ptr<ProjectionBasis> pBasis = ComputeBasis(stats, ++m_version, numLines, m_signalEigen, m_noiseEigen);
+			std::atomic_store(&m_current, std::shared_ptr<const ProjectionBasis>(pBasis));
+		}
+	}
+
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	CovarianceStatistics m_snapshot;
+	size_t m_snapshotLines;
+	bool m_pending;
+	bool m_running;
+	size_t m_version;
+	SymmetricEigen m_signalEigen;
+	SymmetricEigen m_noiseEigen;
+	std::shared_ptr<const ProjectionBasis> m_current;
+	std::thread m_worker;
+};
+
+// projects a line onto the basis: out[c] = transform[c] * line - offset[c];
+//    vectorized across samples
+void ProjectLine(const Line& line, const ProjectionBasis& basis, std::vector<float>& out)
+{
+	out.assign(basis.numComponents * line.stride, 0.0f);
+	for (size_t c = 0; c < basis.numComponents; c++)
+	{
+		float* pDst = &out[c * line.stride];
+		const float* pWeights = &basis.transform[c * basis.numBands];
+		for (size_t b = 0; b < basis.numBands; b++)
+		{
+			const float* pSrc = line.Band(b);
+			size_t s = 0;
+#if defined(__SSE2__)
+			__m128 w = _mm_set1_ps(pWeights[b]);
+			for (; s < line.stride; s += 4)
+				_mm_storeu_ps(pDst + s, _mm_add_ps(_mm_loadu_ps(pDst + s), _mm_mul_ps(w, _mm_loadu_ps(pSrc + s))));
+#endif
+			for (; s < line.stride; s++)
+				pDst[s] += pWeights[b] * pSrc[s];
+		}
+		for (size_t s = 0; s < line.numSamples; s++)
+			pDst[s] -= basis.offset[c];
+	}
+}
+
+// appends a basis to the sidecar: first line it applies to, sizes, mean and
+//    transform
+void WriteBasis(std::ofstream& file, const ProjectionBasis& basis, size_t firstLine)
+{
+	uint32_t header[3] = { static_cast<uint32_t>(firstLine), static_cast<uint32_t>(basis.numBands), static_cast<uint32_t>(basis.numComponents) };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(basis.mean.data()), basis.mean.size() * sizeof(float));
+	file.write(reinterpret_cast<const char*>(basis.transform.data()), basis.transform.size() * sizeof(float));
+}
+
+void WriteEnviHeader(size_t numSamples, size_t numLines, size_t numComponents)
+{
+	std::ofstream header(HEADER_FILE);
+	header << "ENVI\n";
+	header << "description = {" << (USE_MNF ? "MNF" : "PCA") << " components, basis in " << BASIS_FILE << "}\n";
+	header << "samples = " << numSamples << "\n";
+	header << "lines = " << numLines << "\n";
+	header << "bands = " << numComponents << "\n";
+	header << "header offset = 0\n";
+	header << "file type = ENVI Standard\n";
+	header << "data type = 4\n";
+	header << "interleave = bil\n";
+	header << "byte order = 0\n";
+}
+
+// demonstrates streaming dimensionality reduction
+// (1) selects an unpacked 12 or 16-bit mono format
+// (2) bins each frame into bands and updates the covariance statistics
+// (3) requests a basis after the warm-up and then periodically
+// (4) projects each line onto the current basis and writes it out
+// (5) reports timing and retained variance
+// (6) restores the pixel format
+void AcquireWithStreamingPCA(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring pixelFormatInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat");
+
+	// enable stream auto negotiate packet size
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+
+	// enable stream packet resend
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// select pixel format
+	//    Mono12 is unpacked into 16-bit containers, so both formats are read
+	//    straight from the image buffer without conversion.
+	GenApi::CEnumerationPtr pPixelFormat = pNodeMap->GetNode("PixelFormat");
+	GenApi::CEnumEntryPtr pMono12 = pPixelFormat->GetEntryByName("Mono12");
+	const char* pixelFormat = (pMono12 != 0 && GenApi::IsAvailable(pMono12)) ? "Mono12" : "Mono16";
+	std::cout << TAB1 << "Set pixel format to " << pixelFormat << "\n";
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormat);
+
+	size_t numRows = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Height"));
+	size_t numColumns = static_cast<size_t>(Arena::GetNodeValue<int64_t>(pNodeMap, "Width"));
+	size_t numBands = numColumns / SPECTRAL_BINNING;
+	if (numBands < 2 || numRows < 2)
+		throw GenICam::GenericException("Frame too small", __FILE__, __LINE__);
+
+	std::cout << TAB1 << (USE_MNF ? "MNF" : "PCA") << " of " << numBands << " bands to " << std::min(static_cast<size_t>(NUM_COMPONENTS), numBands) << " components over " << numRows << " samples per line\n";
+
+	CovarianceStatistics stats;
+	stats.numBands = numBands;
+	stats.paddedBands = RoundUp4(numBands);
+	stats.count = 0;
+	stats.sum.assign(numBands, 0.0);
+	stats.scatter.assign(stats.paddedBands * stats.paddedBands, 0.0);
+	stats.noiseCount = 0;
+	stats.noiseScatter.assign(USE_MNF ? stats.paddedBands * stats.paddedBands : 0, 0.0);
+
+	BasisRefresher refresher;
+	std::ofstream output(OUTPUT_FILE, std::ios::binary);
+	std::ofstream basisFile(BASIS_FILE, std::ios::binary);
+	if (!output || !basisFile)
+		throw GenICam::GenericException("Could not open output files", __FILE__, __LINE__);
+
+	// lines binned before the first basis is ready
+	std::vector<Line> pending;
+	Line line;
+	Line difference;
+	std::vector<float> reduced;
+	size_t written = 0;
+	size_t writtenVersion = 0;
+	double updateSeconds = 0.0;
+	double projectSeconds = 0.0;
+
+	// writes a line with the current basis, recording each new basis
+	auto writeLine = [&](const Line& x, const ProjectionBasis& basis) {
+		if (basis.version != writtenVersion)
+		{
+			WriteBasis(basisFile, basis, written);
+			writtenVersion = basis.version;
+			std::cout << TAB2 << "basis " << basis.version << " from " << basis.numLines << " lines: " << basis.retained * 100.0 << "% retained, " << basis.sweeps << " sweeps, " << basis.seconds * 1000.0 << " ms\n";
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		ProjectLine(x, basis, reduced);
+		projectSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (size_t c = 0; c < basis.numComponents; c++)
+			output.write(reinterpret_cast<const char*>(&reduced[c * x.stride]), x.numSamples * sizeof(float));
+		written++;
+	};
+
+	std::cout << TAB1 << "Acquire and reduce " << NUM_LINES << " lines\n";
+
+	pDevice->StartStream();
+	for (size_t i = 0; i < NUM_LINES; i++)
+	{
+		Arena::IImage* pImage = pDevice->GetImage(TIMEOUT);
+		if (pImage->GetWidth() != numColumns || pImage->GetHeight() != numRows || pImage->GetBitsPerPixel() != 16)
+		{
+			pDevice->RequeueBuffer(pImage);
+			pDevice->StopStream();
+			throw GenICam::GenericException("Unexpected image size or format", __FILE__, __LINE__);
+		}
+
+		const uint16_t* pFrame = reinterpret_cast<const uint16_t*>(pImage->GetData());
+
+		// the band means of the first line become the shift
+		if (stats.shift.empty())
+		{
+			BinLine(pFrame, numRows, numColumns, stats.shift, line);
+			stats.shift.resize(numBands);
+			for (size_t b = 0; b < numBands; b++)
+			{
+				double sum = 0.0;
+				for (size_t s = 0; s < numRows; s++)
+					sum += line.Band(b)[s];
+				stats.shift[b] = static_cast<float>(sum / numRows);
+			}
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BinLine(pFrame, numRows, numColumns, stats.shift, line);
+		pDevice->RequeueBuffer(pImage);
+		if (USE_MNF)
+			DifferenceLine(line, difference);
+		AddLine(line, difference, stats);
+		updateSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		if (i + 1 == WARMUP_LINES || (i + 1 > WARMUP_LINES && (i + 1 - WARMUP_LINES) % REFRESH_INTERVAL == 0))
+			refresher.Request(stats, i + 1);
+
+		std::shared_ptr<const ProjectionBasis> pBasis = refresher.Current();
+		if (!pBasis)
+		{
+			pending.push_back(line);
+			continue;
+		}
+		for (size_t p = 0; p < pending.size(); p++)
+			writeLine(pending[p], *pBasis);
+		pending.clear();
+		writeLine(line, *pBasis);
+	}
+	pDevice->StopStream();
+
+	// short runs may end before the first basis
+	if (!pending.empty())
+	{
+		if (written == 0 && NUM_LINES < WARMUP_LINES)
+			refresher.Request(stats, NUM_LINES);
+		std::shared_ptr<const ProjectionBasis> pBasis;
+		while (!(pBasis = refresher.Current()))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		for (size_t p = 0; p < pending.size(); p++)
+			writeLine(pending[p], *pBasis);
+	}
+
+	std::shared_ptr<const ProjectionBasis> pBasis = refresher.Current();
+	WriteEnviHeader(numRows, written, pBasis->numComponents);
+
+	std::cout << TAB2 << "covariance update: " << updateSeconds * 1000.0 / NUM_LINES << " ms per line\n";
+	std::cout << TAB2 << "projection: " << projectSeconds * 1000.0 / written << " ms per line\n";
+	std::cout << TAB2 << "wrote " << written << " lines of " << pBasis->numComponents << " components to " << OUTPUT_FILE << " (" << 100.0 * pBasis->numComponents / numBands << "% of the binned size)\n";
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "PixelFormat", pixelFormatInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_StreamingPCA\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		AcquireWithStreamingPCA(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
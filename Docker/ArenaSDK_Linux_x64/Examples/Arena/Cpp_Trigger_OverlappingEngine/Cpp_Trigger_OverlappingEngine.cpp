@@ -0,0 +1,600 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#define TAB1 "  "
+#define TAB2 "    "
+#define TAB3 "      "
+
+// Trigger: Overlapping Trigger Engine
+//    This example extends Cpp_Trigger_OverlappingTrigger into a trigger
+//    engine for long pushbroom scans. The device runs with TriggerOverlap set
+//    to PreviousFrame, so a trigger is accepted as soon as an exposure ends,
+//    while that frame is still being read out. A dedicated event thread waits
+//    on ExposureEnd events (InitializeEvents/WaitOnEvent). On each event it
+//    executes TriggerSoftware straight away through a command node looked up
+//    once. It does not poll TriggerArmed first: the ExposureEnd event is what
+//    arms the trigger. TriggerArmed is only checked when an event does not
+//    arrive in time, and the engine then fires again to keep the scan going.
+//    The acquisition thread receives images. The device timestamps show the
+//    dead time between one exposure and the next. The event thread records
+//    the device timestamp of each ExposureEnd event, and the acquisition
+//    thread measures from it to the start of the next image on the device
+//    clock; this is the trigger latency the sensor actually sees, event
+//    delivery included. The event thread also times its own Execute round
+//    trip on the host clock, which shows only the host's share. All are kept
+//    as histograms, so memory stays fixed however long the scan runs. The
+//    line rate reached is compared with the device's maximum free-running
+//    frame rate at the same exposure time.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// number of lines in the scan
+#define NUM_LINES 20000
+
+// exposure time (us)
+#define EXPOSURE_TIME 1000.0
+
+// number of stream buffers
+#define NUM_BUFFERS 64
+
+// time to wait for an ExposureEnd event before checking the trigger (ms)
+#define EVENT_TIMEOUT 100
+
+// image timeout (ms)
+#define IMAGE_TIMEOUT 2000
+
+// time to wait for the trigger to arm (ms)
+#define ARM_TIMEOUT 1000
+
+// CPU to pin the event thread to; -1 leaves it unpinned
+#define CPU_EVENT 1
+
+// run the event thread with real-time (SCHED_FIFO) priority when permitted
+#define REALTIME_PRIORITY true
+
+// lines between progress reports
+#define REPORT_PERIOD 2000
+
+// histogram bin width (ns) and number of bins; longer times fall into the
+// last bin
+#define HISTOGRAM_BIN_NS 1000
+#define HISTOGRAM_BINS 20000
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPERS =-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// Histogram
+//    Distribution of durations with fixed-width bins; percentiles are
+//    accurate to one bin, mean and maximum are exact.
+class Histogram
+{
+public:
+	Histogram()
+		: m_bins(HISTOGRAM_BINS, 0), m_count(0), m_sum(0.0), m_max(0)
+	{
+	}
+
+	void Add(int64_t ns)
+	{
+		ns = std::max<int64_t>(ns, 0);
+		m_bins[std::min<int64_t>(ns / HISTOGRAM_BIN_NS, HISTOGRAM_BINS - 1)]++;
+		m_count++;
+		m_sum += static_cast<double>(ns);
+		m_max = std::max(m_max, ns);
+	}
+
+	// upper edge of the bin holding the given fraction of samples
+	int64_t Percentile(double fraction) const
+	{
+		uint64_t target = static_cast<uint64_t>(fraction * m_count);
+		uint64_t seen = 0;
+		for (size_t i = 0; i < m_bins.size(); i++)
+		{
+			seen += m_bins[i];
+			if (seen > target)
+				return std::min<int64_t>(static_cast<int64_t>(i + 1) * HISTOGRAM_BIN_NS, m_max);
+		}
+		return m_max;
+	}
+
+	uint64_t GetCount() const
+	{
+		return m_count;
+	}
+
+	double GetMean() const
+	{
+		return m_count ? m_sum / m_count : 0.0;
+	}
+
+	int64_t GetMax() const
+	{
+		return m_max;
+	}
+
+	// one line: mean, p50, p99, p99.9, max in microseconds
+	void Print(const char* name) const
+	{
+		std::cout << TAB2 << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(1)
+				  << "mean " << GetMean() / 1000 << " us, p50 " << Percentile(0.5) / 1000.0 << " us, p99 " << Percentile(0.99) / 1000.0
+				  << " us, p99.9 " << Percentile(0.999) / 1000.0 << " us, max " << GetMax() / 1000.0 << " us (" << GetCount() << " samples)\n";
+	}
+
+private:
+	std::vector<uint64_t> m_bins;
+	uint64_t m_count;
+	double m_sum;
+	int64_t m_max;
+};
+
+// pins the calling thread to a CPU
+void PinThread(const char* name, int cpu)
+{
+	if (cpu < 0)
+		return;
+	if (cpu >= static_cast<int>(std::thread::hardware_concurrency()))
+	{
+		std::cout << TAB2 << name << " thread left unpinned (no CPU " << cpu << ")\n";
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+		std::cout << TAB2 << name << " thread could not be pinned to CPU " << cpu << "\n";
+}
+
+// gives the calling thread real-time priority; needs CAP_SYS_NICE or a
+// suitable RLIMIT_RTPRIO
+void RaiseThreadPriority(const char* name)
+{
+	sched_param param;
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+	if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+		std::cout << TAB2 << name << " thread left at normal priority (SCHED_FIFO not permitted)\n";
+}
+
+// nanoseconds between two steady clock times
+int64_t NanosecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- ENGINE -=-=-=
+// =-=-=-=-=-=-=-=-=-
+
+// Trigger engine
+//    Owns the event thread. Nodes used on the trigger path are looked up
+//    once, before the thread starts. The thread is the only user of
+//    WaitOnEvent and TriggerSoftware; the acquisition thread only reads the
+//    atomic counters while the engine runs.
+class TriggerEngine
+{
+public:
+	TriggerEngine(Arena::IDevice* pDevice, size_t numLines)
+		: m_pDevice(pDevice), m_numLines(numLines), m_fired(0), m_rearms(0), m_stop(false), m_done(false)
+	{
+		GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+		m_pTriggerSoftware = pNodeMap->GetNode("TriggerSoftware");
+		m_pTriggerArmed = pNodeMap->GetNode("TriggerArmed");
+		m_pEventTimestamp = pNodeMap->GetNode("EventExposureEndTimestamp");
+		if (!m_pTriggerSoftware || !m_pTriggerArmed)
+			throw GenICam::GenericException("TriggerSoftware or TriggerArmed node not found", __FILE__, __LINE__);
+		if (!m_pEventTimestamp)
+			std::cout << TAB2 << "EventExposureEndTimestamp node not found; device trigger latency not measured\n";
+	}
+
+	// joins the thread; an exception it ended with is dropped here, call
+	// Stop to receive it
+	~TriggerEngine()
+	{
+		m_stop = true;
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	void Start()
+	{
+		m_thread = std::thread(&TriggerEngine::Run, this);
+	}
+
+	// stops the thread and passes on any exception it ended with
+	void Stop()
+	{
+		m_stop = true;
+		if (m_thread.joinable())
+			m_thread.join();
+		if (m_error)
+		{
+			std::exception_ptr error = m_error;
+			m_error = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	size_t GetFired() const
+	{
+		return m_fired;
+	}
+
+	size_t GetRearms() const
+	{
+		return m_rearms;
+	}
+
+	bool IsDone() const
+	{
+		return m_done;
+	}
+
+	// host time from event to executed trigger; read after Stop
+	const Histogram& GetHostTurnaround() const
+	{
+		return m_hostTurnaround;
+	}
+
+	// moves the device timestamps of the ExposureEnd events received so far
+	// into timestamps, oldest first
+	void TakeEventTimestamps(std::vector<uint64_t>& timestamps)
+	{
+		std::lock_guard<std::mutex> lock(m_eventMutex);
+		timestamps.insert(timestamps.end(), m_eventTimestamps.begin(), m_eventTimestamps.end());
+		m_eventTimestamps.clear();
+	}
+
+private:
+	void Run()
+	{
+		try
+		{
+			PinThread("Event", CPU_EVENT);
+			if (REALTIME_PRIORITY)
+				RaiseThreadPriority("Event");
+
+			// the first trigger starts the chain
+			WaitArmed();
+			Fire();
+
+			while (!m_stop && m_fired < m_numLines)
+			{
+				// Wait on ExposureEnd
+				//    The trigger is armed by the time the event is sent, so
+				//    it is executed without checking TriggerArmed. A lost
+				//    event or a dropped trigger shows up as a timeout; the
+				//    engine then fires again once the trigger is armed.
+				try
+				{
+					m_pDevice->WaitOnEvent(EVENT_TIMEOUT);
+				}
+				catch (GenICam::TimeoutException&)
+				{
+					m_rearms++;
+					WaitArmed();
+					Fire();
+					continue;
+				}
+
+				auto eventTime = std::chrono::steady_clock::now();
+				Fire();
+				m_hostTurnaround.Add(NanosecondsBetween(eventTime, std::chrono::steady_clock::now()));
+
+				// recorded after the trigger so as not to delay it; the
+				// image it starts cannot be received before this returns
+				if (m_pEventTimestamp)
+				{
+					uint64_t timestamp = static_cast<uint64_t>(m_pEventTimestamp->GetValue());
+					std::lock_guard<std::mutex> lock(m_eventMutex);
+					m_eventTimestamps.push_back(timestamp);
+				}
+			}
+		}
+		catch (...)
+		{
+			m_error = std::current_exception();
+		}
+		m_done = true;
+	}
+
+	void Fire()
+	{
+		if (m_fired < m_numLines)
+		{
+			m_pTriggerSoftware->Execute();
+			m_fired++;
+		}
+	}
+
+	void WaitArmed()
+	{
+		auto start = std::chrono::steady_clock::now();
+		while (!m_pTriggerArmed->GetValue())
+		{
+			if (m_stop)
+				return;
+			if (NanosecondsBetween(start, std::chrono::steady_clock::now()) > ARM_TIMEOUT * 1000000LL)
+				throw GenICam::GenericException("trigger did not arm", __FILE__, __LINE__);
+		}
+	}
+
+	Arena::IDevice* m_pDevice;
+	size_t m_numLines;
+	GenApi::CCommandPtr m_pTriggerSoftware;
+	GenApi::CBooleanPtr m_pTriggerArmed;
+	GenApi::CIntegerPtr m_pEventTimestamp;
+	std::atomic<size_t> m_fired;
+	std::atomic<size_t> m_rearms;
+	std::atomic<bool> m_stop;
+	std::atomic<bool> m_done;
+	Histogram m_hostTurnaround;
+	std::mutex m_eventMutex;
+	std::vector<uint64_t> m_eventTimestamps;
+	std::exception_ptr m_error;
+	std::thread m_thread;
+};
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// demonstrates the trigger engine on a long scan
+// (1) reads the maximum free-running frame rate at the scan's exposure time
+// (2) sets software triggering with overlap and ExposureEnd events
+// (3) starts the stream and the engine's event thread
+// (4) receives lines, tracking dead time between exposures and lost lines
+// (5) reports line rate against the maximum and the time distributions
+void RunTriggerEngine(Arena::IDevice* pDevice)
+{
+	GenApi::INodeMap* pNodeMap = pDevice->GetNodeMap();
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	GenICam::gcstring triggerSelectorInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSelector");
+	GenICam::gcstring triggerModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerMode");
+	GenICam::gcstring triggerSourceInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSource");
+	GenICam::gcstring triggerOverlapInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerOverlap");
+	GenICam::gcstring acquisitionModeInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode");
+	GenICam::gcstring exposureAutoInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto");
+	double exposureTimeInitial = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime");
+
+	// Set exposure time
+	std::cout << TAB1 << "Set exposure time to " << EXPOSURE_TIME << " us\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", "Off");
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", EXPOSURE_TIME);
+	double exposureNs = Arena::GetNodeValue<double>(pNodeMap, "ExposureTime") * 1000.0;
+
+	// Read maximum line rate
+	//    Without triggering the device is limited by exposure and readout
+	//    only; that rate is the most a triggered scan can reach.
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerMode", "Off");
+	double maxRate = 1e9 / exposureNs;
+	GenApi::CFloatPtr pFrameRate = pNodeMap->GetNode("AcquisitionFrameRate");
+	if (pFrameRate && GenApi::IsReadable(pFrameRate))
+		maxRate = std::min(maxRate, pFrameRate->GetMax());
+
+	std::cout << TAB1 << "Maximum line rate " << std::fixed << std::setprecision(1) << maxRate << " Hz\n";
+
+	// Set overlapping software trigger
+	std::cout << TAB1 << "Set FrameStart software trigger with PreviousFrame overlap\n";
+
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSelector", "FrameStart");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerMode", "On");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSource", "Software");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerOverlap", "PreviousFrame");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", "Continuous");
+
+	// Enable ExposureEnd events
+	//    Event nodes are only available once the events engine is initialized.
+	std::cout << TAB1 << "Enable ExposureEnd events\n";
+
+	pDevice->InitializeEvents();
+
+	GenICam::gcstring eventSelectorInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "EventSelector");
+	GenICam::gcstring eventNotificationInitial = Arena::GetNodeValue<GenICam::gcstring>(pNodeMap, "EventNotification");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "EventSelector", "ExposureEnd");
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "EventNotification", "On");
+
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamAutoNegotiatePacketSize", true);
+	Arena::SetNodeValue<bool>(pDevice->GetTLStreamNodeMap(), "StreamPacketResendEnable", true);
+
+	// Start stream and engine
+	std::cout << TAB1 << "Scan " << NUM_LINES << " lines\n";
+
+	pDevice->StartStream(NUM_BUFFERS);
+
+	TriggerEngine engine(pDevice, NUM_LINES);
+	engine.Start();
+
+	// Receive lines
+	//    Period is the time between the device timestamps of consecutive
+	//    lines; dead time is the period less the exposure, the time the
+	//    sensor was not exposing. Lines missing from the frame IDs are
+	//    counted as lost and left out of both. Trigger latency is the time
+	//    from the previous line's ExposureEnd event to the start of this
+	//    line, both on the device clock; it is only taken when that event
+	//    falls between the two lines.
+	Histogram periods;
+	Histogram deadTimes;
+	Histogram latencies;
+	std::vector<uint64_t> eventTimestamps;
+	size_t received = 0;
+	size_t lost = 0;
+	size_t incomplete = 0;
+	uint64_t firstTimestamp = 0;
+	uint64_t lastTimestamp = 0;
+	uint64_t lastFrameId = 0;
+
+	while (received + lost < NUM_LINES)
+	{
+		Arena::IImage* pImage = NULL;
+		try
+		{
+			pImage = pDevice->GetImage(IMAGE_TIMEOUT);
+		}
+		catch (GenICam::TimeoutException&)
+		{
+			if (engine.IsDone())
+				break;
+			continue;
+		}
+
+		uint64_t timestamp = pImage->GetTimestampNs();
+		uint64_t frameId = pImage->GetFrameId();
+		if (pImage->IsIncomplete())
+			incomplete++;
+
+		if (received == 0)
+		{
+			firstTimestamp = timestamp;
+		}
+		else
+		{
+			uint64_t step = frameId > lastFrameId ? frameId - lastFrameId : frameId + 0xFFFF - lastFrameId; // 16-bit block IDs wrap to 1
+			if (step > 1)
+			{
+				lost += static_cast<size_t>(step - 1);
+			}
+			else
+			{
+				int64_t period = static_cast<int64_t>(timestamp - lastTimestamp);
+				periods.Add(period);
+				deadTimes.Add(period - static_cast<int64_t>(exposureNs));
+			}
+
+			// latest event before this line
+			engine.TakeEventTimestamps(eventTimestamps);
+			size_t next = 0;
+			while (next < eventTimestamps.size() && eventTimestamps[next] < timestamp)
+				next++;
+			if (step == 1 && next > 0 && eventTimestamps[next - 1] > lastTimestamp)
+				latencies.Add(static_cast<int64_t>(timestamp - eventTimestamps[next - 1]));
+			eventTimestamps.erase(eventTimestamps.begin(), eventTimestamps.begin() + next);
+		}
+
+		lastTimestamp = timestamp;
+		lastFrameId = frameId;
+		received++;
+		pDevice->RequeueBuffer(pImage);
+
+		if (received % REPORT_PERIOD == 0 && lastTimestamp > firstTimestamp)
+			std::cout << TAB2 << std::setw(8) << received << " lines, " << std::setprecision(1) << 1e9 * (received - 1) / (lastTimestamp - firstTimestamp) << " Hz, dead time p99 " << deadTimes.Percentile(0.99) / 1000.0 << " us, " << lost << " lost, " << engine.GetRearms() << " rearms\n";
+	}
+
+	engine.Stop();
+	pDevice->StopStream();
+
+	// Report
+	double rate = lastTimestamp > firstTimestamp ? 1e9 * (received - 1) / (lastTimestamp - firstTimestamp) : 0.0;
+
+	std::cout << TAB1 << "Report\n";
+	std::cout << TAB2 << received << " lines received, " << lost << " lost, " << incomplete << " incomplete, " << engine.GetFired() << " triggers, " << engine.GetRearms() << " rearms\n";
+	std::cout << TAB2 << "Line rate " << std::setprecision(1) << rate << " Hz of " << maxRate << " Hz maximum (" << 100.0 * rate / maxRate << "%)\n";
+	periods.Print("Line period");
+	deadTimes.Print("Dead time");
+	latencies.Print("Trigger latency");
+	engine.GetHostTurnaround().Print("Host trigger execute");
+
+	// Deinitialize events
+	pDevice->DeinitializeEvents();
+
+	// return nodes to their initial values
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "EventNotification", eventNotificationInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "EventSelector", eventSelectorInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "AcquisitionMode", acquisitionModeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerOverlap", triggerOverlapInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSource", triggerSourceInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerMode", triggerModeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "TriggerSelector", triggerSelectorInitial);
+	Arena::SetNodeValue<double>(pNodeMap, "ExposureTime", exposureTimeInitial);
+	Arena::SetNodeValue<GenICam::gcstring>(pNodeMap, "ExposureAuto", exposureAutoInitial);
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+int main()
+{
+	// flag to track when an exception has been thrown
+	bool exceptionThrown = false;
+
+	std::cout << "Cpp_Trigger_OverlappingEngine\n";
+
+	try
+	{
+		// prepare example
+		Arena::ISystem* pSystem = Arena::OpenSystem();
+		pSystem->UpdateDevices(100);
+		std::vector<Arena::DeviceInfo> deviceInfos = pSystem->GetDevices();
+		if (deviceInfos.size() == 0)
+		{
+			std::cout << "\nNo camera connected\nPress enter to complete\n";
+			std::getchar();
+			return 0;
+		}
+		Arena::IDevice* pDevice = pSystem->CreateDevice(deviceInfos[0]);
+
+		// run example
+		std::cout << "Commence example\n\n";
+		RunTriggerEngine(pDevice);
+		std::cout << "\nExample complete\n";
+
+		// clean up example
+		pSystem->DestroyDevice(pDevice);
+		Arena::CloseSystem(pSystem);
+	}
+	catch (GenICam::GenericException& ge)
+	{
+		std::cout << "\nGenICam exception thrown: " << ge.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (std::exception& ex)
+	{
+		std::cout << "\nStandard exception thrown: " << ex.what() << "\n";
+		exceptionThrown = true;
+	}
+	catch (...)
+	{
+		std::cout << "\nUnexpected exception thrown\n";
+		exceptionThrown = true;
+	}
+
+	std::cout << "Press enter to complete\n";
+	std::getchar();
+
+	if (exceptionThrown)
+		return -1;
+	else
+		return 0;
+}
@@ -0,0 +1,144 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaCBatch.h"
+#include <stdbool.h>  // defines boolean type and values
+
+// fills a descriptor from a buffer
+static void DescribeBuffer(acBuffer hBuffer, acFrameDescriptor* pFrame)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+	bool8_t incomplete = false;
+	bool8_t largerThanBuffer = false;
+	bool8_t hasImageData = false;
+	uint8_t* pData = NULL;
+	size_t sizeFilled = 0;
+	size_t width = 0;
+	size_t height = 0;
+
+	pFrame->hBuffer = hBuffer;
+	pFrame->pData = NULL;
+	pFrame->sizeFilled = 0;
+	pFrame->frameId = 0;
+	pFrame->timestampNs = 0;
+	pFrame->width = 0;
+	pFrame->height = 0;
+	pFrame->pixelFormat = 0;
+
+	err = acBufferGetSizeFilled(hBuffer, &sizeFilled);
+	if (err == AC_ERR_SUCCESS)
+		err = acBufferGetFrameId(hBuffer, &pFrame->frameId);
+	if (err == AC_ERR_SUCCESS)
+		err = acBufferIsIncomplete(hBuffer, &incomplete);
+	if (err == AC_ERR_SUCCESS)
+		err = acBufferDataLargerThanBuffer(hBuffer, &largerThanBuffer);
+	if (err == AC_ERR_SUCCESS)
+		err = acBufferHasImageData(hBuffer, &hasImageData);
+	if (err != AC_ERR_SUCCESS)
+	{
+		pFrame->status = AC_FRAME_STATUS_ERROR;
+		return;
+	}
+	pFrame->sizeFilled = sizeFilled;
+
+	if (!hasImageData)
+	{
+		pFrame->status = AC_FRAME_STATUS_NO_IMAGE_DATA;
+		return;
+	}
+
+	err = acImageGetData(hBuffer, &pData);
+	if (err == AC_ERR_SUCCESS)
+		err = acImageGetTimestampNs(hBuffer, &pFrame->timestampNs);
+	if (err == AC_ERR_SUCCESS)
+		err = acImageGetWidth(hBuffer, &width);
+	if (err == AC_ERR_SUCCESS)
+		err = acImageGetHeight(hBuffer, &height);
+	if (err == AC_ERR_SUCCESS)
+		err = acImageGetPixelFormat(hBuffer, &pFrame->pixelFormat);
+	if (err != AC_ERR_SUCCESS)
+	{
+		pFrame->status = AC_FRAME_STATUS_ERROR;
+		return;
+	}
+	pFrame->pData = pData;
+	pFrame->width = width;
+	pFrame->height = height;
+
+	if (largerThanBuffer)
+		pFrame->status = AC_FRAME_STATUS_LARGER_THAN_BUFFER;
+	else if (incomplete)
+		pFrame->status = AC_FRAME_STATUS_INCOMPLETE;
+	else
+		pFrame->status = AC_FRAME_STATUS_COMPLETE;
+}
+
+AC_ERROR acBatchGetBuffers(acDevice hDevice, uint64_t timeout, acFrameDescriptor* pFrames, size_t maxFrames, size_t* pNumFrames)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+	size_t numFrames = 0;
+
+	if (!pNumFrames)
+		return AC_ERR_INVALID_PARAMETER;
+	*pNumFrames = 0;
+	if (!hDevice)
+		return AC_ERR_INVALID_HANDLE;
+	if (!pFrames || maxFrames == 0)
+		return AC_ERR_INVALID_PARAMETER;
+
+	// the first buffer waits; the rest are only taken if already delivered
+	while (numFrames < maxFrames)
+	{
+		acBuffer hBuffer = NULL;
+
+		err = acDeviceGetBuffer(hDevice, numFrames == 0 ? timeout : 0, &hBuffer);
+		if (err != AC_ERR_SUCCESS)
+			break;
+
+		DescribeBuffer(hBuffer, &pFrames[numFrames]);
+		numFrames++;
+	}
+
+	*pNumFrames = numFrames;
+	if (numFrames > 0 && err == AC_ERR_TIMEOUT)
+		return AC_ERR_SUCCESS;
+	return err;
+}
+
+AC_ERROR acBatchRequeueBuffers(acDevice hDevice, acFrameDescriptor* pFrames, size_t numFrames)
+{
+	AC_ERROR firstErr = AC_ERR_SUCCESS;
+	size_t i = 0;
+
+	if (!hDevice)
+		return AC_ERR_INVALID_HANDLE;
+	if (!pFrames && numFrames > 0)
+		return AC_ERR_INVALID_PARAMETER;
+
+	for (i = 0; i < numFrames; i++)
+	{
+		AC_ERROR err = AC_ERR_SUCCESS;
+
+		if (!pFrames[i].hBuffer)
+			continue;
+
+		err = acDeviceRequeueBuffer(hDevice, pFrames[i].hBuffer);
+		if (err != AC_ERR_SUCCESS && firstErr == AC_ERR_SUCCESS)
+			firstErr = err;
+		pFrames[i].hBuffer = NULL;
+		pFrames[i].pData = NULL;
+	}
+	return firstErr;
+}
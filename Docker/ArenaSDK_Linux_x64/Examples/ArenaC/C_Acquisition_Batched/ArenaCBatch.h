@@ -0,0 +1,130 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+#pragma once
+
+#include "ArenaCApi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum AC_FRAME_STATUS_LIST
+ *
+ * Status of a frame descriptor. Only AC_FRAME_STATUS_COMPLETE frames hold a
+ * full image; the others are returned so that their buffers are requeued.
+ */
+enum AC_FRAME_STATUS_LIST
+{
+	AC_FRAME_STATUS_COMPLETE = 0,			 /*!< Complete image */
+	AC_FRAME_STATUS_INCOMPLETE = 1,			 /*!< Missing packets */
+	AC_FRAME_STATUS_LARGER_THAN_BUFFER = 2,	 /*!< Payload did not fit the buffer */
+	AC_FRAME_STATUS_NO_IMAGE_DATA = 3,		 /*!< Chunk-only or other non-image payload */
+	AC_FRAME_STATUS_ERROR = 4				 /*!< A buffer property could not be read */
+};
+
+/**
+ * @struct acFrameDescriptor
+ *
+ * Everything a consumer usually reads from a buffer, filled in one call. The
+ * layout is fixed (8-byte fields only) so that FFI consumers can mirror it,
+ * for example with a ctypes.Structure or a NumPy structured dtype of
+ * 'u8,u8,u8,u8,u8,u8,u8,u8,i8'.
+ */
+typedef struct acFrameDescriptor
+{
+	acBuffer hBuffer;		/*!< Buffer to requeue */
+	const uint8_t* pData;	/*!< Image data, valid until the buffer is requeued */
+	uint64_t sizeFilled;	/*!< Bytes of data */
+	uint64_t frameId;		/*!< Frame ID */
+	uint64_t timestampNs;	/*!< Device timestamp (in nanoseconds) */
+	uint64_t width;			/*!< Width (in pixels) */
+	uint64_t height;		/*!< Height (in pixels) */
+	uint64_t pixelFormat;	/*!< PFNC pixel format */
+	int64_t status;			/*!< AC_FRAME_STATUS_LIST value */
+} acFrameDescriptor;
+
+/**
+ * @fn AC_ERROR acBatchGetBuffers(acDevice hDevice, uint64_t timeout, acFrameDescriptor* pFrames, size_t maxFrames, size_t* pNumFrames)
+ *
+ * @param hDevice
+ *  - Type: acDevice
+ *  - [In] parameter
+ *  - A device
+ *
+ * @param timeout
+ *  - Type: uint64_t
+ *  - [In] parameter
+ *  - Maximum time to wait for the first buffer (in milliseconds)
+ *
+ * @param pFrames
+ *  - Type: acFrameDescriptor*
+ *  - [Out] parameter
+ *  - Caller-provided array of at least maxFrames descriptors
+ *
+ * @param maxFrames
+ *  - Type: size_t
+ *  - [In] parameter
+ *  - Maximum number of buffers to retrieve
+ *
+ * @param pNumFrames
+ *  - Type: size_t*
+ *  - [Out] parameter
+ *  - Number of descriptors filled
+ *
+ * @return
+ *  - Type: AC_ERROR
+ *  - Error code for the function
+ *  - Returns AC_ERR_SUCCESS (0) on success
+ *  - Returns AC_ERR_TIMEOUT if no buffer arrived within the timeout
+ *
+ * <B> acBatchGetBuffers </B> waits up to the timeout for one buffer, then
+ * takes every further buffer that is already delivered, up to maxFrames,
+ * without waiting. Each buffer is described in pFrames. Descriptors filled
+ * before an error are still returned in pNumFrames and must be requeued.
+ */
+AC_ERROR acBatchGetBuffers(acDevice hDevice, uint64_t timeout, acFrameDescriptor* pFrames, size_t maxFrames, size_t* pNumFrames);
+
+/**
+ * @fn AC_ERROR acBatchRequeueBuffers(acDevice hDevice, acFrameDescriptor* pFrames, size_t numFrames)
+ *
+ * @param hDevice
+ *  - Type: acDevice
+ *  - [In] parameter
+ *  - A device
+ *
+ * @param pFrames
+ *  - Type: acFrameDescriptor*
+ *  - [In] parameter
+ *  - Descriptors from acBatchGetBuffers
+ *
+ * @param numFrames
+ *  - Type: size_t
+ *  - [In] parameter
+ *  - Number of descriptors
+ *
+ * @return
+ *  - Type: AC_ERROR
+ *  - Error code for the function
+ *  - Returns AC_ERR_SUCCESS (0) on success
+ *
+ * <B> acBatchRequeueBuffers </B> requeues the buffers of a batch. Every
+ * buffer is requeued even if one fails; the first error is returned. The
+ * descriptors' buffer handles are cleared.
+ */
+AC_ERROR acBatchRequeueBuffers(acDevice hDevice, acFrameDescriptor* pFrames, size_t numFrames);
+
+#ifdef __cplusplus
+}
+#endif
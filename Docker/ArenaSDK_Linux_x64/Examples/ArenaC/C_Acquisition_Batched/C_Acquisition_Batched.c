@@ -0,0 +1,405 @@
+/***************************************************************************************
+ ***                                                                                 ***
+ ***  Copyright (c) 2021, Lucid Vision Labs, Inc.                                    ***
+ ***                                                                                 ***
+ ***  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR     ***
+ ***  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,       ***
+ ***  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE    ***
+ ***  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER         ***
+ ***  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,  ***
+ ***  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE  ***
+ ***  SOFTWARE.                                                                      ***
+ ***                                                                                 ***
+ ***************************************************************************************/
+
+#include "stdafx.h"
+#include "ArenaCApi.h"
+#include "ArenaCBatch.h"
+#include <inttypes.h> // defines macros for printf functions
+#include <stdbool.h>  // defines boolean type and values
+#include <time.h>	  // defines clock_gettime
+
+#define TAB1 "  "
+#define TAB2 "    "
+
+// Acquisition: Batched
+//    This example demonstrates batched acquisition for foreign function
+//    interface (FFI) consumers such as Python. Reading a frame through the
+//    C API normally costs about eight calls: get buffer, size, frame ID,
+//    status, data, timestamp, width and height, and requeue. Through an FFI,
+//    each of these calls costs microseconds. acBatchGetBuffers (ArenaCBatch.c)
+//    fills a caller-provided array of frame descriptors for every buffer that
+//    is ready, in one call. acBatchRequeueBuffers returns the whole batch in
+//    one more call. An FFI consumer then pays for two crossings per batch
+//    instead of eight per frame. The example acquires images both ways and
+//    compares the calls and time spent per frame. 'make libarenacbatch.so'
+//    builds the two entry points as a shared library for ctypes or cffi.
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- SETTINGS =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// image timeout
+#define IMAGE_TIMEOUT 2000
+
+// number of images to grab each way
+#define NUM_IMAGES 500
+
+// largest batch
+#define MAX_BATCH 32
+
+// number of stream buffers; at least MAX_BATCH so a full batch can be queued
+#define NUM_BUFFERS 64
+
+// maximum buffer length
+#define MAX_BUF 512
+
+// timeout for detecting camera devices (in milliseconds).
+#define SYSTEM_TIMEOUT 100
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- HELPER =-=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// gets node value
+// (1) gets node
+// (2) check access mode
+// (3) get value
+AC_ERROR GetNodeValue(acNodeMap hNodeMap, const char* nodeName, char* pValue, size_t* pLen)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+
+	// get node
+	acNode hNode = NULL;
+	AC_ACCESS_MODE accessMode = 0;
+
+	err = acNodeMapGetNodeAndAccessMode(hNodeMap, nodeName, &hNode, &accessMode);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// check access mode
+	if (accessMode != AC_ACCESS_MODE_RO && accessMode != AC_ACCESS_MODE_RW)
+		return AC_ERR_ERROR;
+
+	// get value
+	err = acValueToString(hNode, pValue, pLen);
+	return err;
+}
+
+// sets node value
+// (1) gets node
+// (2) check access mode
+// (3) gets value
+AC_ERROR SetNodeValue(acNodeMap hNodeMap, const char* nodeName, const char* pValue)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+
+	// get node
+	acNode hNode = NULL;
+	AC_ACCESS_MODE accessMode = 0;
+
+	err = acNodeMapGetNodeAndAccessMode(hNodeMap, nodeName, &hNode, &accessMode);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// check access mode
+	if (accessMode != AC_ACCESS_MODE_WO && accessMode != AC_ACCESS_MODE_RW)
+		return AC_ERR_ERROR;
+
+	// get value
+	err = acValueFromString(hNode, pValue);
+	return err;
+}
+
+// monotonic time (in nanoseconds)
+uint64_t NowNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =-=- EXAMPLE -=-=-
+// =-=-=-=-=-=-=-=-=-
+
+// acquires images one call per property, as an FFI consumer of the plain
+// API would
+AC_ERROR AcquirePerFrame(acDevice hDevice, uint64_t* pApiNs, uint64_t* pCalls, uint64_t* pLastFrameId)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+	int i = 0;
+
+	for (i = 0; i < NUM_IMAGES; i++)
+	{
+		acBuffer hBuffer = NULL;
+		size_t sizeFilled = 0;
+		uint64_t frameId = 0;
+		bool8_t incomplete = false;
+		uint8_t* pData = NULL;
+		uint64_t timestampNs = 0;
+		size_t width = 0;
+		size_t height = 0;
+
+		// the wait for the next frame is not API overhead
+		err = acDeviceGetBuffer(hDevice, IMAGE_TIMEOUT, &hBuffer);
+		if (err != AC_ERR_SUCCESS)
+			return err;
+
+		uint64_t start = NowNs();
+		err = acBufferGetSizeFilled(hBuffer, &sizeFilled);
+		if (err == AC_ERR_SUCCESS)
+			err = acBufferGetFrameId(hBuffer, &frameId);
+		if (err == AC_ERR_SUCCESS)
+			err = acBufferIsIncomplete(hBuffer, &incomplete);
+		if (err == AC_ERR_SUCCESS)
+			err = acImageGetData(hBuffer, &pData);
+		if (err == AC_ERR_SUCCESS)
+			err = acImageGetTimestampNs(hBuffer, &timestampNs);
+		if (err == AC_ERR_SUCCESS)
+			err = acImageGetWidth(hBuffer, &width);
+		if (err == AC_ERR_SUCCESS)
+			err = acImageGetHeight(hBuffer, &height);
+		if (err == AC_ERR_SUCCESS)
+			err = acDeviceRequeueBuffer(hDevice, hBuffer);
+		*pApiNs += NowNs() - start;
+		*pCalls += 9;
+		if (err != AC_ERR_SUCCESS)
+			return err;
+
+		*pLastFrameId = frameId;
+	}
+	return err;
+}
+
+// acquires images in batches of up to MAX_BATCH descriptors
+AC_ERROR AcquireBatched(acDevice hDevice, uint64_t* pApiNs, uint64_t* pCalls, uint64_t* pBatches, uint64_t* pIncomplete, uint64_t* pGaps)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+	acFrameDescriptor frames[MAX_BATCH];
+	size_t received = 0;
+	uint64_t lastFrameId = 0;
+
+	while (received < NUM_IMAGES)
+	{
+		size_t numFrames = 0;
+		size_t i = 0;
+		size_t maxFrames = NUM_IMAGES - received < MAX_BATCH ? NUM_IMAGES - received : MAX_BATCH;
+
+		// the pause below lets frames accumulate, so the first buffer is
+		// usually already delivered and the whole call is API overhead
+		uint64_t start = NowNs();
+		err = acBatchGetBuffers(hDevice, IMAGE_TIMEOUT, frames, maxFrames, &numFrames);
+		*pApiNs += NowNs() - start;
+		if (err != AC_ERR_SUCCESS)
+		{
+			acBatchRequeueBuffers(hDevice, frames, numFrames);
+			return err;
+		}
+
+		// consume the batch
+		for (i = 0; i < numFrames; i++)
+		{
+			if (frames[i].status != AC_FRAME_STATUS_COMPLETE)
+				(*pIncomplete)++;
+			if (received + i > 0 && frames[i].frameId != lastFrameId + 1)
+				(*pGaps)++;
+			lastFrameId = frames[i].frameId;
+		}
+
+		start = NowNs();
+		err = acBatchRequeueBuffers(hDevice, frames, numFrames);
+		*pApiNs += NowNs() - start;
+		if (err != AC_ERR_SUCCESS)
+			return err;
+
+		*pCalls += 2;
+		(*pBatches)++;
+		received += numFrames;
+
+		// let frames accumulate, as a consumer busy with the last batch would
+		{
+			struct timespec pause = { 0, 5000000 };
+			nanosleep(&pause, NULL);
+		}
+	}
+	return err;
+}
+
+// demonstrates batched acquisition
+// (1) sets acquisition mode and buffer handling mode
+// (2) enables auto negotiate packet size and packet resend
+// (3) acquires images with per-frame calls
+// (4) acquires images with batched calls
+// (5) compares calls and API time per frame
+AC_ERROR CompareAcquisition(acDevice hDevice)
+{
+	AC_ERROR err = AC_ERR_SUCCESS;
+
+	// get node map
+	acNodeMap hNodeMap = NULL;
+
+	err = acDeviceGetNodeMap(hDevice, &hNodeMap);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// get stream node map
+	acNodeMap hTLStreamNodeMap = NULL;
+
+	err = acDeviceGetTLStreamNodeMap(hDevice, &hTLStreamNodeMap);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// get node values that will be changed in order to return their values at
+	// the end of the example
+	char pAcquisitionModeInitial[MAX_BUF];
+	size_t len = MAX_BUF;
+
+	err = GetNodeValue(hNodeMap, "AcquisitionMode", pAcquisitionModeInitial, &len);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	char pBufferHandlingModeInitial[MAX_BUF];
+	len = MAX_BUF;
+
+	err = GetNodeValue(hTLStreamNodeMap, "StreamBufferHandlingMode", pBufferHandlingModeInitial, &len);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// Set acquisition and buffer handling modes
+	//    'OldestFirst' keeps every delivered buffer queued in order, so that
+	//    a batch collects all frames that arrived since the last one.
+	printf("%sSet acquisition mode to 'Continuous' and buffer handling mode to 'OldestFirst'\n", TAB1);
+
+	err = SetNodeValue(hNodeMap, "AcquisitionMode", "Continuous");
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = SetNodeValue(hTLStreamNodeMap, "StreamBufferHandlingMode", "OldestFirst");
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// enable stream auto negotiate packet size
+	err = acNodeMapSetBooleanValue(hTLStreamNodeMap, "StreamAutoNegotiatePacketSize", true);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// enable stream packet resend
+	err = acNodeMapSetBooleanValue(hTLStreamNodeMap, "StreamPacketResendEnable", true);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// acquire with per-frame calls
+	printf("%sAcquire %d images with per-frame calls\n", TAB1, NUM_IMAGES);
+
+	uint64_t perFrameNs = 0;
+	uint64_t perFrameCalls = 0;
+	uint64_t lastFrameId = 0;
+
+	err = acDeviceStartStreamNumBuffersAndFlags(hDevice, NUM_BUFFERS);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = AcquirePerFrame(hDevice, &perFrameNs, &perFrameCalls, &lastFrameId);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = acDeviceStopStream(hDevice);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// acquire with batched calls
+	printf("%sAcquire %d images in batches of up to %d\n", TAB1, NUM_IMAGES, MAX_BATCH);
+
+	uint64_t batchedNs = 0;
+	uint64_t batchedCalls = 0;
+	uint64_t batches = 0;
+	uint64_t incomplete = 0;
+	uint64_t gaps = 0;
+
+	err = acDeviceStartStreamNumBuffersAndFlags(hDevice, NUM_BUFFERS);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = AcquireBatched(hDevice, &batchedNs, &batchedCalls, &batches, &incomplete, &gaps);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = acDeviceStopStream(hDevice);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	// compare
+	printf("%sper frame: %.1f calls, %.0f ns in the API per frame (excluding the wait)\n", TAB2, (double)perFrameCalls / NUM_IMAGES, (double)perFrameNs / NUM_IMAGES);
+	printf("%sbatched:   %.2f calls, %.0f ns in the API per frame; %.1f frames per batch\n", TAB2, (double)batchedCalls / NUM_IMAGES, (double)batchedNs / NUM_IMAGES, (double)NUM_IMAGES / (double)batches);
+	printf("%s%" PRIu64 " incomplete, %" PRIu64 " frame ID gaps\n", TAB2, incomplete, gaps);
+
+	// return nodes to their initial values
+	err = SetNodeValue(hTLStreamNodeMap, "StreamBufferHandlingMode", pBufferHandlingModeInitial);
+	if (err != AC_ERR_SUCCESS)
+		return err;
+
+	err = SetNodeValue(hNodeMap, "AcquisitionMode", pAcquisitionModeInitial);
+	return err;
+}
+
+// =-=-=-=-=-=-=-=-=-
+// =- PREPARATION -=-
+// =- & CLEAN UP =-=-
+// =-=-=-=-=-=-=-=-=-
+
+// error buffer length
+#define ERR_BUF 512
+
+#define CHECK_RETURN                                  \
+	if (err != AC_ERR_SUCCESS)                        \
+	{                                                 \
+		char pMessageBuf[ERR_BUF];                    \
+		size_t pBufLen = ERR_BUF;                     \
+		acGetLastErrorMessage(pMessageBuf, &pBufLen); \
+		printf("\nError: %s", pMessageBuf);           \
+		printf("\n\nPress enter to complete\n");      \
+		getchar();                                    \
+		return -1;                                    \
+	}
+
+int main()
+{
+	printf("C_Acquisition_Batched\n");
+	AC_ERROR err = AC_ERR_SUCCESS;
+
+	// prepare example
+	acSystem hSystem = NULL;
+	err = acOpenSystem(&hSystem);
+	CHECK_RETURN;
+	err = acSystemUpdateDevices(hSystem, SYSTEM_TIMEOUT);
+	CHECK_RETURN;
+	size_t numDevices = 0;
+	err = acSystemGetNumDevices(hSystem, &numDevices);
+	CHECK_RETURN;
+	if (numDevices == 0)
+	{
+		printf("\nNo camera connected\nPress enter to complete\n");
+		getchar();
+		return -1;
+	}
+	acDevice hDevice = NULL;
+	err = acSystemCreateDevice(hSystem, 0, &hDevice);
+	CHECK_RETURN;
+
+	// run example
+	printf("Commence example\n\n");
+	err = CompareAcquisition(hDevice);
+	CHECK_RETURN;
+	printf("\nExample complete\n");
+
+	// clean up example
+	err = acSystemDestroyDevice(hSystem, hDevice);
+	CHECK_RETURN;
+	err = acCloseSystem(hSystem);
+	CHECK_RETURN;
+
+	printf("Press enter to complete\n");
+	getchar();
+	return -1;
+}